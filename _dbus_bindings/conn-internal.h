@@ -28,6 +28,8 @@
 
 #include "dbus_bindings-internal.h"
 
+typedef struct _DBusPySenderLimits DBusPySenderLimits;
+
 typedef struct {
     PyObject_HEAD
     DBusConnection *conn;
@@ -35,6 +37,8 @@ typedef struct {
     PyObject *filters;
     /* A dict mapping object paths to one of:
      * - tuples (unregister_callback or None, message_callback)
+     * - objects registered by _register_object, whose _dbus_message_cb
+     *   method is the message callback
      * - None (meaning unregistration from libdbus is in progress and nobody
      *         should touch this entry til we're finished)
      */
@@ -44,6 +48,9 @@ typedef struct {
     PyObject *weaklist;
 
     dbus_bool_t has_mainloop;
+
+    /* Limits on method calls to exported objects, or NULL */
+    DBusPySenderLimits *sender_limits;
 } Connection;
 
 typedef struct {
@@ -52,9 +59,13 @@ typedef struct {
 } DBusPyLibDBusConnection;
 
 extern struct PyMethodDef DBusPyConnection_tp_methods[];
+extern PyObject *dbus_py__dbus_message_cb_const;
 extern DBusHandlerResult DBusPyConnection_HandleMessage(Connection *,
                                                         PyObject *,
                                                         PyObject *);
+extern DBusHandlerResult DBusPyConnection_HandleDBusMessage(Connection *,
+                                                            DBusMessage *,
+                                                            PyObject *);
 extern PyObject *DBusPyConnection_ExistingFromDBusConnection(DBusConnection *);
 extern PyObject *DBusPyConnection_GetObjectPathHandlers(PyObject *self,
                                                         PyObject *path);
@@ -64,4 +75,18 @@ extern PyObject *DBusPyConnection_NewForBus(PyTypeObject *cls, PyObject *args,
 extern PyObject *DBusPyConnection_SetUniqueName(Connection *, PyObject *);
 extern PyObject *DBusPyConnection_GetUniqueName(Connection *, PyObject *);
 
+/* sender-limits.c */
+extern DBusPySenderLimits *DBusPySenderLimits_New(double rate, double burst,
+                                                  unsigned long max_concurrent);
+extern void DBusPySenderLimits_Free(DBusPySenderLimits *);
+/* Return 1 if the method call may be dispatched, or 0 if it is over the
+ * limits or there isn't enough memory to keep track of it. */
+extern int DBusPySenderLimits_Admit(DBusPySenderLimits *, DBusMessage *);
+extern void DBusPySenderLimits_Finish(DBusPySenderLimits *,
+                                      const char *sender,
+                                      dbus_uint32_t serial);
+extern void DBusPySenderLimits_ReplySent(DBusPySenderLimits *,
+                                         DBusMessage *);
+extern PyObject *DBusPySenderLimits_GetStats(DBusPySenderLimits *);
+
 #endif
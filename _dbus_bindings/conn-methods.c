@@ -48,6 +48,9 @@ _object_path_unregister(DBusConnection *conn, void *user_data)
 
     DBG("%s", "... yes we have handlers for that object path");
 
+    /* objects registered by _register_object have no unregisterer */
+    if (!PyTuple_Check(tuple)) goto out;
+
     /* 0'th item is the unregisterer (if that's a word) */
     callable = PyTuple_GetItem(tuple, 0);
     if (callable && callable != Py_None) {
@@ -66,6 +69,30 @@ out:
     PyGILState_Release(gil);
 }
 
+/* Reply to a method call that is over the sender limits */
+static DBusHandlerResult
+_object_path_reject(DBusConnection *conn, DBusMessage *message)
+{
+    DBusMessage *reply;
+    dbus_bool_t ok;
+
+    if (dbus_message_get_no_reply(message))
+        return DBUS_HANDLER_RESULT_HANDLED;
+
+    reply = dbus_message_new_error(message, DBUS_ERROR_LIMITS_EXCEEDED,
+                                   "Too many method calls from this sender");
+    if (!reply)
+        return DBUS_HANDLER_RESULT_NEED_MEMORY;
+
+    Py_BEGIN_ALLOW_THREADS
+    ok = dbus_connection_send(conn, reply, NULL);
+    Py_END_ALLOW_THREADS
+    dbus_message_unref(reply);
+
+    return (ok ? DBUS_HANDLER_RESULT_HANDLED
+               : DBUS_HANDLER_RESULT_NEED_MEMORY);
+}
+
 static DBusHandlerResult
 _object_path_message(DBusConnection *conn, DBusMessage *message,
                      void *user_data)
@@ -74,15 +101,8 @@ _object_path_message(DBusConnection *conn, DBusMessage *message,
     PyGILState_STATE gil = PyGILState_Ensure();
     Connection *conn_obj = NULL;
     PyObject *tuple = NULL;
-    PyObject *msg_obj;
-    PyObject *callable;             /* borrowed */
-
-    dbus_message_ref(message);
-    msg_obj = DBusPyMessage_ConsumeDBusMessage(message);
-    if (!msg_obj) {
-        ret = DBUS_HANDLER_RESULT_NEED_MEMORY;
-        goto out;
-    }
+    PyObject *callable;             /* borrowed, except for objects */
+    dbus_bool_t admitted = FALSE;
 
     conn_obj = (Connection *)DBusPyConnection_ExistingFromDBusConnection(conn);
     if (!conn_obj) {
@@ -91,6 +111,17 @@ _object_path_message(DBusConnection *conn, DBusMessage *message,
     }
     TRACE(conn_obj);
 
+    /* Enforce the limits before doing anything else with the message, so
+     * that calls over the limits cost as little as possible */
+    if (conn_obj->sender_limits &&
+        dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_METHOD_CALL) {
+        if (!DBusPySenderLimits_Admit(conn_obj->sender_limits, message)) {
+            ret = _object_path_reject(conn, message);
+            goto out;
+        }
+        admitted = TRUE;
+    }
+
     DBG("Connection at %p messaging object path %s",
         conn_obj, PyBytes_AS_STRING((PyObject *)user_data));
     DBG_DUMP_MESSAGE(message);
@@ -103,6 +134,22 @@ _object_path_message(DBusConnection *conn, DBusMessage *message,
 
     DBG("%s", "... yes we have handlers for that object path");
 
+    if (!PyTuple_Check(tuple)) {
+        /* an object registered by _register_object, whose class provides
+         * the message callback */
+        DBG("%s", "... and it's an exported object");
+        callable = PyObject_GetAttr(tuple, dbus_py__dbus_message_cb_const);
+        if (!callable) {
+            ret = DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+        }
+        else {
+            ret = DBusPyConnection_HandleDBusMessage(conn_obj, message,
+                                                     callable);
+            Py_CLEAR(callable);
+        }
+        goto out;
+    }
+
     /* 1st item (0-based) is the message callback */
     callable = PyTuple_GetItem(tuple, 1);
     if (!callable) {
@@ -116,11 +163,19 @@ _object_path_message(DBusConnection *conn, DBusMessage *message,
     }
     else {
         DBG("%s", "... and we have a message handler for that object path");
-        ret = DBusPyConnection_HandleMessage(conn_obj, msg_obj, callable);
+        ret = DBusPyConnection_HandleDBusMessage(conn_obj, message, callable);
     }
 
 out:
-    Py_CLEAR(msg_obj);
+    /* If we didn't handle it, whoever does will reply to it (or it will be
+     * dispatched to us again), so it's no longer in flight here. The
+     * handler might have changed the limits, so look them up again. */
+    if (admitted && ret != DBUS_HANDLER_RESULT_HANDLED &&
+        conn_obj->sender_limits) {
+        DBusPySenderLimits_Finish(conn_obj->sender_limits,
+                                  dbus_message_get_sender(message),
+                                  dbus_message_get_serial(message));
+    }
     Py_CLEAR(conn_obj);
     Py_CLEAR(tuple);
     if (PyErr_Occurred()) {
@@ -142,19 +197,10 @@ _filter_message(DBusConnection *conn, DBusMessage *message, void *user_data)
     PyGILState_STATE gil = PyGILState_Ensure();
     Connection *conn_obj = NULL;
     PyObject *callable = NULL;
-    PyObject *msg_obj;
 #ifndef DBUS_PYTHON_DISABLE_CHECKS
     Py_ssize_t i, size;
 #endif
 
-    dbus_message_ref(message);
-    msg_obj = DBusPyMessage_ConsumeDBusMessage(message);
-    if (!msg_obj) {
-        DBG("%s", "OOM while trying to construct Message");
-        ret = DBUS_HANDLER_RESULT_NEED_MEMORY;
-        goto out;
-    }
-
     conn_obj = (Connection *)DBusPyConnection_ExistingFromDBusConnection(conn);
     if (!conn_obj) {
         DBG("%s", "failed to traverse DBusConnection -> Connection weakref");
@@ -196,9 +242,8 @@ _filter_message(DBusConnection *conn, DBusMessage *message, void *user_data)
     }
 #endif
 
-    ret = DBusPyConnection_HandleMessage(conn_obj, msg_obj, callable);
+    ret = DBusPyConnection_HandleDBusMessage(conn_obj, message, callable);
 out:
-    Py_CLEAR(msg_obj);
     Py_CLEAR(conn_obj);
     Py_CLEAR(callable);
     PyGILState_Release(gil);
@@ -312,23 +357,68 @@ PyDoc_STRVAR(Connection_send_message__doc__,
 "       The message to be sent.\n"
 );
 static PyObject *
-Connection_send_message(Connection *self, PyObject *args)
+Connection_send_message(Connection *self, PyObject *obj)
+{
+    DBusMessage *msg;
+    dbus_uint32_t serial;
+
+    TRACE(self);
+    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
+
+    msg = DBusPyMessage_BorrowDBusMessage(obj);
+    if (!msg) return NULL;
+
+    if (DBusPyConnection_SendMessage((PyObject *)self, msg, &serial) < 0)
+        return NULL;
+    return PyLong_FromUnsignedLong(serial);
+}
+
+PyDoc_STRVAR(Connection__send_error_reply__doc__,
+"_send_error_reply(reply_to, error_name, error_message=None) -> long\n\n"
+"Queue an error reply to the given method call for sending, and return its\n"
+"serial number. This is equivalent to\n"
+"``send_message(ErrorMessage(reply_to, error_name, error_message))``,\n"
+"but doesn't create a Python object for the reply.\n"
+"\n"
+":Parameters:\n"
+"   `reply_to` : dbus.lowlevel.Message\n"
+"       The method call to which this is a reply\n"
+"   `error_name` : str\n"
+"       The D-Bus error name\n"
+"   `error_message` : str or None\n"
+"       The error message, if any\n"
+":Since: 1.2.1\n"
+);
+static PyObject *
+Connection__send_error_reply(Connection *self, PyObject *args)
 {
     dbus_bool_t ok;
     PyObject *obj;
-    DBusMessage *msg;
+    DBusMessage *msg, *reply;
+    const char *error_name, *error_message = NULL;
     dbus_uint32_t serial;
 
     TRACE(self);
     DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
-    if (!PyArg_ParseTuple(args, "O", &obj)) return NULL;
+    if (!PyArg_ParseTuple(args, "Os|z:_send_error_reply", &obj, &error_name,
+                          &error_message)) {
+        return NULL;
+    }
 
     msg = DBusPyMessage_BorrowDBusMessage(obj);
     if (!msg) return NULL;
+    if (!dbus_py_validate_error_name(error_name)) return NULL;
+
+    reply = dbus_message_new_error(msg, error_name, error_message);
+    if (!reply) return PyErr_NoMemory();
 
     Py_BEGIN_ALLOW_THREADS
-    ok = dbus_connection_send(self->conn, msg, &serial);
+    ok = dbus_connection_send(self->conn, reply, &serial);
     Py_END_ALLOW_THREADS
+    if (ok && self->sender_limits) {
+        DBusPySenderLimits_ReplySent(self->sender_limits, reply);
+    }
+    dbus_message_unref(reply);
 
     if (!ok) {
         return PyErr_NoMemory();
@@ -382,7 +472,7 @@ PyDoc_STRVAR(Connection_send_message_with_reply__doc__,
 "\n"
 );
 static PyObject *
-Connection_send_message_with_reply(Connection *self, PyObject *args, PyObject *kw)
+Connection_send_message_with_reply(Connection *self, DBUS_PY_ARGS)
 {
     dbus_bool_t ok;
     double timeout_s = -1.0;
@@ -393,14 +483,12 @@ Connection_send_message_with_reply(Connection *self, PyObject *args, PyObject *k
     int require_main_loop = 0;
     static char *argnames[] = {"msg", "reply_handler", "timeout_s",
                                "require_main_loop", NULL};
+    DBUS_PY_ARG_PARSER(parser, "OO|di:send_message_with_reply", argnames);
 
     TRACE(self);
     DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
-    if (!PyArg_ParseTupleAndKeywords(args, kw,
-                                     "OO|di:send_message_with_reply",
-                                     argnames,
-                                     &obj, &callable, &timeout_s,
-                                     &require_main_loop)) {
+    if (!DBUS_PY_PARSE_ARGS(parser, &obj, &callable, &timeout_s,
+                            &require_main_loop)) {
         return NULL;
     }
     if (require_main_loop && !Connection__require_main_loop(self, NULL)) {
@@ -464,18 +552,22 @@ PyDoc_STRVAR(Connection_send_message_with_reply_and_block__doc__,
 "\n"
 );
 static PyObject *
-Connection_send_message_with_reply_and_block(Connection *self, PyObject *args)
+Connection_send_message_with_reply_and_block(Connection *self, DBUS_PY_ARGS)
 {
     double timeout_s = -1.0;
     int timeout_ms;
     PyObject *obj;
-    DBusMessage *msg, *reply;
+    DBusMessage *msg, *reply = NULL;
+    DBusPendingCall *pending = NULL;
     DBusError error;
+    dbus_bool_t ok;
+    static char *argnames[] = {"msg", "timeout_s", NULL};
+    DBUS_PY_ARG_PARSER(parser, "O|d:send_message_with_reply_and_block",
+                       argnames);
 
     TRACE(self);
     DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
-    if (!PyArg_ParseTuple(args, "O|d:send_message_with_reply_and_block", &obj,
-                          &timeout_s)) {
+    if (!DBUS_PY_PARSE_ARGS(parser, &obj, &timeout_s)) {
         return NULL;
     }
 
@@ -493,21 +585,379 @@ Connection_send_message_with_reply_and_block(Connection *self, PyObject *args)
         timeout_ms = (int)(timeout_s * 1000.0);
     }
 
-    dbus_error_init(&error);
+    /* This is what dbus_connection_send_with_reply_and_block does, except
+     * that we keep the whole error reply rather than just its first
+     * argument */
     Py_BEGIN_ALLOW_THREADS
-    reply = dbus_connection_send_with_reply_and_block(self->conn, msg,
-                                                      timeout_ms, &error);
+    ok = dbus_connection_send_with_reply(self->conn, msg, &pending,
+                                         timeout_ms);
+    if (ok && pending) {
+        dbus_pending_call_block(pending);
+        reply = dbus_pending_call_steal_reply(pending);
+        dbus_pending_call_unref(pending);
+    }
     Py_END_ALLOW_THREADS
 
-    /* FIXME: if we instead used send_with_reply and blocked on the resulting
-     * PendingCall, then we could get all args from the error, not just
-     * the first */
+    if (!ok) {
+        return PyErr_NoMemory();
+    }
+
+    /* use the same errors as dbus_connection_send_with_reply_and_block */
+    if (!pending) {
+        /* connection is disconnected (doesn't return FALSE!) */
+        dbus_error_init(&error);
+        dbus_set_error(&error, DBUS_ERROR_DISCONNECTED,
+                       "Connection is closed");
+        return DBusPyException_ConsumeError(&error);
+    }
+
     if (!reply) {
+        /* shouldn't happen: a timeout produces a local error reply */
+        dbus_error_init(&error);
+        dbus_set_error(&error, DBUS_ERROR_NO_REPLY,
+                       "Message did not receive a reply");
         return DBusPyException_ConsumeError(&error);
     }
+
+    if (dbus_message_get_type(reply) == DBUS_MESSAGE_TYPE_ERROR) {
+        return DBusPyException_ConsumeErrorMessage(reply);
+    }
     return DBusPyMessage_ConsumeDBusMessage(reply);
 }
 
+/* Where to relay the reply to a forwarded method call. This is the user_data
+ * of the DBusPendingCall, so libdbus' own table of pending replies (keyed
+ * by the serial of the forwarded copy) doubles as our correlation table. */
+typedef struct {
+    DBusConnection *origin;
+    dbus_uint32_t serial;
+    char *sender;
+    dbus_bool_t relayed;
+} ForwardedCall;
+
+static void
+_forwarded_call_free(void *data)
+{
+    ForwardedCall *fc = data;
+
+    dbus_connection_unref(fc->origin);
+    dbus_free(fc->sender);
+    dbus_free(fc);
+}
+
+static void
+_forwarded_call_notify(DBusPendingCall *pc, void *data)
+{
+    ForwardedCall *fc = data;
+    PyGILState_STATE gil;
+    Connection *origin_obj;
+    DBusMessage *reply, *copy;
+
+    /* The GIL protects against this being called twice, as for ordinary
+     * pending calls (see DBusPyPendingCall_ConsumeDBusPendingCall) */
+    gil = PyGILState_Ensure();
+    if (fc->relayed) {
+        PyGILState_Release(gil);
+        return;
+    }
+    fc->relayed = TRUE;
+    /* the call is about to be answered, whether or not we can relay the
+     * reply */
+    origin_obj = (Connection *)DBusPyConnection_ExistingFromDBusConnection(
+        fc->origin);
+    if (origin_obj) {
+        if (origin_obj->sender_limits) {
+            DBusPySenderLimits_Finish(origin_obj->sender_limits, fc->sender,
+                                      fc->serial);
+        }
+        Py_CLEAR(origin_obj);
+    }
+    else {
+        PyErr_Clear();
+    }
+    PyGILState_Release(gil);
+
+    reply = dbus_pending_call_steal_reply(pc);
+    if (!reply)
+        return;
+
+    /* Rewrite the header so the reply looks as though it came in response
+     * to the original call; the body is copied without being unpacked */
+    copy = dbus_message_copy(reply);
+    dbus_message_unref(reply);
+    if (!copy)
+        return;
+
+    if (dbus_message_set_reply_serial(copy, fc->serial)
+        && dbus_message_set_destination(copy, fc->sender)
+        && dbus_message_set_sender(copy, NULL)) {
+        dbus_connection_send(fc->origin, copy, NULL);
+    }
+    dbus_message_unref(copy);
+}
+
+PyDoc_STRVAR(Connection_forward__doc__,
+"forward(msg, destination=None, path=None, origin=None, timeout_s=-1)"
+" -> long\n\n"
+"Queue a copy of a message received on another connection for sending on\n"
+"this one, and return the serial number of the copy.\n"
+"\n"
+"The message body is copied as-is, without being decoded and re-encoded;\n"
+"only the header is changed. The sender field is always removed, since\n"
+"it refers to the other connection.\n"
+"\n"
+":Parameters:\n"
+"   `msg` : dbus.lowlevel.Message\n"
+"       The message to be forwarded\n"
+"   `destination` : str or None\n"
+"       If not None, replace the destination bus name\n"
+"   `path` : str or None\n"
+"       If not None, replace the object path\n"
+"   `origin` : Connection or None\n"
+"       The connection on which `msg` was received. If `msg` is a method\n"
+"       call expecting a reply, the reply (or error, including a local\n"
+"       timeout) is relayed back to its caller on `origin`, with the reply\n"
+"       serial and destination rewritten to match the original call. This\n"
+"       is done without the reply entering Python code.\n"
+"   `timeout_s` : float\n"
+"       If the reply takes more than this many seconds, a timeout error\n"
+"       is relayed instead. If this timeout is negative (default), a sane\n"
+"       default (supplied by libdbus) is used.\n"
+":Since: 1.2.1\n"
+);
+static PyObject *
+Connection_forward(Connection *self, PyObject *args, PyObject *kw)
+{
+    dbus_bool_t ok;
+    double timeout_s = -1.0;
+    int timeout_ms;
+    PyObject *obj, *origin = Py_None;
+    const char *destination = NULL, *path = NULL;
+    DBusMessage *msg, *copy;
+    DBusConnection *origin_conn = NULL;
+    DBusPendingCall *pending = NULL;
+    ForwardedCall *fc;
+    dbus_uint32_t serial;
+    static char *argnames[] = {"msg", "destination", "path", "origin",
+                               "timeout_s", NULL};
+
+    TRACE(self);
+    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "O|zzOd:forward", argnames,
+                                     &obj, &destination, &path, &origin,
+                                     &timeout_s)) {
+        return NULL;
+    }
+
+    msg = DBusPyMessage_BorrowDBusMessage(obj);
+    if (!msg) return NULL;
+    if (destination && !dbus_py_validate_bus_name(destination, 1, 1))
+        return NULL;
+    if (path && !dbus_py_validate_object_path(path)) return NULL;
+
+    if (origin != Py_None) {
+        origin_conn = DBusPyConnection_BorrowDBusConnection(origin);
+        if (!origin_conn) return NULL;
+    }
+
+    if (timeout_s < 0) {
+        timeout_ms = -1;
+    }
+    else {
+        if (timeout_s > ((double)INT_MAX) / 1000.0) {
+            PyErr_SetString(PyExc_ValueError, "Timeout too long");
+            return NULL;
+        }
+        timeout_ms = (int)(timeout_s * 1000.0);
+    }
+
+    /* dbus_message_copy resets the serial number */
+    copy = dbus_message_copy(msg);
+    if (!copy) return PyErr_NoMemory();
+
+    if ((destination && !dbus_message_set_destination(copy, destination))
+        || (path && !dbus_message_set_path(copy, path))
+        || !dbus_message_set_sender(copy, NULL)) {
+        dbus_message_unref(copy);
+        return PyErr_NoMemory();
+    }
+
+    if (!origin_conn
+        || dbus_message_get_type(copy) != DBUS_MESSAGE_TYPE_METHOD_CALL
+        || dbus_message_get_no_reply(copy)) {
+        Py_BEGIN_ALLOW_THREADS
+        ok = dbus_connection_send(self->conn, copy, &serial);
+        Py_END_ALLOW_THREADS
+        dbus_message_unref(copy);
+
+        if (!ok) {
+            return PyErr_NoMemory();
+        }
+        return PyLong_FromUnsignedLong(serial);
+    }
+
+    if (!dbus_message_get_serial(msg)) {
+        dbus_message_unref(copy);
+        PyErr_SetString(PyExc_ValueError, "Cannot relay the reply to a "
+                        "message that was not received from origin");
+        return NULL;
+    }
+
+    fc = dbus_new0(ForwardedCall, 1);
+    if (!fc) {
+        dbus_message_unref(copy);
+        return PyErr_NoMemory();
+    }
+    fc->serial = dbus_message_get_serial(msg);
+    if (dbus_message_get_sender(msg)) {
+        size_t len = strlen(dbus_message_get_sender(msg)) + 1;
+
+        fc->sender = dbus_malloc(len);
+        if (!fc->sender) {
+            dbus_free(fc);
+            dbus_message_unref(copy);
+            return PyErr_NoMemory();
+        }
+        memcpy(fc->sender, dbus_message_get_sender(msg), len);
+    }
+    fc->origin = dbus_connection_ref(origin_conn);
+
+    Py_BEGIN_ALLOW_THREADS
+    ok = dbus_connection_send_with_reply(self->conn, copy, &pending,
+                                         timeout_ms);
+    Py_END_ALLOW_THREADS
+    serial = dbus_message_get_serial(copy);
+    dbus_message_unref(copy);
+
+    if (!ok) {
+        _forwarded_call_free(fc);
+        return PyErr_NoMemory();
+    }
+
+    if (!pending) {
+        _forwarded_call_free(fc);
+        /* connection is disconnected (doesn't return FALSE!) */
+        return DBusPyException_SetString("Connection is disconnected - "
+                                         "unable to forward method call");
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    ok = dbus_pending_call_set_notify(pending, _forwarded_call_notify, fc,
+                                      _forwarded_call_free);
+    Py_END_ALLOW_THREADS
+
+    if (!ok) {
+        _forwarded_call_free(fc);
+        Py_BEGIN_ALLOW_THREADS
+        dbus_pending_call_cancel(pending);
+        dbus_pending_call_unref(pending);
+        Py_END_ALLOW_THREADS
+        return PyErr_NoMemory();
+    }
+
+    /* Same race as in DBusPyPendingCall_ConsumeDBusPendingCall: the reply
+     * might have arrived before the notify function was set */
+    if (dbus_pending_call_get_completed(pending)) {
+        _forwarded_call_notify(pending, fc);
+    }
+
+    /* libdbus keeps its own reference until the reply arrives */
+    dbus_pending_call_unref(pending);
+    return PyLong_FromUnsignedLong(serial);
+}
+
+PyDoc_STRVAR(Connection_set_sender_limits__doc__,
+"set_sender_limits(rate=0, burst=None, max_concurrent=0)\n\n"
+"Limit the method calls each sender (unique name) may make to objects\n"
+"exported on this connection. Calls over the limits get an immediate\n"
+"``org.freedesktop.DBus.Error.LimitsExceeded`` error reply, raised by\n"
+"dbus-python clients as `dbus.exceptions.LimitsExceededException`, without\n"
+"being decoded or passed to Python code. Calling this again replaces\n"
+"the limits and resets the counters returned by `get_sender_stats`.\n"
+"\n"
+"Calls handled by message filters are not affected.\n"
+"\n"
+":Parameters:\n"
+"   `rate` : float\n"
+"       The average number of calls per second allowed from each sender,\n"
+"       or 0 (default) for no limit on the rate\n"
+"   `burst` : float or None\n"
+"       How many calls a sender may make at once before the rate limit\n"
+"       applies (the size of its token bucket). If None (default), one\n"
+"       second's worth of calls, or at least one call\n"
+"   `max_concurrent` : int\n"
+"       The number of calls from each sender that may be awaiting a\n"
+"       reply, or 0 (default) for no limit. A call is finished when a\n"
+"       reply to it is sent with `send_message` (as done by\n"
+"       `dbus.service.Object`, and by native handlers through\n"
+"       ``DBusPyConnection_SendMessage``) or relayed by `forward`; calls\n"
+"       that are never answered count against the limit indefinitely.\n"
+":Since: 1.2.1\n"
+);
+static PyObject *
+Connection_set_sender_limits(Connection *self, PyObject *args, PyObject *kw)
+{
+    double rate = 0.0;
+    PyObject *burst_obj = Py_None;
+    double burst;
+    long max_concurrent = 0;
+    DBusPySenderLimits *limits = NULL;
+    static char *argnames[] = {"rate", "burst", "max_concurrent", NULL};
+
+    TRACE(self);
+    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
+    if (!PyArg_ParseTupleAndKeywords(args, kw, "|dOl:set_sender_limits",
+                                     argnames, &rate, &burst_obj,
+                                     &max_concurrent)) {
+        return NULL;
+    }
+
+    if (burst_obj == Py_None) {
+        burst = (rate > 1.0 ? rate : 1.0);
+    }
+    else {
+        burst = PyFloat_AsDouble(burst_obj);
+        if (burst == -1.0 && PyErr_Occurred())
+            return NULL;
+    }
+    if (rate < 0.0 || burst < 1.0 || max_concurrent < 0) {
+        PyErr_SetString(PyExc_ValueError, "rate and max_concurrent must be "
+                        "non-negative, and burst at least 1");
+        return NULL;
+    }
+
+    if (rate > 0.0 || max_concurrent > 0) {
+        limits = DBusPySenderLimits_New(rate, burst,
+                                        (unsigned long)max_concurrent);
+        if (!limits)
+            return PyErr_NoMemory();
+    }
+
+    DBusPySenderLimits_Free(self->sender_limits);
+    self->sender_limits = limits;
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(Connection_get_sender_stats__doc__,
+"get_sender_stats() -> dict\n\n"
+"Return a dict mapping the unique names of senders (or None, on a\n"
+"connection with no bus) to tuples\n"
+"``(accepted, rejected, in_flight)``: the number of method calls from\n"
+"that sender dispatched to exported objects and rejected since the limits\n"
+"were set with `set_sender_limits`, and the number of dispatched calls\n"
+"still awaiting a reply. Senders with no calls in flight that are not\n"
+"being rate-limited may be forgotten. The dict is empty if there are no\n"
+"limits.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+static PyObject *
+Connection_get_sender_stats(Connection *self, PyObject *unused UNUSED)
+{
+    TRACE(self);
+    return DBusPySenderLimits_GetStats(self->sender_limits);
+}
+
 PyDoc_STRVAR(Connection_flush__doc__,
 "flush()\n\n"
 "Block until the outgoing message queue is empty.\n");
@@ -675,74 +1125,43 @@ Connection_remove_message_filter(Connection *self, PyObject *callable)
     Py_RETURN_NONE;
 }
 
-PyDoc_STRVAR(Connection__register_object_path__doc__,
-"register_object_path(path, on_message, on_unregister=None, fallback=False)\n"
-"\n"
-"Register a callback to be called when messages arrive at the given\n"
-"object-path. Used to export objects' methods on the bus in a low-level\n"
-"way. For the high-level interface to this functionality (usually\n"
-"recommended) see the `dbus.service.Object` base class.\n"
-"\n"
-":Parameters:\n"
-"   `path` : str\n"
-"       Object path to be acted on\n"
-"   `on_message` : callable\n"
-"       Called when a message arrives at the given object-path, with\n"
-"       two positional parameters: the first is this Connection,\n"
-"       the second is the incoming `dbus.lowlevel.Message`.\n"
-"   `on_unregister` : callable or None\n"
-"       If not None, called when the callback is unregistered.\n"
-"   `fallback` : bool\n"
-"       If True (the default is False), when a message arrives for a\n"
-"       'subdirectory' of the given path and there is no more specific\n"
-"       handler, use this handler. Normally this handler is only run if\n"
-"       the paths match exactly.\n"
-);
+/* Return a new reference to path as an exact bytes object.
+
+Path needs to be a string (not a subclass which could do something mad)
+to preserve the desirable property that the DBusConnection can never
+strongly reference the Connection, even indirectly.
+*/
 static PyObject *
-Connection__register_object_path(Connection *self, PyObject *args,
-                                 PyObject *kwargs)
+_object_path_bytes(PyObject *path)
 {
-    dbus_bool_t ok;
-    int fallback = 0;
-    char *path_bytes;
-    PyObject *callbacks, *path, *tuple, *on_message, *on_unregister = Py_None;
-    static char *argnames[] = {"path", "on_message", "on_unregister",
-                               "fallback", NULL};
-
-    TRACE(self);
-    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
-    if (!Connection__require_main_loop(self, NULL)) {
-        return NULL;
-    }
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs,
-                                     "OO|Oi:_register_object_path",
-                                     argnames,
-                                     &path,
-                                     &on_message, &on_unregister,
-                                     &fallback)) return NULL;
-
-    /* Take a reference to path, which we give away to libdbus in a moment.
-
-    Also, path needs to be a string (not a subclass which could do something
-    mad) to preserve the desirable property that the DBusConnection can
-    never strongly reference the Connection, even indirectly.
-    */
     if (PyBytes_CheckExact(path)) {
         Py_INCREF(path);
+        return path;
     }
     else if (PyUnicode_Check(path)) {
-        path = PyUnicode_AsUTF8String(path);
-        if (!path) return NULL;
+        return PyUnicode_AsUTF8String(path);
     }
     else if (PyBytes_Check(path)) {
-        path = PyBytes_FromString(PyBytes_AS_STRING(path));
-        if (!path) return NULL;
-    }
-    else {
-        PyErr_SetString(PyExc_TypeError,
-                        "path must be a str, bytes, or unicode object");
-        return NULL;
+        return PyBytes_FromString(PyBytes_AS_STRING(path));
     }
+    PyErr_SetString(PyExc_TypeError,
+                    "path must be a str, bytes, or unicode object");
+    return NULL;
+}
+
+/* Register path with libdbus, storing handlers (either a tuple of
+ * callbacks or an exported object) in self->object_paths. */
+static PyObject *
+_register_path(Connection *self, PyObject *path, PyObject *handlers,
+               int fallback)
+{
+    dbus_bool_t ok;
+    char *path_bytes;
+    PyObject *callbacks;
+
+    /* Take a reference to path, which we give away to libdbus in a moment. */
+    path = _object_path_bytes(path);
+    if (!path) return NULL;
 
     path_bytes = PyBytes_AS_STRING(path);
     if (!dbus_py_validate_object_path(path_bytes)) {
@@ -750,19 +1169,12 @@ Connection__register_object_path(Connection *self, PyObject *args,
         return NULL;
     }
 
-    tuple = Py_BuildValue("(OO)", on_unregister, on_message);
-    if (!tuple) {
-        Py_CLEAR(path);
-        return NULL;
-    }
-
     /* Guard against registering a handler that already exists. */
     callbacks = PyDict_GetItem(self->object_paths, path);
     if (callbacks && callbacks != Py_None) {
         PyErr_Format(PyExc_KeyError, "Can't register the object-path "
                      "handler for '%s': there is already a handler",
                      path_bytes);
-        Py_CLEAR(tuple);
         Py_CLEAR(path);
         return NULL;
     }
@@ -772,7 +1184,6 @@ Connection__register_object_path(Connection *self, PyObject *args,
      * This ensures we can keep libdbus' opinion of whether those
      * paths are handled in sync with our own. */
     if (PyDict_SetItem(self->object_paths, path, Py_None) < 0) {
-        Py_CLEAR(tuple);
         Py_CLEAR(path);
         return NULL;
     }
@@ -793,7 +1204,7 @@ Connection__register_object_path(Connection *self, PyObject *args,
     Py_END_ALLOW_THREADS
 
     if (ok) {
-        if (PyDict_SetItem(self->object_paths, path, tuple) < 0) {
+        if (PyDict_SetItem(self->object_paths, path, handlers) < 0) {
             /* That shouldn't have happened, we already allocated enough
             memory for it. Oh well, try to undo the registration to keep
             things in sync. If this fails too, we've leaked a bit of
@@ -805,20 +1216,118 @@ Connection__register_object_path(Connection *self, PyObject *args,
             return NULL;
         }
         /* don't DECREF path: libdbus owns a ref now */
-        Py_CLEAR(tuple);
         Py_RETURN_NONE;
     }
     else {
         /* Oops, OOM. Tidy up, if we can, ignoring any error. */
         PyDict_DelItem(self->object_paths, path);
         PyErr_Clear();
-        Py_CLEAR(tuple);
         Py_CLEAR(path);
         PyErr_NoMemory();
         return NULL;
     }
 }
 
+PyDoc_STRVAR(Connection__register_object_path__doc__,
+"register_object_path(path, on_message, on_unregister=None, fallback=False)\n"
+"\n"
+"Register a callback to be called when messages arrive at the given\n"
+"object-path. Used to export objects' methods on the bus in a low-level\n"
+"way. For the high-level interface to this functionality (usually\n"
+"recommended) see the `dbus.service.Object` base class.\n"
+"\n"
+":Parameters:\n"
+"   `path` : str\n"
+"       Object path to be acted on\n"
+"   `on_message` : callable\n"
+"       Called when a message arrives at the given object-path, with\n"
+"       two positional parameters: the first is this Connection,\n"
+"       the second is the incoming `dbus.lowlevel.Message`.\n"
+"   `on_unregister` : callable or None\n"
+"       If not None, called when the callback is unregistered.\n"
+"   `fallback` : bool\n"
+"       If True (the default is False), when a message arrives for a\n"
+"       'subdirectory' of the given path and there is no more specific\n"
+"       handler, use this handler. Normally this handler is only run if\n"
+"       the paths match exactly.\n"
+);
+static PyObject *
+Connection__register_object_path(Connection *self, PyObject *args,
+                                 PyObject *kwargs)
+{
+    int fallback = 0;
+    PyObject *path, *tuple, *on_message, *on_unregister = Py_None, *ret;
+    static char *argnames[] = {"path", "on_message", "on_unregister",
+                               "fallback", NULL};
+
+    TRACE(self);
+    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
+    if (!Connection__require_main_loop(self, NULL)) {
+        return NULL;
+    }
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs,
+                                     "OO|Oi:_register_object_path",
+                                     argnames,
+                                     &path,
+                                     &on_message, &on_unregister,
+                                     &fallback)) return NULL;
+
+    tuple = Py_BuildValue("(OO)", on_unregister, on_message);
+    if (!tuple) return NULL;
+
+    ret = _register_path(self, path, tuple, fallback);
+    Py_CLEAR(tuple);
+    return ret;
+}
+
+PyDoc_STRVAR(Connection__register_object__doc__,
+"_register_object(path, obj, fallback=False)\n"
+"\n"
+"Register an object to handle messages arriving at the given object-path,\n"
+"by calling ``obj._dbus_message_cb(connection, message)`` with the same\n"
+"parameters and return value as the ``on_message`` callback of\n"
+"`_register_object_path`. Used by `dbus.service.LightweightObject`.\n"
+"\n"
+"Only a reference to obj is kept, so the callback is normally a method\n"
+"of obj's class rather than anything stored per object. There is no\n"
+"unregistration callback.\n"
+"\n"
+":Parameters:\n"
+"   `path` : str\n"
+"       Object path to be acted on\n"
+"   `obj` : object\n"
+"       The object handling messages at that path\n"
+"   `fallback` : bool\n"
+"       As for `_register_object_path`\n"
+":Since: 1.2.1\n"
+);
+static PyObject *
+Connection__register_object(Connection *self, PyObject *args,
+                            PyObject *kwargs)
+{
+    int fallback = 0;
+    PyObject *path, *obj;
+    static char *argnames[] = {"path", "obj", "fallback", NULL};
+
+    TRACE(self);
+    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
+    if (!Connection__require_main_loop(self, NULL)) {
+        return NULL;
+    }
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs,
+                                     "OO|i:_register_object",
+                                     argnames, &path, &obj, &fallback)) {
+        return NULL;
+    }
+    /* tuples and None have other meanings in ->object_paths */
+    if (PyTuple_Check(obj) || obj == Py_None) {
+        PyErr_SetString(PyExc_TypeError, "obj cannot be a tuple or None");
+        return NULL;
+    }
+
+    return _register_path(self, path, obj, fallback);
+}
+
 PyDoc_STRVAR(Connection__unregister_object_path__doc__,
 "unregister_object_path(path)\n\n"
 "Remove a previously registered handler for the given object path.\n"
@@ -845,23 +1354,9 @@ Connection__unregister_object_path(Connection *self, PyObject *args,
                                      "O:_unregister_object_path",
                                      argnames, &path)) return NULL;
 
-    /* Take a ref to the path. Same comments as for _register_object_path. */
-    if (PyBytes_CheckExact(path)) {
-        Py_INCREF(path);
-    }
-    else if (PyUnicode_Check(path)) {
-        path = PyUnicode_AsUTF8String(path);
-        if (!path) return NULL;
-    }
-    else if (PyBytes_Check(path)) {
-        path = PyBytes_FromString(PyBytes_AS_STRING(path));
-        if (!path) return NULL;
-    }
-    else {
-        PyErr_SetString(PyExc_TypeError,
-                        "path must be a str, bytes, or unicode object");
-        return NULL;
-    }
+    /* Take a ref to the path. */
+    path = _object_path_bytes(path);
+    if (!path) return NULL;
 
     path_bytes = PyBytes_AS_STRING(path);
 
@@ -934,6 +1429,257 @@ Connection__unregister_object_path(Connection *self, PyObject *args,
     }
 }
 
+PyDoc_STRVAR(Connection__register_object_paths__doc__,
+"_register_object_paths(entries)\n\n"
+"Register handlers for many object paths at once. Either all of them are\n"
+"registered, or none are and an exception is raised.\n"
+"\n"
+":Parameters:\n"
+"   `entries` : sequence of (str, object, bool)\n"
+"       Tuples (path, handler, fallback). The handler is either a tuple\n"
+"       (on_unregister, on_message) as for `_register_object_path`, or an\n"
+"       object as for `_register_object`.\n"
+":Raises KeyError: if a path already has a handler, or appears twice\n"
+":Since: 1.2.1\n"
+);
+static PyObject *
+Connection__register_object_paths(Connection *self, PyObject *entries)
+{
+    PyObject *fast, *paths = NULL, *seen = NULL, *ret = NULL;
+    int *fallbacks = NULL;
+    Py_ssize_t i, n, reserved = 0, registered = 0;
+    dbus_bool_t ok = TRUE;
+
+    TRACE(self);
+    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
+    if (!Connection__require_main_loop(self, NULL)) {
+        return NULL;
+    }
+    fast = PySequence_Fast(entries, "entries must be a sequence");
+    if (!fast) return NULL;
+    n = PySequence_Fast_GET_SIZE(fast);
+
+    paths = PyList_New(n);
+    seen = PySet_New(NULL);
+    fallbacks = dbus_new(int, n ? n : 1);
+    if (!paths || !seen || !fallbacks) {
+        if (!fallbacks) PyErr_NoMemory();
+        goto out;
+    }
+
+    /* Check everything before changing anything */
+    for (i = 0; i < n; i++) {
+        PyObject *entry = PySequence_Fast_GET_ITEM(fast, i);
+        PyObject *path, *handler, *callbacks;
+        int found;
+
+        if (!PyTuple_Check(entry)) {
+            PyErr_SetString(PyExc_TypeError, "entries must be tuples "
+                            "(path, handler, fallback)");
+            goto out;
+        }
+        if (!PyArg_ParseTuple(entry,
+                              "OOi:_register_object_paths",
+                              &path, &handler, &fallbacks[i])) goto out;
+        if (handler == Py_None) {
+            PyErr_SetString(PyExc_TypeError, "handler cannot be None");
+            goto out;
+        }
+        path = _object_path_bytes(path);
+        if (!path) goto out;
+        PyList_SET_ITEM(paths, i, path);
+        if (!dbus_py_validate_object_path(PyBytes_AS_STRING(path))) goto out;
+
+        callbacks = PyDict_GetItem(self->object_paths, path);
+        found = PySet_Contains(seen, path);
+        if (found < 0) goto out;
+        if (found || (callbacks && callbacks != Py_None)) {
+            PyErr_Format(PyExc_KeyError, "Can't register the object-path "
+                         "handler for '%s': there is already a handler",
+                         PyBytes_AS_STRING(path));
+            goto out;
+        }
+        if (PySet_Add(seen, path) < 0) goto out;
+    }
+
+    /* Pre-allocate slots in the dictionary, as in _register_object_path */
+    for (reserved = 0; reserved < n; reserved++) {
+        if (PyDict_SetItem(self->object_paths,
+                           PyList_GET_ITEM(paths, reserved), Py_None) < 0) {
+            goto out;
+        }
+    }
+
+    /* libdbus owns a ref to each path it registers */
+    for (i = 0; i < n; i++) {
+        Py_INCREF(PyList_GET_ITEM(paths, i));
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    for (registered = 0; registered < n; registered++) {
+        PyObject *path = PyList_GET_ITEM(paths, registered);
+
+        if (fallbacks[registered]) {
+            ok = dbus_connection_register_fallback(self->conn,
+                                                   PyBytes_AS_STRING(path),
+                                                   &_object_path_vtable,
+                                                   path);
+        }
+        else {
+            ok = dbus_connection_register_object_path(self->conn,
+                                                      PyBytes_AS_STRING(path),
+                                                      &_object_path_vtable,
+                                                      path);
+        }
+        if (!ok) break;
+    }
+    Py_END_ALLOW_THREADS
+
+    for (i = registered; i < n; i++) {
+        Py_DECREF(PyList_GET_ITEM(paths, i));
+    }
+
+    if (!ok) {
+        /* Oops, OOM. Undo the registrations, which releases libdbus'
+         * refs to the paths. */
+        Py_BEGIN_ALLOW_THREADS
+        for (i = 0; i < registered; i++) {
+            dbus_connection_unregister_object_path(self->conn,
+                PyBytes_AS_STRING(PyList_GET_ITEM(paths, i)));
+        }
+        Py_END_ALLOW_THREADS
+        PyErr_NoMemory();
+        goto out;
+    }
+
+    for (i = 0; i < n; i++) {
+        PyObject *handler = PyTuple_GET_ITEM(PySequence_Fast_GET_ITEM(fast,
+                                                                      i), 1);
+
+        /* can't fail: the slot already exists */
+        PyDict_SetItem(self->object_paths, PyList_GET_ITEM(paths, i),
+                       handler);
+    }
+    reserved = 0;
+    Py_INCREF(Py_None);
+    ret = Py_None;
+
+out:
+    /* Tidy up any reservations, ignoring errors */
+    if (reserved > 0) {
+        PyObject *et, *ev, *etb;
+
+        PyErr_Fetch(&et, &ev, &etb);
+        for (i = 0; i < reserved; i++) {
+            PyDict_DelItem(self->object_paths, PyList_GET_ITEM(paths, i));
+        }
+        PyErr_Clear();
+        PyErr_Restore(et, ev, etb);
+    }
+    dbus_free(fallbacks);
+    Py_CLEAR(seen);
+    Py_CLEAR(paths);
+    Py_CLEAR(fast);
+    return ret;
+}
+
+PyDoc_STRVAR(Connection__unregister_object_paths__doc__,
+"_unregister_object_paths(paths)\n\n"
+"Remove the handlers for many object paths at once.\n"
+"\n"
+":Parameters:\n"
+"   `paths` : sequence of str\n"
+"       The object paths whose handlers are to be removed\n"
+":Raises KeyError: if there is no handler registered for exactly one of\n"
+"   the object paths, in which case none are removed.\n"
+":Since: 1.2.1\n"
+);
+static PyObject *
+Connection__unregister_object_paths(Connection *self, PyObject *seq)
+{
+    PyObject *fast, *paths = NULL, *callbacks = NULL, *ret = NULL;
+    Py_ssize_t i, n, cleared = 0, unregistered = 0;
+    dbus_bool_t ok = TRUE;
+
+    TRACE(self);
+    DBUS_PY_RAISE_VIA_NULL_IF_FAIL(self->conn);
+    fast = PySequence_Fast(seq, "paths must be a sequence");
+    if (!fast) return NULL;
+    n = PySequence_Fast_GET_SIZE(fast);
+
+    paths = PyList_New(n);
+    callbacks = PyList_New(n);
+    if (!paths || !callbacks) goto out;
+
+    for (i = 0; i < n; i++) {
+        PyObject *path = _object_path_bytes(PySequence_Fast_GET_ITEM(fast, i));
+        PyObject *handler;
+
+        if (!path) goto out;
+        PyList_SET_ITEM(paths, i, path);
+
+        /* Guard against unregistering a handler that doesn't exist, whose
+        unregistration is already in progress, or that is listed twice. */
+        handler = PyDict_GetItem(self->object_paths, path);
+        if (!handler || handler == Py_None) {
+            PyErr_Format(PyExc_KeyError, "Can't unregister the object-path "
+                         "handler for '%s': there is no such handler",
+                         PyBytes_AS_STRING(path));
+            goto out;
+        }
+        Py_INCREF(handler);
+        PyList_SET_ITEM(callbacks, i, handler);
+
+        /* As in _unregister_object_path, set the handler to None while we
+        still have the GIL */
+        if (PyDict_SetItem(self->object_paths, path, Py_None) < 0) goto out;
+        cleared = i + 1;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    for (unregistered = 0; unregistered < n; unregistered++) {
+        ok = dbus_connection_unregister_object_path(self->conn,
+            PyBytes_AS_STRING(PyList_GET_ITEM(paths, unregistered)));
+        if (!ok) break;
+    }
+    Py_END_ALLOW_THREADS
+
+    for (i = 0; i < unregistered; i++) {
+        PyDict_DelItem(self->object_paths, PyList_GET_ITEM(paths, i));
+    }
+    /* The above can't fail unless by some strange trickery the key is no
+    longer present. Ignore any errors. */
+    PyErr_Clear();
+
+    if (!ok) {
+        /* Oops, OOM. The handlers that are still registered are put back
+         * below. */
+        PyErr_NoMemory();
+        goto out;
+    }
+    Py_INCREF(Py_None);
+    ret = Py_None;
+
+out:
+    /* Put back the handlers of any paths that are still registered,
+     * including any that were listed twice */
+    if (cleared > unregistered) {
+        PyObject *et, *ev, *etb;
+
+        PyErr_Fetch(&et, &ev, &etb);
+        for (i = cleared - 1; i >= unregistered; i--) {
+            PyDict_SetItem(self->object_paths, PyList_GET_ITEM(paths, i),
+                           PyList_GET_ITEM(callbacks, i));
+        }
+        PyErr_Clear();
+        PyErr_Restore(et, ev, etb);
+    }
+    Py_CLEAR(callbacks);
+    Py_CLEAR(paths);
+    Py_CLEAR(fast);
+    return ret;
+}
+
 PyDoc_STRVAR(Connection_list_exported_child_objects__doc__,
 "list_exported_child_objects(path: str) -> list of str\n\n"
 "Return a list of the names of objects exported on this Connection as\n"
@@ -1034,21 +1780,28 @@ PyDoc_STRVAR(set_unique_name__doc__,
 struct PyMethodDef DBusPyConnection_tp_methods[] = {
 #define ENTRY(name, flags) {#name, (PyCFunction)Connection_##name, flags, Connection_##name##__doc__}
     ENTRY(_require_main_loop, METH_NOARGS),
+    ENTRY(_send_error_reply, METH_VARARGS),
     ENTRY(close, METH_NOARGS),
     ENTRY(flush, METH_NOARGS),
+    ENTRY(forward, METH_VARARGS|METH_KEYWORDS),
     ENTRY(get_is_connected, METH_NOARGS),
     ENTRY(get_is_authenticated, METH_NOARGS),
     ENTRY(set_exit_on_disconnect, METH_VARARGS),
+    ENTRY(set_sender_limits, METH_VARARGS|METH_KEYWORDS),
+    ENTRY(get_sender_stats, METH_NOARGS),
     ENTRY(get_unix_fd, METH_NOARGS),
     ENTRY(get_peer_unix_user, METH_NOARGS),
     ENTRY(get_peer_unix_process_id, METH_NOARGS),
     ENTRY(add_message_filter, METH_O),
+    ENTRY(_register_object, METH_VARARGS|METH_KEYWORDS),
     ENTRY(_register_object_path, METH_VARARGS|METH_KEYWORDS),
+    ENTRY(_register_object_paths, METH_O),
     ENTRY(remove_message_filter, METH_O),
-    ENTRY(send_message, METH_VARARGS),
-    ENTRY(send_message_with_reply, METH_VARARGS|METH_KEYWORDS),
-    ENTRY(send_message_with_reply_and_block, METH_VARARGS),
+    ENTRY(send_message, METH_O),
+    ENTRY(send_message_with_reply, DBUS_PY_METH_KEYWORDS),
+    ENTRY(send_message_with_reply_and_block, DBUS_PY_METH_KEYWORDS),
     ENTRY(_unregister_object_path, METH_VARARGS|METH_KEYWORDS),
+    ENTRY(_unregister_object_paths, METH_O),
     ENTRY(list_exported_child_objects, METH_VARARGS|METH_KEYWORDS),
     {"_new_for_bus", (PyCFunction)DBusPyConnection_NewForBus,
         METH_CLASS|METH_VARARGS|METH_KEYWORDS,
@@ -1064,4 +1817,93 @@ struct PyMethodDef DBusPyConnection_tp_methods[] = {
 #undef ENTRY
 };
 
+/* C API ============================================================ */
+
+/* Turn the result of one of the methods above into 0 or -1. */
+static int
+_status_from_result(PyObject *result)
+{
+    if (!result) return -1;
+    Py_CLEAR(result);
+    return 0;
+}
+
+int
+DBusPyConnection_RegisterObjectPath(PyObject *conn, const char *path,
+                                    PyObject *on_message, int fallback)
+{
+    Connection *self = (Connection *)conn;
+    PyObject *path_obj, *tuple, *ret;
+
+    if (!DBusPyConnection_BorrowDBusConnection(conn)) return -1;
+    if (!Connection__require_main_loop(self, NULL)) return -1;
+
+    path_obj = PyBytes_FromString(path);
+    if (!path_obj) return -1;
+    tuple = Py_BuildValue("(OO)", Py_None, on_message);
+    if (!tuple) {
+        Py_CLEAR(path_obj);
+        return -1;
+    }
+    ret = _register_path(self, path_obj, tuple, fallback);
+    Py_CLEAR(tuple);
+    Py_CLEAR(path_obj);
+    return _status_from_result(ret);
+}
+
+int
+DBusPyConnection_UnregisterObjectPath(PyObject *conn, const char *path)
+{
+    PyObject *args, *ret;
+
+    if (!DBusPyConnection_BorrowDBusConnection(conn)) return -1;
+    args = Py_BuildValue("(s)", path);
+    if (!args) return -1;
+    ret = Connection__unregister_object_path((Connection *)conn, args, NULL);
+    Py_CLEAR(args);
+    return _status_from_result(ret);
+}
+
+int
+DBusPyConnection_SendMessage(PyObject *conn, DBusMessage *msg,
+                             dbus_uint32_t *serial)
+{
+    Connection *self = (Connection *)conn;
+    DBusConnection *dbc = DBusPyConnection_BorrowDBusConnection(conn);
+    dbus_bool_t ok;
+
+    if (!dbc) return -1;
+
+    Py_BEGIN_ALLOW_THREADS
+    ok = dbus_connection_send(dbc, msg, serial);
+    Py_END_ALLOW_THREADS
+
+    if (!ok) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    /* a reply to a call admitted by the sender limits is no longer in
+     * flight */
+    if (self->sender_limits) {
+        DBusPySenderLimits_ReplySent(self->sender_limits, msg);
+    }
+    return 0;
+}
+
+int
+DBusPyConnection_AddMessageFilter(PyObject *conn, PyObject *filter)
+{
+    if (!DBusPyConnection_BorrowDBusConnection(conn)) return -1;
+    return _status_from_result(
+        Connection_add_message_filter((Connection *)conn, filter));
+}
+
+int
+DBusPyConnection_RemoveMessageFilter(PyObject *conn, PyObject *filter)
+{
+    if (!DBusPyConnection_BorrowDBusConnection(conn)) return -1;
+    return _status_from_result(
+        Connection_remove_message_filter((Connection *)conn, filter));
+}
+
 /* vim:set ft=c cino< sw=4 sts=4 et: */
@@ -65,6 +65,118 @@ DBusPyConnection_BorrowDBusConnection(PyObject *self)
     return dbc;
 }
 
+/* Native message handlers ========================================== */
+
+PyDoc_STRVAR(NativeMessageHandler_tp_doc,
+"Object representing a D-Bus message handler implemented in native code.\n"
+"It can be registered as an object-path handler or message filter, and\n"
+"called like one. Cannot be instantiated directly.\n"
+);
+
+static PyTypeObject NativeMessageHandler_Type;
+
+DEFINE_CHECK(NativeMessageHandler)
+
+typedef struct {
+    PyObject_HEAD
+    /* Called with the GIL held, may set a Python exception */
+    _dbus_py_message_handler_func handler_cb;
+    /* Called in a destructor. Must not touch the exception state (use
+     * PyErr_Fetch and PyErr_Restore if necessary). */
+    _dbus_py_free_func free_cb;
+    void *data;
+} NativeMessageHandler;
+
+static void
+NativeMessageHandler_tp_dealloc(NativeMessageHandler *self)
+{
+    if (self->data && self->free_cb) {
+        (self->free_cb)(self->data);
+    }
+    PyObject_Del((PyObject *)self);
+}
+
+static PyObject *
+NativeMessageHandler_tp_call(NativeMessageHandler *self, PyObject *args,
+                             PyObject *kwargs)
+{
+    PyObject *conn, *msg;
+    DBusMessage *message;
+    DBusHandlerResult ret;
+
+    if (kwargs && PyDict_Size(kwargs) != 0) {
+        PyErr_SetString(PyExc_TypeError, "NativeMessageHandler takes no "
+                        "keyword arguments");
+        return NULL;
+    }
+    if (!PyArg_ParseTuple(args, "O!O:NativeMessageHandler",
+                          &DBusPyConnection_Type, &conn, &msg))
+        return NULL;
+    message = DBusPyMessage_BorrowDBusMessage(msg);
+    if (!message) return NULL;
+
+    ret = (self->handler_cb)(conn, message, self->data);
+    if (PyErr_Occurred()) return NULL;
+    return NATIVEINT_FROMLONG(ret);
+}
+
+static PyTypeObject NativeMessageHandler_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "_dbus_bindings.NativeMessageHandler",  /* tp_name */
+    sizeof(NativeMessageHandler),           /* tp_basicsize */
+    0,                                      /* tp_itemsize */
+    (destructor)NativeMessageHandler_tp_dealloc, /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    (ternaryfunc)NativeMessageHandler_tp_call, /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                     /* tp_flags */
+    NativeMessageHandler_tp_doc,            /* tp_doc */
+    0,                                      /* tp_traverse */
+    0,                                      /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    0,                                      /* tp_methods */
+    0,                                      /* tp_members */
+    0,                                      /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    /* deliberately not instantiable from Python */
+    0,                                      /* tp_new */
+};
+
+PyObject *
+DBusPyNativeMessageHandler_New(_dbus_py_message_handler_func handler_cb,
+                               _dbus_py_free_func free_cb,
+                               void *data)
+{
+    NativeMessageHandler *self = PyObject_New(NativeMessageHandler,
+                                              &NativeMessageHandler_Type);
+    if (self) {
+        self->handler_cb = handler_cb;
+        self->free_cb = free_cb;
+        self->data = data;
+    }
+    return (PyObject *)self;
+}
+
 /* Internal C API =================================================== */
 
 /* Pass a message through a handler. */
@@ -123,6 +235,45 @@ DBusPyConnection_HandleMessage(Connection *conn,
     }
 }
 
+/* Pass a libdbus message through a handler, wrapping it in a Message
+ * only if the handler is not a NativeMessageHandler. */
+DBusHandlerResult
+DBusPyConnection_HandleDBusMessage(Connection *conn,
+                                   DBusMessage *message,
+                                   PyObject *callable)
+{
+    DBusHandlerResult ret;
+    PyObject *msg_obj;
+
+    TRACE(conn);
+    if (NativeMessageHandler_Check(callable)) {
+        NativeMessageHandler *nmh = (NativeMessageHandler *)callable;
+
+        ret = (nmh->handler_cb)((PyObject *)conn, message, nmh->data);
+        if (PyErr_Occurred()) {
+            if (PyErr_ExceptionMatches(PyExc_MemoryError)) {
+                DBG_EXC("%p: native handler %p caused OOM", conn, callable);
+                PyErr_Clear();
+                return DBUS_HANDLER_RESULT_NEED_MEMORY;
+            }
+            DBG_EXC("%p: native handler %p raised exception", conn,
+                    callable);
+            return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+        }
+        return ret;
+    }
+
+    dbus_message_ref(message);
+    msg_obj = DBusPyMessage_ConsumeDBusMessage(message);
+    if (!msg_obj) {
+        DBG("%s", "OOM while trying to construct Message");
+        return DBUS_HANDLER_RESULT_NEED_MEMORY;
+    }
+    ret = DBusPyConnection_HandleMessage(conn, msg_obj, callable);
+    Py_CLEAR(msg_obj);
+    return ret;
+}
+
 /* On KeyError or if unregistration is in progress, return None. */
 PyObject *
 DBusPyConnection_GetObjectPathHandlers(PyObject *self, PyObject *path)
@@ -233,6 +384,7 @@ DBusPyConnection_NewConsumingDBusConnection(PyTypeObject *cls,
     self->conn = NULL;
     self->filters = PyList_New(0);
     self->weaklist = NULL;
+    self->sender_limits = NULL;
     if (!self->filters) goto err;
     self->object_paths = PyDict_New();
     if (!self->object_paths) goto err;
@@ -421,6 +573,9 @@ static void Connection_tp_dealloc(Connection *self)
         dbus_connection_unref(conn);
     }
 
+    DBusPySenderLimits_Free(self->sender_limits);
+    self->sender_limits = NULL;
+
     DBG("Connection at %p: freeing self", self);
     PyErr_Restore(et, ev, etb);
     (Py_TYPE(self)->tp_free)((PyObject *)self);
@@ -476,6 +631,8 @@ PyTypeObject DBusPyConnection_Type = {
     0,                      /*tp_is_gc*/
 };
 
+PyObject *dbus_py__dbus_message_cb_const = NULL;
+
 dbus_bool_t
 dbus_py_init_conn_types(void)
 {
@@ -483,8 +640,13 @@ dbus_py_init_conn_types(void)
     _connection_python_slot = -1;
     if (!dbus_connection_allocate_data_slot(&_connection_python_slot))
         return FALSE;
+    dbus_py__dbus_message_cb_const = NATIVESTR_FROMSTR("_dbus_message_cb");
+    if (!dbus_py__dbus_message_cb_const)
+        return FALSE;
     if (PyType_Ready(&DBusPyConnection_Type) < 0)
         return FALSE;
+    if (PyType_Ready(&NativeMessageHandler_Type) < 0)
+        return FALSE;
     return TRUE;
 }
 
@@ -495,6 +657,10 @@ dbus_py_insert_conn_types(PyObject *this_module)
     Py_INCREF (&DBusPyConnection_Type);
     if (PyModule_AddObject(this_module, "Connection",
                            (PyObject *)&DBusPyConnection_Type) < 0) return FALSE;
+    Py_INCREF (&NativeMessageHandler_Type);
+    if (PyModule_AddObject(this_module, "NativeMessageHandler",
+                           (PyObject *)&NativeMessageHandler_Type) < 0)
+        return FALSE;
     return TRUE;
 }
 
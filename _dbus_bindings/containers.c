@@ -1,4 +1,4 @@
-/* D-Bus container types: Array, Dict and Struct.
+/* D-Bus container types: Array, Dict, Struct and VarDict.
  *
  * Copyright (C) 2006-2007 Collabora Ltd. <http://www.collabora.co.uk/>
  *
@@ -780,11 +780,1162 @@ PyTypeObject DBusPyStruct_Type = {
     Struct_tp_new,                          /* tp_new */
 };
 
+/* VarDict ========================================================== */
+
+PyDoc_STRVAR(VarDict_tp_doc,
+"An immutable mapping from strings to values of any type, which is sent\n"
+"over D-Bus as a dict of signature ``a{sv}``: the usual type for\n"
+"properties, hints and other extensible options.\n"
+"\n"
+"The D-Bus type of each value is worked out once, when the VarDict is\n"
+"made, rather than every time it's sent; if the VarDict was received in\n"
+"a message (see the ``vardicts`` option of `Message.get_args_list`),\n"
+"it's the type the sender used. The keys are interned, so looking up\n"
+"a key which is a string literal is fast.\n"
+"\n"
+"Constructor::\n"
+"\n"
+"    VarDict(mapping_or_iterable=(), signatures=None, variant_level=0)\n"
+"\n"
+"``mapping_or_iterable`` is a mapping or an iterable of (key, value)\n"
+"pairs, as for dict. The keys must be strings.\n"
+"\n"
+"``signatures`` is either None or a mapping from some of the keys to\n"
+"the D-Bus signature of their values, such as ``{'Volume': 'u'}``. The\n"
+"signatures of the other values are guessed, as they would be for a\n"
+"Variant, unless they are copied from another VarDict.\n"
+"\n"
+"``variant_level`` must be non-negative; the default is 0.\n"
+"\n"
+"A VarDict is equal to any VarDict or dict with equal items, and is\n"
+"hashable if its values are. Its ``keys()``, ``values()`` and\n"
+"``items()`` return lists, as in Python 2, rather than views.\n"
+"\n"
+":IVariables:\n"
+"  `variant_level` : int\n"
+"    Indicates how many nested Variant containers this object\n"
+"    is contained in, as for `Dictionary`.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+static struct PyMemberDef VarDict_tp_members[] = {
+    {"variant_level", T_LONG, offsetof(DBusPyVarDict, variant_level),
+     READONLY,
+     "The number of nested variants wrapping the real data. "
+     "0 if not in a variant."},
+    {NULL},
+};
+
+/* Double the size of the hash table (or make the first one), and put
+ * all the entries back in. */
+static int
+_vardict_grow_slots(DBusPyVarDict *self)
+{
+    size_t n_slots = self->n_slots ? self->n_slots * 2 : 8;
+    Py_ssize_t *slots = PyMem_New(Py_ssize_t, n_slots);
+    Py_ssize_t i;
+    size_t j;
+
+    if (!slots) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (j = 0; j < n_slots; j++) {
+        slots[j] = -1;
+    }
+    for (i = 0; i < self->n_entries; i++) {
+        j = (size_t)self->entries[i].hash & (n_slots - 1);
+        while (slots[j] >= 0) {
+            j = (j + 1) & (n_slots - 1);
+        }
+        slots[j] = i;
+    }
+    PyMem_Free(self->slots);
+    self->slots = slots;
+    self->n_slots = n_slots;
+    return 0;
+}
+
+/* Set *slot to the slot of the hash table which holds key, or the empty
+ * one where it would go. Return 0, or -1 if comparing keys raised an
+ * exception. */
+static int
+_vardict_find(DBusPyVarDict *self, PyObject *key, dbus_py_hash_t hash,
+              size_t *slot)
+{
+    size_t mask = self->n_slots - 1;
+    size_t i = (size_t)hash & mask;
+
+    while (self->slots[i] >= 0) {
+        DBusPyVarDictEntry *entry = &self->entries[self->slots[i]];
+
+        /* the usual case, since keys are interned */
+        if (entry->key == key) break;
+        if (entry->hash == hash) {
+            int equal = PyObject_RichCompareBool(entry->key, key, Py_EQ);
+
+            if (equal < 0) return -1;
+            if (equal) break;
+        }
+        i = (i + 1) & mask;
+    }
+    *slot = i;
+    return 0;
+}
+
+/* Return a borrowed pointer to the entry for key, or NULL, with an
+ * exception set if there was an error rather than no such key. */
+static DBusPyVarDictEntry *
+_vardict_lookup(DBusPyVarDict *self, PyObject *key)
+{
+    dbus_py_hash_t hash = PyObject_Hash(key);
+    size_t slot;
+
+    if (hash == -1) return NULL;
+    if (_vardict_find(self, key, hash, &slot) < 0) return NULL;
+    if (self->slots[slot] < 0) return NULL;
+    return &self->entries[self->slots[slot]];
+}
+
+static PyObject *
+_vardict_alloc(PyTypeObject *cls, long variant_level)
+{
+    DBusPyVarDict *self = (DBusPyVarDict *)(cls->tp_alloc)(cls, 0);
+
+    if (!self) return NULL;
+    self->variant_level = variant_level;
+    self->hash = -1;
+    if (_vardict_grow_slots(self) < 0) {
+        Py_CLEAR(self);
+        return NULL;
+    }
+    return (PyObject *)self;
+}
+
+/* Return a new, empty VarDict. Only the code which creates it may add
+ * items to it, before anything else sees it. */
+PyObject *
+DBusPyVarDict_New(long variant_level)
+{
+    return _vardict_alloc(&DBusPyVarDict_Type, variant_level);
+}
+
+/* Add an item to a VarDict, or replace the item with an equal key. The
+ * signature of the value, which must be a single complete type, is len
+ * bytes at signature; if signature is NULL, it's guessed. */
+int
+DBusPyVarDict_Add(PyObject *obj, PyObject *key, PyObject *value,
+                  const char *signature, size_t len)
+{
+    DBusPyVarDict *self = (DBusPyVarDict *)obj;
+    PyObject *guessed = NULL;
+    DBusPyVarDictEntry *entry;
+    dbus_py_hash_t hash;
+    size_t slot, offset;
+
+#ifdef PY3
+    if (!PyUnicode_Check(key)) {
+#else
+    if (!PyUnicode_Check(key) && !PyBytes_Check(key)) {
+#endif
+        PyErr_SetString(PyExc_TypeError, "The keys of a VarDict must be "
+                        "strings");
+        return -1;
+    }
+
+    if (!signature) {
+        guessed = dbus_py_guess_variant_signature(value);
+        if (!guessed) return -1;
+        signature = PyBytes_AS_STRING(guessed);
+        len = PyBytes_GET_SIZE(guessed);
+    }
+
+    if (self->signatures_len + len + 1 > self->signatures_allocated) {
+        size_t n = self->signatures_allocated ? self->signatures_allocated
+                                              : 64;
+        char *signatures;
+
+        while (n < self->signatures_len + len + 1) {
+            n *= 2;
+        }
+        signatures = PyMem_Realloc(self->signatures, n);
+        if (!signatures) {
+            Py_CLEAR(guessed);
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->signatures = signatures;
+        self->signatures_allocated = n;
+    }
+    offset = self->signatures_len;
+    memcpy(self->signatures + offset, signature, len);
+    self->signatures[offset + len] = '\0';
+    self->signatures_len += len + 1;
+    Py_CLEAR(guessed);
+
+    Py_INCREF(key);
+#ifdef PY3
+    if (PyUnicode_CheckExact(key)) PyUnicode_InternInPlace(&key);
+#else
+    if (PyBytes_CheckExact(key)) PyString_InternInPlace(&key);
+#endif
+    hash = PyObject_Hash(key);
+    if (hash == -1 || _vardict_find(self, key, hash, &slot) < 0) {
+        Py_CLEAR(key);
+        return -1;
+    }
+    self->hash = -1;
+
+    if (self->slots[slot] >= 0) {
+        PyObject *old;
+
+        entry = &self->entries[self->slots[slot]];
+        old = entry->value;
+        Py_INCREF(value);
+        entry->value = value;
+        entry->signature = offset;
+        Py_CLEAR(old);
+        Py_CLEAR(key);
+        return 0;
+    }
+
+    if (self->n_entries == self->n_allocated) {
+        Py_ssize_t n = self->n_allocated ? self->n_allocated * 2 : 8;
+        DBusPyVarDictEntry *entries = self->entries;
+
+        PyMem_Resize(entries, DBusPyVarDictEntry, n);
+        if (!entries) {
+            Py_CLEAR(key);
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->entries = entries;
+        self->n_allocated = n;
+    }
+    entry = &self->entries[self->n_entries];
+    entry->key = key;
+    Py_INCREF(value);
+    entry->value = value;
+    entry->hash = hash;
+    entry->signature = offset;
+    self->slots[slot] = self->n_entries++;
+
+    if ((size_t)self->n_entries * 2 > self->n_slots) {
+        /* the entry is already added, so this failing just leaves the
+         * hash table fuller than it should be */
+        if (_vardict_grow_slots(self) < 0) return -1;
+    }
+    return 0;
+}
+
+/* Add an item to a VarDict being constructed, with the signature from
+ * signatures if it's there, or else from default_signature if that's
+ * not NULL, or else guessed */
+static int
+_vardict_add_with_signatures(PyObject *self, PyObject *key, PyObject *value,
+                             PyObject *signatures,
+                             const char *default_signature)
+{
+    PyObject *signature = NULL;
+    PyObject *signature_as_bytes = NULL;
+    int ret = -1;
+
+    if (signatures != Py_None) {
+        signature = PyObject_GetItem(signatures, key);
+        if (!signature) {
+            if (!PyErr_ExceptionMatches(PyExc_KeyError)) return -1;
+            PyErr_Clear();
+        }
+    }
+
+    if (!signature) {
+        return DBusPyVarDict_Add(self, key, value, default_signature,
+                                 default_signature
+                                 ? strlen(default_signature) : 0);
+    }
+
+    if (PyUnicode_Check(signature)) {
+        signature_as_bytes = PyUnicode_AsUTF8String(signature);
+        if (!signature_as_bytes) goto finally;
+    }
+#ifndef PY3
+    else if (PyBytes_Check(signature)) {
+        signature_as_bytes = signature;
+        Py_INCREF(signature_as_bytes);
+    }
+#endif
+    else {
+        PyErr_SetString(PyExc_TypeError, "The signatures of a VarDict's "
+                        "values must be strings");
+        goto finally;
+    }
+
+    if (!dbus_signature_validate_single(PyBytes_AS_STRING(signature_as_bytes),
+                                        NULL)) {
+        PyErr_SetString(PyExc_ValueError, "The signature of a VarDict's "
+                        "value must be a single complete type");
+        goto finally;
+    }
+
+    ret = DBusPyVarDict_Add(self, key, value,
+                            PyBytes_AS_STRING(signature_as_bytes),
+                            PyBytes_GET_SIZE(signature_as_bytes));
+finally:
+    Py_CLEAR(signature);
+    Py_CLEAR(signature_as_bytes);
+    return ret;
+}
+
+static PyObject *
+VarDict_tp_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    PyObject *obj = dbus_py_empty_tuple;
+    PyObject *signatures = Py_None;
+    PyObject *self, *items = NULL, *iterator = NULL, *item;
+    long variant_level = 0;
+    static char *argnames[] = {"mapping_or_iterable", "signatures",
+                               "variant_level", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|OOl:__new__", argnames,
+                                     &obj, &signatures, &variant_level)) {
+        return NULL;
+    }
+    if (variant_level < 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "variant_level must be non-negative");
+        return NULL;
+    }
+
+    self = _vardict_alloc(cls, variant_level);
+    if (!self) return NULL;
+
+    if (DBusPyVarDict_Check(obj)) {
+        DBusPyVarDict *other = (DBusPyVarDict *)obj;
+        Py_ssize_t i;
+
+        for (i = 0; i < other->n_entries; i++) {
+            DBusPyVarDictEntry *entry = &other->entries[i];
+
+            if (_vardict_add_with_signatures(self, entry->key, entry->value,
+                                             signatures,
+                                             other->signatures
+                                             + entry->signature) < 0) {
+                goto fail;
+            }
+        }
+        return self;
+    }
+
+    if (PyDict_Check(obj)) {
+        items = PyDict_Items(obj);
+    }
+    else if (PyObject_HasAttrString(obj, "keys")) {
+        items = PyMapping_Items(obj);
+    }
+    else {
+        items = obj;
+        Py_INCREF(items);
+    }
+    if (!items) goto fail;
+    iterator = PyObject_GetIter(items);
+    if (!iterator) goto fail;
+
+    while ((item = PyIter_Next(iterator))) {
+        PyObject *pair = PySequence_Fast(item, "A VarDict's items must be "
+                                         "(key, value) pairs");
+        int status = -1;
+
+        Py_CLEAR(item);
+        if (!pair) goto fail;
+        if (PySequence_Fast_GET_SIZE(pair) != 2) {
+            PyErr_SetString(PyExc_ValueError, "A VarDict's items must be "
+                            "(key, value) pairs");
+        }
+        else {
+            status = _vardict_add_with_signatures(self,
+                PySequence_Fast_GET_ITEM(pair, 0),
+                PySequence_Fast_GET_ITEM(pair, 1),
+                signatures, NULL);
+        }
+        Py_CLEAR(pair);
+        if (status < 0) goto fail;
+    }
+    if (PyErr_Occurred()) goto fail;
+
+    Py_CLEAR(iterator);
+    Py_CLEAR(items);
+    return self;
+
+fail:
+    Py_CLEAR(iterator);
+    Py_CLEAR(items);
+    Py_CLEAR(self);
+    return NULL;
+}
+
+static void
+VarDict_tp_dealloc(DBusPyVarDict *self)
+{
+    Py_ssize_t i;
+
+    PyObject_GC_UnTrack(self);
+    for (i = 0; i < self->n_entries; i++) {
+        Py_CLEAR(self->entries[i].key);
+        Py_CLEAR(self->entries[i].value);
+    }
+    PyMem_Free(self->entries);
+    PyMem_Free(self->slots);
+    PyMem_Free(self->signatures);
+    (Py_TYPE(self)->tp_free)((PyObject *)self);
+}
+
+static int
+VarDict_tp_traverse(DBusPyVarDict *self, visitproc visit, void *arg)
+{
+    Py_ssize_t i;
+
+    for (i = 0; i < self->n_entries; i++) {
+        Py_VISIT(self->entries[i].key);
+        Py_VISIT(self->entries[i].value);
+    }
+    return 0;
+}
+
+/* Return a list of the keys (what == 0), values (1) or items (2) */
+static PyObject *
+_vardict_list(DBusPyVarDict *self, int what)
+{
+    PyObject *list = PyList_New(self->n_entries);
+    Py_ssize_t i;
+
+    if (!list) return NULL;
+    for (i = 0; i < self->n_entries; i++) {
+        DBusPyVarDictEntry *entry = &self->entries[i];
+        PyObject *item;
+
+        if (what == 2) {
+            item = PyTuple_Pack(2, entry->key, entry->value);
+            if (!item) {
+                Py_CLEAR(list);
+                return NULL;
+            }
+        }
+        else {
+            item = what ? entry->value : entry->key;
+            Py_INCREF(item);
+        }
+        PyList_SET_ITEM(list, i, item);
+    }
+    return list;
+}
+
+static PyObject *
+VarDict_tp_repr(DBusPyVarDict *self)
+{
+    PyObject *dict = NULL;
+    PyObject *dict_repr = NULL;
+    PyObject *my_repr = NULL;
+    Py_ssize_t i;
+    int status = Py_ReprEnter((PyObject *)self);
+
+    if (status != 0) {
+        if (status < 0) return NULL;
+        return PyUnicode_FromFormat("%s({...})", Py_TYPE(self)->tp_name);
+    }
+
+    dict = PyDict_New();
+    if (!dict) goto finally;
+    for (i = 0; i < self->n_entries; i++) {
+        if (PyDict_SetItem(dict, self->entries[i].key,
+                           self->entries[i].value) < 0) {
+            goto finally;
+        }
+    }
+    dict_repr = PyObject_Repr(dict);
+    if (!dict_repr) goto finally;
+
+    if (self->variant_level > 0) {
+        my_repr = PyUnicode_FromFormat("%s(%V, variant_level=%ld)",
+                                       Py_TYPE(self)->tp_name,
+                                       REPRV(dict_repr),
+                                       self->variant_level);
+    }
+    else {
+        my_repr = PyUnicode_FromFormat("%s(%V)", Py_TYPE(self)->tp_name,
+                                       REPRV(dict_repr));
+    }
+finally:
+    Py_ReprLeave((PyObject *)self);
+    Py_CLEAR(dict);
+    Py_CLEAR(dict_repr);
+    return my_repr;
+}
+
+/* Return 1 if self has the same items as other, a VarDict or dict, 0 if
+ * not, or -1 with an exception set. */
+static int
+_vardict_equal(DBusPyVarDict *self, PyObject *other)
+{
+    Py_ssize_t i;
+
+    if (DBusPyVarDict_Check(other)) {
+        DBusPyVarDict *that = (DBusPyVarDict *)other;
+
+        if (self->n_entries != that->n_entries) return 0;
+        if (self->hash != -1 && that->hash != -1 && self->hash != that->hash)
+            return 0;
+        for (i = 0; i < self->n_entries; i++) {
+            DBusPyVarDictEntry *entry = &self->entries[i];
+            size_t slot;
+            int equal;
+
+            if (_vardict_find(that, entry->key, entry->hash, &slot) < 0)
+                return -1;
+            if (that->slots[slot] < 0) return 0;
+            equal = PyObject_RichCompareBool(entry->value,
+                that->entries[that->slots[slot]].value, Py_EQ);
+            if (equal <= 0) return equal;
+        }
+        return 1;
+    }
+
+    if (PyDict_Size(other) != self->n_entries) return 0;
+    for (i = 0; i < self->n_entries; i++) {
+        PyObject *value = PyDict_GetItem(other, self->entries[i].key);
+        int equal;
+
+        if (!value) return 0;
+        Py_INCREF(value);
+        equal = PyObject_RichCompareBool(self->entries[i].value, value,
+                                         Py_EQ);
+        Py_CLEAR(value);
+        if (equal <= 0) return equal;
+    }
+    return 1;
+}
+
+static PyObject *
+VarDict_tp_richcompare(PyObject *self, PyObject *other, int op)
+{
+    int equal;
+
+    if ((op != Py_EQ && op != Py_NE)
+        || !(DBusPyVarDict_Check(other) || PyDict_Check(other))) {
+        Py_INCREF(Py_NotImplemented);
+        return Py_NotImplemented;
+    }
+    equal = _vardict_equal((DBusPyVarDict *)self, other);
+    if (equal < 0) return NULL;
+    return PyBool_FromLong(op == Py_EQ ? equal : !equal);
+}
+
+/* The hash doesn't depend on the order of the items, and is cached: the
+ * keys are strings and the VarDict is immutable, so it can only change if
+ * a value is mutable, in which case it's unhashable anyway. */
+static dbus_py_hash_t
+VarDict_tp_hash(DBusPyVarDict *self)
+{
+    size_t hash = (size_t)self->n_entries * 1000003U;
+    Py_ssize_t i;
+
+    if (self->hash != -1) return self->hash;
+    for (i = 0; i < self->n_entries; i++) {
+        dbus_py_hash_t value_hash = PyObject_Hash(self->entries[i].value);
+        size_t item_hash;
+
+        if (value_hash == -1) return -1;
+        item_hash = (size_t)self->entries[i].hash * 1000003U
+                    ^ (size_t)value_hash;
+        hash ^= item_hash ^ (item_hash >> 16) ^ 89869747U;
+    }
+    self->hash = (dbus_py_hash_t)hash;
+    if (self->hash == -1) self->hash = -2;
+    return self->hash;
+}
+
+static Py_ssize_t
+VarDict_mp_length(DBusPyVarDict *self)
+{
+    return self->n_entries;
+}
+
+static PyObject *
+VarDict_mp_subscript(DBusPyVarDict *self, PyObject *key)
+{
+    DBusPyVarDictEntry *entry = _vardict_lookup(self, key);
+
+    if (!entry) {
+        if (!PyErr_Occurred()) {
+            PyObject *args = PyTuple_Pack(1, key);
+
+            if (args) {
+                PyErr_SetObject(PyExc_KeyError, args);
+                Py_CLEAR(args);
+            }
+        }
+        return NULL;
+    }
+    Py_INCREF(entry->value);
+    return entry->value;
+}
+
+static int
+VarDict_sq_contains(DBusPyVarDict *self, PyObject *key)
+{
+    if (_vardict_lookup(self, key)) return 1;
+    return PyErr_Occurred() ? -1 : 0;
+}
+
+static PyObject *
+VarDict_tp_iter(DBusPyVarDict *self)
+{
+    PyObject *keys = _vardict_list(self, 0);
+    PyObject *iterator;
+
+    if (!keys) return NULL;
+    iterator = PyObject_GetIter(keys);
+    Py_CLEAR(keys);
+    return iterator;
+}
+
+static PyObject *
+VarDict_keys(DBusPyVarDict *self, PyObject *unused UNUSED)
+{
+    return _vardict_list(self, 0);
+}
+
+static PyObject *
+VarDict_values(DBusPyVarDict *self, PyObject *unused UNUSED)
+{
+    return _vardict_list(self, 1);
+}
+
+static PyObject *
+VarDict_items(DBusPyVarDict *self, PyObject *unused UNUSED)
+{
+    return _vardict_list(self, 2);
+}
+
+static PyObject *
+VarDict_get(DBusPyVarDict *self, PyObject *args)
+{
+    PyObject *key, *value = Py_None;
+    DBusPyVarDictEntry *entry;
+
+    if (!PyArg_UnpackTuple(args, "get", 1, 2, &key, &value)) return NULL;
+    entry = _vardict_lookup(self, key);
+    if (entry) {
+        value = entry->value;
+    }
+    else if (PyErr_Occurred()) {
+        return NULL;
+    }
+    Py_INCREF(value);
+    return value;
+}
+
+/* Return the arguments with which the VarDict can be made again, with
+ * the same signatures: this lets copy, deepcopy and pickle work. */
+static PyObject *
+VarDict_reduce(DBusPyVarDict *self, PyObject *unused UNUSED)
+{
+    PyObject *items = PyDict_New();
+    PyObject *signatures = PyDict_New();
+    Py_ssize_t i;
+
+    if (!items || !signatures) goto fail;
+    for (i = 0; i < self->n_entries; i++) {
+        DBusPyVarDictEntry *entry = &self->entries[i];
+        PyObject *signature = NATIVESTR_FROMSTR(self->signatures +
+                                                entry->signature);
+        int status;
+
+        if (!signature) goto fail;
+        status = PyDict_SetItem(signatures, entry->key, signature);
+        Py_CLEAR(signature);
+        if (status < 0 ||
+            PyDict_SetItem(items, entry->key, entry->value) < 0)
+            goto fail;
+    }
+    return Py_BuildValue("(O(NNl))", Py_TYPE(self), items, signatures,
+                         self->variant_level);
+
+fail:
+    Py_CLEAR(items);
+    Py_CLEAR(signatures);
+    return NULL;
+}
+
+PyDoc_STRVAR(VarDict_value_signature__doc__,
+"value_signature(key) -> dbus.Signature\n\n"
+"Return the D-Bus signature of the value for the given key, which is\n"
+"what it's sent as, inside a variant.\n");
+
+static PyObject *
+VarDict_value_signature(DBusPyVarDict *self, PyObject *key)
+{
+    DBusPyVarDictEntry *entry = _vardict_lookup(self, key);
+
+    if (!entry) return VarDict_mp_subscript(self, key);
+    return PyObject_CallFunction((PyObject *)&DBusPySignature_Type, "(s)",
+                                 self->signatures + entry->signature);
+}
+
+static PyObject *
+VarDict_get_signature(DBusPyVarDict *self UNUSED, void *closure UNUSED)
+{
+    return PyObject_CallFunction((PyObject *)&DBusPySignature_Type, "(s)",
+                                 "sv");
+}
+
+static PyMethodDef VarDict_tp_methods[] = {
+    {"keys", (PyCFunction)VarDict_keys, METH_NOARGS,
+     "Return a list of the keys."},
+    {"values", (PyCFunction)VarDict_values, METH_NOARGS,
+     "Return a list of the values."},
+    {"items", (PyCFunction)VarDict_items, METH_NOARGS,
+     "Return a list of (key, value) pairs."},
+    {"__reduce__", (PyCFunction)VarDict_reduce, METH_NOARGS, NULL},
+    {"get", (PyCFunction)VarDict_get, METH_VARARGS,
+     "Return the value for the key if it's present, else the default "
+     "(None if not given)."},
+    {"value_signature", (PyCFunction)VarDict_value_signature, METH_O,
+     VarDict_value_signature__doc__},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef VarDict_tp_getset[] = {
+    {"signature", (getter)VarDict_get_signature, NULL,
+     "The D-Bus signature of each key in this VarDict, followed by "
+     "that of each value, as a Signature instance: always 'sv'.",
+     NULL},
+    {NULL}
+};
+
+static PyMappingMethods VarDict_tp_as_mapping = {
+    (lenfunc)VarDict_mp_length,             /* mp_length */
+    (binaryfunc)VarDict_mp_subscript,       /* mp_subscript */
+    0,                                      /* mp_ass_subscript */
+};
+
+static PySequenceMethods VarDict_tp_as_sequence = {
+    0,                                      /* sq_length */
+    0,                                      /* sq_concat */
+    0,                                      /* sq_repeat */
+    0,                                      /* sq_item */
+    0,                                      /* sq_slice */
+    0,                                      /* sq_ass_item */
+    0,                                      /* sq_ass_slice */
+    (objobjproc)VarDict_sq_contains,        /* sq_contains */
+};
+
+PyTypeObject DBusPyVarDict_Type = {
+    PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
+    "dbus.VarDict",
+    sizeof(DBusPyVarDict),
+    0,
+    (destructor)VarDict_tp_dealloc,         /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    (reprfunc)VarDict_tp_repr,              /* tp_repr */
+    0,                                      /* tp_as_number */
+    &VarDict_tp_as_sequence,                /* tp_as_sequence */
+    &VarDict_tp_as_mapping,                 /* tp_as_mapping */
+    (hashfunc)VarDict_tp_hash,              /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,
+                                            /* tp_flags */
+    VarDict_tp_doc,                         /* tp_doc */
+    (traverseproc)VarDict_tp_traverse,      /* tp_traverse */
+    0,                                      /* tp_clear */
+    VarDict_tp_richcompare,                 /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    (getiterfunc)VarDict_tp_iter,           /* tp_iter */
+    0,                                      /* tp_iternext */
+    VarDict_tp_methods,                     /* tp_methods */
+    VarDict_tp_members,                     /* tp_members */
+    VarDict_tp_getset,                      /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    VarDict_tp_new,                         /* tp_new */
+};
+
+/* Struct classes =================================================== */
+
+/* Maps struct signatures (native strings, including the parentheses) to
+ * the classes registered for them with register_struct_class(). */
+static PyObject *struct_classes;
+/* Maps each of those classes to a tuple (signature, names, offsets).
+ * names and offsets are None for tuple subclasses, whose items are the
+ * struct's fields. Otherwise names is a tuple of attribute names, and
+ * offsets a tuple of the same length giving the offset of each attribute
+ * within an instance if it is stored in a __slots__ member, or -1 if it
+ * has to be fetched with getattr. */
+static PyObject *struct_class_info;
+/* How many of the registered signatures start with each type code, so
+ * that decoding a struct only has to look its signature up (which means
+ * allocating it, for a DBusMessageIter) if a class might match. */
+static unsigned int struct_classes_by_first_field[128];
+
+/* Return the type code of the first field in a struct signature, which
+ * must be a native string */
+static int
+_struct_signature_first_field(PyObject *signature)
+{
+#ifdef PY3
+    return (int)PyUnicode_READ_CHAR(signature, 1);
+#else
+    return (unsigned char)PyBytes_AS_STRING(signature)[1];
+#endif
+}
+
+/* Return TRUE if a class might be registered for a struct whose first
+ * field has the given type code, either the first character of its
+ * signature or what dbus_message_iter_get_arg_type() returns */
+dbus_bool_t
+dbus_py_may_have_struct_class(int first_field)
+{
+    if (first_field == DBUS_TYPE_STRUCT)
+        first_field = DBUS_STRUCT_BEGIN_CHAR;
+    else if (first_field == DBUS_TYPE_DICT_ENTRY)
+        first_field = DBUS_DICT_ENTRY_BEGIN_CHAR;
+    return (first_field > 0 && first_field < 128 &&
+            struct_classes_by_first_field[first_field] > 0);
+}
+
+/* Return a borrowed reference to the class registered for the given struct
+ * signature, or NULL (without an exception) if there is none. */
+PyObject *
+dbus_py_get_struct_class(const char *signature)
+{
+    return PyDict_GetItemString(struct_classes, signature);
+}
+
+/* Return a borrowed reference to the struct signature registered for the
+ * class of obj, or NULL (without an exception) if there is none. */
+PyObject *
+dbus_py_get_struct_class_signature(PyObject *obj)
+{
+    PyObject *info;
+
+    if (PyDict_Size(struct_class_info) == 0)
+        return NULL;
+    info = PyDict_GetItem(struct_class_info, (PyObject *)Py_TYPE(obj));
+    if (!info)
+        return NULL;
+    return PyTuple_GET_ITEM(info, 0);
+}
+
+/* If obj is an instance of a registered struct class other than a tuple
+ * subclass, return a new reference to a tuple of its fields. Otherwise
+ * return NULL, with an exception set if a field could not be read. */
+PyObject *
+dbus_py_get_struct_fields(PyObject *obj)
+{
+    PyObject *info, *names, *offsets, *ret;
+    Py_ssize_t i, n;
+
+    if (PyDict_Size(struct_class_info) == 0)
+        return NULL;
+    info = PyDict_GetItem(struct_class_info, (PyObject *)Py_TYPE(obj));
+    if (!info)
+        return NULL;
+    names = PyTuple_GET_ITEM(info, 1);
+    offsets = PyTuple_GET_ITEM(info, 2);
+    if (names == Py_None)
+        return NULL;
+
+    n = PyTuple_GET_SIZE(names);
+    ret = PyTuple_New(n);
+    if (!ret)
+        return NULL;
+
+    for (i = 0; i < n; i++) {
+        long offset = NATIVEINT_ASLONG(PyTuple_GET_ITEM(offsets, i));
+        PyObject *value;
+
+        if (offset >= 0) {
+            /* the class is exactly the registered one, so its layout is
+             * the one we looked at when it was registered */
+            value = *(PyObject **)((char *)obj + offset);
+            if (!value) {
+                PyErr_SetObject(PyExc_AttributeError,
+                                PyTuple_GET_ITEM(names, i));
+            }
+            Py_XINCREF(value);
+        }
+        else {
+            value = PyObject_GetAttr(obj, PyTuple_GET_ITEM(names, i));
+        }
+        if (!value) {
+            Py_CLEAR(ret);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(ret, i, value);
+    }
+    return ret;
+}
+
+/* Return a new reference to the attribute names of cls's fields, or to
+ * None if cls is a tuple subclass. */
+static PyObject *
+_struct_class_field_names(PyObject *cls)
+{
+    PyObject *attr, *ret;
+
+    if (PyType_IsSubtype((PyTypeObject *)cls, &PyTuple_Type)) {
+        Py_RETURN_NONE;
+    }
+
+    if (PyObject_HasAttrString(cls, "__dataclass_fields__")) {
+        PyObject *dataclasses = PyImport_ImportModule("dataclasses");
+        PyObject *fields, *name;
+        Py_ssize_t i;
+
+        if (!dataclasses)
+            return NULL;
+        fields = PyObject_CallMethod(dataclasses, "fields", "(O)", cls);
+        Py_CLEAR(dataclasses);
+        if (!fields)
+            return NULL;
+        ret = PySequence_Tuple(fields);
+        Py_CLEAR(fields);
+        if (!ret)
+            return NULL;
+        for (i = 0; i < PyTuple_GET_SIZE(ret); i++) {
+            PyObject *field = PyTuple_GET_ITEM(ret, i);
+            PyObject *init = PyObject_GetAttrString(field, "init");
+            int in_init = (init ? PyObject_IsTrue(init) : -1);
+
+            Py_CLEAR(init);
+            if (in_init < 0) {
+                Py_CLEAR(ret);
+                return NULL;
+            }
+            if (!in_init) {
+                /* decoded structs are built with cls(*fields) */
+                PyErr_Format(PyExc_TypeError, "Dataclass %s has fields "
+                             "that are not __init__ parameters",
+                             ((PyTypeObject *)cls)->tp_name);
+                Py_CLEAR(ret);
+                return NULL;
+            }
+            name = PyObject_GetAttrString(field, "name");
+            if (!name) {
+                Py_CLEAR(ret);
+                return NULL;
+            }
+            /* ret isn't shared yet, so it's OK to modify it */
+            Py_DECREF(PyTuple_GET_ITEM(ret, i));
+            PyTuple_SET_ITEM(ret, i, name);
+        }
+        return ret;
+    }
+
+    attr = PyObject_GetAttrString(cls, "__slots__");
+    if (!attr) {
+        if (PyErr_ExceptionMatches(PyExc_AttributeError)) {
+            PyErr_Clear();
+            PyErr_Format(PyExc_TypeError, "Unable to find the fields of "
+                         "class %s: it is not a tuple subclass, dataclass "
+                         "or class with __slots__, so fields must be given",
+                         ((PyTypeObject *)cls)->tp_name);
+        }
+        return NULL;
+    }
+    if (PyBytes_Check(attr) || PyUnicode_Check(attr)) {
+        ret = PyTuple_Pack(1, attr);
+    }
+    else {
+        ret = PySequence_Tuple(attr);
+    }
+    Py_CLEAR(attr);
+    return ret;
+}
+
+/* Return a new reference to a tuple giving, for each of the names, the
+ * offset of the __slots__ member of that name in instances of cls, or -1. */
+static PyObject *
+_struct_class_field_offsets(PyObject *cls, PyObject *names)
+{
+    Py_ssize_t i, n = PyTuple_GET_SIZE(names);
+    PyObject *ret = PyTuple_New(n);
+
+    if (!ret)
+        return NULL;
+
+    for (i = 0; i < n; i++) {
+        PyObject *descr = PyObject_GetAttr(cls, PyTuple_GET_ITEM(names, i));
+        Py_ssize_t offset = -1;
+        PyObject *offset_obj;
+
+        if (descr) {
+            if (Py_TYPE(descr) == &PyMemberDescr_Type &&
+                ((PyMemberDescrObject *)descr)->d_member->type == T_OBJECT_EX) {
+                offset = ((PyMemberDescrObject *)descr)->d_member->offset;
+            }
+            Py_CLEAR(descr);
+        }
+        else if (PyErr_ExceptionMatches(PyExc_AttributeError)) {
+            /* e.g. a dataclass field with no default */
+            PyErr_Clear();
+        }
+        else {
+            Py_CLEAR(ret);
+            return NULL;
+        }
+
+        offset_obj = NATIVEINT_FROMLONG((long)offset);
+        if (!offset_obj) {
+            Py_CLEAR(ret);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(ret, i, offset_obj);
+    }
+    return ret;
+}
+
+/* Remove whatever is registered for the given signature, and the signature
+ * registered for cls if cls is not NULL. */
+static dbus_bool_t
+_struct_class_unregister(PyObject *signature, PyObject *cls)
+{
+    PyObject *old_cls = PyDict_GetItem(struct_classes, signature);
+    PyObject *info;
+
+    if (old_cls) {
+        if (PyDict_GetItem(struct_class_info, old_cls) &&
+            PyDict_DelItem(struct_class_info, old_cls) < 0) {
+            return FALSE;
+        }
+        if (PyDict_DelItem(struct_classes, signature) < 0)
+            return FALSE;
+        struct_classes_by_first_field[
+            _struct_signature_first_field(signature)]--;
+    }
+
+    if (cls) {
+        info = PyDict_GetItem(struct_class_info, cls);
+        if (info) {
+            PyObject *old_sig = PyTuple_GET_ITEM(info, 0);
+
+            if (PyDict_DelItem(struct_classes, old_sig) < 0)
+                return FALSE;
+            struct_classes_by_first_field[
+                _struct_signature_first_field(old_sig)]--;
+            if (PyDict_DelItem(struct_class_info, cls) < 0)
+                return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+dbus_bool_t
+dbus_py_register_struct_class(const char *signature, PyObject *cls,
+                              PyObject *fields)
+{
+    DBusSignatureIter sig_iter, sub_sig_iter;
+    PyObject *sig_obj = NULL, *names = NULL, *offsets = NULL, *info = NULL;
+    Py_ssize_t n_types = 0;
+    dbus_bool_t ret = FALSE;
+
+    if (!dbus_signature_validate_single(signature, NULL) ||
+        signature[0] != DBUS_STRUCT_BEGIN_CHAR) {
+        PyErr_Format(PyExc_ValueError, "'%s' is not the signature of a "
+                     "single struct", signature);
+        return FALSE;
+    }
+
+    sig_obj = NATIVESTR_FROMSTR(signature);
+    if (!sig_obj)
+        return FALSE;
+
+    if (cls == Py_None) {
+        ret = _struct_class_unregister(sig_obj, NULL);
+        goto out;
+    }
+
+    if (!PyType_Check(cls)) {
+        PyErr_SetString(PyExc_TypeError, "A struct class must be a class");
+        goto out;
+    }
+
+    if (fields && fields != Py_None) {
+        names = PySequence_Tuple(fields);
+    }
+    else {
+        names = _struct_class_field_names(cls);
+    }
+    if (!names)
+        goto out;
+
+    if (names == Py_None) {
+        Py_INCREF(Py_None);
+        offsets = Py_None;
+    }
+    else {
+        dbus_signature_iter_init(&sig_iter, signature);
+        dbus_signature_iter_recurse(&sig_iter, &sub_sig_iter);
+        do {
+            n_types++;
+        } while (dbus_signature_iter_next(&sub_sig_iter));
+
+        if (PyTuple_GET_SIZE(names) != n_types) {
+            PyErr_Format(PyExc_ValueError, "Struct signature '%s' has %ld "
+                         "fields, but class %s has %ld", signature,
+                         (long)n_types, ((PyTypeObject *)cls)->tp_name,
+                         (long)PyTuple_GET_SIZE(names));
+            goto out;
+        }
+        offsets = _struct_class_field_offsets(cls, names);
+        if (!offsets)
+            goto out;
+    }
+
+    info = PyTuple_Pack(3, sig_obj, names, offsets);
+    if (!info)
+        goto out;
+
+    if (!_struct_class_unregister(sig_obj, cls))
+        goto out;
+    if (PyDict_SetItem(struct_classes, sig_obj, cls) < 0)
+        goto out;
+    if (PyDict_SetItem(struct_class_info, cls, info) < 0) {
+        PyDict_DelItem(struct_classes, sig_obj);
+        goto out;
+    }
+    struct_classes_by_first_field[(unsigned char)signature[1]]++;
+    ret = TRUE;
+
+out:
+    Py_CLEAR(sig_obj);
+    Py_CLEAR(names);
+    Py_CLEAR(offsets);
+    Py_CLEAR(info);
+    return ret;
+}
+
 dbus_bool_t
 dbus_py_init_container_types(void)
 {
     struct_signatures = PyDict_New();
     if (!struct_signatures) return 0;
+    struct_classes = PyDict_New();
+    if (!struct_classes) return 0;
+    struct_class_info = PyDict_New();
+    if (!struct_class_info) return 0;
 
     DBusPyArray_Type.tp_base = &PyList_Type;
     if (PyType_Ready(&DBusPyArray_Type) < 0) return 0;
@@ -798,6 +1949,9 @@ dbus_py_init_container_types(void)
     if (PyType_Ready(&DBusPyStruct_Type) < 0) return 0;
     DBusPyStruct_Type.tp_print = NULL;
 
+    if (PyType_Ready(&DBusPyVarDict_Type) < 0) return 0;
+    DBusPyVarDict_Type.tp_print = NULL;
+
     return 1;
 }
 
@@ -817,6 +1971,10 @@ dbus_py_insert_container_types(PyObject *this_module)
     if (PyModule_AddObject(this_module, "Struct",
                            (PyObject *)&DBusPyStruct_Type) < 0) return 0;
 
+    Py_INCREF(&DBusPyVarDict_Type);
+    if (PyModule_AddObject(this_module, "VarDict",
+                           (PyObject *)&DBusPyVarDict_Type) < 0) return 0;
+
     return 1;
 }
 
@@ -94,6 +94,52 @@ static inline int type##_CheckExact (PyObject *o) \
 #define NATIVESTR_FROMSTR(obj) (PyBytes_FromString(obj))
 #endif
 
+/* Methods taking keyword arguments which are called for every message are
+ * declared like this:
+ *
+ *  static PyObject *
+ *  Foo_bar(Foo *self, DBUS_PY_ARGS)
+ *  {
+ *      static char *argnames[] = {"baz", NULL};
+ *      DBUS_PY_ARG_PARSER(parser, "O:bar", argnames);
+ *      ...
+ *      if (!DBUS_PY_PARSE_ARGS(parser, &baz)) return NULL;
+ *
+ * with DBUS_PY_METH_KEYWORDS in their PyMethodDef, and DBUS_PY_NARGS for
+ * the number of positional arguments. Since Python 3.7 they
+ * are METH_FASTCALL, so calling them doesn't build a tuple and dict of
+ * arguments, and the keywords are looked up by a precompiled _PyArg_Parser.
+ * That isn't in the limited API, and Python 3.13 made it private, so other
+ * versions use PyArg_ParseTupleAndKeywords as usual. */
+#undef USING_FASTCALL
+#if defined(PY3) && PY_VERSION_HEX >= 0x03070000 && \
+    PY_VERSION_HEX < 0x030D0000 && !defined(Py_LIMITED_API)
+#   define USING_FASTCALL 1
+#endif
+
+#ifdef USING_FASTCALL
+#   define DBUS_PY_METH_KEYWORDS (METH_FASTCALL | METH_KEYWORDS)
+#   define DBUS_PY_ARGS \
+        PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames
+#   define DBUS_PY_ARG_PARSER(parser, fmt, names) \
+        static _PyArg_Parser parser = { \
+            .format = (fmt), .keywords = (const char *const *)(names) }
+#   define DBUS_PY_PARSE_ARGS(parser, ...) \
+        _PyArg_ParseStackAndKeywords(args, nargs, kwnames, &(parser), \
+                                     __VA_ARGS__)
+#   define DBUS_PY_NARGS nargs
+#else
+#   define DBUS_PY_METH_KEYWORDS (METH_VARARGS | METH_KEYWORDS)
+#   define DBUS_PY_ARGS PyObject *args, PyObject *kwargs
+#   define DBUS_PY_ARG_PARSER(parser, fmt, names) \
+        static const struct { const char *format; char **keywords; } \
+            parser = { (fmt), (names) }
+#   define DBUS_PY_PARSE_ARGS(parser, ...) \
+        PyArg_ParseTupleAndKeywords(args, kwargs, (parser).format, \
+                                    (parser).keywords, __VA_ARGS__)
+#   define DBUS_PY_NARGS PyTuple_GET_SIZE(args)
+#endif
+
 #ifdef PY3
 PyMODINIT_FUNC PyInit__dbus_bindings(void);
 #else
@@ -120,6 +166,7 @@ extern dbus_bool_t dbus_py_insert_bus_types(PyObject *this_module);
 /* exceptions.c */
 extern PyObject *DBusPyException_SetString(const char *msg);
 extern PyObject *DBusPyException_ConsumeError(DBusError *error);
+extern PyObject *DBusPyException_ConsumeErrorMessage(DBusMessage *msg);
 extern dbus_bool_t dbus_py_init_exception_types(void);
 extern dbus_bool_t dbus_py_insert_exception_types(PyObject *this_module);
 
@@ -133,6 +180,8 @@ extern PyTypeObject DBusPyArray_Type, DBusPyDict_Type, DBusPyStruct_Type;
 DEFINE_CHECK(DBusPyArray)
 DEFINE_CHECK(DBusPyDict)
 DEFINE_CHECK(DBusPyStruct)
+extern PyTypeObject DBusPyVarDict_Type;
+DEFINE_CHECK(DBusPyVarDict)
 extern PyTypeObject DBusPyByte_Type, DBusPyByteArray_Type;
 DEFINE_CHECK(DBusPyByteArray)
 DEFINE_CHECK(DBusPyByte)
@@ -174,6 +223,18 @@ extern dbus_bool_t dbus_py_insert_byte_types(PyObject *this_module);
 
 int dbus_py_unix_fd_get_fd(PyObject *self);
 
+/* containers.c */
+extern dbus_bool_t dbus_py_register_struct_class(const char *signature,
+                                                 PyObject *cls,
+                                                 PyObject *fields);
+extern dbus_bool_t dbus_py_may_have_struct_class(int first_field);
+extern PyObject *dbus_py_get_struct_class(const char *signature);
+extern PyObject *dbus_py_get_struct_class_signature(PyObject *obj);
+extern PyObject *dbus_py_get_struct_fields(PyObject *obj);
+extern PyObject *DBusPyVarDict_New(long variant_level);
+extern int DBusPyVarDict_Add(PyObject *self, PyObject *key, PyObject *value,
+                             const char *signature, size_t len);
+
 /* generic */
 extern void dbus_py_take_gil_and_xdecref(PyObject *);
 extern int dbus_py_immutable_setattro(PyObject *, PyObject *, PyObject *);
@@ -185,6 +246,7 @@ extern DBusMessage *DBusPyMessage_BorrowDBusMessage(PyObject *msg);
 extern PyObject *DBusPyMessage_ConsumeDBusMessage(DBusMessage *);
 extern dbus_bool_t dbus_py_init_message_types(void);
 extern dbus_bool_t dbus_py_insert_message_types(PyObject *this_module);
+extern PyObject *dbus_py_guess_variant_signature(PyObject *obj);
 
 /* pending-call.c */
 extern PyObject *DBusPyPendingCall_ConsumeDBusPendingCall(DBusPendingCall *,
@@ -192,6 +254,10 @@ extern PyObject *DBusPyPendingCall_ConsumeDBusPendingCall(DBusPendingCall *,
 extern dbus_bool_t dbus_py_init_pending_call(void);
 extern dbus_bool_t dbus_py_insert_pending_call(PyObject *this_module);
 
+/* monitor.c */
+extern dbus_bool_t dbus_py_init_monitor_types(void);
+extern dbus_bool_t dbus_py_insert_monitor_types(PyObject *this_module);
+
 /* mainloop.c */
 extern dbus_bool_t dbus_py_set_up_connection(PyObject *conn,
                                              PyObject *mainloop);
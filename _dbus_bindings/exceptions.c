@@ -26,6 +26,9 @@
 #include "dbus_bindings-internal.h"
 
 static PyObject *imported_dbus_exception = NULL;
+static PyObject *imported_error_classes = NULL;
+static PyObject *imported_recent_error_classes = NULL;
+static PyObject *imported_get_error_class = NULL;
 
 static dbus_bool_t
 import_exception(void)
@@ -46,6 +49,25 @@ import_exception(void)
     if (exceptions == NULL) {
         return FALSE;
     }
+    imported_error_classes = PyObject_GetAttrString(exceptions,
+                                                    "_error_classes");
+    imported_recent_error_classes = PyObject_GetAttrString(exceptions,
+                                                "_recent_error_classes");
+    imported_get_error_class = PyObject_GetAttrString(exceptions,
+                                                      "get_error_class");
+    if ((imported_error_classes && !PyDict_Check(imported_error_classes))
+        || (imported_recent_error_classes
+            && !PyDict_Check(imported_recent_error_classes))) {
+        PyErr_SetString(PyExc_TypeError,
+                        "dbus.exceptions error class caches should be dicts");
+    }
+    if (PyErr_Occurred()) {
+        Py_CLEAR(imported_error_classes);
+        Py_CLEAR(imported_recent_error_classes);
+        Py_CLEAR(imported_get_error_class);
+        Py_CLEAR(exceptions);
+        return FALSE;
+    }
     imported_dbus_exception = PyObject_GetAttrString(exceptions,
                                                      "DBusException");
     Py_CLEAR(exceptions);
@@ -53,6 +75,68 @@ import_exception(void)
     return (imported_dbus_exception != NULL);
 }
 
+/* Return a new reference to the exception class for errors called name,
+ * or NULL with an exception set. Registered names, and names that have
+ * been seen recently, only need a dict lookup. */
+static PyObject *
+get_error_class(const char *name)
+{
+    PyObject *cls;
+
+    if (!name) {
+        Py_INCREF(imported_dbus_exception);
+        return imported_dbus_exception;
+    }
+
+    cls = PyDict_GetItemString(imported_error_classes, name);
+    if (!cls)
+        cls = PyDict_GetItemString(imported_recent_error_classes, name);
+    if (cls) {
+        Py_INCREF(cls);
+        return cls;
+    }
+    return PyObject_CallFunction(imported_get_error_class, "s", name);
+}
+
+/* Raise cls(*args, name=name). Steals a reference to args. */
+static PyObject *
+raise_error(PyObject *cls, PyObject *args, const char *name)
+{
+    PyObject *kwargs = NULL, *exc_value = NULL;
+
+    if (!args)
+        goto finally;
+
+    if (name) {
+        PyObject *name_obj = NATIVESTR_FROMSTR(name);
+        int ret;
+
+        if (!name_obj)
+            goto finally;
+        kwargs = PyDict_New();
+        if (!kwargs) {
+            Py_CLEAR(name_obj);
+            goto finally;
+        }
+        ret = PyDict_SetItemString(kwargs, "name", name_obj);
+        Py_CLEAR(name_obj);
+        if (ret < 0)
+            goto finally;
+    }
+
+    exc_value = PyObject_Call(cls, args, kwargs);
+    if (!exc_value)
+        goto finally;
+
+    PyErr_SetObject((PyObject *)Py_TYPE(exc_value), exc_value);
+
+finally:
+    Py_CLEAR(args);
+    Py_CLEAR(kwargs);
+    Py_CLEAR(exc_value);
+    return NULL;
+}
+
 PyObject *
 DBusPyException_SetString(const char *msg)
 {
@@ -65,39 +149,59 @@ DBusPyException_SetString(const char *msg)
 PyObject *
 DBusPyException_ConsumeError(DBusError *error)
 {
-    PyObject *exc_value = NULL;
+    PyObject *cls;
 
     if (imported_dbus_exception == NULL && !import_exception()) {
         goto finally;
     }
 
-    exc_value = PyObject_CallFunction(imported_dbus_exception,
-                                      "s",
-                                      error->message ? error->message
-                                                     : "");
-
-    if (!exc_value) {
+    cls = get_error_class(error->name);
+    if (!cls) {
         goto finally;
     }
 
-    if (error->name) {
-        PyObject *name = NATIVESTR_FROMSTR(error->name);
-        int ret;
+    raise_error(cls, Py_BuildValue("(s)", error->message ? error->message
+                                                         : ""),
+                error->name);
+    Py_CLEAR(cls);
 
-        if (!name)
-            goto finally;
-        ret = PyObject_SetAttrString(exc_value, "_dbus_error_name", name);
-        Py_CLEAR(name);
-        if (ret < 0) {
-            goto finally;
-        }
+finally:
+    dbus_error_free(error);
+    return NULL;
+}
+
+PyObject *
+DBusPyException_ConsumeErrorMessage(DBusMessage *msg)
+{
+    PyObject *cls, *msg_obj;
+    const char *name;
+
+    if (imported_dbus_exception == NULL && !import_exception()) {
+        dbus_message_unref(msg);
+        return NULL;
     }
 
-    PyErr_SetObject(imported_dbus_exception, exc_value);
+    name = dbus_message_get_error_name(msg);
+    cls = get_error_class(name);
+    if (!cls) {
+        dbus_message_unref(msg);
+        return NULL;
+    }
 
-finally:
-    Py_CLEAR(exc_value);
-    dbus_error_free(error);
+    /* the name stays valid for as long as msg_obj owns the message */
+    msg_obj = DBusPyMessage_ConsumeDBusMessage(msg);
+    if (msg_obj) {
+        PyObject *args = PyObject_CallMethod(msg_obj, "get_args_list", NULL);
+
+        if (args) {
+            PyObject *tuple = PySequence_Tuple(args);
+
+            Py_CLEAR(args);
+            raise_error(cls, tuple, name);
+        }
+    }
+    Py_CLEAR(msg_obj);
+    Py_CLEAR(cls);
     return NULL;
 }
 
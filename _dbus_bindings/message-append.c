@@ -27,6 +27,7 @@
 #include <config.h>
 
 #include <assert.h>
+#include <string.h>
 
 #define DBG_IS_TOO_VERBOSE
 #include "compat-internal.h"
@@ -56,6 +57,9 @@ get_variant_level(PyObject *obj)
     else if (DBusPyDict_Check(obj)) {
         return ((DBusPyDict *)obj)->variant_level;
     }
+    else if (DBusPyVarDict_Check(obj)) {
+        return ((DBusPyVarDict *)obj)->variant_level;
+    }
     else if (DBusPyLongBase_Check(obj) ||
 #ifdef PY3
              DBusPyBytesBase_Check(obj) ||
@@ -98,6 +102,17 @@ char dbus_py_Message_append__doc__[] = (
 "\n"
 "If there is no signature, guess from the arguments using\n"
 "the static method `Message.guess_signature`.\n"
+"\n"
+"If the ``direct`` keyword parameter is true, encode the arguments\n"
+"straight into the D-Bus wire format and rebuild the message around\n"
+"them, which is faster for large arguments. The result is identical,\n"
+"but if the arguments can't be appended, the message is left as it\n"
+"was. Only the first append to a message that hasn't yet been sent is\n"
+"encoded like this; later ones, and any with Unix file descriptors at\n"
+"the top level, fall back to the usual method. (New in 1.2.1.)\n"
+"\n"
+"If a container is open (see `open_array`), the arguments are appended\n"
+"to it, and must be what its signature expects next.\n"
 );
 
 char dbus_py_Message_guess_signature__doc__[] = (
@@ -192,6 +207,12 @@ _signature_string_from_pyobject(PyObject *obj, long *variant_level_ptr)
       return NATIVESTR_FROMSTR(DBUS_TYPE_BOOLEAN_AS_STRING);
     }
 
+    magic_attr = dbus_py_get_struct_class_signature(obj);
+    if (magic_attr) {
+        Py_INCREF(magic_attr);
+        return magic_attr;
+    }
+
     magic_attr = get_object_path(obj);
     if (!magic_attr)
         return NULL;
@@ -444,6 +465,13 @@ _signature_string_from_pyobject(PyObject *obj, long *variant_level_ptr)
         Py_CLEAR(valuesig);
         return ret;
     }
+    else if (DBusPyVarDict_Check(obj)) {
+        return NATIVESTR_FROMSTR(DBUS_TYPE_ARRAY_AS_STRING
+                                 DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
+                                 DBUS_TYPE_STRING_AS_STRING
+                                 DBUS_TYPE_VARIANT_AS_STRING
+                                 DBUS_DICT_ENTRY_END_CHAR_AS_STRING);
+    }
     else {
         PyErr_Format(PyExc_TypeError, "Don't know which D-Bus type "
                      "to use to encode type \"%s\"",
@@ -452,6 +480,57 @@ _signature_string_from_pyobject(PyObject *obj, long *variant_level_ptr)
     }
 }
 
+/* Return a new reference to the signature of what's inside the innermost
+ * of the variants that obj would be wrapped in, as bytes, and put the
+ * number of those variants in *variant_level_ptr. The signature is
+ * checked, so that libdbus isn't asked to open a variant with (say) an
+ * over-deep guessed signature. */
+static PyObject *
+_variant_signature_from_pyobject(PyObject *obj, long *variant_level_ptr)
+{
+    PyObject *obj_sig = _signature_string_from_pyobject(obj,
+                                                        variant_level_ptr);
+
+    if (!obj_sig) return NULL;
+
+    if (PyUnicode_Check(obj_sig)) {
+        PyObject *obj_sig_as_bytes = PyUnicode_AsUTF8String(obj_sig);
+        Py_CLEAR(obj_sig);
+        if (!obj_sig_as_bytes)
+            return NULL;
+        obj_sig = obj_sig_as_bytes;
+    }
+    if (!PyBytes_Check(obj_sig)) {
+        PyErr_SetString(PyExc_TypeError, "Variant signature must be a str");
+        Py_CLEAR(obj_sig);
+        return NULL;
+    }
+    if (!dbus_signature_validate_single(PyBytes_AS_STRING(obj_sig), NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Corrupt type signature, or not "
+                        "a single complete type, for variant contents");
+        Py_CLEAR(obj_sig);
+        return NULL;
+    }
+    return obj_sig;
+}
+
+/* Return the signature of what a variant containing obj would contain,
+ * inside any variants implied by its variant_level, as UTF-8 bytes. */
+PyObject *
+dbus_py_guess_variant_signature(PyObject *obj)
+{
+    long variant_level;
+    PyObject *sig = _signature_string_from_pyobject(obj, &variant_level);
+
+    if (sig && PyUnicode_Check(sig)) {
+        PyObject *sig_as_bytes = PyUnicode_AsUTF8String(sig);
+
+        Py_CLEAR(sig);
+        return sig_as_bytes;
+    }
+    return sig;
+}
+
 PyObject *
 dbus_py_Message_guess_signature(PyObject *unused UNUSED, PyObject *args)
 {
@@ -525,13 +604,69 @@ static int _message_iter_append_pyobject(DBusMessageIter *appender,
 static int _message_iter_append_variant(DBusMessageIter *appender,
                                         PyObject *obj);
 
+/* Get the UTF-8 for a str, unicode or bytes object without copying it:
+ * for str on Python 3.3 or later, this is the interpreter's cached UTF-8,
+ * which for a compact ASCII str is the string's own data. Otherwise *tmp
+ * is set to a new reference to the bytes object holding it, which the
+ * caller must release. *is_ascii is set if the string is known to be
+ * ASCII, and so valid UTF-8. Embedded NULs raise the same exception as
+ * PyBytes_AsStringAndSize. Return 0, or -1 with an exception set. */
+static int
+_get_utf8(PyObject *obj, PyObject **tmp, const char **s, Py_ssize_t *len,
+          dbus_bool_t *is_ascii)
+{
+    char *buf;
+
+    *tmp = NULL;
+    *is_ascii = FALSE;
+#if defined(PY3) && PY_VERSION_HEX >= 0x03030000
+    if (PyUnicode_Check(obj)) {
+        const char *utf8 = PyUnicode_AsUTF8AndSize(obj, len);
+
+        if (!utf8)
+            return -1;
+        if (!memchr(utf8, '\0', *len)) {
+            *s = utf8;
+            *is_ascii = PyUnicode_IS_ASCII(obj);
+            return 0;
+        }
+        /* carry on, to raise the usual exception */
+    }
+#endif
+    if (PyBytes_Check(obj)) {
+        *tmp = obj;
+        Py_INCREF(obj);
+    }
+    else if (PyUnicode_Check(obj)) {
+        *tmp = PyUnicode_AsUTF8String(obj);
+        if (!*tmp) return -1;
+    }
+    else {
+        PyErr_SetString(PyExc_TypeError,
+                        "Expected a string or unicode object");
+        return -1;
+    }
+
+    /* Raise TypeError if the string has embedded NULs */
+    if (PyBytes_AsStringAndSize(*tmp, &buf, NULL) < 0) {
+        Py_CLEAR(*tmp);
+        return -1;
+    }
+    *s = buf;
+    *len = PyBytes_GET_SIZE(*tmp);
+    return 0;
+}
+
 static int
 _message_iter_append_string(DBusMessageIter *appender,
                             int sig_type, PyObject *obj,
                             dbus_bool_t allow_object_path_attr)
 {
-    char *s;
+    const char *s;
+    Py_ssize_t len;
+    dbus_bool_t is_ascii;
     PyObject *utf8;
+    int ret = -1;
 
     if (sig_type == DBUS_TYPE_OBJECT_PATH && allow_object_path_attr) {
         PyObject *object_path = get_object_path (obj);
@@ -543,48 +678,34 @@ _message_iter_append_string(DBusMessageIter *appender,
             return -1;
         }
         else {
-            int ret = _message_iter_append_string(appender, sig_type,
-                                                  object_path, FALSE);
+            ret = _message_iter_append_string(appender, sig_type,
+                                              object_path, FALSE);
             Py_CLEAR(object_path);
             return ret;
         }
     }
 
-    if (PyBytes_Check(obj)) {
-        utf8 = obj;
-        Py_INCREF(obj);
-    }
-    else if (PyUnicode_Check(obj)) {
-        utf8 = PyUnicode_AsUTF8String(obj);
-        if (!utf8) return -1;
-    }
-    else {
-        PyErr_SetString(PyExc_TypeError,
-                        "Expected a string or unicode object");
-        return -1;
-    }
-
-    /* Raise TypeError if the string has embedded NULs */
-    if (PyBytes_AsStringAndSize(utf8, &s, NULL) < 0)
+    if (_get_utf8(obj, &utf8, &s, &len, &is_ascii) < 0)
         return -1;
 
     /* Validate UTF-8, strictly */
-    if (!dbus_validate_utf8(s, NULL)) {
+    if (!is_ascii && !dbus_validate_utf8(s, NULL)) {
         PyErr_SetString(PyExc_UnicodeError, "String parameters "
                         "to be sent over D-Bus must be valid UTF-8 "
                         "with no noncharacter code points");
-        return -1;
+        goto out;
     }
 
     DBG("Performing actual append: string (from unicode) %s", s);
     if (!dbus_message_iter_append_basic(appender, sig_type, &s)) {
-        Py_CLEAR(utf8);
         PyErr_NoMemory();
-        return -1;
+        goto out;
     }
+    ret = 0;
 
+out:
     Py_CLEAR(utf8);
-    return 0;
+    return ret;
 }
 
 static int
@@ -734,7 +855,8 @@ _message_iter_append_multi(DBusMessageIter *appender,
     DBusSignatureIter sub_sig_iter;
     PyObject *contents;
     int ret;
-    PyObject *iterator = PyObject_GetIter(obj);
+    PyObject *fields = NULL;
+    PyObject *iterator;
     char *sig = NULL;
     int container = mode;
     dbus_bool_t is_byte_array = DBusPyByteArray_Check(obj);
@@ -750,6 +872,13 @@ _message_iter_append_multi(DBusMessageIter *appender,
     fprintf(stderr, "\n");
 #endif
 
+    if (mode == DBUS_TYPE_STRUCT && !PyTuple_Check(obj)) {
+        /* an instance of a registered struct class? */
+        fields = dbus_py_get_struct_fields(obj);
+        if (!fields && PyErr_Occurred()) return -1;
+    }
+    iterator = PyObject_GetIter(fields ? fields : obj);
+    Py_CLEAR(fields);
     if (!iterator) return -1;
     if (mode == DBUS_TYPE_DICT_ENTRY) container = DBUS_TYPE_ARRAY;
 
@@ -904,36 +1033,18 @@ _message_iter_append_string_as_byte_array(DBusMessageIter *appender,
     return ret;
 }
 
-/* Encode some Python object into a D-Bus variant slot. */
+/* Encode some Python object into a D-Bus variant slot, given the
+ * signature of what's inside the innermost of variant_level variants. */
 static int
-_message_iter_append_variant(DBusMessageIter *appender, PyObject *obj)
+_message_iter_append_variant_contents(DBusMessageIter *appender,
+                                      PyObject *obj, const char *obj_sig_str,
+                                      long variant_level)
 {
     DBusSignatureIter obj_sig_iter;
-    const char *obj_sig_str;
-    PyObject *obj_sig;
     int ret;
-    long variant_level;
     dbus_bool_t dummy;
     DBusMessageIter *variant_iters = NULL;
 
-    /* Separate the object into the contained object, and the number of
-     * variants it's wrapped in. */
-    obj_sig = _signature_string_from_pyobject(obj, &variant_level);
-    if (!obj_sig) return -1;
-
-    if (PyUnicode_Check(obj_sig)) {
-        PyObject *obj_sig_as_bytes = PyUnicode_AsUTF8String(obj_sig);
-        Py_CLEAR(obj_sig);
-        if (!obj_sig_as_bytes)
-            return -1;
-        obj_sig = obj_sig_as_bytes;
-    }
-    obj_sig_str = PyBytes_AsString(obj_sig);
-    if (!obj_sig_str) {
-        Py_CLEAR(obj_sig);
-        return -1;
-    }
-
     if (variant_level < 1) {
         variant_level = 1;
     }
@@ -1004,10 +1115,104 @@ out:
     if (variant_iters != NULL)
         free (variant_iters);
 
+    return ret;
+}
+
+/* Encode some Python object into a D-Bus variant slot. */
+static int
+_message_iter_append_variant(DBusMessageIter *appender, PyObject *obj)
+{
+    const char *obj_sig_str;
+    PyObject *obj_sig;
+    int ret;
+    long variant_level;
+
+    /* Separate the object into the contained object, and the number of
+     * variants it's wrapped in. */
+    obj_sig = _variant_signature_from_pyobject(obj, &variant_level);
+    if (!obj_sig) return -1;
+    obj_sig_str = PyBytes_AS_STRING(obj_sig);
+
+    ret = _message_iter_append_variant_contents(appender, obj, obj_sig_str,
+                                                variant_level);
     Py_CLEAR(obj_sig);
     return ret;
 }
 
+/* Encode a VarDict as an array of {sv}, using the signatures it already
+ * knows for the values. */
+static int
+_message_iter_append_vardict(DBusMessageIter *appender, DBusPyVarDict *dict)
+{
+    DBusMessageIter array, entry;
+    Py_ssize_t i;
+    int ret = 0;
+
+    DBG("%s", "Opening ARRAY container for VarDict");
+    if (!dbus_message_iter_open_container(appender, DBUS_TYPE_ARRAY,
+                                          DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
+                                          DBUS_TYPE_STRING_AS_STRING
+                                          DBUS_TYPE_VARIANT_AS_STRING
+                                          DBUS_DICT_ENTRY_END_CHAR_AS_STRING,
+                                          &array)) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    for (i = 0; i < dict->n_entries && ret == 0; i++) {
+        DBusPyVarDictEntry *item = &dict->entries[i];
+        long variant_level = get_variant_level(item->value);
+
+        if (variant_level < 0) {
+            ret = -1;
+            break;
+        }
+        if (!dbus_message_iter_open_container(&array, DBUS_TYPE_DICT_ENTRY,
+                                              NULL, &entry)) {
+            PyErr_NoMemory();
+            ret = -1;
+            break;
+        }
+        ret = _message_iter_append_string(&entry, DBUS_TYPE_STRING,
+                                          item->key, FALSE);
+        if (ret == 0) {
+            ret = _message_iter_append_variant_contents(&entry, item->value,
+                dict->signatures + item->signature, variant_level);
+        }
+        if (!dbuspy_message_iter_close_container(&array, &entry,
+                                                 (ret == 0))) {
+            PyErr_NoMemory();
+            ret = -1;
+        }
+    }
+
+    DBG("%s", "Closing ARRAY container for VarDict");
+    if (!dbuspy_message_iter_close_container(appender, &array, (ret == 0))) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return ret;
+}
+
+/* Return TRUE if sig_iter is at an array of {sv} */
+static dbus_bool_t
+_is_vardict_signature(const DBusSignatureIter *sig_iter)
+{
+    DBusSignatureIter entry_iter, key_iter;
+
+    if (dbus_signature_iter_get_current_type(sig_iter) != DBUS_TYPE_ARRAY ||
+        dbus_signature_iter_get_element_type(sig_iter)
+            != DBUS_TYPE_DICT_ENTRY)
+        return FALSE;
+    dbus_signature_iter_recurse(sig_iter, &entry_iter);
+    dbus_signature_iter_recurse(&entry_iter, &key_iter);
+    if (dbus_signature_iter_get_current_type(&key_iter) != DBUS_TYPE_STRING ||
+        !dbus_signature_iter_next(&key_iter))
+        return FALSE;
+    return (dbus_signature_iter_get_current_type(&key_iter)
+            == DBUS_TYPE_VARIANT);
+}
+
 /* On success, *more is set to whether there's more in the signature. */
 static int
 _message_iter_append_pyobject(DBusMessageIter *appender,
@@ -1146,7 +1351,11 @@ _message_iter_append_pyobject(DBusMessageIter *appender,
            * or it might be a generic array. */
 
           sig_type = dbus_signature_iter_get_element_type(sig_iter);
-          if (sig_type == DBUS_TYPE_DICT_ENTRY)
+          if (sig_type == DBUS_TYPE_DICT_ENTRY && DBusPyVarDict_Check(obj)
+              && _is_vardict_signature(sig_iter))
+            ret = _message_iter_append_vardict(appender,
+                                               (DBusPyVarDict *)obj);
+          else if (sig_type == DBUS_TYPE_DICT_ENTRY)
             ret = _message_iter_append_multi(appender, sig_iter,
                                              DBUS_TYPE_DICT_ENTRY, obj);
           else if (sig_type == DBUS_TYPE_BYTE && PyBytes_Check(obj))
@@ -1196,98 +1405,1957 @@ _message_iter_append_pyobject(DBusMessageIter *appender,
 }
 
 
-PyObject *
-dbus_py_Message_append(Message *self, PyObject *args, PyObject *kwargs)
-{
-    const char *signature = NULL;
-    PyObject *signature_obj = NULL;
-    DBusSignatureIter sig_iter;
-    DBusMessageIter appender;
-    static char *argnames[] = {"signature", NULL};
-    dbus_bool_t more;
+/* Direct encoding: rather than appending each value through a
+ * DBusMessageIter, write the whole message in the D-Bus wire format (in
+ * native byte order) into a buffer, then load it with
+ * dbus_message_demarshal(), which validates it in one pass. The
+ * conversions are the same as for _message_iter_append_pyobject(). */
 
-    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+typedef struct {
+    char *data;
+    size_t len;
+    size_t alloc;
+} WireBuffer;
 
-#ifdef USING_DBG
-    fprintf(stderr, "DBG/%ld: called Message_append(*", (long)getpid());
-    PyObject_Print(args, stderr, 0);
-    if (kwargs) {
-        fprintf(stderr, ", **");
-        PyObject_Print(kwargs, stderr, 0);
+static int
+_wire_reserve(WireBuffer *buf, size_t n)
+{
+    size_t alloc = buf->alloc ? buf->alloc : 256;
+    char *data;
+
+    if (buf->len + n <= buf->alloc)
+        return 0;
+    while (alloc < buf->len + n)
+        alloc *= 2;
+    data = PyMem_Realloc(buf->data, alloc);
+    if (!data) {
+        PyErr_NoMemory();
+        return -1;
     }
-    fprintf(stderr, ")\n");
-#endif
+    buf->data = data;
+    buf->alloc = alloc;
+    return 0;
+}
 
-    /* only use kwargs for this step: deliberately ignore args for now */
-    if (!PyArg_ParseTupleAndKeywords(dbus_py_empty_tuple, kwargs, "|z:append",
-                                     argnames, &signature)) return NULL;
+static int
+_wire_put(WireBuffer *buf, const void *p, size_t n)
+{
+    if (_wire_reserve(buf, n) < 0)
+        return -1;
+    memcpy(buf->data + buf->len, p, n);
+    buf->len += n;
+    return 0;
+}
 
-    if (!signature) {
-        DBG("%s", "No signature for message, guessing...");
-        signature_obj = dbus_py_Message_guess_signature(NULL, args);
-        if (!signature_obj) return NULL;
-        if (PyUnicode_Check(signature_obj)) {
-            PyObject *signature_as_bytes;
-            signature_as_bytes = PyUnicode_AsUTF8String(signature_obj);
-            Py_CLEAR(signature_obj);
-            if (!signature_as_bytes)
-                return NULL;
-            signature_obj = signature_as_bytes;
-        }
-        else {
-            assert(PyBytes_Check(signature_obj));
-        }
-        signature = PyBytes_AS_STRING(signature_obj);
+/* Pad with zero bytes to a multiple of alignment, which is 1, 2, 4 or 8.
+ * The body starts at an 8-aligned offset in the message, so aligning
+ * offsets in the message aligns them in the body too. */
+static int
+_wire_pad(WireBuffer *buf, size_t alignment)
+{
+    size_t padding = (alignment - (buf->len & (alignment - 1)))
+                     & (alignment - 1);
+
+    if (_wire_reserve(buf, padding) < 0)
+        return -1;
+    memset(buf->data + buf->len, 0, padding);
+    buf->len += padding;
+    return 0;
+}
+
+static int
+_wire_put_aligned(WireBuffer *buf, const void *p, size_t n)
+{
+    if (_wire_pad(buf, n) < 0)
+        return -1;
+    return _wire_put(buf, p, n);
+}
+
+/* A signature, or a string of another type if len_size is 4 */
+static int
+_wire_put_string(WireBuffer *buf, const char *s, size_t len, int len_size)
+{
+    if (len_size == 1) {
+        unsigned char len_byte = (unsigned char)len;
+
+        if (_wire_put(buf, &len_byte, 1) < 0)
+            return -1;
     }
-    /* from here onwards, you have to do a goto rather than returning NULL
-    to make sure signature_obj gets freed */
+    else {
+        dbus_uint32_t len_u32 = (dbus_uint32_t)len;
 
-    /* iterate over args and the signature, together */
-    if (!dbus_signature_validate(signature, NULL)) {
-        PyErr_SetString(PyExc_ValueError, "Corrupt type signature");
-        goto err;
+        if (_wire_put_aligned(buf, &len_u32, 4) < 0)
+            return -1;
+    }
+    /* the terminating NUL too */
+    return _wire_put(buf, s, len + 1);
+}
+
+/* The alignment of a type in the wire format, which for the fixed-width
+ * types is also their size there. */
+size_t
+dbus_py_type_alignment(int type)
+{
+    switch (type) {
+        case DBUS_TYPE_BYTE:
+        case DBUS_TYPE_SIGNATURE:
+        case DBUS_TYPE_VARIANT:
+            return 1;
+        case DBUS_TYPE_INT16:
+        case DBUS_TYPE_UINT16:
+            return 2;
+        case DBUS_TYPE_INT64:
+        case DBUS_TYPE_UINT64:
+        case DBUS_TYPE_DOUBLE:
+        case DBUS_TYPE_STRUCT:
+        case DBUS_TYPE_DICT_ENTRY:
+            return 8;
+        default:
+            return 4;
     }
-    dbus_message_iter_init_append(self->msg, &appender);
+}
 
-    if (signature[0] != '\0') {
-        int i = 0;
+static int _wire_append_pyobject(WireBuffer *buf,
+                                 DBusSignatureIter *sig_iter,
+                                 PyObject *obj,
+                                 dbus_bool_t *more);
+static int _wire_append_variant(WireBuffer *buf, PyObject *obj);
 
-        more = TRUE;
-        dbus_signature_iter_init(&sig_iter, signature);
-        while (more) {
-            if (i >= PyTuple_GET_SIZE(args)) {
-                PyErr_SetString(PyExc_TypeError, "More items found in D-Bus "
-                                "signature than in Python arguments");
-                goto hosed;
-            }
-            if (_message_iter_append_pyobject(&appender, &sig_iter,
-                                              PyTuple_GET_ITEM(args, i),
-                                              &more) < 0) {
-                goto hosed;
-            }
-            i++;
+static int
+_wire_append_string(WireBuffer *buf, int sig_type, PyObject *obj,
+                    dbus_bool_t allow_object_path_attr)
+{
+    const char *s;
+    Py_ssize_t len;
+    dbus_bool_t is_ascii;
+    PyObject *utf8;
+    int ret = -1;
+
+    if (sig_type == DBUS_TYPE_OBJECT_PATH && allow_object_path_attr) {
+        PyObject *object_path = get_object_path (obj);
+
+        if (object_path == Py_None) {
+            Py_CLEAR(object_path);
         }
-        if (i < PyTuple_GET_SIZE(args)) {
-            PyErr_SetString(PyExc_TypeError, "Fewer items found in D-Bus "
-                    "signature than in Python arguments");
-            goto hosed;
+        else if (!object_path) {
+            return -1;
+        }
+        else {
+            ret = _wire_append_string(buf, sig_type, object_path, FALSE);
+            Py_CLEAR(object_path);
+            return ret;
         }
     }
 
-    /* success! */
-    Py_CLEAR(signature_obj);
-    Py_RETURN_NONE;
+    if (_get_utf8(obj, &utf8, &s, &len, &is_ascii) < 0)
+        return -1;
 
-hosed:
-    /* "If appending any of the arguments fails due to lack of memory,
-     * generally the message is hosed and you have to start over" -libdbus docs
-     * Enforce this by throwing away the message structure.
-     */
-    dbus_message_unref(self->msg);
-    self->msg = NULL;
-err:
-    Py_CLEAR(signature_obj);
-    return NULL;
+    if (sig_type == DBUS_TYPE_OBJECT_PATH) {
+        if (!dbus_py_validate_object_path(s))
+            goto out;
+    }
+    else if (sig_type == DBUS_TYPE_SIGNATURE) {
+        if (!dbus_signature_validate(s, NULL)) {
+            PyErr_SetString(PyExc_ValueError, "Corrupt type signature");
+            goto out;
+        }
+    }
+    /* Validate UTF-8, strictly */
+    else if (!is_ascii && !dbus_validate_utf8(s, NULL)) {
+        PyErr_SetString(PyExc_UnicodeError, "String parameters "
+                        "to be sent over D-Bus must be valid UTF-8 "
+                        "with no noncharacter code points");
+        goto out;
+    }
+    if ((size_t)len > DBUS_MAXIMUM_ARRAY_LENGTH) {
+        PyErr_SetString(PyExc_ValueError, "String too long for D-Bus");
+        goto out;
+    }
+
+    ret = _wire_put_string(buf, s, len,
+                           sig_type == DBUS_TYPE_SIGNATURE ? 1 : 4);
+out:
+    Py_CLEAR(utf8);
+    return ret;
+}
+
+static int
+_wire_append_byte(WireBuffer *buf, PyObject *obj)
+{
+    unsigned char y;
+
+    if (PyBytes_Check(obj)) {
+        if (PyBytes_GET_SIZE(obj) != 1) {
+            PyErr_Format(PyExc_ValueError,
+                         "Expected a length-1 bytes but found %d bytes",
+                         (int)PyBytes_GET_SIZE(obj));
+            return -1;
+        }
+        y = *(unsigned char *)PyBytes_AS_STRING(obj);
+    }
+    else {
+        /* on Python 2 this accepts either int or long */
+        long i = PyLong_AsLong(obj);
+
+        if (i == -1 && PyErr_Occurred()) return -1;
+        if (i < 0 || i > 0xff) {
+            PyErr_Format(PyExc_ValueError,
+                         "%d outside range for a byte value",
+                         (int)i);
+            return -1;
+        }
+        y = i;
+    }
+    return _wire_put(buf, &y, 1);
+}
+
+static int
+_wire_append_multi(WireBuffer *buf, const DBusSignatureIter *sig_iter,
+                   int mode, PyObject *obj)
+{
+    DBusSignatureIter sub_sig_iter;
+    PyObject *contents;
+    PyObject *fields = NULL;
+    PyObject *iterator;
+    dbus_bool_t is_byte_array = DBusPyByteArray_Check(obj);
+    int inner_type;
+    size_t len_offset = 0, start = 0;
+    dbus_bool_t more = TRUE;
+    int ret = 0;
+
+    if (mode == DBUS_TYPE_STRUCT && !PyTuple_Check(obj)) {
+        /* an instance of a registered struct class? */
+        fields = dbus_py_get_struct_fields(obj);
+        if (!fields && PyErr_Occurred()) return -1;
+    }
+    iterator = PyObject_GetIter(fields ? fields : obj);
+    Py_CLEAR(fields);
+    if (!iterator) return -1;
+
+    dbus_signature_iter_recurse(sig_iter, &sub_sig_iter);
+    inner_type = dbus_signature_iter_get_current_type(&sub_sig_iter);
+
+    if (mode == DBUS_TYPE_STRUCT) {
+        if (_wire_pad(buf, 8) < 0)
+            goto fail;
+    }
+    else {
+        dbus_uint32_t placeholder = 0;
+
+        if (_wire_put_aligned(buf, &placeholder, 4) < 0)
+            goto fail;
+        len_offset = buf->len - 4;
+        /* the padding before the first element isn't counted, even if
+         * there are no elements */
+        if (_wire_pad(buf, dbus_py_type_alignment(inner_type)) < 0)
+            goto fail;
+        start = buf->len;
+    }
+
+    while ((contents = PyIter_Next(iterator))) {
+        if (mode == DBUS_TYPE_ARRAY || mode == DBUS_TYPE_DICT_ENTRY) {
+            dbus_signature_iter_recurse(sig_iter, &sub_sig_iter);
+        }
+        else if (!more) {
+            PyErr_Format(PyExc_TypeError, "Fewer items found in struct's "
+                         "D-Bus signature than in Python arguments ");
+            Py_CLEAR(contents);
+            goto fail;
+        }
+
+        if (mode == DBUS_TYPE_DICT_ENTRY) {
+            PyObject *value = PyObject_GetItem(obj, contents);
+            DBusSignatureIter entry_sig_iter;
+
+            dbus_signature_iter_recurse(&sub_sig_iter, &entry_sig_iter);
+            if (!value || _wire_pad(buf, 8) < 0 ||
+                _wire_append_pyobject(buf, &entry_sig_iter, contents,
+                                      &more) < 0 ||
+                _wire_append_pyobject(buf, &entry_sig_iter, value,
+                                      &more) < 0) {
+                ret = -1;
+            }
+            Py_CLEAR(value);
+        }
+        else if (mode == DBUS_TYPE_ARRAY && is_byte_array
+                 && inner_type == DBUS_TYPE_VARIANT) {
+            /* as for _message_iter_append_multi, make variants containing
+             * bytes, not strings */
+            PyObject *byte = PyObject_CallFunctionObjArgs(
+                (PyObject *)&DBusPyByte_Type, contents, NULL);
+
+            if (!byte || _wire_append_variant(buf, byte) < 0)
+                ret = -1;
+            Py_CLEAR(byte);
+        }
+        else {
+            ret = _wire_append_pyobject(buf, &sub_sig_iter, contents, &more);
+        }
+
+        Py_CLEAR(contents);
+        if (ret < 0)
+            goto fail;
+    }
+
+    if (PyErr_Occurred())
+        goto fail;
+    if (mode == DBUS_TYPE_STRUCT) {
+        if (more) {
+            PyErr_Format(PyExc_TypeError, "More items found in struct's D-Bus "
+                         "signature than in Python arguments ");
+            goto fail;
+        }
+    }
+    else {
+        dbus_uint32_t len_u32;
+
+        if (buf->len - start > DBUS_MAXIMUM_ARRAY_LENGTH) {
+            PyErr_SetString(PyExc_ValueError, "Array too long for D-Bus");
+            goto fail;
+        }
+        len_u32 = (dbus_uint32_t)(buf->len - start);
+        memcpy(buf->data + len_offset, &len_u32, 4);
+    }
+
+    Py_CLEAR(iterator);
+    return 0;
+
+fail:
+    Py_CLEAR(iterator);
+    return -1;
+}
+
+/* Encode obj into a variant, given the signature of what's inside the
+ * innermost of variant_level variants. */
+static int
+_wire_append_variant_contents(WireBuffer *buf, PyObject *obj,
+                              const char *obj_sig_str, long variant_level)
+{
+    DBusSignatureIter obj_sig_iter;
+    dbus_bool_t dummy;
+    long i;
+
+    if (variant_level < 1) {
+        variant_level = 1;
+    }
+    /* each variant but the innermost contains another variant */
+    for (i = 1; i < variant_level; i++) {
+        if (_wire_put_string(buf, DBUS_TYPE_VARIANT_AS_STRING, 1, 1) < 0)
+            return -1;
+    }
+    if (_wire_put_string(buf, obj_sig_str, strlen(obj_sig_str), 1) < 0)
+        return -1;
+
+    dbus_signature_iter_init(&obj_sig_iter, obj_sig_str);
+    return _wire_append_pyobject(buf, &obj_sig_iter, obj, &dummy);
+}
+
+static int
+_wire_append_variant(WireBuffer *buf, PyObject *obj)
+{
+    const char *obj_sig_str;
+    PyObject *obj_sig;
+    long variant_level;
+    int ret = -1;
+
+    obj_sig = _variant_signature_from_pyobject(obj, &variant_level);
+    if (!obj_sig) return -1;
+    obj_sig_str = PyBytes_AS_STRING(obj_sig);
+
+    ret = _wire_append_variant_contents(buf, obj, obj_sig_str,
+                                        variant_level);
+    Py_CLEAR(obj_sig);
+    return ret;
+}
+
+/* As for _message_iter_append_vardict */
+static int
+_wire_append_vardict(WireBuffer *buf, DBusPyVarDict *dict)
+{
+    dbus_uint32_t placeholder = 0, len_u32;
+    size_t len_offset, start;
+    Py_ssize_t i;
+
+    if (_wire_put_aligned(buf, &placeholder, 4) < 0)
+        return -1;
+    len_offset = buf->len - 4;
+    if (_wire_pad(buf, 8) < 0)
+        return -1;
+    start = buf->len;
+
+    for (i = 0; i < dict->n_entries; i++) {
+        DBusPyVarDictEntry *item = &dict->entries[i];
+        long variant_level = get_variant_level(item->value);
+
+        if (variant_level < 0 || _wire_pad(buf, 8) < 0 ||
+            _wire_append_string(buf, DBUS_TYPE_STRING, item->key,
+                                FALSE) < 0 ||
+            _wire_append_variant_contents(buf, item->value,
+                                          dict->signatures + item->signature,
+                                          variant_level) < 0)
+            return -1;
+    }
+
+    if (buf->len - start > DBUS_MAXIMUM_ARRAY_LENGTH) {
+        PyErr_SetString(PyExc_ValueError, "Array too long for D-Bus");
+        return -1;
+    }
+    len_u32 = (dbus_uint32_t)(buf->len - start);
+    memcpy(buf->data + len_offset, &len_u32, 4);
+    return 0;
+}
+
+/* On success, *more is set to whether there's more in the signature. */
+static int
+_wire_append_pyobject(WireBuffer *buf, DBusSignatureIter *sig_iter,
+                      PyObject *obj, dbus_bool_t *more)
+{
+    int sig_type = dbus_signature_iter_get_current_type(sig_iter);
+    DBusBasicValue u;
+    int ret = -1;
+
+    switch (sig_type) {
+      case DBUS_TYPE_BOOLEAN:
+          ret = PyObject_IsTrue(obj);
+          if (ret < 0)
+              break;
+          u.bool_val = ret;
+          ret = _wire_put_aligned(buf, &u.bool_val, 4);
+          break;
+
+      case DBUS_TYPE_DOUBLE:
+          u.dbl = PyFloat_AsDouble(obj);
+          if (PyErr_Occurred())
+              break;
+          ret = _wire_put_aligned(buf, &u.dbl, 8);
+          break;
+
+#define PROCESS_INTEGER(size, member) \
+          u.member = dbus_py_##size##_range_check(obj);\
+          if (u.member == (dbus_##size##_t)(-1) && PyErr_Occurred())\
+              break;\
+          ret = _wire_put_aligned(buf, &u.member, sizeof(u.member));
+
+      case DBUS_TYPE_INT16:
+          PROCESS_INTEGER(int16, i16)
+          break;
+      case DBUS_TYPE_UINT16:
+          PROCESS_INTEGER(uint16, u16)
+          break;
+      case DBUS_TYPE_INT32:
+          PROCESS_INTEGER(int32, i32)
+          break;
+      case DBUS_TYPE_UINT32:
+          PROCESS_INTEGER(uint32, u32)
+          break;
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+      case DBUS_TYPE_INT64:
+          PROCESS_INTEGER(int64, i64)
+          break;
+      case DBUS_TYPE_UINT64:
+          PROCESS_INTEGER(uint64, u64)
+          break;
+#else
+      case DBUS_TYPE_INT64:
+      case DBUS_TYPE_UINT64:
+          PyErr_SetString(PyExc_NotImplementedError, "64-bit integer "
+                          "types are not supported on this platform");
+          break;
+#endif
+#undef PROCESS_INTEGER
+
+      case DBUS_TYPE_STRING:
+      case DBUS_TYPE_SIGNATURE:
+      case DBUS_TYPE_OBJECT_PATH:
+          ret = _wire_append_string(buf, sig_type, obj, TRUE);
+          break;
+
+      case DBUS_TYPE_BYTE:
+          ret = _wire_append_byte(buf, obj);
+          break;
+
+      case DBUS_TYPE_ARRAY:
+          sig_type = dbus_signature_iter_get_element_type(sig_iter);
+          if (sig_type == DBUS_TYPE_DICT_ENTRY && DBusPyVarDict_Check(obj)
+              && _is_vardict_signature(sig_iter)) {
+              ret = _wire_append_vardict(buf, (DBusPyVarDict *)obj);
+          }
+          else if (sig_type == DBUS_TYPE_DICT_ENTRY) {
+              ret = _wire_append_multi(buf, sig_iter, DBUS_TYPE_DICT_ENTRY,
+                                       obj);
+          }
+          else if (sig_type == DBUS_TYPE_BYTE && PyBytes_Check(obj)) {
+              dbus_uint32_t len = (dbus_uint32_t)PyBytes_GET_SIZE(obj);
+
+              if (PyBytes_GET_SIZE(obj) > DBUS_MAXIMUM_ARRAY_LENGTH) {
+                  PyErr_SetString(PyExc_ValueError,
+                                  "Array too long for D-Bus");
+                  break;
+              }
+              if (_wire_put_aligned(buf, &len, 4) < 0)
+                  break;
+              ret = _wire_put(buf, PyBytes_AS_STRING(obj), len);
+          }
+          else {
+              ret = _wire_append_multi(buf, sig_iter, DBUS_TYPE_ARRAY, obj);
+          }
+          break;
+
+      case DBUS_TYPE_STRUCT:
+          ret = _wire_append_multi(buf, sig_iter, sig_type, obj);
+          break;
+
+      case DBUS_TYPE_VARIANT:
+          ret = _wire_append_variant(buf, obj);
+          break;
+
+      case DBUS_TYPE_INVALID:
+          PyErr_SetString(PyExc_TypeError, "Fewer items found in D-Bus "
+                          "signature than in Python arguments");
+          break;
+
+#if defined(DBUS_TYPE_UNIX_FD)
+      case DBUS_TYPE_UNIX_FD:
+          /* the file descriptors can't be attached to a demarshalled
+           * message */
+          PyErr_SetString(PyExc_TypeError, "Unix file descriptors in "
+                          "variants cannot be appended with direct=True");
+          break;
+#endif
+
+      default:
+          PyErr_Format(PyExc_TypeError, "Unknown type '\\x%x' in D-Bus "
+                       "signature", sig_type);
+          break;
+    }
+    if (ret < 0) return -1;
+
+    *more = dbus_signature_iter_next(sig_iter);
+    return 0;
+}
+
+/* Return the offset just past the header field at offset pos, or 0 if
+ * it's not one we know how to skip. */
+static size_t
+_header_field_end(const char *data, size_t pos, size_t end)
+{
+    dbus_uint32_t len;
+
+    /* code, then a single complete type as a signature */
+    if (pos + 4 > end || data[pos + 1] != 1 || data[pos + 3] != '\0')
+        return 0;
+    switch (data[pos + 2]) {
+        case DBUS_TYPE_UINT32:
+            pos = (pos + 4 + 3) & ~(size_t)3;
+            pos += 4;
+            break;
+        case DBUS_TYPE_STRING:
+        case DBUS_TYPE_OBJECT_PATH:
+            pos = (pos + 4 + 3) & ~(size_t)3;
+            if (pos + 4 > end)
+                return 0;
+            memcpy(&len, data + pos, 4);
+            pos += 4 + (size_t)len + 1;
+            break;
+        case DBUS_TYPE_SIGNATURE:
+            pos += 4;
+            if (pos + 1 > end)
+                return 0;
+            pos += 1 + (unsigned char)data[pos] + 1;
+            break;
+        default:
+            return 0;
+    }
+    return pos <= end ? pos : 0;
+}
+
+static int
+_header_put_signature(WireBuffer *buf, const char *signature)
+{
+    size_t len = strlen(signature);
+    unsigned char field[5] = { DBUS_HEADER_FIELD_SIGNATURE, 1,
+                               DBUS_TYPE_SIGNATURE, '\0', 0 };
+
+    field[4] = (unsigned char)len;
+    if (_wire_put(buf, field, sizeof(field)) < 0)
+        return -1;
+    return _wire_put(buf, signature, len + 1);
+}
+
+/* Append the arguments to the message with the direct encoder, replacing
+ * self->msg. Return 1 on success, 0 if the message can't be encoded
+ * directly (decided before looking at the arguments), or -1 with an
+ * exception set, leaving the message unchanged.
+ *
+ * Only a message with no body yet is encoded directly: otherwise the
+ * existing body would have to be copied and validated again on every
+ * call, which makes a series of appends quadratic. Nor is a message whose
+ * DBusMessage has been borrowed, since the borrower's pointer would be
+ * left dangling. */
+static int
+_message_append_direct(Message *self, const char *signature, PyObject *args)
+{
+    static const union { dbus_uint32_t u; char c[4]; } probe = { 1 };
+    char *data = NULL;
+    int data_len = 0;
+    dbus_uint32_t fields_len, body_len, serial, u32;
+    size_t fields_end, header_len, body_start, pos;
+    dbus_bool_t replaced = FALSE;
+    WireBuffer buf = { NULL, 0, 0 };
+    DBusSignatureIter sig_iter;
+    DBusMessage *msg;
+    DBusError error;
+    dbus_bool_t more = TRUE;
+    Py_ssize_t i = 0;
+    int ret = -1;
+
+    if (self->borrowed || *dbus_message_get_signature(self->msg) != '\0')
+        return 0;
+#if defined(DBUS_TYPE_UNIX_FD)
+    /* file descriptors can't be passed through dbus_message_demarshal() */
+    if (strchr(signature, DBUS_TYPE_UNIX_FD))
+        return 0;
+#endif
+    if (strlen(signature) > DBUS_MAXIMUM_SIGNATURE_LENGTH) {
+        PyErr_SetString(PyExc_ValueError, "Signature too long for D-Bus");
+        return -1;
+    }
+
+    if (!dbus_message_marshal(self->msg, &data, &data_len)) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    if (data_len < 16 ||
+        data[0] != (probe.c[0] ? DBUS_LITTLE_ENDIAN : DBUS_BIG_ENDIAN)) {
+        ret = 0;
+        goto out;
+    }
+    memcpy(&body_len, data + 4, 4);
+    memcpy(&fields_len, data + 12, 4);
+    fields_end = 16 + (size_t)fields_len;
+    header_len = (fields_end + 7) & ~(size_t)7;
+    if (body_len != 0 || header_len != (size_t)data_len) {
+        ret = 0;
+        goto out;
+    }
+
+    /* the fixed part of the header, then the fields, with the new
+     * signature in place of the old one, or at the end */
+    if (_wire_put(&buf, data, 16) < 0)
+        goto out;
+    for (pos = 16; pos < fields_end; pos = (pos + 7) & ~(size_t)7) {
+        size_t end = _header_field_end(data, pos, fields_end);
+
+        if (end == 0) {
+            ret = 0;
+            goto out;
+        }
+        if (_wire_pad(&buf, 8) < 0)
+            goto out;
+        if (data[pos] == DBUS_HEADER_FIELD_SIGNATURE) {
+            if (_header_put_signature(&buf, signature) < 0)
+                goto out;
+            replaced = TRUE;
+        }
+        else if (_wire_put(&buf, data + pos, end - pos) < 0) {
+            goto out;
+        }
+        pos = end;
+    }
+    if (!replaced) {
+        if (_wire_pad(&buf, 8) < 0 ||
+            _header_put_signature(&buf, signature) < 0)
+            goto out;
+    }
+    u32 = (dbus_uint32_t)(buf.len - 16);
+    memcpy(buf.data + 12, &u32, 4);
+    if (_wire_pad(&buf, 8) < 0)
+        goto out;
+
+    /* then the arguments */
+    body_start = buf.len;
+    dbus_signature_iter_init(&sig_iter, signature);
+    while (more) {
+        if (i >= PyTuple_GET_SIZE(args)) {
+            PyErr_SetString(PyExc_TypeError, "More items found in D-Bus "
+                            "signature than in Python arguments");
+            goto out;
+        }
+        if (_wire_append_pyobject(&buf, &sig_iter, PyTuple_GET_ITEM(args, i),
+                                  &more) < 0)
+            goto out;
+        i++;
+    }
+    if (i < PyTuple_GET_SIZE(args)) {
+        PyErr_SetString(PyExc_TypeError, "Fewer items found in D-Bus "
+                "signature than in Python arguments");
+        goto out;
+    }
+    if (buf.len > DBUS_MAXIMUM_MESSAGE_LENGTH) {
+        PyErr_SetString(PyExc_ValueError, "Message too long for D-Bus");
+        goto out;
+    }
+    u32 = (dbus_uint32_t)(buf.len - body_start);
+    memcpy(buf.data + 4, &u32, 4);
+
+    /* a message with serial 0 won't load, so give it one temporarily;
+     * copying it resets the serial to 0 */
+    memcpy(&serial, buf.data + 8, 4);
+    if (serial == 0) {
+        u32 = 1;
+        memcpy(buf.data + 8, &u32, 4);
+    }
+
+    dbus_error_init(&error);
+    msg = dbus_message_demarshal(buf.data, (int)buf.len, &error);
+    if (!msg) {
+        DBusPyException_ConsumeError(&error);
+        goto out;
+    }
+    if (serial == 0) {
+        DBusMessage *copy = dbus_message_copy(msg);
+
+        dbus_message_unref(msg);
+        if (!copy) {
+            PyErr_NoMemory();
+            goto out;
+        }
+        msg = copy;
+    }
+    dbus_message_unref(self->msg);
+    self->msg = msg;
+    ret = 1;
+
+out:
+    dbus_free(data);
+    PyMem_Free(buf.data);
+    return ret;
+}
+
+/* The streaming writer: open_array() and friends open containers in the
+ * message one at a time, which are filled with append(), append_basic()
+ * and so on, then closed with close(). The signature of each container's
+ * contents is checked as we go, so that mistakes raise an exception
+ * rather than upsetting libdbus. */
+
+typedef struct {
+    /* DBUS_TYPE_ARRAY etc., or DBUS_TYPE_INVALID at the top level */
+    int type;
+    DBusMessageIter iter;
+    /* the contents must match the signature from expected to end, of
+     * which pos is the part still to be written; if expected is NULL,
+     * anything may be written */
+    const char *expected;
+    const char *end;
+    const char *pos;
+    /* a copy of the signature, if it's not part of the parent's */
+    char *owned;
+    unsigned long n_items;
+} WriterLevel;
+
+#define MAX_WRITER_DEPTH (2 * DBUS_MAXIMUM_TYPE_RECURSION_DEPTH)
+
+struct _DBusPyMessageWriter {
+    /* levels[0] is the top level, levels[depth] the innermost container */
+    int depth;
+    WriterLevel levels[MAX_WRITER_DEPTH + 1];
+};
+
+/* The length of the single complete type at the start of sig, which is
+ * known to be valid */
+static size_t
+_complete_type_len(const char *sig)
+{
+    size_t len = 1;
+
+    switch (sig[0]) {
+        case DBUS_TYPE_ARRAY:
+            return 1 + _complete_type_len(sig + 1);
+        case DBUS_STRUCT_BEGIN_CHAR:
+        case DBUS_DICT_ENTRY_BEGIN_CHAR:
+            while (sig[len] != DBUS_STRUCT_END_CHAR &&
+                   sig[len] != DBUS_DICT_ENTRY_END_CHAR)
+                len += _complete_type_len(sig + len);
+            return len + 1;
+        default:
+            return 1;
+    }
+}
+
+static const char *
+_container_name(int type)
+{
+    switch (type) {
+        case DBUS_TYPE_ARRAY:
+            return "array";
+        case DBUS_TYPE_STRUCT:
+            return "struct";
+        case DBUS_TYPE_DICT_ENTRY:
+            return "dict entry";
+        case DBUS_TYPE_VARIANT:
+            return "variant";
+        default:
+            return "message";
+    }
+}
+
+/* Check that a value of the single complete type sig[:len] may be written
+ * next in the level, and move past it. */
+static int
+_writer_expect(WriterLevel *level, const char *sig, size_t len)
+{
+    size_t n;
+
+    if (!level->expected) {
+        level->n_items++;
+        return 0;
+    }
+    if (level->pos >= level->end) {
+        PyErr_Format(PyExc_TypeError, "Nothing more can be written in this "
+                     "%s", _container_name(level->type));
+        return -1;
+    }
+    n = _complete_type_len(level->pos);
+    if (n != len || memcmp(level->pos, sig, len) != 0) {
+        /* PyErr_Format doesn't understand %.*s */
+        char buf[2 * DBUS_MAXIMUM_SIGNATURE_LENGTH + 100];
+
+        PyOS_snprintf(buf, sizeof(buf), "Expected a value of D-Bus type "
+                      "'%.*s' in this %s, not '%.*s'", (int)n, level->pos,
+                      _container_name(level->type), (int)len, sig);
+        PyErr_SetString(PyExc_TypeError, buf);
+        return -1;
+    }
+    /* every element of an array has the same type */
+    if (level->type != DBUS_TYPE_ARRAY)
+        level->pos += n;
+    level->n_items++;
+    return 0;
+}
+
+/* As _writer_expect, for each complete type in a valid signature; on
+ * failure, the level is unchanged. */
+static int
+_writer_expect_all(WriterLevel *level, const char *signature)
+{
+    const char *pos = level->pos;
+    unsigned long n_items = level->n_items;
+
+    while (*signature) {
+        size_t len = _complete_type_len(signature);
+
+        if (_writer_expect(level, signature, len) < 0) {
+            level->pos = pos;
+            level->n_items = n_items;
+            return -1;
+        }
+        signature += len;
+    }
+    return 0;
+}
+
+void
+dbus_py_message_writer_free(Message *self)
+{
+    DBusPyMessageWriter *writer = self->writer;
+
+    if (!writer)
+        return;
+    /* innermost first */
+    for (; writer->depth > 0; writer->depth--) {
+        WriterLevel *level = &writer->levels[writer->depth];
+
+        dbus_message_iter_abandon_container(
+            &writer->levels[writer->depth - 1].iter, &level->iter);
+        dbus_free(level->owned);
+    }
+    PyMem_Free(writer);
+    self->writer = NULL;
+}
+
+int
+dbus_py_message_check_closed(Message *self)
+{
+    if (self->writer) {
+        DBusPyException_SetString("Message has containers that have not "
+                                  "been closed");
+        return -1;
+    }
+    return 0;
+}
+
+/* "If appending any of the arguments fails due to lack of memory,
+ * generally the message is hosed and you have to start over" -libdbus docs
+ * Enforce this by throwing away the message structure. */
+static void
+_message_hose(Message *self)
+{
+    dbus_py_message_writer_free(self);
+    dbus_message_unref(self->msg);
+    self->msg = NULL;
+}
+
+/* Return the iterator with which to append values of the given valid
+ * signature: in the innermost open container, whose signature is checked,
+ * or after the message's arguments. Return NULL with an exception set if
+ * they can't be written there. */
+static DBusMessageIter *
+_writer_appender(Message *self, const char *signature,
+                 DBusMessageIter *appender)
+{
+    WriterLevel *level;
+
+    if (!self->writer) {
+        dbus_message_iter_init_append(self->msg, appender);
+        return appender;
+    }
+    level = &self->writer->levels[self->writer->depth];
+    if (_writer_expect_all(level, signature) < 0)
+        return NULL;
+    return &level->iter;
+}
+
+/* Append the n items, one for each complete type in the valid signature.
+ * On failure, some of them might have been appended. */
+static int
+_message_iter_append_items(DBusMessageIter *iter, const char *signature,
+                           PyObject *const *items, Py_ssize_t n)
+{
+    DBusSignatureIter sig_iter;
+    dbus_bool_t more;
+    Py_ssize_t i = 0;
+
+    if (signature[0] == '\0')
+        return 0;
+
+    more = TRUE;
+    dbus_signature_iter_init(&sig_iter, signature);
+    while (more) {
+        if (i >= n) {
+            PyErr_SetString(PyExc_TypeError, "More items found in D-Bus "
+                            "signature than in Python arguments");
+            return -1;
+        }
+        if (_message_iter_append_pyobject(iter, &sig_iter, items[i],
+                                          &more) < 0) {
+            return -1;
+        }
+        i++;
+    }
+    if (i < n) {
+        PyErr_SetString(PyExc_TypeError, "Fewer items found in D-Bus "
+                "signature than in Python arguments");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *
+_message_append(Message *self, PyObject *args, const char *signature,
+                int direct)
+{
+    PyObject *signature_obj = NULL;
+    DBusMessageIter appender, *iter;
+
+#ifdef USING_DBG
+    fprintf(stderr, "DBG/%ld: called Message_append(*", (long)getpid());
+    PyObject_Print(args, stderr, 0);
+    fprintf(stderr, ", signature=%s)\n", signature ? signature : "None");
+#endif
+
+    if (!signature) {
+        DBG("%s", "No signature for message, guessing...");
+        signature_obj = dbus_py_Message_guess_signature(NULL, args);
+        if (!signature_obj) return NULL;
+        if (PyUnicode_Check(signature_obj)) {
+            PyObject *signature_as_bytes;
+            signature_as_bytes = PyUnicode_AsUTF8String(signature_obj);
+            Py_CLEAR(signature_obj);
+            if (!signature_as_bytes)
+                return NULL;
+            signature_obj = signature_as_bytes;
+        }
+        else {
+            assert(PyBytes_Check(signature_obj));
+        }
+        signature = PyBytes_AS_STRING(signature_obj);
+    }
+    /* from here onwards, you have to do a goto rather than returning NULL
+    to make sure signature_obj gets freed */
+
+    /* iterate over args and the signature, together */
+    if (!dbus_signature_validate(signature, NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Corrupt type signature");
+        goto err;
+    }
+
+    if (direct && !self->writer && signature[0] != '\0') {
+        switch (_message_append_direct(self, signature, args)) {
+            case 1:
+                Py_CLEAR(signature_obj);
+                Py_RETURN_NONE;
+            case 0:
+                /* not supported for this message; use the iterator */
+                break;
+            default:
+                goto err;
+        }
+    }
+
+    iter = _writer_appender(self, signature, &appender);
+    if (!iter)
+        goto err;
+
+    if (_message_iter_append_items(iter, signature,
+                                   PySequence_Fast_ITEMS(args),
+                                   PyTuple_GET_SIZE(args)) < 0) {
+        goto hosed;
+    }
+
+    /* success! */
+    Py_CLEAR(signature_obj);
+    Py_RETURN_NONE;
+
+hosed:
+    _message_hose(self);
+err:
+    Py_CLEAR(signature_obj);
+    return NULL;
+}
+
+PyObject *
+dbus_py_Message_append(Message *self, DBUS_PY_ARGS)
+{
+    const char *signature = NULL;
+    static char *argnames[] = {"signature", "direct", NULL};
+    int direct = 0;
+#ifdef USING_FASTCALL
+    DBUS_PY_ARG_PARSER(parser, "|zi:append", argnames);
+    PyObject *items, *ret;
+    Py_ssize_t i;
+#endif
+
+    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+
+#ifdef USING_FASTCALL
+    /* the keyword arguments' values follow the items: parse just those */
+    if (!_PyArg_ParseStackAndKeywords(args + nargs, 0, kwnames, &parser,
+                                      &signature, &direct))
+        return NULL;
+
+    items = PyTuple_New(nargs);
+    if (!items) return NULL;
+    for (i = 0; i < nargs; i++) {
+        Py_INCREF(args[i]);
+        PyTuple_SET_ITEM(items, i, args[i]);
+    }
+    ret = _message_append(self, items, signature, direct);
+    Py_CLEAR(items);
+    return ret;
+#else
+    /* only use kwargs for this step: deliberately ignore args for now */
+    if (!PyArg_ParseTupleAndKeywords(dbus_py_empty_tuple, kwargs, "|zi:append",
+                                     argnames, &signature, &direct))
+        return NULL;
+
+    return _message_append(self, args, signature, direct);
+#endif
+}
+
+char dbus_py_Message_append_columns__doc__[] = (
+"append_columns(signature, columns)\n\n"
+"Append an array of structs to the message's arguments, taking the\n"
+"values of each struct field from a separate column.\n"
+"\n"
+"This is equivalent to\n"
+"``append(list(zip(*columns)), signature=signature)``,\n"
+"but no tuple is made for each row. Columns for fixed-width numeric\n"
+"fields may be objects supporting the buffer protocol, such as\n"
+"``array.array`` or ``memoryview``, whose values are converted directly\n"
+"in C; other columns are any sequence of objects, converted as for\n"
+"`append`.\n"
+"\n"
+":Parameters:\n"
+"   `signature` : str\n"
+"       The signature of the array, for instance ``a(sidu)``\n"
+"   `columns` : sequence\n"
+"       One column for each field of the struct, all of the same length\n"
+":Since: 1.2.1\n"
+);
+
+typedef struct {
+    /* type of the struct field */
+    int type;
+    /* the struct field's signature, for the generic path */
+    DBusSignatureIter sig_iter;
+    /* the column as a list or tuple, or NULL if it's a buffer */
+    PyObject *seq;
+    /* the column as a buffer, if view.obj is not NULL */
+    Py_buffer view;
+    /* 'i' for signed integers, 'u' for unsigned, 'f' for floating point */
+    char kind;
+} Column;
+
+/* If the column for a fixed-width numeric field supports the buffer
+ * protocol, with native numbers of a kind that can be converted to the
+ * field's type, fill in col->view and col->kind and return TRUE. */
+static dbus_bool_t
+_column_get_buffer(Column *col, PyObject *obj)
+{
+    const char *format;
+
+    switch (col->type) {
+        case DBUS_TYPE_BYTE:
+        case DBUS_TYPE_BOOLEAN:
+        case DBUS_TYPE_INT16:
+        case DBUS_TYPE_UINT16:
+        case DBUS_TYPE_INT32:
+        case DBUS_TYPE_UINT32:
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+        case DBUS_TYPE_INT64:
+        case DBUS_TYPE_UINT64:
+#endif
+        case DBUS_TYPE_DOUBLE:
+            break;
+        default:
+            return FALSE;
+    }
+
+    if (!PyObject_CheckBuffer(obj))
+        return FALSE;
+    if (PyObject_GetBuffer(obj, &col->view,
+                           PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) < 0) {
+        PyErr_Clear();
+        return FALSE;
+    }
+
+    format = col->view.format ? col->view.format : "B";
+    if (*format == '@')
+        format++;
+    col->kind = 0;
+    if (col->view.ndim <= 1 && format[0] && !format[1]) {
+        if (strchr("bhilq", format[0]))
+            col->kind = 'i';
+        else if (strchr("BHILQ?", format[0]))
+            col->kind = 'u';
+        else if (strchr("fd", format[0]))
+            col->kind = 'f';
+    }
+    if (col->kind == 'f') {
+        if (col->type != DBUS_TYPE_DOUBLE ||
+            (col->view.itemsize != sizeof(float) &&
+             col->view.itemsize != sizeof(double)))
+            col->kind = 0;
+    }
+    else if (col->view.itemsize != 1 && col->view.itemsize != 2 &&
+             col->view.itemsize != 4 && col->view.itemsize != 8) {
+        col->kind = 0;
+    }
+    if (!col->kind) {
+        /* not something we understand: use it as a sequence instead */
+        PyBuffer_Release(&col->view);
+        col->view.obj = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Append the value in row i of a buffer column */
+static int
+_column_append_fixed(DBusMessageIter *appender, Column *col, Py_ssize_t i)
+{
+    const char *p = (const char *)col->view.buf + i * col->view.itemsize;
+    DBusBasicValue u;
+    PY_LONG_LONG s = 0;
+    unsigned PY_LONG_LONG v = 0;
+    double d = 0.0;
+
+    switch (col->kind) {
+        case 'i':
+            switch (col->view.itemsize) {
+                case 1: { signed char x; memcpy(&x, p, 1); s = x; break; }
+                case 2: { dbus_int16_t x; memcpy(&x, p, 2); s = x; break; }
+                case 4: { dbus_int32_t x; memcpy(&x, p, 4); s = x; break; }
+                default: { PY_LONG_LONG x; memcpy(&x, p, 8); s = x; break; }
+            }
+            d = (double)s;
+            break;
+        case 'u':
+            switch (col->view.itemsize) {
+                case 1: { unsigned char x; memcpy(&x, p, 1); v = x; break; }
+                case 2: { dbus_uint16_t x; memcpy(&x, p, 2); v = x; break; }
+                case 4: { dbus_uint32_t x; memcpy(&x, p, 4); v = x; break; }
+                default: {
+                    unsigned PY_LONG_LONG x;
+                    memcpy(&x, p, 8);
+                    v = x;
+                    break;
+                }
+            }
+            d = (double)v;
+            break;
+        default:
+            if (col->view.itemsize == sizeof(float)) {
+                float x;
+                memcpy(&x, p, sizeof(float));
+                d = x;
+            }
+            else {
+                memcpy(&d, p, sizeof(double));
+            }
+            break;
+    }
+
+    /* the range of a signed value, or of an unsigned value stored in s */
+#define IN_RANGE(lo, hi) \
+    (col->kind == 'i' ? (s >= (lo) && s <= (PY_LONG_LONG)(hi)) \
+                      : (v <= (unsigned PY_LONG_LONG)(hi)))
+
+    switch (col->type) {
+        case DBUS_TYPE_DOUBLE:
+            u.dbl = d;
+            break;
+        case DBUS_TYPE_BOOLEAN:
+            u.bool_val = (col->kind == 'i' ? s != 0 : v != 0);
+            break;
+        case DBUS_TYPE_BYTE:
+            if (!IN_RANGE(0, 0xff))
+                goto overflow;
+            u.byt = (unsigned char)(col->kind == 'i' ? s : (PY_LONG_LONG)v);
+            break;
+        case DBUS_TYPE_INT16:
+            if (!IN_RANGE(-0x8000, 0x7fff))
+                goto overflow;
+            u.i16 = (dbus_int16_t)(col->kind == 'i' ? s : (PY_LONG_LONG)v);
+            break;
+        case DBUS_TYPE_UINT16:
+            if (!IN_RANGE(0, 0xffff))
+                goto overflow;
+            u.u16 = (dbus_uint16_t)(col->kind == 'i' ? s : (PY_LONG_LONG)v);
+            break;
+        case DBUS_TYPE_INT32:
+            if (!IN_RANGE(-(PY_LONG_LONG)0x80000000, 0x7fffffff))
+                goto overflow;
+            u.i32 = (dbus_int32_t)(col->kind == 'i' ? s : (PY_LONG_LONG)v);
+            break;
+        case DBUS_TYPE_UINT32:
+            if (!IN_RANGE(0, 0xffffffffUL))
+                goto overflow;
+            u.u32 = (dbus_uint32_t)(col->kind == 'i' ? s : (PY_LONG_LONG)v);
+            break;
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+        case DBUS_TYPE_INT64:
+            if (col->kind == 'u' && v > 0x7fffffffffffffffULL)
+                goto overflow;
+            u.i64 = (col->kind == 'i' ? s : (PY_LONG_LONG)v);
+            break;
+        case DBUS_TYPE_UINT64:
+            if (col->kind == 'i' && s < 0)
+                goto overflow;
+            u.u64 = (col->kind == 'i' ? (unsigned PY_LONG_LONG)s : v);
+            break;
+#endif
+        default:
+            /* _column_get_buffer doesn't allow anything else */
+            assert(0);
+            PyErr_SetString(PyExc_SystemError, "unexpected column type");
+            return -1;
+    }
+#undef IN_RANGE
+
+    if (!dbus_message_iter_append_basic(appender, col->type, &u)) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return 0;
+
+overflow:
+    /* the same exceptions as append() raises */
+    PyErr_Format(col->type == DBUS_TYPE_BYTE ? PyExc_ValueError
+                                             : PyExc_OverflowError,
+                 "Value in row %ld is out of range for D-Bus type '%c'",
+                 (long)i, col->type);
+    return -1;
+}
+
+PyObject *
+dbus_py_Message_append_columns(Message *self, PyObject *args)
+{
+    const char *signature;
+    PyObject *columns_obj;
+    PyObject *columns_seq = NULL;
+    Column *columns = NULL;
+    Py_ssize_t n_columns = 0, n_fields = 0, n_rows = -1, i, j;
+    DBusSignatureIter sig_iter, field_iter;
+    DBusMessageIter appender, *iter, array_appender, struct_appender;
+    char *struct_sig = NULL;
+    PyObject *ret = NULL;
+
+    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+
+    if (!PyArg_ParseTuple(args, "sO:append_columns", &signature,
+                          &columns_obj)) return NULL;
+
+    if (!dbus_signature_validate_single(signature, NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Corrupt type signature, or not "
+                        "a single complete type");
+        return NULL;
+    }
+    dbus_signature_iter_init(&sig_iter, signature);
+    if (dbus_signature_iter_get_current_type(&sig_iter) != DBUS_TYPE_ARRAY ||
+        dbus_signature_iter_get_element_type(&sig_iter) != DBUS_TYPE_STRUCT) {
+        PyErr_SetString(PyExc_ValueError, "append_columns() needs the "
+                        "signature of an array of structs");
+        return NULL;
+    }
+
+    columns_seq = PySequence_Fast(columns_obj, "columns must be a sequence");
+    if (!columns_seq) return NULL;
+    n_columns = PySequence_Fast_GET_SIZE(columns_seq);
+
+    /* sig_iter -> the struct -> its first field */
+    dbus_signature_iter_recurse(&sig_iter, &field_iter);
+    struct_sig = dbus_signature_iter_get_signature(&field_iter);
+    if (!struct_sig) {
+        PyErr_NoMemory();
+        goto out;
+    }
+    dbus_signature_iter_recurse(&field_iter, &field_iter);
+
+    columns = PyMem_New(Column, n_columns ? n_columns : 1);
+    if (!columns) {
+        PyErr_NoMemory();
+        goto out;
+    }
+    do {
+        if (n_fields < n_columns) {
+            Column *col = &columns[n_fields];
+            PyObject *obj = PySequence_Fast_GET_ITEM(columns_seq, n_fields);
+            Py_ssize_t len;
+
+            col->type = dbus_signature_iter_get_current_type(&field_iter);
+            col->sig_iter = field_iter;
+            col->seq = NULL;
+            col->view.obj = NULL;
+            if (_column_get_buffer(col, obj)) {
+                len = col->view.len / col->view.itemsize;
+            }
+            else {
+                col->seq = PySequence_Fast(obj, "each column must be a "
+                                           "sequence");
+                if (!col->seq) {
+                    n_columns = n_fields;
+                    goto out;
+                }
+                len = PySequence_Fast_GET_SIZE(col->seq);
+            }
+            if (n_rows >= 0 && len != n_rows) {
+                PyErr_SetString(PyExc_ValueError, "All the columns must "
+                                "have the same length");
+                n_columns = n_fields + 1;
+                goto out;
+            }
+            n_rows = len;
+        }
+        n_fields++;
+    } while (dbus_signature_iter_next(&field_iter));
+
+    if (n_fields != n_columns) {
+        PyErr_Format(PyExc_TypeError, "The struct has %ld fields but %ld "
+                     "columns were given", (long)n_fields, (long)n_columns);
+        if (n_columns > n_fields)
+            n_columns = n_fields;
+        goto out;
+    }
+
+    iter = _writer_appender(self, signature, &appender);
+    if (!iter)
+        goto out;
+    if (!dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY,
+                                          struct_sig, &array_appender)) {
+        PyErr_NoMemory();
+        goto hosed;
+    }
+    for (i = 0; i < n_rows; i++) {
+        int status = 0;
+
+        if (!dbus_message_iter_open_container(&array_appender,
+                                              DBUS_TYPE_STRUCT, NULL,
+                                              &struct_appender)) {
+            PyErr_NoMemory();
+            dbuspy_message_iter_close_container(iter, &array_appender,
+                                                FALSE);
+            goto hosed;
+        }
+        for (j = 0; j < n_columns && status == 0; j++) {
+            Column *col = &columns[j];
+
+            if (col->view.obj) {
+                status = _column_append_fixed(&struct_appender, col, i);
+            }
+            else {
+                /* appending advances the iterator, so use a copy */
+                DBusSignatureIter field_sig = col->sig_iter;
+                dbus_bool_t more;
+
+                status = _message_iter_append_pyobject(
+                    &struct_appender, &field_sig,
+                    PySequence_Fast_GET_ITEM(col->seq, i), &more);
+            }
+        }
+        if (!dbuspy_message_iter_close_container(&array_appender,
+                                                 &struct_appender,
+                                                 status == 0)) {
+            if (status == 0)
+                PyErr_NoMemory();
+            status = -1;
+        }
+        if (status < 0) {
+            dbuspy_message_iter_close_container(iter, &array_appender,
+                                                FALSE);
+            goto hosed;
+        }
+    }
+    if (!dbuspy_message_iter_close_container(iter, &array_appender,
+                                             TRUE)) {
+        PyErr_NoMemory();
+        goto hosed;
+    }
+
+    Py_INCREF(Py_None);
+    ret = Py_None;
+    goto out;
+
+hosed:
+    /* as for append(), the message can't be used after a failure */
+    _message_hose(self);
+out:
+    if (columns) {
+        for (j = 0; j < n_columns; j++) {
+            if (columns[j].view.obj)
+                PyBuffer_Release(&columns[j].view);
+            Py_CLEAR(columns[j].seq);
+        }
+        PyMem_Free(columns);
+    }
+    dbus_free(struct_sig);
+    Py_CLEAR(columns_seq);
+    return ret;
+}
+
+/* Return the innermost open level, or NULL if there is none */
+static WriterLevel *
+_writer_current(Message *self)
+{
+    DBusPyMessageWriter *writer = self->writer;
+
+    if (!writer)
+        return NULL;
+    return &writer->levels[writer->depth];
+}
+
+/* Check that another container can be opened, before anything is done
+ * to open it */
+static int
+_writer_check_depth(Message *self)
+{
+    if (!self->msg) {
+        DBusPy_RaiseUnusableMessage();
+        return -1;
+    }
+    if (self->writer && self->writer->depth >= MAX_WRITER_DEPTH) {
+        PyErr_SetString(PyExc_ValueError, "Containers nested too deeply "
+                        "for D-Bus");
+        return -1;
+    }
+    return 0;
+}
+
+/* Open a container in the current level, whose signature has been
+ * checked, making it the current level. If owned_sig is not NULL, it is
+ * copied and becomes the signature of the container's contents; otherwise
+ * the contents must match [expected, end), or anything if expected is
+ * NULL. */
+static PyObject *
+_writer_open(Message *self, int type, const char *sig,
+             const char *owned_sig, const char *expected, const char *end)
+{
+    DBusPyMessageWriter *writer = self->writer;
+    WriterLevel *parent, *level;
+
+    if (!writer) {
+        writer = PyMem_New(DBusPyMessageWriter, 1);
+        if (!writer)
+            return PyErr_NoMemory();
+        writer->depth = 0;
+        writer->levels[0].type = DBUS_TYPE_INVALID;
+        writer->levels[0].expected = NULL;
+        writer->levels[0].owned = NULL;
+        writer->levels[0].n_items = 0;
+        dbus_message_iter_init_append(self->msg, &writer->levels[0].iter);
+        self->writer = writer;
+    }
+
+    parent = &writer->levels[writer->depth];
+    level = &writer->levels[writer->depth + 1];
+    level->type = type;
+    level->owned = NULL;
+    level->n_items = 0;
+    if (owned_sig) {
+        size_t len = strlen(owned_sig);
+
+        level->owned = dbus_malloc(len + 1);
+        if (!level->owned) {
+            _message_hose(self);
+            return PyErr_NoMemory();
+        }
+        memcpy(level->owned, owned_sig, len + 1);
+        expected = level->owned;
+        end = level->owned + len;
+    }
+    level->expected = level->pos = expected;
+    level->end = end;
+
+    if (!dbus_message_iter_open_container(&parent->iter, type, sig,
+                                          &level->iter)) {
+        dbus_free(level->owned);
+        _message_hose(self);
+        return PyErr_NoMemory();
+    }
+    writer->depth++;
+    Py_RETURN_NONE;
+}
+
+char dbus_py_Message_open_array__doc__[] = (
+"open_array(signature)\n\n"
+"Open an array whose elements have the given signature, after the\n"
+"message's arguments or in the current container. Until it is closed\n"
+"with `close`, `append` and the other methods add elements to it.\n"
+"\n"
+"This and the other ``open_`` methods build a message incrementally,\n"
+"so that large values needn't be made into Python objects all at once.\n"
+"The message can't be sent or read while containers are open.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+PyObject *
+dbus_py_Message_open_array(Message *self, PyObject *arg)
+{
+    const char *signature;
+    char item[DBUS_MAXIMUM_SIGNATURE_LENGTH + 1];
+    size_t len;
+    WriterLevel *parent;
+    const char *expected;
+
+    if (!PyArg_Parse(arg, "s:open_array", &signature))
+        return NULL;
+    if (_writer_check_depth(self) < 0)
+        return NULL;
+    len = strlen(signature);
+    if (len + 1 > DBUS_MAXIMUM_SIGNATURE_LENGTH) {
+        PyErr_SetString(PyExc_ValueError, "Signature too long for D-Bus");
+        return NULL;
+    }
+    /* dict entries are only valid as array elements */
+    item[0] = DBUS_TYPE_ARRAY;
+    memcpy(item + 1, signature, len + 1);
+    if (len == 0 || !dbus_signature_validate_single(item, NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Corrupt type signature, or not "
+                        "a single complete type");
+        return NULL;
+    }
+
+    parent = _writer_current(self);
+    if (parent && parent->expected) {
+        /* the element signature is already part of the parent's */
+        expected = parent->pos + 1;
+        if (_writer_expect(parent, item, len + 1) < 0)
+            return NULL;
+        return _writer_open(self, DBUS_TYPE_ARRAY, signature, NULL,
+                            expected, expected + len);
+    }
+    if (parent)
+        parent->n_items++;
+    return _writer_open(self, DBUS_TYPE_ARRAY, signature, signature,
+                        NULL, NULL);
+}
+
+char dbus_py_Message_open_struct__doc__[] = (
+"open_struct()\n\n"
+"Open a struct, after the message's arguments or in the current\n"
+"container, as for `open_array`. Its fields are appended in order, and\n"
+"there must be at least one.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+PyObject *
+dbus_py_Message_open_struct(Message *self, PyObject *args UNUSED)
+{
+    WriterLevel *parent;
+    const char *expected;
+    size_t len;
+
+    if (_writer_check_depth(self) < 0)
+        return NULL;
+    parent = _writer_current(self);
+    if (!parent || !parent->expected) {
+        /* anything goes, and the same applies to the fields */
+        if (parent)
+            parent->n_items++;
+        return _writer_open(self, DBUS_TYPE_STRUCT, NULL, NULL, NULL, NULL);
+    }
+
+    expected = parent->pos;
+    if (expected < parent->end && *expected == DBUS_STRUCT_BEGIN_CHAR) {
+        len = _complete_type_len(expected);
+    }
+    else {
+        /* get the usual exception */
+        len = 2;
+        expected = "()";
+    }
+    if (_writer_expect(parent, expected, len) < 0)
+        return NULL;
+    return _writer_open(self, DBUS_TYPE_STRUCT, NULL, NULL, expected + 1,
+                        expected + len - 1);
+}
+
+char dbus_py_Message_open_dict_entry__doc__[] = (
+"open_dict_entry()\n\n"
+"Open an entry in the current container, which must be an array opened\n"
+"with a dict entry signature such as ``'{sv}'``. The key and the value\n"
+"are appended in that order.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+PyObject *
+dbus_py_Message_open_dict_entry(Message *self, PyObject *args UNUSED)
+{
+    WriterLevel *parent;
+    size_t len;
+
+    if (_writer_check_depth(self) < 0)
+        return NULL;
+    parent = _writer_current(self);
+    if (!parent || parent->type != DBUS_TYPE_ARRAY ||
+        *parent->expected != DBUS_DICT_ENTRY_BEGIN_CHAR) {
+        PyErr_SetString(PyExc_TypeError, "Dict entries can only be "
+                        "written in an array of dict entries");
+        return NULL;
+    }
+    len = parent->end - parent->expected;
+    if (_writer_expect(parent, parent->expected, len) < 0)
+        return NULL;
+    return _writer_open(self, DBUS_TYPE_DICT_ENTRY, NULL, NULL,
+                        parent->expected + 1, parent->end - 1);
+}
+
+char dbus_py_Message_open_variant__doc__[] = (
+"open_variant(signature)\n\n"
+"Open a variant containing one value of the given signature, after the\n"
+"message's arguments or in the current container, as for `open_array`.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+PyObject *
+dbus_py_Message_open_variant(Message *self, PyObject *arg)
+{
+    const char *signature;
+    WriterLevel *parent;
+
+    if (!PyArg_Parse(arg, "s:open_variant", &signature))
+        return NULL;
+    if (_writer_check_depth(self) < 0)
+        return NULL;
+    if (!dbus_signature_validate_single(signature, NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Corrupt type signature, or not "
+                        "a single complete type");
+        return NULL;
+    }
+    parent = _writer_current(self);
+    if (parent && _writer_expect(parent, DBUS_TYPE_VARIANT_AS_STRING, 1) < 0)
+        return NULL;
+    return _writer_open(self, DBUS_TYPE_VARIANT, signature, signature,
+                        NULL, NULL);
+}
+
+/* Parse a type code given as a str of length 1 */
+static int
+_parse_type_code(PyObject *obj, const char *what)
+{
+    PyObject *tmp = NULL;
+    const char *s;
+    Py_ssize_t len;
+    dbus_bool_t is_ascii;
+    int type = DBUS_TYPE_INVALID;
+
+    if (_get_utf8(obj, &tmp, &s, &len, &is_ascii) < 0)
+        return DBUS_TYPE_INVALID;
+    if (len == 1)
+        type = (unsigned char)s[0];
+    Py_CLEAR(tmp);
+    if (type == DBUS_TYPE_INVALID || !dbus_type_is_basic(type)) {
+        PyErr_Format(PyExc_ValueError, "%s must be the type code of a "
+                     "basic D-Bus type, such as 's' or 'i'", what);
+        return DBUS_TYPE_INVALID;
+    }
+    return type;
+}
+
+char dbus_py_Message_append_basic__doc__[] = (
+"append_basic(type, value)\n\n"
+"Append a value of a basic type, given by its type code such as ``'s'``\n"
+"or ``'i'``, after the message's arguments or in the current container.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+PyObject *
+dbus_py_Message_append_basic(Message *self, PyObject *args)
+{
+    PyObject *type_obj, *value;
+    char sig[2] = { '\0', '\0' };
+    DBusMessageIter appender, *iter;
+    DBusSignatureIter sig_iter;
+    dbus_bool_t more;
+
+    if (!PyArg_ParseTuple(args, "OO:append_basic", &type_obj, &value))
+        return NULL;
+    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    sig[0] = (char)_parse_type_code(type_obj, "type");
+    if (sig[0] == DBUS_TYPE_INVALID)
+        return NULL;
+
+    iter = _writer_appender(self, sig, &appender);
+    if (!iter)
+        return NULL;
+    dbus_signature_iter_init(&sig_iter, sig);
+    if (_message_iter_append_pyobject(iter, &sig_iter, value, &more) < 0) {
+        _message_hose(self);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+/* Return TRUE if the items of view can be copied into a message as an
+ * array of type, whose items are size bytes each: as in _column_init(),
+ * the format must be a single native item of the same kind and size. */
+static dbus_bool_t
+_buffer_matches_type(const Py_buffer *view, int type, size_t size)
+{
+    const char *format = view->format ? view->format : "B";
+    const char *kinds;
+
+    if (*format == '@')
+        format++;
+    if (view->ndim > 1 || !format[0] || format[1] ||
+        (size_t)view->itemsize != size)
+        return FALSE;
+    switch (type) {
+        case DBUS_TYPE_BYTE:
+            kinds = "bBc";
+            break;
+        case DBUS_TYPE_INT16:
+        case DBUS_TYPE_INT32:
+        case DBUS_TYPE_INT64:
+            kinds = "bhilq";
+            break;
+        case DBUS_TYPE_UINT16:
+        case DBUS_TYPE_UINT32:
+        case DBUS_TYPE_UINT64:
+            kinds = "BHILQ";
+            break;
+        case DBUS_TYPE_DOUBLE:
+            kinds = "d";
+            break;
+        default:
+            return FALSE;
+    }
+    return strchr(kinds, format[0]) != NULL;
+}
+
+char dbus_py_Message_append_fixed_array__doc__[] = (
+"append_fixed_array(type, values)\n\n"
+"Append an array of a fixed-width basic type, given by its type code such\n"
+"as ``'i'`` or ``'d'``, after the message's arguments or in the current\n"
+"container. If `values` supports the buffer protocol, such as\n"
+"``array.array`` or ``bytes``, its contents are copied into the message\n"
+"as they are: they must be in the machine's byte order, and its items\n"
+"must have the size and signedness of the D-Bus type (or be floats of\n"
+"type ``'d'`` for doubles). Otherwise it's used as a sequence of values.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+PyObject *
+dbus_py_Message_append_fixed_array(Message *self, PyObject *args)
+{
+    PyObject *type_obj, *values;
+    int type;
+    char sig[3] = { DBUS_TYPE_ARRAY, '\0', '\0' };
+    DBusMessageIter appender, sub_appender, *iter;
+    DBusSignatureIter sig_iter;
+    Py_buffer view;
+    const void *data;
+    dbus_bool_t more, ok;
+    size_t size;
+    PyObject *ret = NULL;
+
+    if (!PyArg_ParseTuple(args, "OO:append_fixed_array", &type_obj, &values))
+        return NULL;
+    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    type = _parse_type_code(type_obj, "type");
+    if (type == DBUS_TYPE_INVALID)
+        return NULL;
+    if (!dbus_type_is_fixed(type)) {
+        PyErr_SetString(PyExc_ValueError, "append_fixed_array() needs a "
+                        "fixed-width type");
+        return NULL;
+    }
+    sig[1] = (char)type;
+
+    /* booleans and fds need converting one by one */
+    if (type == DBUS_TYPE_BOOLEAN ||
+#ifdef DBUS_TYPE_UNIX_FD
+        type == DBUS_TYPE_UNIX_FD ||
+#endif
+        !PyObject_CheckBuffer(values)) {
+        iter = _writer_appender(self, sig, &appender);
+        if (!iter)
+            return NULL;
+        dbus_signature_iter_init(&sig_iter, sig);
+        if (_message_iter_append_pyobject(iter, &sig_iter, values,
+                                          &more) < 0) {
+            _message_hose(self);
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    if (PyObject_GetBuffer(values, &view,
+                           PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) < 0)
+        return NULL;
+    size = dbus_py_type_alignment(type);
+    if (!_buffer_matches_type(&view, type, size)) {
+        PyErr_Format(PyExc_ValueError, "The buffer's items must be %lu "
+                     "bytes each, with a format matching '%c'",
+                     (unsigned long)size, type);
+        goto out;
+    }
+    if (view.len % size != 0) {
+        PyErr_Format(PyExc_ValueError, "The buffer's length must be a "
+                     "multiple of %lu", (unsigned long)size);
+        goto out;
+    }
+    if (view.len / size > DBUS_MAXIMUM_ARRAY_LENGTH / size) {
+        PyErr_SetString(PyExc_ValueError, "Array too long for D-Bus");
+        goto out;
+    }
+    iter = _writer_appender(self, sig, &appender);
+    if (!iter)
+        goto out;
+
+    if (!dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY, sig + 1,
+                                          &sub_appender)) {
+        PyErr_NoMemory();
+        _message_hose(self);
+        goto out;
+    }
+    data = view.buf;
+    ok = dbus_message_iter_append_fixed_array(&sub_appender, type, &data,
+                                              (int)(view.len / size));
+    if (!dbuspy_message_iter_close_container(iter, &sub_appender, ok) ||
+        !ok) {
+        PyErr_NoMemory();
+        _message_hose(self);
+        goto out;
+    }
+    Py_INCREF(Py_None);
+    ret = Py_None;
+
+out:
+    PyBuffer_Release(&view);
+    return ret;
+}
+
+char dbus_py_Message_close__doc__[] = (
+"close()\n\n"
+"Close the container most recently opened with `open_array`,\n"
+"`open_struct`, `open_dict_entry` or `open_variant`. Raise TypeError,\n"
+"leaving it open, if it isn't complete.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+PyObject *
+dbus_py_Message_close(Message *self, PyObject *args UNUSED)
+{
+    DBusPyMessageWriter *writer = self->writer;
+    WriterLevel *level;
+
+    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    if (!writer) {
+        PyErr_SetString(PyExc_ValueError, "No container is open");
+        return NULL;
+    }
+    level = &writer->levels[writer->depth];
+    if (level->type == DBUS_TYPE_STRUCT && level->n_items == 0) {
+        PyErr_SetString(PyExc_TypeError, "A struct must have at least one "
+                        "field");
+        return NULL;
+    }
+    if (level->expected && level->type != DBUS_TYPE_ARRAY &&
+        level->pos < level->end) {
+        char buf[DBUS_MAXIMUM_SIGNATURE_LENGTH + 100];
+
+        PyOS_snprintf(buf, sizeof(buf), "Expected a value of D-Bus type "
+                      "'%.*s' before closing this %s",
+                      (int)_complete_type_len(level->pos), level->pos,
+                      _container_name(level->type));
+        PyErr_SetString(PyExc_TypeError, buf);
+        return NULL;
+    }
+
+    writer->depth--;
+    if (!dbus_message_iter_close_container(&writer->levels[writer->depth].iter,
+                                           &level->iter)) {
+        dbus_free(level->owned);
+        _message_hose(self);
+        return PyErr_NoMemory();
+    }
+    dbus_free(level->owned);
+    if (writer->depth == 0) {
+        PyMem_Free(writer);
+        self->writer = NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+/* C API ============================================================ */
+
+int
+DBusPyMessageIter_AppendArgs(DBusMessageIter *iter, const char *signature,
+                             PyObject *args)
+{
+    PyObject *tuple;
+    int ret;
+
+    if (!dbus_signature_validate(signature, NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Corrupt type signature");
+        return -1;
+    }
+    /* a tuple, so that appending can't change it under our feet */
+    tuple = PySequence_Tuple(args);
+    if (!tuple) return -1;
+    ret = _message_iter_append_items(iter, signature,
+                                     PySequence_Fast_ITEMS(tuple),
+                                     PyTuple_GET_SIZE(tuple));
+    Py_CLEAR(tuple);
+    return ret;
 }
 
 /* vim:set ft=c cino< sw=4 sts=4 et: */
@@ -27,6 +27,8 @@
 #define PY_SIZE_T_CLEAN 1
 
 #define DBG_IS_TOO_VERBOSE
+#include <string.h>
+
 #include "compat-internal.h"
 #include "types-internal.h"
 #include "message-internal.h"
@@ -48,6 +50,21 @@ char dbus_py_Message_get_args_list__doc__[] = (
 "       If true, return D-Bus strings as Python 8-bit strings (of UTF-8).\n"
 "       If false (default), return D-Bus strings as Python unicode objects.\n"
 #endif
+"   `struct_columns` : bool\n"
+"       If true, convert each array of structs into a tuple with one\n"
+"       column per struct field, instead of a dbus.Array of dbus.Struct.\n"
+"       Columns of fixed-width numbers are ``array.array`` objects (bytes\n"
+"       and booleans with typecode 'B'); other columns are lists of the\n"
+"       usual types. (New in 1.2.1.)\n"
+"   `vardicts` : bool\n"
+"       If true, convert each dict of signature 'a{sv}' into a dbus.VarDict,\n"
+"       which is immutable and remembers the D-Bus type of each value,\n"
+"       instead of a dbus.Dictionary. (New in 1.2.1.)\n"
+"   `direct` : bool\n"
+"       If true, decode the arguments from the marshalled message body in\n"
+"       a single pass, which is faster for large or deeply nested messages.\n"
+"       The result is the same; messages containing Unix file descriptors\n"
+"       are always decoded with a D-Bus message iterator. (New in 1.2.1.)\n"
 "\n"
 "Most of the type mappings should be fairly obvious:\n"
 "\n"
@@ -62,11 +79,13 @@ char dbus_py_Message_get_args_list__doc__[] = (
 "string (s)       dbus.String (unicode subclass)\n"
 "                 (or dbus.UTF8String, str subclass, if utf8_strings set)\n"
 "Object path (o)  dbus.ObjectPath (str subclass)\n"
-"dict (a{...})    dbus.Dictionary\n"
+"dict (a{...})    dbus.Dictionary (or dbus.VarDict for a{sv}, if\n"
+"                 vardicts set)\n"
 "array (a...)     dbus.Array (list subclass) containing appropriate types\n"
 "byte array (ay)  dbus.ByteArray (str subclass) if byte_arrays set; or\n"
 "                 list of Byte\n"
-"struct ((...))   dbus.Struct (tuple subclass) of appropriate types\n"
+"struct ((...))   dbus.Struct (tuple subclass) of appropriate types, or\n"
+"                 the class registered with register_struct_class\n"
 "variant (v)      contained type, but with variant_level > 0\n"
 "===============  ===================================================\n"
 );
@@ -76,6 +95,8 @@ typedef struct {
 #ifndef PY3
     int utf8_strings;
 #endif
+    int struct_columns;
+    int vardicts;
 } Message_get_args_options;
 
 static PyObject *_message_iter_get_pyobject(DBusMessageIter *iter,
@@ -185,61 +206,429 @@ _message_iter_get_dict(DBusMessageIter *iter,
     return ret;
 }
 
-/* Returns a new reference. */
+/* One column being decoded by _message_iter_get_struct_columns */
+typedef struct {
+    int type;
+    /* the array.array typecode, or 0 to make a list */
+    char typecode;
+    int size;
+    char *buf;
+    size_t len;
+    size_t alloc;
+    PyObject *list;
+} OutputColumn;
+
+/* Return the array.array typecode for a fixed-width D-Bus type, and set
+ * *size to its size, or return 0 if there is no suitable typecode. */
+static char
+_column_typecode(int type, int *size)
+{
+    switch (type) {
+        case DBUS_TYPE_BYTE:
+        case DBUS_TYPE_BOOLEAN:
+            *size = 1;
+            return 'B';
+        case DBUS_TYPE_INT16:
+            *size = 2;
+            return sizeof(short) == 2 ? 'h' : 0;
+        case DBUS_TYPE_UINT16:
+            *size = 2;
+            return sizeof(short) == 2 ? 'H' : 0;
+        case DBUS_TYPE_INT32:
+            *size = 4;
+            return sizeof(int) == 4 ? 'i' : 0;
+        case DBUS_TYPE_UINT32:
+            *size = 4;
+            return sizeof(int) == 4 ? 'I' : 0;
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+        case DBUS_TYPE_INT64:
+            *size = 8;
+#ifdef PY3
+            return 'q';
+#else
+            return sizeof(long) == 8 ? 'l' : 0;
+#endif
+        case DBUS_TYPE_UINT64:
+            *size = 8;
+#ifdef PY3
+            return 'Q';
+#else
+            return sizeof(long) == 8 ? 'L' : 0;
+#endif
+#endif
+        case DBUS_TYPE_DOUBLE:
+            *size = 8;
+            return 'd';
+        default:
+            return 0;
+    }
+}
+
+/* Set up a zero-filled column for a field of the given type. */
+static int
+_column_init(OutputColumn *col, int type)
+{
+    col->type = type;
+    col->typecode = _column_typecode(type, &col->size);
+    if (!col->typecode) {
+        col->list = PyList_New(0);
+        if (!col->list)
+            return -1;
+    }
+    return 0;
+}
+
+/* Add a fixed-width value, in the D-Bus representation, to the column. */
+static int
+_column_push_fixed(OutputColumn *col, const void *value)
+{
+    if (col->len + col->size > col->alloc) {
+        size_t alloc = col->alloc ? col->alloc * 2 : 64;
+        char *buf = PyMem_Realloc(col->buf, alloc);
+
+        if (!buf) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        col->buf = buf;
+        col->alloc = alloc;
+    }
+    if (col->type == DBUS_TYPE_BOOLEAN) {
+        dbus_bool_t b;
+
+        memcpy(&b, value, sizeof(b));
+        col->buf[col->len] = (b != 0);
+    }
+    else {
+        memcpy(col->buf + col->len, value, col->size);
+    }
+    col->len += col->size;
+    return 0;
+}
+
 static PyObject *
-_message_iter_get_pyobject(DBusMessageIter *iter,
-                           Message_get_args_options *opts,
-                           long variant_level)
+_column_to_array(OutputColumn *col)
 {
-    DBusBasicValue u;
-    int type = dbus_message_iter_get_arg_type(iter);
-    PyObject *args = NULL;
-    PyObject *kwargs = NULL;
-    PyObject *ret = NULL;
+    static PyObject *array_type = NULL;
+    char typecode[2] = { col->typecode, '\0' };
+    PyObject *view, *ret, *result;
 
-    /* If the variant-level is >0, prepare a dict for the kwargs.
-     * For variant wrappers optimize slightly by skipping this.
-     */
-    if (variant_level > 0 && type != DBUS_TYPE_VARIANT) {
-        PyObject *variant_level_int;
+    if (!array_type) {
+        PyObject *module = PyImport_ImportModule("array");
 
-        variant_level_int = NATIVEINT_FROMLONG(variant_level);
-        if (!variant_level_int) {
+        if (!module)
             return NULL;
-        }
-        kwargs = PyDict_New();
-        if (!kwargs) {
-            Py_CLEAR(variant_level_int);
+        array_type = PyObject_GetAttrString(module, "array");
+        Py_CLEAR(module);
+        if (!array_type)
             return NULL;
+    }
+
+    ret = PyObject_CallFunction(array_type, "(s)", typecode);
+    if (!ret || col->len == 0)
+        return ret;
+
+    /* copy straight from our buffer into the array's */
+#ifdef PY3
+    view = PyMemoryView_FromMemory(col->buf, (Py_ssize_t)col->len,
+                                   PyBUF_READ);
+#else
+    view = PyBuffer_FromMemory(col->buf, (Py_ssize_t)col->len);
+#endif
+    if (!view) {
+        Py_CLEAR(ret);
+        return NULL;
+    }
+#ifdef PY3
+    result = PyObject_CallMethod(ret, "frombytes", "(O)", view);
+#else
+    result = PyObject_CallMethod(ret, "fromstring", "(O)", view);
+#endif
+    Py_CLEAR(view);
+    if (!result) {
+        Py_CLEAR(ret);
+        return NULL;
+    }
+    Py_CLEAR(result);
+    return ret;
+}
+
+/* Return a tuple of the columns' contents. */
+static PyObject *
+_columns_to_tuple(OutputColumn *columns, int n_columns)
+{
+    PyObject *ret = PyTuple_New(n_columns);
+    int i;
+
+    if (!ret)
+        return NULL;
+    for (i = 0; i < n_columns; i++) {
+        PyObject *column;
+
+        if (columns[i].typecode) {
+            column = _column_to_array(&columns[i]);
+            if (!column) {
+                Py_CLEAR(ret);
+                return NULL;
+            }
         }
-        if (PyDict_SetItem(kwargs, dbus_py_variant_level_const,
-                           variant_level_int) < 0) {
-            Py_CLEAR(variant_level_int);
-            Py_CLEAR(kwargs);
-            return NULL;
+        else {
+            column = columns[i].list;
+            columns[i].list = NULL;
         }
-        Py_CLEAR(variant_level_int);
+        PyTuple_SET_ITEM(ret, i, column);
+    }
+    return ret;
+}
+
+static OutputColumn *
+_columns_new(int n_columns)
+{
+    OutputColumn *columns = PyMem_New(OutputColumn, n_columns);
+
+    if (!columns) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    memset(columns, 0, n_columns * sizeof(OutputColumn));
+    return columns;
+}
+
+static void
+_columns_free(OutputColumn *columns, int n_columns)
+{
+    int i;
+
+    if (!columns)
+        return;
+    for (i = 0; i < n_columns; i++) {
+        PyMem_Free(columns[i].buf);
+        Py_CLEAR(columns[i].list);
+    }
+    PyMem_Free(columns);
+}
+
+/* Decode an array of structs into a tuple of columns, in one pass. */
+static PyObject *
+_message_iter_get_struct_columns(DBusMessageIter *iter,
+                                 Message_get_args_options *opts)
+{
+    char *sig = dbus_message_iter_get_signature(iter);
+    DBusSignatureIter array_iter, struct_iter, sig_iter;
+    DBusMessageIter rows;
+    OutputColumn *columns = NULL;
+    int n_columns = 0, i;
+    PyObject *ret = NULL;
+
+    if (!sig) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    /* the array -> the struct -> its first field (recursing into the
+     * same iterator would confuse libdbus if that field is an array) */
+    dbus_signature_iter_init(&array_iter, sig);
+    dbus_signature_iter_recurse(&array_iter, &struct_iter);
+    dbus_signature_iter_recurse(&struct_iter, &sig_iter);
+    {
+        DBusSignatureIter count_iter = sig_iter;
+
+        do {
+            n_columns++;
+        } while (dbus_signature_iter_next(&count_iter));
+    }
+
+    columns = _columns_new(n_columns);
+    if (!columns)
+        goto out;
+    for (i = 0; i < n_columns; i++) {
+        if (_column_init(&columns[i],
+                         dbus_signature_iter_get_current_type(&sig_iter)) < 0)
+            goto out;
+        dbus_signature_iter_next(&sig_iter);
+    }
+
+    dbus_message_iter_recurse(iter, &rows);
+    while (dbus_message_iter_get_arg_type(&rows) == DBUS_TYPE_STRUCT) {
+        DBusMessageIter fields;
+
+        dbus_message_iter_recurse(&rows, &fields);
+        for (i = 0; i < n_columns; i++) {
+            OutputColumn *col = &columns[i];
+
+            if (col->typecode) {
+                DBusBasicValue u;
+
+                dbus_message_iter_get_basic(&fields, &u);
+                /* the union's members all start at its beginning */
+                if (_column_push_fixed(col, &u) < 0)
+                    goto out;
+            }
+            else {
+                PyObject *item = _message_iter_get_pyobject(&fields, opts, 0);
+                int status;
+
+                if (!item)
+                    goto out;
+                status = PyList_Append(col->list, item);
+                Py_CLEAR(item);
+                if (status < 0)
+                    goto out;
+            }
+            dbus_message_iter_next(&fields);
+        }
+        dbus_message_iter_next(&rows);
+    }
+
+    ret = _columns_to_tuple(columns, n_columns);
+
+out:
+    _columns_free(columns, n_columns);
+    dbus_free(sig);
+    return ret;
+}
+
+#if defined(PY3) && PY_VERSION_HEX >= 0x03030000
+/* Decode one character of UTF-8 that libdbus has already validated,
+ * without checking it again; invalid input gives wrong characters, but
+ * never reads past the end. */
+static Py_UCS4
+_utf8_next(const unsigned char **p, const unsigned char *end)
+{
+    const unsigned char *s = *p;
+    Py_UCS4 c = *s++;
+    int n = 0;
+
+    if (c >= 0xF0) {
+        c &= 0x07;
+        n = 3;
+    }
+    else if (c >= 0xE0) {
+        c &= 0x0F;
+        n = 2;
+    }
+    else if (c >= 0xC0) {
+        c &= 0x1F;
+        n = 1;
+    }
+    while (n-- > 0 && s < end)
+        c = (c << 6) | (*s++ & 0x3F);
+    *p = s;
+    return c;
+}
+
+/* Return the length of the ASCII prefix of s, testing a word at a time */
+static size_t
+_ascii_prefix(const char *s, size_t len)
+{
+    const size_t high_bits = ((size_t)-1 / 0xFF) * 0x80;
+    size_t i = 0;
+
+    for (; i + sizeof(size_t) <= len; i += sizeof(size_t)) {
+        size_t word;
+
+        memcpy(&word, s + i, sizeof(word));
+        if (word & high_bits)
+            break;
+    }
+    while (i < len && !(s[i] & 0x80))
+        i++;
+    return i;
+}
+#endif
+
+/* Return a new str for the validated UTF-8 from a message. D-Bus names,
+ * paths and most strings are ASCII, which is copied straight into a
+ * compact string; other strings are converted without validating them
+ * a second time. */
+static PyObject *
+_trusted_utf8_to_unicode(const char *s, size_t len)
+{
+#if defined(PY3) && PY_VERSION_HEX >= 0x03030000
+    size_t ascii = _ascii_prefix(s, len);
+    const unsigned char *end = (const unsigned char *)s + len;
+    const unsigned char *p;
+    Py_UCS4 maxchar = 127;
+    Py_ssize_t n, i;
+    PyObject *ret;
+    int kind;
+    void *data;
+
+    if (ascii == len) {
+        ret = PyUnicode_New((Py_ssize_t)len, 127);
+        if (ret)
+            memcpy(PyUnicode_DATA(ret), s, len);
+        return ret;
     }
-    /* From here down you need to break from the switch to exit, so the
-     * dict is freed if necessary
-     */
+
+    n = (Py_ssize_t)ascii;
+    for (p = (const unsigned char *)s + ascii; p < end; n++) {
+        Py_UCS4 c = _utf8_next(&p, end);
+
+        if (c > maxchar)
+            maxchar = c;
+    }
+    if (maxchar > 0x10FFFF) {
+        /* can't happen for a valid message; let Python raise the error */
+        return PyUnicode_DecodeUTF8(s, len, NULL);
+    }
+
+    ret = PyUnicode_New(n, maxchar);
+    if (!ret)
+        return NULL;
+    kind = PyUnicode_KIND(ret);
+    data = PyUnicode_DATA(ret);
+    for (i = 0; i < (Py_ssize_t)ascii; i++)
+        PyUnicode_WRITE(kind, data, i, (Py_UCS4)(unsigned char)s[i]);
+    for (p = (const unsigned char *)s + ascii; p < end; i++)
+        PyUnicode_WRITE(kind, data, i, _utf8_next(&p, end));
+    return ret;
+#else
+    return PyUnicode_DecodeUTF8(s, len, NULL);
+#endif
+}
+
+/* Return a new 1-tuple of the native string for a signature or object
+ * path from a message. */
+static PyObject *
+_trusted_native_str_args(const char *s, size_t len)
+{
+#ifdef PY3
+    PyObject *str = _trusted_utf8_to_unicode(s, len);
+
+    if (!str)
+        return NULL;
+    return Py_BuildValue("(N)", str);
+#else
+    return Py_BuildValue("(s#)", s, (Py_ssize_t)len);
+#endif
+}
+
+/* Return a new reference to the Python object for a basic value of the
+ * given type, other than a Unix fd; for the string-like types, len is
+ * the length of u->str. */
+static PyObject *
+_basic_value_to_pyobject(int type, const DBusBasicValue *u, size_t len,
+                         Message_get_args_options *opts, PyObject *kwargs)
+{
+    PyObject *args = NULL;
+    PyObject *ret = NULL;
 
     switch (type) {
         PyObject *unicode;
 
         case DBUS_TYPE_STRING:
             DBG("%s", "found a string");
-            dbus_message_iter_get_basic(iter, &u.str);
 #ifndef PY3
             if (opts->utf8_strings) {
-                args = Py_BuildValue("(s)", u.str);
+                args = Py_BuildValue("(s#)", u->str, (Py_ssize_t)len);
                 if (!args) break;
                 ret = PyObject_Call((PyObject *)&DBusPyUTF8String_Type,
                                     args, kwargs);
             }
             else {
 #endif
-                unicode = PyUnicode_DecodeUTF8(u.str, strlen(u.str), NULL);
+                unicode = _trusted_utf8_to_unicode(u->str, len);
                 if (!unicode) {
                     break;
                 }
@@ -256,116 +645,72 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
 
         case DBUS_TYPE_SIGNATURE:
             DBG("%s", "found a signature");
-            dbus_message_iter_get_basic(iter, &u.str);
-            args = Py_BuildValue("(s)", u.str);
+            args = _trusted_native_str_args(u->str, len);
             if (!args) break;
             ret = PyObject_Call((PyObject *)&DBusPySignature_Type, args, kwargs);
             break;
 
         case DBUS_TYPE_OBJECT_PATH:
             DBG("%s", "found an object path");
-            dbus_message_iter_get_basic(iter, &u.str);
-            args = Py_BuildValue("(s)", u.str);
+            args = _trusted_native_str_args(u->str, len);
             if (!args) break;
             ret = PyObject_Call((PyObject *)&DBusPyObjectPath_Type, args, kwargs);
             break;
 
         case DBUS_TYPE_DOUBLE:
             DBG("%s", "found a double");
-            dbus_message_iter_get_basic(iter, &u.dbl);
-            args = Py_BuildValue("(f)", u.dbl);
+            args = Py_BuildValue("(f)", u->dbl);
             if (!args) break;
             ret = PyObject_Call((PyObject *)&DBusPyDouble_Type, args, kwargs);
             break;
 
-#ifdef WITH_DBUS_FLOAT32
-        case DBUS_TYPE_FLOAT:
-            DBG("%s", "found a float");
-            /* FIXME: DBusBasicValue will need to grow a float member if
-             * float32 becomes supported */
-            dbus_message_iter_get_basic(iter, &u.f);
-            args = Py_BuildValue("(f)", (double)u.f);
-            if (!args) break;
-            ret = PyObject_Call((PyObject *)&DBusPyFloat_Type, args, kwargs);
-            break;
-#endif
-
         case DBUS_TYPE_INT16:
             DBG("%s", "found an int16");
-            dbus_message_iter_get_basic(iter, &u.i16);
-            args = Py_BuildValue("(i)", (int)u.i16);
+            args = Py_BuildValue("(i)", (int)u->i16);
             if (!args) break;
             ret = PyObject_Call((PyObject *)&DBusPyInt16_Type, args, kwargs);
             break;
 
         case DBUS_TYPE_UINT16:
             DBG("%s", "found a uint16");
-            dbus_message_iter_get_basic(iter, &u.u16);
-            args = Py_BuildValue("(i)", (int)u.u16);
+            args = Py_BuildValue("(i)", (int)u->u16);
             if (!args) break;
             ret = PyObject_Call((PyObject *)&DBusPyUInt16_Type, args, kwargs);
             break;
 
         case DBUS_TYPE_INT32:
             DBG("%s", "found an int32");
-            dbus_message_iter_get_basic(iter, &u.i32);
-            args = Py_BuildValue("(l)", (long)u.i32);
+            args = Py_BuildValue("(l)", (long)u->i32);
             if (!args) break;
             ret = PyObject_Call((PyObject *)&DBusPyInt32_Type, args, kwargs);
             break;
 
         case DBUS_TYPE_UINT32:
             DBG("%s", "found a uint32");
-            dbus_message_iter_get_basic(iter, &u.u32);
-            args = Py_BuildValue("(k)", (unsigned long)u.u32);
+            args = Py_BuildValue("(k)", (unsigned long)u->u32);
             if (!args) break;
             ret = PyObject_Call((PyObject *)&DBusPyUInt32_Type, args, kwargs);
             break;
 
-#ifdef DBUS_TYPE_UNIX_FD
-        case DBUS_TYPE_UNIX_FD:
-            DBG("%s", "found an unix fd");
-            dbus_message_iter_get_basic(iter, &u.fd);
-            args = Py_BuildValue("(i)", u.fd);
-            if (args) {
-                ret = PyObject_Call((PyObject *)&DBusPyUnixFd_Type, args,
-                                    kwargs);
-            }
-            if (u.fd >= 0) {
-                close(u.fd);
-            }
-            break;
-#endif
-
 #if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
         case DBUS_TYPE_INT64:
             DBG("%s", "found an int64");
-            dbus_message_iter_get_basic(iter, &u.i64);
-            args = Py_BuildValue("(L)", (PY_LONG_LONG)u.i64);
+            args = Py_BuildValue("(L)", (PY_LONG_LONG)u->i64);
             if (!args) break;
             ret = PyObject_Call((PyObject *)&DBusPyInt64_Type, args, kwargs);
             break;
 
         case DBUS_TYPE_UINT64:
             DBG("%s", "found a uint64");
-            dbus_message_iter_get_basic(iter, &u.u64);
-            args = Py_BuildValue("(K)", (unsigned PY_LONG_LONG)u.u64);
+            args = Py_BuildValue("(K)", (unsigned PY_LONG_LONG)u->u64);
             if (!args) break;
             ret = PyObject_Call((PyObject *)&DBusPyUInt64_Type, args, kwargs);
             break;
-#else
-        case DBUS_TYPE_INT64:
-        case DBUS_TYPE_UINT64:
-            PyErr_SetString(PyExc_NotImplementedError,
-                            "64-bit integer types are not supported on "
-                            "this platform");
-            break;
 #endif
 
         case DBUS_TYPE_BYTE:
             DBG("%s", "found a byte");
-            dbus_message_iter_get_basic(iter, &u.byt);
-            args = Py_BuildValue("(l)", (long)u.byt);
+            args = Py_BuildValue("(l)", (long)u->byt);
             if (!args)
                 break;
             ret = PyObject_Call((PyObject *)&DBusPyByte_Type, args, kwargs);
@@ -373,50 +718,261 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
 
         case DBUS_TYPE_BOOLEAN:
             DBG("%s", "found a bool");
-            dbus_message_iter_get_basic(iter, &u.bool_val);
-            args = Py_BuildValue("(l)", (long)u.bool_val);
+            args = Py_BuildValue("(l)", (long)u->bool_val);
             if (!args)
                 break;
             ret = PyObject_Call((PyObject *)&DBusPyBoolean_Type, args, kwargs);
             break;
 
-        case DBUS_TYPE_ARRAY:
-            DBG("%s", "found an array...");
-            /* Dicts are arrays of DBUS_TYPE_DICT_ENTRY on the wire.
-            Also, we special-case arrays of DBUS_TYPE_BYTE sometimes. */
-            type = dbus_message_iter_get_element_type(iter);
-            if (type == DBUS_TYPE_DICT_ENTRY) {
-                DBG("%s", "no, actually it's a dict...");
-                if (!kwargs) {
-                    kwargs = PyDict_New();
-                    if (!kwargs) break;
-                }
-                ret = _message_iter_get_dict(iter, opts, kwargs);
-            }
-            else if (opts->byte_arrays && type == DBUS_TYPE_BYTE) {
-                DBusMessageIter sub;
-                int n;
+        default:
+            PyErr_Format(PyExc_TypeError, "Unknown type '\\%x' in D-Bus "
+                         "message", type);
+    }
 
-                DBG("%s", "actually, a byte array...");
-                dbus_message_iter_recurse(iter, &sub);
-                dbus_message_iter_get_fixed_array(&sub,
-                                                  (const unsigned char **)&u.str,
-                                                  &n);
-                if (n == 0 && u.str == NULL) {
-                    /* fd.o #21831: s# turns (NULL, 0) into None, but
-                     * dbus_message_iter_get_fixed_array produces (NULL, 0)
-                     * for an empty byte-blob... */
-                    u.str = "";
-                }
-#ifdef PY3
-                args = Py_BuildValue("(y#)", u.str, (Py_ssize_t)n);
-#else
-                args = Py_BuildValue("(s#)", u.str, (Py_ssize_t)n);
-#endif
+    Py_CLEAR(args);
+    return ret;
+}
+
+/* Returns a new reference. */
+/* Return a new reference to the plain string for a VarDict's key */
+static PyObject *
+_vardict_key(const char *s, size_t len, Message_get_args_options *opts)
+{
+#ifndef PY3
+    if (opts->utf8_strings)
+        return PyBytes_FromStringAndSize(s, (Py_ssize_t)len);
+#endif
+    return _trusted_utf8_to_unicode(s, len);
+}
+
+/* Return TRUE if iter is at an array of {sv} */
+static dbus_bool_t
+_message_iter_is_vardict(DBusMessageIter *iter)
+{
+    char *sig = dbus_message_iter_get_signature(iter);
+    dbus_bool_t ret;
+
+    if (!sig)
+        return FALSE;
+    ret = (strcmp(sig, (DBUS_TYPE_ARRAY_AS_STRING
+                        DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
+                        DBUS_TYPE_STRING_AS_STRING
+                        DBUS_TYPE_VARIANT_AS_STRING
+                        DBUS_DICT_ENTRY_END_CHAR_AS_STRING)) == 0);
+    dbus_free(sig);
+    return ret;
+}
+
+static PyObject *
+_message_iter_get_vardict(DBusMessageIter *iter,
+                          Message_get_args_options *opts,
+                          long variant_level)
+{
+    DBusMessageIter entries;
+    PyObject *ret = DBusPyVarDict_New(variant_level);
+
+    if (!ret)
+        return NULL;
+
+    dbus_message_iter_recurse(iter, &entries);
+    while (dbus_message_iter_get_arg_type(&entries) == DBUS_TYPE_DICT_ENTRY) {
+        DBusMessageIter kv, contents;
+        const char *key_str;
+        PyObject *key, *value;
+        char basic_sig[2];
+        char *sig = NULL;
+        int type, status;
+
+        dbus_message_iter_recurse(&entries, &kv);
+        dbus_message_iter_get_basic(&kv, &key_str);
+        dbus_message_iter_next(&kv);
+        dbus_message_iter_recurse(&kv, &contents);
+        type = dbus_message_iter_get_arg_type(&contents);
+
+        key = _vardict_key(key_str, strlen(key_str), opts);
+        if (!key)
+            goto fail;
+        value = _message_iter_get_pyobject(&kv, opts, 0);
+        if (!value) {
+            Py_CLEAR(key);
+            goto fail;
+        }
+
+        /* the signature of a value in a nested variant is guessed, since
+         * the VarDict adds the outer variant */
+        if (dbus_type_is_basic(type)) {
+            basic_sig[0] = (char)type;
+            basic_sig[1] = '\0';
+            status = DBusPyVarDict_Add(ret, key, value, basic_sig, 1);
+        }
+        else if (type != DBUS_TYPE_VARIANT &&
+                 !(sig = dbus_message_iter_get_signature(&contents))) {
+            PyErr_NoMemory();
+            status = -1;
+        }
+        else {
+            status = DBusPyVarDict_Add(ret, key, value, sig,
+                                       sig ? strlen(sig) : 0);
+        }
+        if (sig)
+            dbus_free(sig);
+        Py_CLEAR(key);
+        Py_CLEAR(value);
+        if (status < 0)
+            goto fail;
+        dbus_message_iter_next(&entries);
+    }
+    return ret;
+
+fail:
+    Py_CLEAR(ret);
+    return NULL;
+}
+
+static PyObject *
+_message_iter_get_pyobject(DBusMessageIter *iter,
+                           Message_get_args_options *opts,
+                           long variant_level)
+{
+    DBusBasicValue u;
+    int type = dbus_message_iter_get_arg_type(iter);
+    PyObject *args = NULL;
+    PyObject *kwargs = NULL;
+    PyObject *ret = NULL;
+
+    /* If the variant-level is >0, prepare a dict for the kwargs.
+     * For variant wrappers optimize slightly by skipping this.
+     */
+    if (variant_level > 0 && type != DBUS_TYPE_VARIANT) {
+        PyObject *variant_level_int;
+
+        variant_level_int = NATIVEINT_FROMLONG(variant_level);
+        if (!variant_level_int) {
+            return NULL;
+        }
+        kwargs = PyDict_New();
+        if (!kwargs) {
+            Py_CLEAR(variant_level_int);
+            return NULL;
+        }
+        if (PyDict_SetItem(kwargs, dbus_py_variant_level_const,
+                           variant_level_int) < 0) {
+            Py_CLEAR(variant_level_int);
+            Py_CLEAR(kwargs);
+            return NULL;
+        }
+        Py_CLEAR(variant_level_int);
+    }
+    /* From here down you need to break from the switch to exit, so the
+     * dict is freed if necessary
+     */
+
+    switch (type) {
+        case DBUS_TYPE_STRING:
+        case DBUS_TYPE_SIGNATURE:
+        case DBUS_TYPE_OBJECT_PATH:
+            dbus_message_iter_get_basic(iter, &u.str);
+            ret = _basic_value_to_pyobject(type, &u, strlen(u.str), opts,
+                                           kwargs);
+            break;
+
+        case DBUS_TYPE_DOUBLE:
+        case DBUS_TYPE_INT16:
+        case DBUS_TYPE_UINT16:
+        case DBUS_TYPE_INT32:
+        case DBUS_TYPE_UINT32:
+        case DBUS_TYPE_BYTE:
+        case DBUS_TYPE_BOOLEAN:
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+        case DBUS_TYPE_INT64:
+        case DBUS_TYPE_UINT64:
+#endif
+            dbus_message_iter_get_basic(iter, &u);
+            ret = _basic_value_to_pyobject(type, &u, 0, opts, kwargs);
+            break;
+
+#ifdef WITH_DBUS_FLOAT32
+        case DBUS_TYPE_FLOAT:
+            DBG("%s", "found a float");
+            /* FIXME: DBusBasicValue will need to grow a float member if
+             * float32 becomes supported */
+            dbus_message_iter_get_basic(iter, &u.f);
+            args = Py_BuildValue("(f)", (double)u.f);
+            if (!args) break;
+            ret = PyObject_Call((PyObject *)&DBusPyFloat_Type, args, kwargs);
+            break;
+#endif
+
+#ifdef DBUS_TYPE_UNIX_FD
+        case DBUS_TYPE_UNIX_FD:
+            DBG("%s", "found an unix fd");
+            dbus_message_iter_get_basic(iter, &u.fd);
+            args = Py_BuildValue("(i)", u.fd);
+            if (args) {
+                ret = PyObject_Call((PyObject *)&DBusPyUnixFd_Type, args,
+                                    kwargs);
+            }
+            if (u.fd >= 0) {
+                close(u.fd);
+            }
+            break;
+#endif
+
+#if !defined(DBUS_HAVE_INT64) || !defined(HAVE_LONG_LONG)
+        case DBUS_TYPE_INT64:
+        case DBUS_TYPE_UINT64:
+            PyErr_SetString(PyExc_NotImplementedError,
+                            "64-bit integer types are not supported on "
+                            "this platform");
+            break;
+#endif
+
+        case DBUS_TYPE_ARRAY:
+            DBG("%s", "found an array...");
+            /* Dicts are arrays of DBUS_TYPE_DICT_ENTRY on the wire.
+            Also, we special-case arrays of DBUS_TYPE_BYTE sometimes. */
+            type = dbus_message_iter_get_element_type(iter);
+            if (type == DBUS_TYPE_DICT_ENTRY && opts->vardicts &&
+                _message_iter_is_vardict(iter)) {
+                DBG("%s", "no, actually it's a vardict...");
+                ret = _message_iter_get_vardict(iter, opts, variant_level);
+            }
+            else if (type == DBUS_TYPE_DICT_ENTRY) {
+                DBG("%s", "no, actually it's a dict...");
+                if (!kwargs) {
+                    kwargs = PyDict_New();
+                    if (!kwargs) break;
+                }
+                ret = _message_iter_get_dict(iter, opts, kwargs);
+            }
+            else if (opts->byte_arrays && type == DBUS_TYPE_BYTE) {
+                DBusMessageIter sub;
+                int n;
+
+                DBG("%s", "actually, a byte array...");
+                dbus_message_iter_recurse(iter, &sub);
+                dbus_message_iter_get_fixed_array(&sub,
+                                                  (const unsigned char **)&u.str,
+                                                  &n);
+                if (n == 0 && u.str == NULL) {
+                    /* fd.o #21831: s# turns (NULL, 0) into None, but
+                     * dbus_message_iter_get_fixed_array produces (NULL, 0)
+                     * for an empty byte-blob... */
+                    u.str = "";
+                }
+#ifdef PY3
+                args = Py_BuildValue("(y#)", u.str, (Py_ssize_t)n);
+#else
+                args = Py_BuildValue("(s#)", u.str, (Py_ssize_t)n);
+#endif
                 if (!args) break;
                 ret = PyObject_Call((PyObject *)&DBusPyByteArray_Type,
                                     args, kwargs);
             }
+            else if (opts->struct_columns && type == DBUS_TYPE_STRUCT) {
+                DBG("%s", "an array of structs, as columns...");
+                ret = _message_iter_get_struct_columns(iter, opts);
+            }
             else {
                 DBusMessageIter sub;
                 char *sig;
@@ -450,26 +1006,54 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
         case DBUS_TYPE_STRUCT:
             {
                 DBusMessageIter sub;
-                PyObject *list = PyList_New(0);
+                PyObject *list;
                 PyObject *tuple;
+                PyObject *cls = NULL;
 
                 DBG("%s", "found a struct...");
-                if (!list) break;
                 dbus_message_iter_recurse(iter, &sub);
+                if (dbus_py_may_have_struct_class(
+                        dbus_message_iter_get_arg_type(&sub))) {
+                    char *sig = dbus_message_iter_get_signature(iter);
+
+                    if (!sig) {
+                        PyErr_NoMemory();
+                        break;
+                    }
+                    /* hold a reference, in case decoding the contents runs
+                     * code that unregisters it */
+                    cls = dbus_py_get_struct_class(sig);
+                    Py_XINCREF(cls);
+                    dbus_free(sig);
+                }
+                list = PyList_New(0);
+                if (!list) {
+                    Py_CLEAR(cls);
+                    break;
+                }
                 if (_message_iter_append_all_to_list(&sub, list, opts) < 0) {
                     Py_CLEAR(list);
+                    Py_CLEAR(cls);
                     break;
                 }
-                tuple = Py_BuildValue("(O)", list);
-                if (tuple) {
-                    ret = PyObject_Call((PyObject *)&DBusPyStruct_Type, tuple, kwargs);
+                if (cls) {
+                    /* a registered record class: cls(*items) */
+                    tuple = PyList_AsTuple(list);
+                    if (tuple) {
+                        ret = PyObject_Call(cls, tuple, NULL);
+                    }
                 }
                 else {
-                    ret = NULL;
+                    tuple = Py_BuildValue("(O)", list);
+                    if (tuple) {
+                        ret = PyObject_Call((PyObject *)&DBusPyStruct_Type,
+                                            tuple, kwargs);
+                    }
                 }
                 /* whether successful or not, we take the same action: */
                 Py_CLEAR(list);
                 Py_CLEAR(tuple);
+                Py_CLEAR(cls);
             }
             break;
 
@@ -493,20 +1077,644 @@ _message_iter_get_pyobject(DBusMessageIter *iter,
     return ret;
 }
 
+/* Direct decoding: rather than walking the body with a DBusMessageIter,
+ * get the marshalled message once and parse its body in a single pass,
+ * driven by the compiled signature. libdbus validated the message when
+ * it was received or built, but every read is bounds-checked anyway. */
+
+/* For each position in a signature, the position just after the single
+ * complete type starting there */
+typedef struct {
+    const char *sig;
+    unsigned short next[DBUS_MAXIMUM_SIGNATURE_LENGTH + 1];
+} WireProgram;
+
+typedef struct {
+    const char *data;
+    size_t len;
+    size_t pos;
+} WireReader;
+
+static PyObject *_wire_get_pyobject(WireReader *r, const WireProgram *prog,
+                                    size_t pc,
+                                    Message_get_args_options *opts,
+                                    long variant_level);
+
+static size_t
+_wire_compile_type(WireProgram *prog, size_t pc, size_t len)
+{
+    size_t next = pc + 1;
+
+    switch (prog->sig[pc]) {
+        case DBUS_TYPE_ARRAY:
+            next = _wire_compile_type(prog, pc + 1, len);
+            break;
+        case DBUS_STRUCT_BEGIN_CHAR:
+        case DBUS_DICT_ENTRY_BEGIN_CHAR:
+            while (next < len && prog->sig[next] != DBUS_STRUCT_END_CHAR &&
+                   prog->sig[next] != DBUS_DICT_ENTRY_END_CHAR)
+                next = _wire_compile_type(prog, next, len);
+            next++;
+            break;
+    }
+    if (pc <= len)
+        prog->next[pc] = (unsigned short)next;
+    return next;
+}
+
+static int
+_wire_compile(WireProgram *prog, const char *sig)
+{
+    size_t len = strlen(sig);
+    size_t pc = 0;
+
+    prog->sig = sig;
+    if (len <= DBUS_MAXIMUM_SIGNATURE_LENGTH) {
+        while (pc < len)
+            pc = _wire_compile_type(prog, pc, len);
+        if (pc == len)
+            return 0;
+    }
+    PyErr_SetString(PyExc_ValueError, "Corrupt type signature in message");
+    return -1;
+}
+
+/* Skip padding to the given alignment, then return a pointer to the next
+ * n bytes and skip those too. */
+static const char *
+_wire_read(WireReader *r, size_t alignment, size_t n)
+{
+    size_t pos = (r->pos + alignment - 1) & ~(alignment - 1);
+
+    if (pos > r->len || r->len - pos < n) {
+        PyErr_SetString(PyExc_ValueError, "Corrupt message body");
+        return NULL;
+    }
+    r->pos = pos + n;
+    return r->data + pos;
+}
+
+/* Read an array's length and skip the padding before its first element.
+ * Return the offset of the end of the array, or 0 on error. */
+static size_t
+_wire_read_array(WireReader *r, int element_type)
+{
+    const char *p = _wire_read(r, 4, 4);
+    dbus_uint32_t len;
+
+    if (!p)
+        return 0;
+    memcpy(&len, p, 4);
+    p = _wire_read(r, dbus_py_type_alignment(element_type), len);
+    if (!p)
+        return 0;
+    /* go back to the start of the contents */
+    r->pos -= len;
+    return r->pos + len;
+}
+
+static PyObject *
+_wire_get_signature(const WireProgram *prog, size_t start, size_t end)
+{
+    return PyObject_CallFunction((PyObject *)&DBusPySignature_Type, "(s#)",
+                                 prog->sig + start, (Py_ssize_t)(end - start));
+}
+
+/* Read a variant's signature and compile it into contents. Return the
+ * signature, which is *len bytes followed by '\0', or NULL on error. */
+static const char *
+_wire_read_variant_signature(WireReader *r, WireProgram *contents,
+                             dbus_uint32_t *len)
+{
+    const char *p = _wire_read(r, 1, 1);
+
+    if (!p)
+        return NULL;
+    *len = (unsigned char)*p;
+    p = _wire_read(r, 1, (size_t)*len + 1);
+    if (!p || _wire_compile(contents, p) < 0)
+        return NULL;
+    if (*len == 0 || contents->next[0] != *len) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Corrupt type signature in message");
+        return NULL;
+    }
+    return p;
+}
+
+/* As for _message_iter_get_vardict */
+static PyObject *
+_wire_get_vardict(WireReader *r, Message_get_args_options *opts,
+                  long variant_level)
+{
+    PyObject *ret = DBusPyVarDict_New(variant_level);
+    size_t end;
+
+    if (!ret)
+        return NULL;
+
+    end = _wire_read_array(r, DBUS_TYPE_DICT_ENTRY);
+    if (!end)
+        goto fail;
+    while (r->pos < end) {
+        WireProgram contents;
+        const char *p, *sig;
+        dbus_uint32_t len;
+        PyObject *key, *value;
+        int status;
+
+        if (!_wire_read(r, 8, 0) || !(p = _wire_read(r, 4, 4)))
+            goto fail;
+        memcpy(&len, p, 4);
+        p = _wire_read(r, 1, (size_t)len + 1);
+        if (!p)
+            goto fail;
+        key = _vardict_key(p, len, opts);
+        if (!key)
+            goto fail;
+
+        sig = _wire_read_variant_signature(r, &contents, &len);
+        value = sig ? _wire_get_pyobject(r, &contents, 0, opts, 1) : NULL;
+        if (!value) {
+            Py_CLEAR(key);
+            goto fail;
+        }
+        status = DBusPyVarDict_Add(ret, key, value,
+                                   (*sig == DBUS_TYPE_VARIANT ? NULL : sig),
+                                   len);
+        Py_CLEAR(key);
+        Py_CLEAR(value);
+        if (status < 0)
+            goto fail;
+    }
+    return ret;
+
+fail:
+    Py_CLEAR(ret);
+    return NULL;
+}
+
+static PyObject *
+_wire_get_dict(WireReader *r, const WireProgram *prog, size_t pc,
+               Message_get_args_options *opts, PyObject *kwargs)
+{
+    /* the dict entry, and its key and value */
+    size_t entry = pc + 1;
+    size_t key = entry + 1;
+    size_t value = prog->next[key];
+    size_t end;
+    PyObject *sig;
+    PyObject *ret;
+    int status;
+
+    sig = _wire_get_signature(prog, key, prog->next[entry] - 1);
+    if (!sig)
+        return NULL;
+    status = PyDict_SetItem(kwargs, dbus_py_signature_const, sig);
+    Py_CLEAR(sig);
+    if (status < 0)
+        return NULL;
+
+    ret = PyObject_Call((PyObject *)&DBusPyDict_Type, dbus_py_empty_tuple,
+                        kwargs);
+    if (!ret)
+        return NULL;
+
+    end = _wire_read_array(r, DBUS_TYPE_DICT_ENTRY);
+    if (!end)
+        goto fail;
+    while (r->pos < end) {
+        PyObject *k, *v;
+
+        if (!_wire_read(r, 8, 0))
+            goto fail;
+        k = _wire_get_pyobject(r, prog, key, opts, 0);
+        if (!k)
+            goto fail;
+        v = _wire_get_pyobject(r, prog, value, opts, 0);
+        if (!v) {
+            Py_CLEAR(k);
+            goto fail;
+        }
+        status = PyDict_SetItem(ret, k, v);
+        Py_CLEAR(k);
+        Py_CLEAR(v);
+        if (status < 0)
+            goto fail;
+    }
+    return ret;
+
+fail:
+    Py_CLEAR(ret);
+    return NULL;
+}
+
+static PyObject *
+_wire_get_struct_columns(WireReader *r, const WireProgram *prog, size_t pc,
+                         Message_get_args_options *opts)
+{
+    /* the array -> the struct -> its first field */
+    size_t first = pc + 2;
+    size_t field, end;
+    OutputColumn *columns = NULL;
+    int n_columns = 0, i;
+    PyObject *ret = NULL;
+
+    for (field = first; prog->sig[field] != DBUS_STRUCT_END_CHAR;
+         field = prog->next[field])
+        n_columns++;
+
+    columns = _columns_new(n_columns);
+    if (!columns)
+        goto out;
+    for (i = 0, field = first; i < n_columns; i++, field = prog->next[field]) {
+        int type = prog->sig[field];
+
+        if (type == DBUS_STRUCT_BEGIN_CHAR)
+            type = DBUS_TYPE_STRUCT;
+        if (_column_init(&columns[i], type) < 0)
+            goto out;
+    }
+
+    end = _wire_read_array(r, DBUS_TYPE_STRUCT);
+    if (!end)
+        goto out;
+    while (r->pos < end) {
+        if (!_wire_read(r, 8, 0))
+            goto out;
+        for (i = 0, field = first; i < n_columns;
+             i++, field = prog->next[field]) {
+            OutputColumn *col = &columns[i];
+
+            if (col->typecode) {
+                size_t size = dbus_py_type_alignment(col->type);
+                const char *p = _wire_read(r, size, size);
+
+                if (!p || _column_push_fixed(col, p) < 0)
+                    goto out;
+            }
+            else {
+                PyObject *item = _wire_get_pyobject(r, prog, field, opts, 0);
+                int status;
+
+                if (!item)
+                    goto out;
+                status = PyList_Append(col->list, item);
+                Py_CLEAR(item);
+                if (status < 0)
+                    goto out;
+            }
+        }
+    }
+
+    ret = _columns_to_tuple(columns, n_columns);
+
+out:
+    _columns_free(columns, n_columns);
+    return ret;
+}
+
+static PyObject *
+_wire_get_array(WireReader *r, const WireProgram *prog, size_t pc,
+                Message_get_args_options *opts, PyObject *kwargs)
+{
+    size_t element = pc + 1;
+    int type = prog->sig[element];
+    size_t end;
+    PyObject *sig;
+    PyObject *ret;
+    int status;
+
+    if (type == DBUS_DICT_ENTRY_BEGIN_CHAR) {
+        return _wire_get_dict(r, prog, pc, opts, kwargs);
+    }
+    else if (opts->byte_arrays && type == DBUS_TYPE_BYTE) {
+        PyObject *args;
+        size_t start;
+
+        end = _wire_read_array(r, type);
+        if (!end)
+            return NULL;
+        start = r->pos;
+        r->pos = end;
+#ifdef PY3
+        args = Py_BuildValue("(y#)", r->data + start,
+                             (Py_ssize_t)(end - start));
+#else
+        args = Py_BuildValue("(s#)", r->data + start,
+                             (Py_ssize_t)(end - start));
+#endif
+        if (!args)
+            return NULL;
+        ret = PyObject_Call((PyObject *)&DBusPyByteArray_Type, args, kwargs);
+        Py_CLEAR(args);
+        return ret;
+    }
+    else if (opts->struct_columns && type == DBUS_STRUCT_BEGIN_CHAR) {
+        return _wire_get_struct_columns(r, prog, pc, opts);
+    }
+
+    sig = _wire_get_signature(prog, element, prog->next[element]);
+    if (!sig)
+        return NULL;
+    status = PyDict_SetItem(kwargs, dbus_py_signature_const, sig);
+    Py_CLEAR(sig);
+    if (status < 0)
+        return NULL;
+    ret = PyObject_Call((PyObject *)&DBusPyArray_Type, dbus_py_empty_tuple,
+                        kwargs);
+    if (!ret)
+        return NULL;
+
+    end = _wire_read_array(r, type == DBUS_STRUCT_BEGIN_CHAR
+                              ? DBUS_TYPE_STRUCT : type);
+    if (!end)
+        goto fail;
+    while (r->pos < end) {
+        PyObject *item = _wire_get_pyobject(r, prog, element, opts, 0);
+
+        if (!item)
+            goto fail;
+        status = PyList_Append(ret, item);
+        Py_CLEAR(item);
+        if (status < 0)
+            goto fail;
+    }
+    return ret;
+
+fail:
+    Py_CLEAR(ret);
+    return NULL;
+}
+
+static PyObject *
+_wire_get_struct(WireReader *r, const WireProgram *prog, size_t pc,
+                 Message_get_args_options *opts, PyObject *kwargs)
+{
+    PyObject *list;
+    PyObject *tuple;
+    PyObject *cls = NULL;
+    PyObject *ret = NULL;
+    size_t field;
+
+    if (dbus_py_may_have_struct_class(prog->sig[pc + 1])) {
+        char sig[DBUS_MAXIMUM_SIGNATURE_LENGTH + 1];
+        size_t len = prog->next[pc] - pc;
+
+        memcpy(sig, prog->sig + pc, len);
+        sig[len] = '\0';
+        /* hold a reference, in case decoding the contents runs code that
+         * unregisters it */
+        cls = dbus_py_get_struct_class(sig);
+        Py_XINCREF(cls);
+    }
+
+    list = PyList_New(0);
+    if (!list || !_wire_read(r, 8, 0))
+        goto out;
+    for (field = pc + 1; prog->sig[field] != DBUS_STRUCT_END_CHAR;
+         field = prog->next[field]) {
+        PyObject *item = _wire_get_pyobject(r, prog, field, opts, 0);
+        int status;
+
+        if (!item)
+            goto out;
+        status = PyList_Append(list, item);
+        Py_CLEAR(item);
+        if (status < 0)
+            goto out;
+    }
+
+    if (cls) {
+        /* a registered record class: cls(*items) */
+        tuple = PyList_AsTuple(list);
+        if (tuple) {
+            ret = PyObject_Call(cls, tuple, NULL);
+        }
+    }
+    else {
+        tuple = Py_BuildValue("(O)", list);
+        if (tuple) {
+            ret = PyObject_Call((PyObject *)&DBusPyStruct_Type, tuple,
+                                kwargs);
+        }
+    }
+    Py_CLEAR(tuple);
+
+out:
+    Py_CLEAR(list);
+    Py_CLEAR(cls);
+    return ret;
+}
+
+/* Returns a new reference. */
+static PyObject *
+_wire_get_pyobject(WireReader *r, const WireProgram *prog, size_t pc,
+                   Message_get_args_options *opts, long variant_level)
+{
+    int type = prog->sig[pc];
+    DBusBasicValue u;
+    dbus_uint32_t len;
+    const char *p;
+    PyObject *kwargs = NULL;
+    PyObject *ret = NULL;
+
+    /* as for _message_iter_get_pyobject */
+    if (variant_level > 0 && type != DBUS_TYPE_VARIANT) {
+        PyObject *variant_level_int;
+
+        variant_level_int = NATIVEINT_FROMLONG(variant_level);
+        if (!variant_level_int) {
+            return NULL;
+        }
+        kwargs = PyDict_New();
+        if (!kwargs) {
+            Py_CLEAR(variant_level_int);
+            return NULL;
+        }
+        if (PyDict_SetItem(kwargs, dbus_py_variant_level_const,
+                           variant_level_int) < 0) {
+            Py_CLEAR(variant_level_int);
+            Py_CLEAR(kwargs);
+            return NULL;
+        }
+        Py_CLEAR(variant_level_int);
+    }
+
+    switch (type) {
+        case DBUS_TYPE_STRING:
+        case DBUS_TYPE_OBJECT_PATH:
+            p = _wire_read(r, 4, 4);
+            if (!p) break;
+            memcpy(&len, p, 4);
+            p = _wire_read(r, 1, (size_t)len + 1);
+            if (!p) break;
+            u.str = (char *)p;
+            ret = _basic_value_to_pyobject(type, &u, len, opts, kwargs);
+            break;
+
+        case DBUS_TYPE_SIGNATURE:
+            p = _wire_read(r, 1, 1);
+            if (!p) break;
+            len = (unsigned char)*p;
+            p = _wire_read(r, 1, (size_t)len + 1);
+            if (!p) break;
+            u.str = (char *)p;
+            ret = _basic_value_to_pyobject(type, &u, len, opts, kwargs);
+            break;
+
+        case DBUS_TYPE_DOUBLE:
+        case DBUS_TYPE_INT16:
+        case DBUS_TYPE_UINT16:
+        case DBUS_TYPE_INT32:
+        case DBUS_TYPE_UINT32:
+        case DBUS_TYPE_BYTE:
+        case DBUS_TYPE_BOOLEAN:
+#if defined(DBUS_HAVE_INT64) && defined(HAVE_LONG_LONG)
+        case DBUS_TYPE_INT64:
+        case DBUS_TYPE_UINT64:
+#endif
+            len = (dbus_uint32_t)dbus_py_type_alignment(type);
+            p = _wire_read(r, len, len);
+            if (!p) break;
+            /* the union's members all start at its beginning */
+            memcpy(&u, p, len);
+            ret = _basic_value_to_pyobject(type, &u, 0, opts, kwargs);
+            break;
+
+#if !defined(DBUS_HAVE_INT64) || !defined(HAVE_LONG_LONG)
+        case DBUS_TYPE_INT64:
+        case DBUS_TYPE_UINT64:
+            PyErr_SetString(PyExc_NotImplementedError,
+                            "64-bit integer types are not supported on "
+                            "this platform");
+            break;
+#endif
+
+        case DBUS_TYPE_ARRAY:
+            if (opts->vardicts && prog->next[pc] == pc + 5 &&
+                memcmp(prog->sig + pc, (DBUS_TYPE_ARRAY_AS_STRING
+                                        DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
+                                        DBUS_TYPE_STRING_AS_STRING
+                                        DBUS_TYPE_VARIANT_AS_STRING
+                                        DBUS_DICT_ENTRY_END_CHAR_AS_STRING),
+                       5) == 0) {
+                ret = _wire_get_vardict(r, opts, variant_level);
+                break;
+            }
+            if (!kwargs) {
+                kwargs = PyDict_New();
+                if (!kwargs) break;
+            }
+            ret = _wire_get_array(r, prog, pc, opts, kwargs);
+            break;
+
+        case DBUS_STRUCT_BEGIN_CHAR:
+            ret = _wire_get_struct(r, prog, pc, opts, kwargs);
+            break;
+
+        case DBUS_TYPE_VARIANT:
+            {
+                WireProgram contents;
+
+                if (!_wire_read_variant_signature(r, &contents, &len)) break;
+                ret = _wire_get_pyobject(r, &contents, 0, opts,
+                                         variant_level + 1);
+            }
+            break;
+
+        default:
+            /* Unix fds never get here: messages with them are decoded
+             * with the iterator */
+            PyErr_Format(PyExc_TypeError, "Unknown type '\\%x' in D-Bus "
+                         "message", type);
+    }
+
+    Py_CLEAR(kwargs);
+    return ret;
+}
+
+/* Append the message's arguments to the list with the direct decoder.
+ * Return 1 on success, 0 if the message can't be decoded directly
+ * (decided before appending anything), or -1 with an exception set. */
+static int
+_message_get_args_direct(Message *self, Message_get_args_options *opts,
+                         PyObject *list)
+{
+    static const union { dbus_uint32_t u; char c[4]; } probe = { 1 };
+    const char *signature = dbus_message_get_signature(self->msg);
+    WireProgram prog;
+    WireReader r;
+    char *data = NULL;
+    int data_len = 0;
+    dbus_uint32_t fields_len, body_len;
+    size_t header_len, pc;
+    int ret = -1;
+
+    /* the fds are only available through a DBusMessageIter */
+    if (strchr(signature, DBUS_TYPE_UNIX_FD))
+        return 0;
+    if (_wire_compile(&prog, signature) < 0)
+        return -1;
+
+    if (!dbus_message_marshal(self->msg, &data, &data_len)) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    if (data_len < 16 ||
+        data[0] != (probe.c[0] ? DBUS_LITTLE_ENDIAN : DBUS_BIG_ENDIAN)) {
+        ret = 0;
+        goto out;
+    }
+    memcpy(&body_len, data + 4, 4);
+    memcpy(&fields_len, data + 12, 4);
+    header_len = (16 + (size_t)fields_len + 7) & ~(size_t)7;
+    if (header_len + body_len != (size_t)data_len) {
+        ret = 0;
+        goto out;
+    }
+
+    r.data = data + header_len;
+    r.len = body_len;
+    r.pos = 0;
+    for (pc = 0; signature[pc] != '\0'; pc = prog.next[pc]) {
+        PyObject *item = _wire_get_pyobject(&r, &prog, pc, opts, 0);
+        int status;
+
+        if (!item)
+            goto out;
+        status = PyList_Append(list, item);
+        Py_CLEAR(item);
+        if (status < 0)
+            goto out;
+    }
+    ret = 1;
+
+out:
+    dbus_free(data);
+    return ret;
+}
+
 PyObject *
-dbus_py_Message_get_args_list(Message *self, PyObject *args, PyObject *kwargs)
+dbus_py_Message_get_args_list(Message *self, DBUS_PY_ARGS)
 {
 #ifdef PY3
-    Message_get_args_options opts = { 0 };
-    static char *argnames[] = { "byte_arrays", NULL };
+    Message_get_args_options opts = { 0, 0, 0 };
+    static char *argnames[] = { "byte_arrays", "struct_columns", "vardicts",
+                                "direct", NULL };
+    DBUS_PY_ARG_PARSER(parser, "|iiii:get_args_list", argnames);
 #else
-    Message_get_args_options opts = { 0, 0 };
-    static char *argnames[] = { "byte_arrays", "utf8_strings", NULL };
+    Message_get_args_options opts = { 0, 0, 0, 0 };
+    static char *argnames[] = { "byte_arrays", "utf8_strings",
+                                "struct_columns", "vardicts", "direct",
+                                NULL };
+    DBUS_PY_ARG_PARSER(parser, "|iiiii:get_args_list", argnames);
 #endif
+    int direct = 0;
     PyObject *list;
     DBusMessageIter iter;
 
-#ifdef USING_DBG
+#if defined(USING_DBG) && !defined(USING_FASTCALL)
     fprintf(stderr, "DBG/%ld: called Message_get_args_list(self, *",
             (long)getpid());
     PyObject_Print(args, stderr, 0);
@@ -517,26 +1725,44 @@ dbus_py_Message_get_args_list(Message *self, PyObject *args, PyObject *kwargs)
     fprintf(stderr, ")\n");
 #endif
 
-    if (PyTuple_Size(args) != 0) {
+    if (DBUS_PY_NARGS != 0) {
         PyErr_SetString(PyExc_TypeError, "get_args_list takes no positional "
                         "arguments");
         return NULL;
     }
 #ifdef PY3
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|i:get_args_list",
-                                     argnames,
-                                     &(opts.byte_arrays))) return NULL;
+    if (!DBUS_PY_PARSE_ARGS(parser,
+                            &(opts.byte_arrays),
+                            &(opts.struct_columns),
+                            &(opts.vardicts),
+                            &direct)) return NULL;
 #else
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|ii:get_args_list",
-                                     argnames,
-                                     &(opts.byte_arrays),
-                                     &(opts.utf8_strings))) return NULL;
+    if (!DBUS_PY_PARSE_ARGS(parser,
+                            &(opts.byte_arrays),
+                            &(opts.utf8_strings),
+                            &(opts.struct_columns),
+                            &(opts.vardicts),
+                            &direct)) return NULL;
 #endif
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    if (dbus_py_message_check_closed(self) < 0) return NULL;
 
     list = PyList_New(0);
     if (!list) return NULL;
 
+    if (direct) {
+        switch (_message_get_args_direct(self, &opts, list)) {
+            case 1:
+                return list;
+            case 0:
+                /* not supported for this message; use the iterator */
+                break;
+            default:
+                Py_CLEAR(list);
+                return NULL;
+        }
+    }
+
     /* Iterate over args, if any, appending to list */
     if (dbus_message_iter_init(self->msg, &iter)) {
         if (_message_iter_append_all_to_list(&iter, list, &opts) < 0) {
@@ -555,4 +1781,30 @@ dbus_py_Message_get_args_list(Message *self, PyObject *args, PyObject *kwargs)
     return list;
 }
 
+/* C API ============================================================ */
+
+PyObject *
+DBusPyMessageIter_GetArgs(DBusMessageIter *iter, int flags)
+{
+    PyObject *list;
+#ifdef PY3
+    Message_get_args_options opts = { 0, 0, 0 };
+#else
+    Message_get_args_options opts = { 0, 0, 0, 0 };
+
+    opts.utf8_strings = (flags & DBUS_PY_GET_ARGS_UTF8_STRINGS) != 0;
+#endif
+    opts.byte_arrays = (flags & DBUS_PY_GET_ARGS_BYTE_ARRAYS) != 0;
+    opts.struct_columns = (flags & DBUS_PY_GET_ARGS_STRUCT_COLUMNS) != 0;
+    opts.vardicts = (flags & DBUS_PY_GET_ARGS_VARDICTS) != 0;
+
+    list = PyList_New(0);
+    if (!list) return NULL;
+    if (_message_iter_append_all_to_list(iter, list, &opts) < 0) {
+        Py_CLEAR(list);
+        return NULL;
+    }
+    return list;
+}
+
 /* vim:set ft=c cino< sw=4 sts=4 et: */
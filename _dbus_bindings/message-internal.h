@@ -30,19 +30,49 @@
 #ifndef DBUS_BINDINGS_MESSAGE_INTERNAL_H
 #define DBUS_BINDINGS_MESSAGE_INTERNAL_H
 
+typedef struct _DBusPyMessageWriter DBusPyMessageWriter;
+
 typedef struct {
     PyObject_HEAD
     DBusMessage *msg;
+    /* the containers opened with open_array() etc. and not yet closed,
+     * or NULL if there are none */
+    DBusPyMessageWriter *writer;
+    /* TRUE once msg has been lent out by DBusPyMessage_BorrowDBusMessage,
+     * after which it must never be replaced by another DBusMessage */
+    dbus_bool_t borrowed;
 } Message;
 
 extern char dbus_py_Message_append__doc__[];
-extern PyObject *dbus_py_Message_append(Message *, PyObject *, PyObject *);
+extern PyObject *dbus_py_Message_append(Message *, DBUS_PY_ARGS);
+extern char dbus_py_Message_append_columns__doc__[];
+extern PyObject *dbus_py_Message_append_columns(Message *, PyObject *);
 extern char dbus_py_Message_guess_signature__doc__[];
 extern PyObject *dbus_py_Message_guess_signature(PyObject *, PyObject *);
 extern char dbus_py_Message_get_args_list__doc__[];
-extern PyObject *dbus_py_Message_get_args_list(Message *,
-                                               PyObject *,
-                                               PyObject *);
+extern PyObject *dbus_py_Message_get_args_list(Message *, DBUS_PY_ARGS);
+
+extern char dbus_py_Message_open_array__doc__[];
+extern PyObject *dbus_py_Message_open_array(Message *, PyObject *);
+extern char dbus_py_Message_open_struct__doc__[];
+extern PyObject *dbus_py_Message_open_struct(Message *, PyObject *);
+extern char dbus_py_Message_open_dict_entry__doc__[];
+extern PyObject *dbus_py_Message_open_dict_entry(Message *, PyObject *);
+extern char dbus_py_Message_open_variant__doc__[];
+extern PyObject *dbus_py_Message_open_variant(Message *, PyObject *);
+extern char dbus_py_Message_append_basic__doc__[];
+extern PyObject *dbus_py_Message_append_basic(Message *, PyObject *);
+extern char dbus_py_Message_append_fixed_array__doc__[];
+extern PyObject *dbus_py_Message_append_fixed_array(Message *, PyObject *);
+extern char dbus_py_Message_close__doc__[];
+extern PyObject *dbus_py_Message_close(Message *, PyObject *);
+
+/* Abandon any open containers */
+extern void dbus_py_message_writer_free(Message *);
+/* Return 0 if no containers are open, or -1 with an exception set */
+extern int dbus_py_message_check_closed(Message *);
+
+extern size_t dbus_py_type_alignment(int type);
 
 extern PyObject *DBusPy_RaiseUnusableMessage(void);
 
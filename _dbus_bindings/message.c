@@ -50,6 +50,7 @@ PyDoc_STRVAR(Message_tp_doc,
 
 static void Message_tp_dealloc(Message *self)
 {
+    dbus_py_message_writer_free(self);
     if (self->msg) {
         dbus_message_unref(self->msg);
     }
@@ -66,6 +67,8 @@ Message_tp_new(PyTypeObject *type,
     self = (Message *)type->tp_alloc(type, 0);
     if (!self) return NULL;
     self->msg = NULL;
+    self->writer = NULL;
+    self->borrowed = FALSE;
     return (PyObject *)self;
 }
 
@@ -127,6 +130,7 @@ MethodCallMessage_tp_init(Message *self, PyObject *args, PyObject *kwargs)
     if (interface && !dbus_py_validate_interface_name(interface)) return -1;
     if (!dbus_py_validate_member_name(method)) return -1;
     if (self->msg) {
+        dbus_py_message_writer_free(self);
         dbus_message_unref(self->msg);
         self->msg = NULL;
     }
@@ -154,6 +158,7 @@ MethodReturnMessage_tp_init(Message *self, PyObject *args, PyObject *kwargs)
         return -1;
     }
     if (self->msg) {
+        dbus_py_message_writer_free(self);
         dbus_message_unref(self->msg);
         self->msg = NULL;
     }
@@ -182,6 +187,7 @@ SignalMessage_tp_init(Message *self, PyObject *args, PyObject *kwargs)
     if (!dbus_py_validate_interface_name(interface)) return -1;
     if (!dbus_py_validate_member_name(name)) return -1;
     if (self->msg) {
+        dbus_py_message_writer_free(self);
         dbus_message_unref(self->msg);
         self->msg = NULL;
     }
@@ -234,6 +240,7 @@ ErrorMessage_tp_init(Message *self, PyObject *args, PyObject *kwargs)
     }
     if (!dbus_py_validate_error_name(error_name)) return -1;
     if (self->msg) {
+        dbus_py_message_writer_free(self);
         dbus_message_unref(self->msg);
         self->msg = NULL;
     }
@@ -257,6 +264,9 @@ DBusPyMessage_BorrowDBusMessage(PyObject *msg)
         DBusPy_RaiseUnusableMessage();
         return NULL;
     }
+    if (dbus_py_message_check_closed((Message *)msg) < 0)
+        return NULL;
+    ((Message *)msg)->borrowed = TRUE;
     return ((Message *)msg)->msg;
 }
 
@@ -300,11 +310,32 @@ Message_copy(Message *self, PyObject *args UNUSED)
 {
     DBusMessage *msg;
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    if (dbus_py_message_check_closed(self) < 0) return NULL;
     msg = dbus_message_copy(self->msg);
     if (!msg) return PyErr_NoMemory();
     return DBusPyMessage_ConsumeDBusMessage(msg);
 }
 
+PyDoc_STRVAR(Message_marshal__doc__,
+"message.marshal() -> bytes\n"
+"Return the message serialized in the D-Bus wire format.\n\n"
+":Since: 1.2.1\n");
+static PyObject *
+Message_marshal(Message *self, PyObject *args UNUSED)
+{
+    char *data;
+    int len;
+    PyObject *ret;
+
+    if (!self->msg) return DBusPy_RaiseUnusableMessage();
+    if (dbus_py_message_check_closed(self) < 0) return NULL;
+    if (!dbus_message_marshal(self->msg, &data, &len))
+        return PyErr_NoMemory();
+    ret = PyBytes_FromStringAndSize(data, len);
+    dbus_free(data);
+    return ret;
+}
+
 PyDoc_STRVAR(Message_get_auto_start__doc__,
 "message.get_auto_start() -> bool\n"
 "Return true if this message will cause an owner for the destination name\n"
@@ -321,10 +352,10 @@ PyDoc_STRVAR(Message_set_auto_start__doc__,
 "Set whether this message will cause an owner for the destination name\n"
 "to be auto-started.\n");
 static PyObject *
-Message_set_auto_start(Message *self, PyObject *args)
+Message_set_auto_start(Message *self, PyObject *arg)
 {
     int value;
-    if (!PyArg_ParseTuple(args, "i", &value)) return NULL;
+    if (!PyArg_Parse(arg, "i", &value)) return NULL;
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
     dbus_message_set_auto_start(self->msg, value ? TRUE : FALSE);
     Py_INCREF(Py_None);
@@ -345,10 +376,10 @@ PyDoc_STRVAR(Message_set_no_reply__doc__,
 "message.set_no_reply(bool) -> None\n"
 "Set whether no reply to this message is required.\n");
 static PyObject *
-Message_set_no_reply(Message *self, PyObject *args)
+Message_set_no_reply(Message *self, PyObject *arg)
 {
     int value;
-    if (!PyArg_ParseTuple(args, "i", &value)) return NULL;
+    if (!PyArg_Parse(arg, "i", &value)) return NULL;
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
     dbus_message_set_no_reply(self->msg, value ? TRUE : FALSE);
     Py_RETURN_NONE;
@@ -368,11 +399,11 @@ PyDoc_STRVAR(Message_set_reply_serial__doc__,
 "message.set_reply_serial(bool) -> None\n"
 "Set the serial that this message is a reply to.\n");
 static PyObject *
-Message_set_reply_serial(Message *self, PyObject *args)
+Message_set_reply_serial(Message *self, PyObject *arg)
 {
     dbus_uint32_t value;
 
-    if (!PyArg_ParseTuple(args, "k", &value)) return NULL;
+    if (!PyArg_Parse(arg, "k", &value)) return NULL;
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
     if (!dbus_message_set_reply_serial(self->msg, value)) {
         return PyErr_NoMemory();
@@ -424,11 +455,11 @@ Message_is_method_call(Message *self, PyObject *args)
 PyDoc_STRVAR(Message_is_error__doc__,
 "is_error(error: str) -> bool");
 static PyObject *
-Message_is_error(Message *self, PyObject *args)
+Message_is_error(Message *self, PyObject *arg)
 {
     const char *error_name;
 
-    if (!PyArg_ParseTuple(args, "s:is_error", &error_name)) {
+    if (!PyArg_Parse(arg, "s:is_error", &error_name)) {
         return NULL;
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -468,11 +499,11 @@ Message_get_member(Message *self, PyObject *unused UNUSED)
 PyDoc_STRVAR(Message_has_member__doc__,
 "has_member(name: str or None) -> bool");
 static PyObject *
-Message_has_member(Message *self, PyObject *args)
+Message_has_member(Message *self, PyObject *arg)
 {
     const char *name;
 
-    if (!PyArg_ParseTuple(args, "z:has_member", &name)) {
+    if (!PyArg_Parse(arg, "z:has_member", &name)) {
         return NULL;
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -482,11 +513,11 @@ Message_has_member(Message *self, PyObject *args)
 PyDoc_STRVAR(Message_set_member__doc__,
 "set_member(unique_name: str or None)");
 static PyObject *
-Message_set_member(Message *self, PyObject *args)
+Message_set_member(Message *self, PyObject *arg)
 {
     const char *name;
 
-    if (!PyArg_ParseTuple(args, "z:set_member", &name)) {
+    if (!PyArg_Parse(arg, "z:set_member", &name)) {
         return NULL;
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -557,11 +588,11 @@ Message_get_path_decomposed(Message *self, PyObject *unused UNUSED)
 PyDoc_STRVAR(Message_has_path__doc__,
 "has_path(name: str or None) -> bool");
 static PyObject *
-Message_has_path(Message *self, PyObject *args)
+Message_has_path(Message *self, PyObject *arg)
 {
     const char *name;
 
-    if (!PyArg_ParseTuple(args, "z:has_path", &name)) {
+    if (!PyArg_Parse(arg, "z:has_path", &name)) {
         return NULL;
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -571,11 +602,11 @@ Message_has_path(Message *self, PyObject *args)
 PyDoc_STRVAR(Message_set_path__doc__,
 "set_path(name: str or None)");
 static PyObject *
-Message_set_path(Message *self, PyObject *args)
+Message_set_path(Message *self, PyObject *arg)
 {
     const char *name;
 
-    if (!PyArg_ParseTuple(args, "z:set_path", &name)) return NULL;
+    if (!PyArg_Parse(arg, "z:set_path", &name)) return NULL;
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
     if (!dbus_message_has_path(self->msg, name)) return PyErr_NoMemory();
     Py_RETURN_NONE;
@@ -599,11 +630,11 @@ Message_get_signature(Message *self, PyObject *unused UNUSED)
 PyDoc_STRVAR(Message_has_signature__doc__,
 "has_signature(signature: str) -> bool");
 static PyObject *
-Message_has_signature(Message *self, PyObject *args)
+Message_has_signature(Message *self, PyObject *arg)
 {
     const char *name;
 
-    if (!PyArg_ParseTuple(args, "s:has_signature", &name)) {
+    if (!PyArg_Parse(arg, "s:has_signature", &name)) {
         return NULL;
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -629,11 +660,11 @@ Message_get_sender(Message *self, PyObject *unused UNUSED)
 PyDoc_STRVAR(Message_has_sender__doc__,
 "has_sender(unique_name: str) -> bool");
 static PyObject *
-Message_has_sender(Message *self, PyObject *args)
+Message_has_sender(Message *self, PyObject *arg)
 {
   const char *name;
 
-  if (!PyArg_ParseTuple(args, "s:has_sender", &name)) {
+  if (!PyArg_Parse(arg, "s:has_sender", &name)) {
       return NULL;
   }
   if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -643,11 +674,11 @@ Message_has_sender(Message *self, PyObject *args)
 PyDoc_STRVAR(Message_set_sender__doc__,
 "set_sender(unique_name: str or None)");
 static PyObject *
-Message_set_sender(Message *self, PyObject *args)
+Message_set_sender(Message *self, PyObject *arg)
 {
     const char *name;
 
-    if (!PyArg_ParseTuple(args, "z:set_sender", &name)) {
+    if (!PyArg_Parse(arg, "z:set_sender", &name)) {
         return NULL;
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -675,11 +706,11 @@ Message_get_destination(Message *self, PyObject *unused UNUSED)
 PyDoc_STRVAR(Message_has_destination__doc__,
 "has_destination(bus_name: str) -> bool");
 static PyObject *
-Message_has_destination(Message *self, PyObject *args)
+Message_has_destination(Message *self, PyObject *arg)
 {
     const char *name;
 
-    if (!PyArg_ParseTuple(args, "s:has_destination", &name)) {
+    if (!PyArg_Parse(arg, "s:has_destination", &name)) {
         return NULL;
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -689,11 +720,11 @@ Message_has_destination(Message *self, PyObject *args)
 PyDoc_STRVAR(Message_set_destination__doc__,
 "set_destination(bus_name: str or None)");
 static PyObject *
-Message_set_destination(Message *self, PyObject *args)
+Message_set_destination(Message *self, PyObject *arg)
 {
     const char *name;
 
-    if (!PyArg_ParseTuple(args, "z:set_destination", &name)) {
+    if (!PyArg_Parse(arg, "z:set_destination", &name)) {
         return NULL;
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -720,11 +751,11 @@ Message_get_interface(Message *self, PyObject *unused UNUSED)
 PyDoc_STRVAR(Message_has_interface__doc__,
 "has_interface(interface: str or None) -> bool");
 static PyObject *
-Message_has_interface(Message *self, PyObject *args)
+Message_has_interface(Message *self, PyObject *arg)
 {
     const char *name;
 
-    if (!PyArg_ParseTuple(args, "z:has_interface", &name)) {
+    if (!PyArg_Parse(arg, "z:has_interface", &name)) {
         return NULL;
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -734,11 +765,11 @@ Message_has_interface(Message *self, PyObject *args)
 PyDoc_STRVAR(Message_set_interface__doc__,
 "set_interface(name: str or None)");
 static PyObject *
-Message_set_interface(Message *self, PyObject *args)
+Message_set_interface(Message *self, PyObject *arg)
 {
     const char *name;
 
-    if (!PyArg_ParseTuple(args, "z:set_interface", &name)) {
+    if (!PyArg_Parse(arg, "z:set_interface", &name)) {
         return NULL;
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -765,11 +796,11 @@ Message_get_error_name(Message *self, PyObject *unused UNUSED)
 PyDoc_STRVAR(Message_set_error_name__doc__,
 "set_error_name(name: str or None)");
 static PyObject *
-Message_set_error_name(Message *self, PyObject *args)
+Message_set_error_name(Message *self, PyObject *arg)
 {
     const char *name;
 
-    if (!PyArg_ParseTuple(args, "z:set_error_name", &name)) {
+    if (!PyArg_Parse(arg, "z:set_error_name", &name)) {
         return NULL;
     }
     if (!self->msg) return DBusPy_RaiseUnusableMessage();
@@ -781,74 +812,92 @@ Message_set_error_name(Message *self, PyObject *args)
 static PyMethodDef Message_tp_methods[] = {
     {"copy", (PyCFunction)Message_copy,
       METH_NOARGS, Message_copy__doc__},
+    {"marshal", (PyCFunction)Message_marshal,
+      METH_NOARGS, Message_marshal__doc__},
     {"is_method_call", (PyCFunction)Message_is_method_call,
       METH_VARARGS, Message_is_method_call__doc__},
     {"is_signal", (PyCFunction)Message_is_signal,
       METH_VARARGS, Message_is_signal__doc__},
     {"is_error", (PyCFunction)Message_is_error,
-      METH_VARARGS, Message_is_error__doc__},
+      METH_O, Message_is_error__doc__},
 
     {"get_args_list", (PyCFunction)dbus_py_Message_get_args_list,
-      METH_VARARGS|METH_KEYWORDS, dbus_py_Message_get_args_list__doc__},
+      DBUS_PY_METH_KEYWORDS, dbus_py_Message_get_args_list__doc__},
     {"guess_signature", (PyCFunction)dbus_py_Message_guess_signature,
       METH_VARARGS|METH_STATIC, dbus_py_Message_guess_signature__doc__},
     {"append", (PyCFunction)dbus_py_Message_append,
-      METH_VARARGS|METH_KEYWORDS, dbus_py_Message_append__doc__},
+      DBUS_PY_METH_KEYWORDS, dbus_py_Message_append__doc__},
+    {"append_columns", (PyCFunction)dbus_py_Message_append_columns,
+      METH_VARARGS, dbus_py_Message_append_columns__doc__},
+    {"open_array", (PyCFunction)dbus_py_Message_open_array,
+      METH_O, dbus_py_Message_open_array__doc__},
+    {"open_struct", (PyCFunction)dbus_py_Message_open_struct,
+      METH_NOARGS, dbus_py_Message_open_struct__doc__},
+    {"open_dict_entry", (PyCFunction)dbus_py_Message_open_dict_entry,
+      METH_NOARGS, dbus_py_Message_open_dict_entry__doc__},
+    {"open_variant", (PyCFunction)dbus_py_Message_open_variant,
+      METH_O, dbus_py_Message_open_variant__doc__},
+    {"append_basic", (PyCFunction)dbus_py_Message_append_basic,
+      METH_VARARGS, dbus_py_Message_append_basic__doc__},
+    {"append_fixed_array", (PyCFunction)dbus_py_Message_append_fixed_array,
+      METH_VARARGS, dbus_py_Message_append_fixed_array__doc__},
+    {"close", (PyCFunction)dbus_py_Message_close,
+      METH_NOARGS, dbus_py_Message_close__doc__},
 
     {"get_auto_start", (PyCFunction)Message_get_auto_start,
       METH_NOARGS, Message_get_auto_start__doc__},
     {"set_auto_start", (PyCFunction)Message_set_auto_start,
-      METH_VARARGS, Message_set_auto_start__doc__},
+      METH_O, Message_set_auto_start__doc__},
     {"get_destination", (PyCFunction)Message_get_destination,
       METH_NOARGS, Message_get_destination__doc__},
     {"set_destination", (PyCFunction)Message_set_destination,
-      METH_VARARGS, Message_set_destination__doc__},
+      METH_O, Message_set_destination__doc__},
     {"has_destination", (PyCFunction)Message_has_destination,
-      METH_VARARGS, Message_has_destination__doc__},
+      METH_O, Message_has_destination__doc__},
     {"get_error_name", (PyCFunction)Message_get_error_name,
       METH_NOARGS, Message_get_error_name__doc__},
     {"set_error_name", (PyCFunction)Message_set_error_name,
-      METH_VARARGS, Message_set_error_name__doc__},
+      METH_O, Message_set_error_name__doc__},
     {"get_interface", (PyCFunction)Message_get_interface,
       METH_NOARGS, Message_get_interface__doc__},
     {"set_interface", (PyCFunction)Message_set_interface,
-      METH_VARARGS, Message_set_interface__doc__},
+      METH_O, Message_set_interface__doc__},
     {"has_interface", (PyCFunction)Message_has_interface,
-      METH_VARARGS, Message_has_interface__doc__},
+      METH_O, Message_has_interface__doc__},
     {"get_member", (PyCFunction)Message_get_member,
       METH_NOARGS, Message_get_member__doc__},
     {"set_member", (PyCFunction)Message_set_member,
-      METH_VARARGS, Message_set_member__doc__},
+      METH_O, Message_set_member__doc__},
     {"has_member", (PyCFunction)Message_has_member,
-      METH_VARARGS, Message_has_member__doc__},
+      METH_O, Message_has_member__doc__},
     {"get_path", (PyCFunction)Message_get_path,
       METH_NOARGS, Message_get_path__doc__},
     {"get_path_decomposed", (PyCFunction)Message_get_path_decomposed,
       METH_NOARGS, Message_get_path_decomposed__doc__},
     {"set_path", (PyCFunction)Message_set_path,
-      METH_VARARGS, Message_set_path__doc__},
+      METH_O, Message_set_path__doc__},
     {"has_path", (PyCFunction)Message_has_path,
-      METH_VARARGS, Message_has_path__doc__},
+      METH_O, Message_has_path__doc__},
     {"get_no_reply", (PyCFunction)Message_get_no_reply,
       METH_NOARGS, Message_get_no_reply__doc__},
     {"set_no_reply", (PyCFunction)Message_set_no_reply,
-      METH_VARARGS, Message_set_no_reply__doc__},
+      METH_O, Message_set_no_reply__doc__},
     {"get_reply_serial", (PyCFunction)Message_get_reply_serial,
       METH_NOARGS, Message_get_reply_serial__doc__},
     {"set_reply_serial", (PyCFunction)Message_set_reply_serial,
-      METH_VARARGS, Message_set_reply_serial__doc__},
+      METH_O, Message_set_reply_serial__doc__},
     {"get_sender", (PyCFunction)Message_get_sender,
       METH_NOARGS, Message_get_sender__doc__},
     {"set_sender", (PyCFunction)Message_set_sender,
-      METH_VARARGS, Message_set_sender__doc__},
+      METH_O, Message_set_sender__doc__},
     {"has_sender", (PyCFunction)Message_has_sender,
-      METH_VARARGS, Message_has_sender__doc__},
+      METH_O, Message_has_sender__doc__},
     {"get_serial", (PyCFunction)Message_get_serial,
       METH_NOARGS, Message_get_serial__doc__},
     {"get_signature", (PyCFunction)Message_get_signature,
       METH_NOARGS, Message_get_signature__doc__},
     {"has_signature", (PyCFunction)Message_has_signature,
-      METH_VARARGS, Message_has_signature__doc__},
+      METH_O, Message_has_signature__doc__},
     {"get_type", (PyCFunction)Message_get_type,
       METH_NOARGS, Message_get_type__doc__},
     {NULL, NULL, 0, NULL}
@@ -218,6 +218,45 @@ set_default_main_loop(PyObject *always_null UNUSED,
     Py_RETURN_NONE;
 }
 
+PyDoc_STRVAR(register_struct_class__doc__,
+"register_struct_class(signature, cls[, fields])\n\n"
+"Decode D-Bus structs with the given signature, such as ``(ssuta{sv})``,\n"
+"as instances of cls rather than as `dbus.Struct`, and append instances of\n"
+"cls as structs with that signature.\n"
+"\n"
+"Decoded structs are constructed by calling ``cls(*items)``, so cls can\n"
+"be a namedtuple, a dataclass, or a class with ``__slots__`` whose\n"
+"constructor takes the fields in order. When appending, the items of a\n"
+"tuple subclass are used directly; for other classes, the attributes named\n"
+"by fields are read, which defaults to the dataclass fields or the\n"
+"``__slots__`` of cls. Instances of cls do not record a variant level, so\n"
+"structs found in variants are decoded the same way.\n"
+"\n"
+"Only instances of exactly cls are recognised, not of its subclasses. Each\n"
+"signature has at most one class and each class at most one signature;\n"
+"pass None as cls to remove the class for a signature.\n"
+"\n"
+":Since: 1.2.1\n"
+);
+static PyObject *
+register_struct_class(PyObject *unused UNUSED, PyObject *args,
+                      PyObject *kwargs)
+{
+    const char *signature;
+    PyObject *cls, *fields = NULL;
+    static char *argnames[] = {"signature", "cls", "fields", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs,
+                                     "sO|O:register_struct_class", argnames,
+                                     &signature, &cls, &fields)) {
+        return NULL;
+    }
+    if (!dbus_py_register_struct_class(signature, cls, fields)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
 static PyMethodDef module_functions[] = {
 #define ENTRY(name,flags) {#name, (PyCFunction)name, flags, name##__doc__}
     ENTRY(validate_interface_name, METH_VARARGS),
@@ -226,6 +265,7 @@ static PyMethodDef module_functions[] = {
     ENTRY(validate_object_path, METH_VARARGS),
     ENTRY(set_default_main_loop, METH_VARARGS),
     ENTRY(get_default_main_loop, METH_NOARGS),
+    ENTRY(register_struct_class, METH_VARARGS|METH_KEYWORDS),
     /* validate_error_name is just implemented as validate_interface_name */
     {"validate_error_name", validate_interface_name,
      METH_VARARGS, validate_error_name__doc__},
@@ -261,6 +301,16 @@ init_dbus_bindings(void)
     dbus_bindings_API[0] = (_dbus_py_func_ptr)&API_count;
     dbus_bindings_API[1] = (_dbus_py_func_ptr)DBusPyConnection_BorrowDBusConnection;
     dbus_bindings_API[2] = (_dbus_py_func_ptr)DBusPyNativeMainLoop_New4;
+    dbus_bindings_API[3] = (_dbus_py_func_ptr)DBusPyMessage_BorrowDBusMessage;
+    dbus_bindings_API[4] = (_dbus_py_func_ptr)DBusPyMessage_ConsumeDBusMessage;
+    dbus_bindings_API[5] = (_dbus_py_func_ptr)DBusPyMessageIter_AppendArgs;
+    dbus_bindings_API[6] = (_dbus_py_func_ptr)DBusPyMessageIter_GetArgs;
+    dbus_bindings_API[7] = (_dbus_py_func_ptr)DBusPyNativeMessageHandler_New;
+    dbus_bindings_API[8] = (_dbus_py_func_ptr)DBusPyConnection_RegisterObjectPath;
+    dbus_bindings_API[9] = (_dbus_py_func_ptr)DBusPyConnection_UnregisterObjectPath;
+    dbus_bindings_API[10] = (_dbus_py_func_ptr)DBusPyConnection_AddMessageFilter;
+    dbus_bindings_API[11] = (_dbus_py_func_ptr)DBusPyConnection_RemoveMessageFilter;
+    dbus_bindings_API[12] = (_dbus_py_func_ptr)DBusPyConnection_SendMessage;
 
     default_main_loop = NULL;
 
@@ -275,6 +325,7 @@ init_dbus_bindings(void)
     if (!dbus_py_init_byte_types()) goto init_error;
     if (!dbus_py_init_message_types()) goto init_error;
     if (!dbus_py_init_pending_call()) goto init_error;
+    if (!dbus_py_init_monitor_types()) goto init_error;
     if (!dbus_py_init_mainloop()) goto init_error;
     if (!dbus_py_init_libdbus_conn_types()) goto init_error;
     if (!dbus_py_init_conn_types()) goto init_error;
@@ -298,6 +349,7 @@ init_dbus_bindings(void)
     if (!dbus_py_insert_byte_types(this_module)) goto init_error;
     if (!dbus_py_insert_message_types(this_module)) goto init_error;
     if (!dbus_py_insert_pending_call(this_module)) goto init_error;
+    if (!dbus_py_insert_monitor_types(this_module)) goto init_error;
     if (!dbus_py_insert_mainloop_types(this_module)) goto init_error;
     if (!dbus_py_insert_libdbus_conn_types(this_module)) goto init_error;
     if (!dbus_py_insert_conn_types(this_module)) goto init_error;
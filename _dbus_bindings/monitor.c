@@ -0,0 +1,707 @@
+/* Capture of the messages seen by a connection in monitor mode.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "dbus_bindings-internal.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "structmember.h"
+
+PyDoc_STRVAR(Monitor_tp_doc,
+"Monitor(connection[, handler=None][, pcap=None][, raw=False]\n"
+"        [, batch_size=256][, message_types=None][, interfaces=None]\n"
+"        [, members=None][, paths=None])\n"
+"\n"
+"Capture every message received by a connection, which will usually have\n"
+"been made into a monitor with `dbus.bus.BusConnection.become_monitor`.\n"
+"\n"
+"Captured messages are filtered and recorded by a C message filter,\n"
+"without constructing a `Message` for each one. While the monitor is\n"
+"active, no other filters, signal handlers or exported objects on the\n"
+"connection see the messages it captures.\n"
+"\n"
+"The connection keeps the Monitor alive: capture continues until `stop`\n"
+"is called or the connection is finalized.\n"
+"\n"
+":Parameters:\n"
+"   `connection` : dbus.connection.Connection\n"
+"       The connection whose messages are to be captured\n"
+"   `handler` : callable\n"
+"       If not None, called with a list of records whenever `batch_size`\n"
+"       of them have been captured, when no more messages are waiting to\n"
+"       be dispatched, and by `flush`. Each record is\n"
+"       ``(time, bytes)`` if `raw` is true, or otherwise\n"
+"       ``(time, type, serial, reply_serial, sender, destination, path,\n"
+"       interface, member, error_name, signature)``, with None for\n"
+"       missing header fields.\n"
+"   `pcap` : file or int\n"
+"       If not None, a file object or file descriptor to which each\n"
+"       captured message is written in pcap format (link type\n"
+"       LINKTYPE_DBUS). The file header is written immediately; records\n"
+"       are buffered and written without calling into Python.\n"
+"   `raw` : bool\n"
+"       If true, records passed to the handler contain the serialized\n"
+"       message instead of its header fields\n"
+"   `batch_size` : int\n"
+"       The largest number of records passed to the handler at once\n"
+"   `message_types` : sequence of int\n"
+"       If not None, capture only messages of these types (the\n"
+"       MESSAGE_TYPE_* constants)\n"
+"   `interfaces`, `members`, `paths` : sequence of str\n"
+"       If not None, capture only messages with one of these\n"
+"       interfaces, members or object paths respectively\n"
+"\n"
+":Since: 1.2.1\n"
+);
+
+/* Bytes of pcap records to buffer before writing them out */
+#define PCAP_BUFFER_SIZE 65536
+
+/* LINKTYPE_DBUS from the tcpdump.org list of link-layer header types */
+#define PCAP_LINKTYPE_DBUS 231
+
+typedef struct {
+    dbus_uint32_t magic;
+    dbus_uint16_t version_major;
+    dbus_uint16_t version_minor;
+    dbus_int32_t thiszone;
+    dbus_uint32_t sigfigs;
+    dbus_uint32_t snaplen;
+    dbus_uint32_t network;
+} PcapFileHeader;
+
+typedef struct {
+    dbus_uint32_t ts_sec;
+    dbus_uint32_t ts_usec;
+    dbus_uint32_t incl_len;
+    dbus_uint32_t orig_len;
+} PcapRecordHeader;
+
+/* Everything here is protected by the GIL. */
+
+typedef struct {
+    PyObject_HEAD
+    /* borrowed: valid while the filter is installed, NULL afterwards */
+    DBusConnection *conn;
+    PyObject *handler;
+    /* the file object or int given as pcap=, kept alive while fd is used */
+    PyObject *pcap;
+    int fd;
+    /* errno of the first failed write, reported by flush() */
+    int write_error;
+    dbus_bool_t raw;
+    Py_ssize_t batch_size;
+    /* records not yet passed to the handler */
+    PyObject *batch;
+    char *buf;
+    size_t buf_len;
+    /* bit (1 << type) is set for each message type to be captured */
+    unsigned int type_mask;
+    /* NULL-terminated arrays, or NULL to capture everything */
+    char **interfaces;
+    char **members;
+    char **paths;
+    unsigned long captured;
+    unsigned long filtered_out;
+} Monitor;
+
+static void
+_strv_free(char **strv)
+{
+    char **iter;
+
+    if (!strv)
+        return;
+    for (iter = strv; *iter; iter++)
+        dbus_free(*iter);
+    dbus_free(strv);
+}
+
+/* Convert a sequence of str into a NULL-terminated array of copies, or
+ * return NULL with an exception set. */
+static char **
+_strv_from_sequence(PyObject *seq, const char *what)
+{
+    PyObject *fast = PySequence_Fast(seq, what);
+    char **strv;
+    Py_ssize_t i, n;
+
+    if (!fast)
+        return NULL;
+    n = PySequence_Fast_GET_SIZE(fast);
+    strv = dbus_new0(char *, n + 1);
+    if (!strv) {
+        Py_CLEAR(fast);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    for (i = 0; i < n; i++) {
+        PyObject *item = PySequence_Fast_GET_ITEM(fast, i);
+        PyObject *utf8;
+        size_t len;
+
+        if (PyUnicode_Check(item)) {
+            utf8 = PyUnicode_AsUTF8String(item);
+            if (!utf8)
+                goto error;
+        }
+        else if (PyBytes_Check(item)) {
+            Py_INCREF(item);
+            utf8 = item;
+        }
+        else {
+            PyErr_Format(PyExc_TypeError, "%s", what);
+            goto error;
+        }
+        len = PyBytes_GET_SIZE(utf8) + 1;
+        strv[i] = dbus_malloc(len);
+        if (!strv[i]) {
+            Py_CLEAR(utf8);
+            PyErr_NoMemory();
+            goto error;
+        }
+        memcpy(strv[i], PyBytes_AS_STRING(utf8), len);
+        Py_CLEAR(utf8);
+    }
+    Py_CLEAR(fast);
+    return strv;
+
+error:
+    Py_CLEAR(fast);
+    _strv_free(strv);
+    return NULL;
+}
+
+static dbus_bool_t
+_strv_contains(char **strv, const char *s)
+{
+    if (!strv)
+        return TRUE;
+    if (!s)
+        return FALSE;
+    for (; *strv; strv++) {
+        if (strcmp(*strv, s) == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static dbus_bool_t
+_monitor_wants(Monitor *self, DBusMessage *message)
+{
+    int type = dbus_message_get_type(message);
+
+    return ((self->type_mask & (1u << type)) &&
+            _strv_contains(self->interfaces,
+                           dbus_message_get_interface(message)) &&
+            _strv_contains(self->members, dbus_message_get_member(message)) &&
+            _strv_contains(self->paths, dbus_message_get_path(message)));
+}
+
+/* Write len bytes to the pcap sink, remembering the first error. */
+static void
+_monitor_write(Monitor *self, const char *data, size_t len)
+{
+    while (len > 0 && !self->write_error) {
+        ssize_t written = write(self->fd, data, len);
+
+        if (written < 0) {
+            if (errno != EINTR)
+                self->write_error = errno;
+        }
+        else {
+            data += written;
+            len -= written;
+        }
+    }
+}
+
+static void
+_monitor_flush_pcap(Monitor *self)
+{
+    if (self->buf_len > 0) {
+        _monitor_write(self, self->buf, self->buf_len);
+        self->buf_len = 0;
+    }
+}
+
+static void
+_monitor_append_pcap(Monitor *self, const struct timeval *tv,
+                     const char *data, int len)
+{
+    PcapRecordHeader header;
+
+    header.ts_sec = tv->tv_sec;
+    header.ts_usec = tv->tv_usec;
+    header.incl_len = len;
+    header.orig_len = len;
+
+    if (self->buf_len + sizeof(header) + len > PCAP_BUFFER_SIZE)
+        _monitor_flush_pcap(self);
+
+    if (sizeof(header) + len > PCAP_BUFFER_SIZE) {
+        /* too big to buffer */
+        _monitor_write(self, (const char *)&header, sizeof(header));
+        _monitor_write(self, data, len);
+        return;
+    }
+
+    memcpy(self->buf + self->buf_len, &header, sizeof(header));
+    memcpy(self->buf + self->buf_len + sizeof(header), data, len);
+    self->buf_len += sizeof(header) + len;
+}
+
+/* Pass the current batch to the handler. Return FALSE if it raised. */
+static dbus_bool_t
+_monitor_flush_batch(Monitor *self)
+{
+    PyObject *batch = self->batch;
+    PyObject *handler = self->handler;
+    PyObject *ret;
+
+    if (!handler || !batch || PyList_GET_SIZE(batch) == 0)
+        return TRUE;
+
+    self->batch = PyList_New(0);
+    if (!self->batch) {
+        self->batch = batch;
+        return FALSE;
+    }
+    /* the handler might stop the monitor, releasing its ref */
+    Py_INCREF(handler);
+    ret = PyObject_CallFunctionObjArgs(handler, batch, NULL);
+    Py_CLEAR(handler);
+    Py_CLEAR(batch);
+    if (!ret)
+        return FALSE;
+    Py_CLEAR(ret);
+    return TRUE;
+}
+
+static PyObject *
+_monitor_record(Monitor *self, DBusMessage *message, const struct timeval *tv,
+                const char *data, int len)
+{
+    double t = (double)tv->tv_sec + (double)tv->tv_usec / 1e6;
+
+    if (self->raw)
+        return Py_BuildValue("(dN)", t, PyBytes_FromStringAndSize(data, len));
+
+    return Py_BuildValue("(diIIzzzzzzz)", t,
+                         dbus_message_get_type(message),
+                         (unsigned int)dbus_message_get_serial(message),
+                         (unsigned int)dbus_message_get_reply_serial(message),
+                         dbus_message_get_sender(message),
+                         dbus_message_get_destination(message),
+                         dbus_message_get_path(message),
+                         dbus_message_get_interface(message),
+                         dbus_message_get_member(message),
+                         dbus_message_get_error_name(message),
+                         dbus_message_get_signature(message));
+}
+
+static DBusHandlerResult
+_monitor_filter(DBusConnection *conn, DBusMessage *message, void *user_data)
+{
+    PyGILState_STATE gil;
+    Monitor *self = (Monitor *)user_data;
+    struct timeval tv;
+    char *data = NULL;
+    int len = 0;
+
+    /* the connection must still see Disconnected */
+    if (dbus_message_has_interface(message, DBUS_INTERFACE_LOCAL))
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+    gettimeofday(&tv, NULL);
+    gil = PyGILState_Ensure();
+    /* the handler might stop the monitor, releasing the filter's ref */
+    Py_INCREF(self);
+
+    if (!_monitor_wants(self, message)) {
+        self->filtered_out++;
+        goto out;
+    }
+    self->captured++;
+
+    if ((self->fd >= 0 || (self->handler && self->raw)) &&
+        !dbus_message_marshal(message, &data, &len)) {
+        DBG("%s", "OOM while trying to serialize captured message");
+        goto out;
+    }
+
+    if (self->fd >= 0)
+        _monitor_append_pcap(self, &tv, data, len);
+
+    if (self->handler) {
+        PyObject *record = _monitor_record(self, message, &tv, data, len);
+
+        if (!record || PyList_Append(self->batch, record) < 0) {
+            Py_CLEAR(record);
+            PyErr_Print();
+            goto out;
+        }
+        Py_CLEAR(record);
+    }
+
+out:
+    /* deliver at the end of each burst of messages, even if the last
+     * one was filtered out, so nothing is left waiting in the batch if
+     * the bus goes quiet */
+    if ((self->handler && self->batch &&
+         PyList_GET_SIZE(self->batch) >= self->batch_size)
+        || dbus_connection_get_dispatch_status(conn) == DBUS_DISPATCH_COMPLETE) {
+        if (!_monitor_flush_batch(self))
+            PyErr_Print();
+        _monitor_flush_pcap(self);
+    }
+    dbus_free(data);
+    Py_CLEAR(self);
+    PyGILState_Release(gil);
+    /* monitors must never reply to the method calls they see */
+    return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+static void
+_monitor_filter_free(void *user_data)
+{
+    PyGILState_STATE gil = PyGILState_Ensure();
+    Monitor *self = (Monitor *)user_data;
+
+    self->conn = NULL;
+    Py_CLEAR(self);
+    PyGILState_Release(gil);
+}
+
+static PyObject *
+Monitor_tp_new(PyTypeObject *cls, PyObject *args, PyObject *kwargs)
+{
+    Monitor *self;
+    DBusConnection *conn;
+    PyObject *connection, *handler = Py_None, *pcap = Py_None;
+    PyObject *message_types = Py_None, *interfaces = Py_None;
+    PyObject *members = Py_None, *paths = Py_None;
+    int raw = 0;
+    Py_ssize_t batch_size = 256;
+    dbus_bool_t ok;
+    static char *argnames[] = {"connection", "handler", "pcap", "raw",
+                               "batch_size", "message_types", "interfaces",
+                               "members", "paths", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OOinOOOO:Monitor",
+                                     argnames, &connection, &handler, &pcap,
+                                     &raw, &batch_size, &message_types,
+                                     &interfaces, &members, &paths)) {
+        return NULL;
+    }
+    if (batch_size < 1) {
+        PyErr_SetString(PyExc_ValueError, "batch_size must be positive");
+        return NULL;
+    }
+    conn = DBusPyConnection_BorrowDBusConnection(connection);
+    if (!conn)
+        return NULL;
+
+    self = (Monitor *)(cls->tp_alloc(cls, 0));
+    if (!self)
+        return NULL;
+    self->fd = -1;
+    self->raw = raw ? TRUE : FALSE;
+    self->batch_size = batch_size;
+    self->type_mask = ~0u;
+
+    if (handler != Py_None) {
+        Py_INCREF(handler);
+        self->handler = handler;
+        self->batch = PyList_New(0);
+        if (!self->batch)
+            goto error;
+    }
+
+    if (message_types != Py_None) {
+        PyObject *fast = PySequence_Fast(message_types,
+                                         "message_types must be a sequence "
+                                         "of int");
+        Py_ssize_t i;
+
+        if (!fast)
+            goto error;
+        self->type_mask = 0;
+        for (i = 0; i < PySequence_Fast_GET_SIZE(fast); i++) {
+            long type = NATIVEINT_ASLONG(PySequence_Fast_GET_ITEM(fast, i));
+
+            if (type == -1 && PyErr_Occurred()) {
+                Py_CLEAR(fast);
+                goto error;
+            }
+            if (type < 0 || type > 31) {
+                Py_CLEAR(fast);
+                PyErr_Format(PyExc_ValueError, "invalid message type %ld",
+                             type);
+                goto error;
+            }
+            self->type_mask |= 1u << type;
+        }
+        Py_CLEAR(fast);
+    }
+
+    if (interfaces != Py_None) {
+        self->interfaces = _strv_from_sequence(interfaces, "interfaces must "
+                                               "be a sequence of str");
+        if (!self->interfaces)
+            goto error;
+    }
+    if (members != Py_None) {
+        self->members = _strv_from_sequence(members, "members must be a "
+                                            "sequence of str");
+        if (!self->members)
+            goto error;
+    }
+    if (paths != Py_None) {
+        self->paths = _strv_from_sequence(paths, "paths must be a sequence "
+                                          "of str");
+        if (!self->paths)
+            goto error;
+    }
+
+    if (pcap != Py_None) {
+        PcapFileHeader header;
+
+        self->fd = PyObject_AsFileDescriptor(pcap);
+        if (self->fd < 0)
+            goto error;
+        Py_INCREF(pcap);
+        self->pcap = pcap;
+        self->buf = dbus_malloc(PCAP_BUFFER_SIZE);
+        if (!self->buf) {
+            PyErr_NoMemory();
+            goto error;
+        }
+
+        header.magic = 0xa1b2c3d4;
+        header.version_major = 2;
+        header.version_minor = 4;
+        header.thiszone = 0;
+        header.sigfigs = 0;
+        header.snaplen = DBUS_MAXIMUM_MESSAGE_LENGTH;
+        header.network = PCAP_LINKTYPE_DBUS;
+        _monitor_write(self, (const char *)&header, sizeof(header));
+        if (self->write_error) {
+            errno = self->write_error;
+            PyErr_SetFromErrno(PyExc_IOError);
+            goto error;
+        }
+    }
+
+    /* The filter owns a reference to self, released by
+     * _monitor_filter_free when it is removed */
+    self->conn = conn;
+    Py_INCREF(self);
+    Py_BEGIN_ALLOW_THREADS
+    ok = dbus_connection_add_filter(conn, _monitor_filter, self,
+                                    _monitor_filter_free);
+    Py_END_ALLOW_THREADS
+    if (!ok) {
+        self->conn = NULL;
+        Py_DECREF(self);
+        PyErr_NoMemory();
+        goto error;
+    }
+    return (PyObject *)self;
+
+error:
+    Py_CLEAR(self);
+    return NULL;
+}
+
+PyDoc_STRVAR(Monitor_flush__doc__,
+"flush()\n\n"
+"Pass any captured records to the handler and write any buffered pcap\n"
+"records.\n"
+"\n"
+":Raises IOError: if writing to the pcap file has failed\n");
+static PyObject *
+Monitor_flush(Monitor *self, PyObject *unused UNUSED)
+{
+    if (!_monitor_flush_batch(self))
+        return NULL;
+    if (self->fd >= 0)
+        _monitor_flush_pcap(self);
+    if (self->write_error) {
+        errno = self->write_error;
+        return PyErr_SetFromErrno(PyExc_IOError);
+    }
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(Monitor_stop__doc__,
+"stop()\n\n"
+"Stop capturing messages, then `flush` and release the handler and the\n"
+"pcap file.\n"
+"\n"
+"The connection itself is not closed: a connection that has become a\n"
+"monitor can't be used for anything else, so it should usually be closed\n"
+"afterwards. If called more than once, only the first call has an\n"
+"effect.\n");
+static PyObject *
+Monitor_stop(Monitor *self, PyObject *unused UNUSED)
+{
+    DBusConnection *conn = self->conn;
+    PyObject *ret;
+
+    if (!conn)
+        Py_RETURN_NONE;
+    self->conn = NULL;
+    Py_BEGIN_ALLOW_THREADS
+    dbus_connection_remove_filter(conn, _monitor_filter, self);
+    Py_END_ALLOW_THREADS
+    ret = Monitor_flush(self, NULL);
+    Py_CLEAR(self->handler);
+    Py_CLEAR(self->pcap);
+    self->fd = -1;
+    return ret;
+}
+
+static void
+Monitor_tp_dealloc(Monitor *self)
+{
+    PyObject *et, *ev, *etb;
+
+    PyObject_GC_UnTrack(self);
+    /* avoid clobbering any pending exception */
+    PyErr_Fetch(&et, &ev, &etb);
+
+    if (self->fd >= 0)
+        _monitor_flush_pcap(self);
+
+    Py_CLEAR(self->handler);
+    Py_CLEAR(self->batch);
+    Py_CLEAR(self->pcap);
+    dbus_free(self->buf);
+    _strv_free(self->interfaces);
+    _strv_free(self->members);
+    _strv_free(self->paths);
+
+    PyErr_Restore(et, ev, etb);
+    (Py_TYPE(self)->tp_free)((PyObject *)self);
+}
+
+/* While the filter is installed, libdbus holds a reference to the
+ * Monitor that the collector can't see, so it is never collected then. */
+static int
+Monitor_tp_traverse(Monitor *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->handler);
+    Py_VISIT(self->batch);
+    Py_VISIT(self->pcap);
+    return 0;
+}
+
+static int
+Monitor_tp_clear(Monitor *self)
+{
+    if (self->fd >= 0)
+        _monitor_flush_pcap(self);
+    Py_CLEAR(self->handler);
+    Py_CLEAR(self->batch);
+    Py_CLEAR(self->pcap);
+    self->fd = -1;
+    return 0;
+}
+
+static PyMethodDef Monitor_tp_methods[] = {
+    {"flush", (PyCFunction)Monitor_flush, METH_NOARGS, Monitor_flush__doc__},
+    {"stop", (PyCFunction)Monitor_stop, METH_NOARGS, Monitor_stop__doc__},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyMemberDef Monitor_tp_members[] = {
+    {"captured", T_ULONG, offsetof(Monitor, captured), READONLY,
+     "The number of messages captured so far"},
+    {"filtered_out", T_ULONG, offsetof(Monitor, filtered_out), READONLY,
+     "The number of messages rejected by the filters so far"},
+    {NULL},
+};
+
+static PyTypeObject MonitorType = {
+    PyVarObject_HEAD_INIT(DEFERRED_ADDRESS(&PyType_Type), 0)
+    "dbus.lowlevel.Monitor",
+    sizeof(Monitor),
+    0,
+    (destructor)Monitor_tp_dealloc,         /* tp_dealloc */
+    0,                                      /* tp_print */
+    0,                                      /* tp_getattr */
+    0,                                      /* tp_setattr */
+    0,                                      /* tp_compare */
+    0,                                      /* tp_repr */
+    0,                                      /* tp_as_number */
+    0,                                      /* tp_as_sequence */
+    0,                                      /* tp_as_mapping */
+    0,                                      /* tp_hash */
+    0,                                      /* tp_call */
+    0,                                      /* tp_str */
+    0,                                      /* tp_getattro */
+    0,                                      /* tp_setattro */
+    0,                                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC, /* tp_flags */
+    Monitor_tp_doc,                         /* tp_doc */
+    (traverseproc)Monitor_tp_traverse,      /* tp_traverse */
+    (inquiry)Monitor_tp_clear,              /* tp_clear */
+    0,                                      /* tp_richcompare */
+    0,                                      /* tp_weaklistoffset */
+    0,                                      /* tp_iter */
+    0,                                      /* tp_iternext */
+    Monitor_tp_methods,                     /* tp_methods */
+    Monitor_tp_members,                     /* tp_members */
+    0,                                      /* tp_getset */
+    0,                                      /* tp_base */
+    0,                                      /* tp_dict */
+    0,                                      /* tp_descr_get */
+    0,                                      /* tp_descr_set */
+    0,                                      /* tp_dictoffset */
+    0,                                      /* tp_init */
+    0,                                      /* tp_alloc */
+    Monitor_tp_new,                         /* tp_new */
+};
+
+dbus_bool_t
+dbus_py_init_monitor_types(void)
+{
+    if (PyType_Ready(&MonitorType) < 0) return 0;
+    return 1;
+}
+
+dbus_bool_t
+dbus_py_insert_monitor_types(PyObject *this_module)
+{
+    /* PyModule_AddObject steals a ref */
+    Py_INCREF(&MonitorType);
+    if (PyModule_AddObject(this_module, "Monitor",
+                           (PyObject *)&MonitorType) < 0) return 0;
+    return 1;
+}
+
+/* vim:set ft=c cino< sw=4 sts=4 et: */
@@ -0,0 +1,387 @@
+/* Per-sender limits on the method calls dispatched to exported objects.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "dbus_bindings-internal.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "conn-internal.h"
+
+/* Everything here is protected by the GIL. */
+
+typedef struct _SenderEntry SenderEntry;
+
+struct _SenderEntry {
+    SenderEntry *next;
+    char *sender;
+    unsigned int hash;
+    /* token bucket: tokens available as of the time updated */
+    double tokens;
+    double updated;
+    unsigned long accepted;
+    unsigned long rejected;
+    /* serials of the calls from this sender still awaiting a reply, in
+     * an array with room for in_flight_alloc, which grows as needed up
+     * to max_concurrent */
+    unsigned long n_in_flight;
+    unsigned long in_flight_alloc;
+    dbus_uint32_t *in_flight;
+};
+
+struct _DBusPySenderLimits {
+    double rate;
+    double burst;
+    unsigned long max_concurrent;
+    SenderEntry **buckets;
+    unsigned long n_buckets;
+    unsigned long n_entries;
+    /* forget idle senders when n_entries reaches this */
+    unsigned long sweep_at;
+};
+
+#define INITIAL_BUCKETS 64
+#define INITIAL_IN_FLIGHT 4
+#define MIN_SWEEP_AT 1024
+
+static double
+_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned int
+_hash(const char *s)
+{
+    unsigned int h = 5381;
+
+    while (*s)
+        h = h * 33 + (unsigned char)*s++;
+    return h;
+}
+
+static void
+_entry_free(SenderEntry *entry)
+{
+    dbus_free(entry->in_flight);
+    dbus_free(entry->sender);
+    dbus_free(entry);
+}
+
+/* Refill the entry's token bucket up to now */
+static void
+_entry_refill(DBusPySenderLimits *limits, SenderEntry *entry, double now)
+{
+    entry->tokens += (now - entry->updated) * limits->rate;
+    if (entry->tokens > limits->burst)
+        entry->tokens = limits->burst;
+    entry->updated = now;
+}
+
+/* Forget senders with no calls in flight and a full token bucket: they
+ * are in the same state as a sender we have never seen. */
+static void
+_sweep(DBusPySenderLimits *limits, double now)
+{
+    unsigned long i;
+
+    for (i = 0; i < limits->n_buckets; i++) {
+        SenderEntry **link = &limits->buckets[i];
+
+        while (*link) {
+            SenderEntry *entry = *link;
+
+            if (limits->rate > 0)
+                _entry_refill(limits, entry, now);
+            if (entry->n_in_flight == 0 &&
+                (limits->rate <= 0 || entry->tokens >= limits->burst)) {
+                *link = entry->next;
+                _entry_free(entry);
+                limits->n_entries--;
+            }
+            else {
+                link = &entry->next;
+            }
+        }
+    }
+
+    limits->sweep_at = limits->n_entries * 2;
+    if (limits->sweep_at < MIN_SWEEP_AT)
+        limits->sweep_at = MIN_SWEEP_AT;
+}
+
+static dbus_bool_t
+_grow(DBusPySenderLimits *limits)
+{
+    unsigned long n_buckets = limits->n_buckets * 2;
+    SenderEntry **buckets = dbus_new0(SenderEntry *, n_buckets);
+    unsigned long i;
+
+    if (!buckets)
+        return FALSE;
+
+    for (i = 0; i < limits->n_buckets; i++) {
+        while (limits->buckets[i]) {
+            SenderEntry *entry = limits->buckets[i];
+
+            limits->buckets[i] = entry->next;
+            entry->next = buckets[entry->hash % n_buckets];
+            buckets[entry->hash % n_buckets] = entry;
+        }
+    }
+    dbus_free(limits->buckets);
+    limits->buckets = buckets;
+    limits->n_buckets = n_buckets;
+    return TRUE;
+}
+
+/* Return the entry for the sender, creating it if create is true. Return
+ * NULL if it doesn't exist or can't be created. */
+static SenderEntry *
+_lookup(DBusPySenderLimits *limits, const char *sender, dbus_bool_t create,
+        double now)
+{
+    unsigned int hash = _hash(sender);
+    SenderEntry *entry;
+    size_t len;
+
+    for (entry = limits->buckets[hash % limits->n_buckets]; entry;
+         entry = entry->next) {
+        if (entry->hash == hash && strcmp(entry->sender, sender) == 0)
+            return entry;
+    }
+    if (!create)
+        return NULL;
+
+    if (limits->n_entries >= limits->sweep_at)
+        _sweep(limits, now);
+    if (limits->n_entries >= limits->n_buckets * 2 && !_grow(limits))
+        return NULL;
+
+    entry = dbus_new0(SenderEntry, 1);
+    if (!entry)
+        return NULL;
+    len = strlen(sender) + 1;
+    entry->sender = dbus_malloc(len);
+    if (!entry->sender) {
+        _entry_free(entry);
+        return NULL;
+    }
+    memcpy(entry->sender, sender, len);
+    entry->hash = hash;
+    entry->tokens = limits->burst;
+    entry->updated = now;
+
+    entry->next = limits->buckets[hash % limits->n_buckets];
+    limits->buckets[hash % limits->n_buckets] = entry;
+    limits->n_entries++;
+    return entry;
+}
+
+DBusPySenderLimits *
+DBusPySenderLimits_New(double rate, double burst,
+                       unsigned long max_concurrent)
+{
+    DBusPySenderLimits *limits = dbus_new0(DBusPySenderLimits, 1);
+
+    if (!limits)
+        return NULL;
+    limits->buckets = dbus_new0(SenderEntry *, INITIAL_BUCKETS);
+    if (!limits->buckets) {
+        dbus_free(limits);
+        return NULL;
+    }
+    limits->n_buckets = INITIAL_BUCKETS;
+    limits->sweep_at = MIN_SWEEP_AT;
+    limits->rate = rate;
+    limits->burst = burst;
+    limits->max_concurrent = max_concurrent;
+    return limits;
+}
+
+void
+DBusPySenderLimits_Free(DBusPySenderLimits *limits)
+{
+    unsigned long i;
+
+    if (!limits)
+        return;
+
+    for (i = 0; i < limits->n_buckets; i++) {
+        while (limits->buckets[i]) {
+            SenderEntry *entry = limits->buckets[i];
+
+            limits->buckets[i] = entry->next;
+            _entry_free(entry);
+        }
+    }
+    dbus_free(limits->buckets);
+    dbus_free(limits);
+}
+
+/* Make room for one more serial in the entry's in_flight array, which is
+ * not yet full to max_concurrent */
+static dbus_bool_t
+_entry_reserve_in_flight(DBusPySenderLimits *limits, SenderEntry *entry)
+{
+    unsigned long n;
+    dbus_uint32_t *in_flight;
+
+    if (entry->n_in_flight < entry->in_flight_alloc)
+        return TRUE;
+
+    n = entry->in_flight_alloc ? entry->in_flight_alloc * 2
+                               : INITIAL_IN_FLIGHT;
+    if (n > limits->max_concurrent)
+        n = limits->max_concurrent;
+    in_flight = dbus_realloc(entry->in_flight, n * sizeof(dbus_uint32_t));
+    if (!in_flight)
+        return FALSE;
+    entry->in_flight = in_flight;
+    entry->in_flight_alloc = n;
+    return TRUE;
+}
+
+int
+DBusPySenderLimits_Admit(DBusPySenderLimits *limits, DBusMessage *call)
+{
+    const char *sender = dbus_message_get_sender(call);
+    double now = _now();
+    SenderEntry *entry;
+    dbus_bool_t track;
+
+    /* if we can't keep track of the call, reject it: asking libdbus to
+     * dispatch it again would just bring it back here */
+    entry = _lookup(limits, sender ? sender : "", TRUE, now);
+    if (!entry)
+        return 0;
+
+    if (limits->rate > 0) {
+        _entry_refill(limits, entry, now);
+        if (entry->tokens < 1.0) {
+            entry->rejected++;
+            return 0;
+        }
+    }
+
+    /* nobody will reply to a call that doesn't want a reply, so it can't
+     * be counted as in flight */
+    track = (limits->max_concurrent > 0 && !dbus_message_get_no_reply(call));
+    if (track && (entry->n_in_flight >= limits->max_concurrent ||
+                  !_entry_reserve_in_flight(limits, entry))) {
+        entry->rejected++;
+        return 0;
+    }
+
+    if (limits->rate > 0)
+        entry->tokens -= 1.0;
+    if (track)
+        entry->in_flight[entry->n_in_flight++] = dbus_message_get_serial(call);
+    entry->accepted++;
+    return 1;
+}
+
+void
+DBusPySenderLimits_Finish(DBusPySenderLimits *limits, const char *sender,
+                          dbus_uint32_t serial)
+{
+    SenderEntry *entry;
+    unsigned long i;
+
+    if (limits->max_concurrent == 0)
+        return;
+
+    entry = _lookup(limits, sender ? sender : "", FALSE, 0);
+    if (!entry)
+        return;
+
+    for (i = 0; i < entry->n_in_flight; i++) {
+        if (entry->in_flight[i] == serial) {
+            entry->in_flight[i] = entry->in_flight[--entry->n_in_flight];
+            return;
+        }
+    }
+}
+
+void
+DBusPySenderLimits_ReplySent(DBusPySenderLimits *limits, DBusMessage *msg)
+{
+    int type = dbus_message_get_type(msg);
+
+    if (type == DBUS_MESSAGE_TYPE_METHOD_RETURN ||
+        type == DBUS_MESSAGE_TYPE_ERROR) {
+        DBusPySenderLimits_Finish(limits, dbus_message_get_destination(msg),
+                                  dbus_message_get_reply_serial(msg));
+    }
+}
+
+PyObject *
+DBusPySenderLimits_GetStats(DBusPySenderLimits *limits)
+{
+    PyObject *ret = PyDict_New();
+    unsigned long i;
+
+    if (!ret || !limits)
+        return ret;
+
+    for (i = 0; i < limits->n_buckets; i++) {
+        SenderEntry *entry;
+
+        for (entry = limits->buckets[i]; entry; entry = entry->next) {
+            PyObject *key, *value;
+            int status;
+
+            if (entry->sender[0]) {
+                key = NATIVESTR_FROMSTR(entry->sender);
+            }
+            else {
+                Py_INCREF(Py_None);
+                key = Py_None;
+            }
+            if (!key) {
+                Py_CLEAR(ret);
+                return NULL;
+            }
+            value = Py_BuildValue("(kkk)", entry->accepted, entry->rejected,
+                                  entry->n_in_flight);
+            if (!value) {
+                Py_CLEAR(key);
+                Py_CLEAR(ret);
+                return NULL;
+            }
+            status = PyDict_SetItem(ret, key, value);
+            Py_CLEAR(key);
+            Py_CLEAR(value);
+            if (status < 0) {
+                Py_CLEAR(ret);
+                return NULL;
+            }
+        }
+    }
+    return ret;
+}
+
+/* vim:set ft=c cino< sw=4 sts=4 et: */
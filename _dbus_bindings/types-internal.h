@@ -104,6 +104,38 @@ typedef struct {
     long variant_level;
 } DBusPyDict;
 
+/* the type of hash values, which is long before Python 3.2 */
+#if PY_VERSION_HEX >= 0x03020000
+typedef Py_hash_t dbus_py_hash_t;
+#else
+typedef long dbus_py_hash_t;
+#endif
+
+typedef struct {
+    PyObject *key;
+    PyObject *value;
+    dbus_py_hash_t hash;
+    /* offset of the value's signature in the VarDict's signatures */
+    size_t signature;
+} DBusPyVarDictEntry;
+
+typedef struct {
+    PyObject_HEAD
+    long variant_level;
+    /* -1 if not calculated yet */
+    dbus_py_hash_t hash;
+    Py_ssize_t n_entries;
+    Py_ssize_t n_allocated;
+    DBusPyVarDictEntry *entries;
+    /* an open-addressed hash table of indexes into entries, or -1 */
+    Py_ssize_t *slots;
+    size_t n_slots;
+    /* the signature of each value, followed by '\0' */
+    char *signatures;
+    size_t signatures_len;
+    size_t signatures_allocated;
+} DBusPyVarDict;
+
 PyObject *dbus_py_variant_level_getattro(PyObject *obj, PyObject *name);
 dbus_bool_t dbus_py_variant_level_set(PyObject *obj, long variant_level);
 void dbus_py_variant_level_clear(PyObject *obj);
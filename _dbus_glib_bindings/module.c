@@ -28,6 +28,8 @@
 #include <dbus/dbus-glib.h>
 #include <dbus/dbus-glib-lowlevel.h>
 
+#include "timer-wheel.h"
+
 #ifdef PY3
 PyMODINIT_FUNC PyInit__dbus_glib_bindings(void);
 #else
@@ -44,12 +46,263 @@ PyMODINIT_FUNC init_dbus_glib_bindings(void);
 #   define UNUSED /*nothing*/
 #endif
 
+/* Timeouts ========================================================== */
+
+/* dbus-glib adds a GSource for each libdbus timeout, so every pending call
+ * costs a GSource being attached to and removed from the main context.
+ * Instead, we keep a connection's timeouts in a timer wheel, and use one
+ * GSource per connection to wake up when the earliest of them is due. */
+
+typedef struct {
+    GSource source;
+    /* Protects the wheel: libdbus can add or remove timeouts from any
+     * thread */
+    GMutex lock;
+    DBusPyTimerWheel wheel;
+    /* Monotonic time corresponding to tick 0, in microseconds */
+    gint64 epoch;
+} TimeoutSource;
+
+/* The data attached to each DBusTimeout */
+typedef struct {
+    DBusPyTimer timer;
+    TimeoutSource *source;
+} TimeoutHandler;
+
+/* Convert a monotonic time in microseconds to wheel ticks */
+static dbus_uint64_t
+timeout_source_ticks_at(TimeoutSource *self, gint64 now)
+{
+    if (now < self->epoch)
+        return 0;
+    return (now - self->epoch) / 1000;
+}
+
+/* The current tick, as cached by the main loop for this iteration; only
+ * valid while it is preparing, checking or dispatching the source */
+static dbus_uint64_t
+timeout_source_get_ticks(TimeoutSource *self)
+{
+    return timeout_source_ticks_at(self, g_source_get_time((GSource *)self));
+}
+
+/* Return TRUE if a timeout is due now; otherwise set *timeout_ms to how
+ * long the main loop may sleep (-1 if forever) */
+static gboolean
+timeout_source_is_due(TimeoutSource *self, gint *timeout_ms)
+{
+    dbus_uint64_t when, now;
+    gboolean due = FALSE;
+
+    *timeout_ms = -1;
+    g_mutex_lock(&self->lock);
+    if (dbus_py_timer_wheel_next_expiry(&self->wheel, &when)) {
+        now = timeout_source_get_ticks(self);
+        if (when <= now) {
+            *timeout_ms = 0;
+            due = TRUE;
+        }
+        else if (when - now > G_MAXINT) {
+            *timeout_ms = G_MAXINT;
+        }
+        else {
+            *timeout_ms = (gint)(when - now);
+        }
+    }
+    g_mutex_unlock(&self->lock);
+    return due;
+}
+
+static gboolean
+timeout_source_prepare(GSource *source, gint *timeout_ms)
+{
+    return timeout_source_is_due((TimeoutSource *)source, timeout_ms);
+}
+
+static gboolean
+timeout_source_check(GSource *source)
+{
+    gint timeout_ms;
+
+    return timeout_source_is_due((TimeoutSource *)source, &timeout_ms);
+}
+
+static gboolean
+timeout_source_dispatch(GSource *source,
+                        GSourceFunc callback UNUSED,
+                        gpointer user_data UNUSED)
+{
+    TimeoutSource *self = (TimeoutSource *)source;
+    DBusPyTimer expired;
+    dbus_uint64_t now;
+
+    dbus_py_timer_list_init(&expired);
+
+    g_mutex_lock(&self->lock);
+    now = timeout_source_get_ticks(self);
+    dbus_py_timer_wheel_advance(&self->wheel, now, &expired);
+
+    while (!dbus_py_timer_list_is_empty(&expired)) {
+        DBusPyTimer *timer = expired.next;
+        DBusTimeout *timeout = timer->data;
+
+        /* DBusTimeouts repeat until they're removed, which handling one
+         * usually does; the handler might also remove other timeouts from
+         * the expired list, so only one is taken off it at a time */
+        dbus_py_timer_wheel_remove(&self->wheel, timer);
+        dbus_py_timer_wheel_add(&self->wheel, timer,
+                                now + dbus_timeout_get_interval(timeout));
+
+        g_mutex_unlock(&self->lock);
+        dbus_timeout_handle(timeout);
+        g_mutex_lock(&self->lock);
+    }
+    g_mutex_unlock(&self->lock);
+
+    return TRUE;
+}
+
+static void
+timeout_source_finalize(GSource *source)
+{
+    TimeoutSource *self = (TimeoutSource *)source;
+
+    g_mutex_clear(&self->lock);
+}
+
+static GSourceFuncs timeout_source_funcs = {
+    timeout_source_prepare,
+    timeout_source_check,
+    timeout_source_dispatch,
+    timeout_source_finalize,
+    NULL,
+    NULL
+};
+
+/* Call with the lock held */
+static void
+timeout_handler_schedule(TimeoutHandler *handler, DBusTimeout *timeout)
+{
+    TimeoutSource *self = handler->source;
+    GMainContext *ctx;
+
+    dbus_py_timer_wheel_remove(&self->wheel, &handler->timer);
+    if (!dbus_timeout_get_enabled(timeout))
+        return;
+
+    /* this can be called from any thread, and at any time, so the main
+     * loop's cached time could be stale */
+    dbus_py_timer_wheel_add(&self->wheel, &handler->timer,
+                            timeout_source_ticks_at(self,
+                                                    g_get_monotonic_time())
+                            + dbus_timeout_get_interval(timeout));
+
+    /* if the main loop is asleep in another thread, it might need to wake
+     * up sooner than it was going to */
+    ctx = g_source_get_context((GSource *)self);
+    if (ctx && !g_main_context_is_owner(ctx))
+        g_main_context_wakeup(ctx);
+}
+
+static void
+timeout_handler_free(void *data)
+{
+    TimeoutHandler *handler = data;
+    TimeoutSource *self = handler->source;
+
+    g_mutex_lock(&self->lock);
+    dbus_py_timer_wheel_remove(&self->wheel, &handler->timer);
+    g_mutex_unlock(&self->lock);
+    g_source_unref((GSource *)self);
+    g_free(handler);
+}
+
+static dbus_bool_t
+add_timeout(DBusTimeout *timeout, void *data)
+{
+    TimeoutSource *self = data;
+    TimeoutHandler *handler = g_new0(TimeoutHandler, 1);
+
+    dbus_py_timer_init(&handler->timer, timeout);
+    handler->source = (TimeoutSource *)g_source_ref((GSource *)self);
+    /* this frees any data left over from the previous timeout functions */
+    dbus_timeout_set_data(timeout, handler, timeout_handler_free);
+
+    g_mutex_lock(&self->lock);
+    timeout_handler_schedule(handler, timeout);
+    g_mutex_unlock(&self->lock);
+    return TRUE;
+}
+
+static void
+remove_timeout(DBusTimeout *timeout, void *data)
+{
+    TimeoutSource *self = data;
+    TimeoutHandler *handler = dbus_timeout_get_data(timeout);
+
+    if (!handler)
+        return;
+
+    g_mutex_lock(&self->lock);
+    dbus_py_timer_wheel_remove(&self->wheel, &handler->timer);
+    g_mutex_unlock(&self->lock);
+}
+
+static void
+timeout_toggled(DBusTimeout *timeout, void *data)
+{
+    TimeoutSource *self = data;
+    TimeoutHandler *handler = dbus_timeout_get_data(timeout);
+
+    if (!handler)
+        return;
+
+    g_mutex_lock(&self->lock);
+    timeout_handler_schedule(handler, timeout);
+    g_mutex_unlock(&self->lock);
+}
+
+static void
+timeout_source_destroy(void *data)
+{
+    GSource *source = data;
+
+    g_source_destroy(source);
+    g_source_unref(source);
+}
+
+static void
+dbus_py_glib_set_up_timeouts(DBusConnection *conn, GMainContext *ctx)
+{
+    GSource *source = g_source_new(&timeout_source_funcs,
+                                   sizeof(TimeoutSource));
+    TimeoutSource *self = (TimeoutSource *)source;
+
+    g_mutex_init(&self->lock);
+    self->epoch = g_get_monotonic_time();
+    dbus_py_timer_wheel_init(&self->wheel, 0);
+    g_source_attach(source, ctx);
+
+    /* This replaces the timeout functions set by dbus-glib, which are told
+     * to remove the existing timeouts, and we're told to add them */
+    if (!dbus_connection_set_timeout_functions(conn, add_timeout,
+                                               remove_timeout,
+                                               timeout_toggled, source,
+                                               timeout_source_destroy)) {
+        /* OOM: keep using dbus-glib's timeouts */
+        timeout_source_destroy(source);
+    }
+}
+
+/* Main loop integration ============================================= */
+
 static dbus_bool_t
 dbus_py_glib_set_up_conn(DBusConnection *conn, void *data)
 {
     GMainContext *ctx = (GMainContext *)data;
     Py_BEGIN_ALLOW_THREADS
     dbus_connection_setup_with_g_main(conn, ctx);
+    dbus_py_glib_set_up_timeouts(conn, ctx);
     Py_END_ALLOW_THREADS
     return 1;
 }
@@ -0,0 +1,245 @@
+/* Hierarchical timer wheel, used to coalesce libdbus timeouts.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "timer-wheel.h"
+
+#include <stddef.h>
+
+#define SLOT_MASK ((dbus_uint64_t)(DBUS_PY_TIMER_WHEEL_SLOTS - 1))
+/* The number of ticks covered by one slot of the given level */
+#define LEVEL_TICKS(level) \
+    ((dbus_uint64_t)1 << (DBUS_PY_TIMER_WHEEL_BITS * (level)))
+/* The furthest ahead a timer can be placed without being clamped */
+#define MAX_DELTA (LEVEL_TICKS(DBUS_PY_TIMER_WHEEL_LEVELS) - 1)
+
+void
+dbus_py_timer_init(DBusPyTimer *timer, void *data)
+{
+    timer->prev = NULL;
+    timer->next = NULL;
+    timer->expires = 0;
+    timer->in_wheel = FALSE;
+    timer->data = data;
+}
+
+void
+dbus_py_timer_list_init(DBusPyTimer *head)
+{
+    dbus_py_timer_init(head, NULL);
+    head->prev = head;
+    head->next = head;
+}
+
+dbus_bool_t
+dbus_py_timer_list_is_empty(const DBusPyTimer *head)
+{
+    return (head->next == head);
+}
+
+static void
+_timer_link(DBusPyTimer *head, DBusPyTimer *timer)
+{
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+static void
+_timer_unlink(DBusPyTimer *timer)
+{
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->prev = NULL;
+    timer->next = NULL;
+}
+
+void
+dbus_py_timer_wheel_init(DBusPyTimerWheel *wheel, dbus_uint64_t now)
+{
+    int level, slot;
+
+    wheel->now = now;
+    wheel->n_timers = 0;
+    for (level = 0; level < DBUS_PY_TIMER_WHEEL_LEVELS; level++) {
+        for (slot = 0; slot < DBUS_PY_TIMER_WHEEL_SLOTS; slot++) {
+            dbus_py_timer_list_init(&wheel->slots[level][slot]);
+        }
+    }
+}
+
+/* Put the timer in the slot that will next be looked at before it
+ * expires: level 0 if it expires within 64 ticks, level 1 if within
+ * 64**2 ticks, and so on. */
+static void
+_timer_wheel_place(DBusPyTimerWheel *wheel, DBusPyTimer *timer)
+{
+    dbus_uint64_t expires = timer->expires;
+    dbus_uint64_t delta;
+    int level;
+
+    if (expires <= wheel->now) {
+        expires = wheel->now + 1;
+    }
+    delta = expires - wheel->now;
+    if (delta > MAX_DELTA) {
+        delta = MAX_DELTA;
+        expires = wheel->now + MAX_DELTA;
+    }
+
+    for (level = 0; level < DBUS_PY_TIMER_WHEEL_LEVELS - 1; level++) {
+        if (delta < LEVEL_TICKS(level + 1))
+            break;
+    }
+
+    _timer_link(&wheel->slots[level][(expires >> (DBUS_PY_TIMER_WHEEL_BITS
+                                                  * level)) & SLOT_MASK],
+                timer);
+}
+
+void
+dbus_py_timer_wheel_add(DBusPyTimerWheel *wheel, DBusPyTimer *timer,
+                        dbus_uint64_t expires)
+{
+    timer->expires = expires;
+    timer->in_wheel = TRUE;
+    wheel->n_timers++;
+    _timer_wheel_place(wheel, timer);
+}
+
+void
+dbus_py_timer_wheel_remove(DBusPyTimerWheel *wheel, DBusPyTimer *timer)
+{
+    if (!timer->next)
+        return;
+
+    _timer_unlink(timer);
+    if (timer->in_wheel) {
+        timer->in_wheel = FALSE;
+        wheel->n_timers--;
+    }
+}
+
+/* Re-place every timer in the given slot, which is now due */
+static void
+_timer_wheel_cascade(DBusPyTimerWheel *wheel, int level)
+{
+    DBusPyTimer *head = &wheel->slots[level][(wheel->now >>
+                                              (DBUS_PY_TIMER_WHEEL_BITS
+                                               * level)) & SLOT_MASK];
+    DBusPyTimer pending;
+
+    if (dbus_py_timer_list_is_empty(head))
+        return;
+
+    /* move the whole list aside first, since timers far in the future
+     * might be put straight back into the same slot */
+    dbus_py_timer_list_init(&pending);
+    pending.next = head->next;
+    pending.prev = head->prev;
+    pending.next->prev = &pending;
+    pending.prev->next = &pending;
+    dbus_py_timer_list_init(head);
+
+    while (!dbus_py_timer_list_is_empty(&pending)) {
+        DBusPyTimer *timer = pending.next;
+
+        _timer_unlink(timer);
+        _timer_wheel_place(wheel, timer);
+    }
+}
+
+void
+dbus_py_timer_wheel_advance(DBusPyTimerWheel *wheel, dbus_uint64_t now,
+                            DBusPyTimer *expired)
+{
+    while (wheel->now < now) {
+        DBusPyTimer *head;
+        dbus_uint64_t next;
+        int level;
+
+        /* skip over ticks where nothing would happen */
+        if (!dbus_py_timer_wheel_next_expiry(wheel, &next) || next > now) {
+            wheel->now = now;
+            break;
+        }
+        wheel->now = next;
+
+        /* From the top down, so that timers cascading from one level can
+         * cascade again from the next if necessary */
+        for (level = DBUS_PY_TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+            if ((wheel->now & (LEVEL_TICKS(level) - 1)) == 0) {
+                _timer_wheel_cascade(wheel, level);
+            }
+        }
+
+        /* everything in this level 0 slot expires now */
+        head = &wheel->slots[0][wheel->now & SLOT_MASK];
+        while (!dbus_py_timer_list_is_empty(head)) {
+            DBusPyTimer *timer = head->next;
+
+            _timer_unlink(timer);
+            timer->in_wheel = FALSE;
+            wheel->n_timers--;
+            _timer_link(expired, timer);
+        }
+    }
+}
+
+dbus_bool_t
+dbus_py_timer_wheel_next_expiry(const DBusPyTimerWheel *wheel,
+                                dbus_uint64_t *when)
+{
+    dbus_bool_t found = FALSE;
+    dbus_uint64_t best = 0;
+    int level, j;
+
+    if (wheel->n_timers == 0)
+        return FALSE;
+
+    for (level = 0; level < DBUS_PY_TIMER_WHEEL_LEVELS; level++) {
+        int shift = DBUS_PY_TIMER_WHEEL_BITS * level;
+        dbus_uint64_t base = wheel->now >> shift;
+
+        /* Level 0 slots are exact; for the others, the time at which the
+         * slot will be cascaded is a lower bound */
+        for (j = 1; j <= DBUS_PY_TIMER_WHEEL_SLOTS; j++) {
+            if (!dbus_py_timer_list_is_empty(
+                    &wheel->slots[level][(base + j) & SLOT_MASK])) {
+                dbus_uint64_t t = (base + j) << shift;
+
+                if (!found || t < best) {
+                    best = t;
+                    found = TRUE;
+                }
+                break;
+            }
+        }
+    }
+
+    if (found)
+        *when = best;
+    return found;
+}
+
+/* vim:set ft=c cino< sw=4 sts=4 et: */
@@ -0,0 +1,78 @@
+/* Hierarchical timer wheel, used to coalesce libdbus timeouts.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DBUS_PYTHON_TIMER_WHEEL_H
+#define DBUS_PYTHON_TIMER_WHEEL_H
+
+#include <dbus/dbus.h>
+
+/* Times are in ticks (milliseconds, for libdbus timeouts). Each level has
+ * 64 slots, and each slot of level n covers 64**n ticks, so four levels
+ * cover about 4.6 hours; timers further in the future than that sit in the
+ * top level and are re-examined each time it turns. */
+#define DBUS_PY_TIMER_WHEEL_BITS 6
+#define DBUS_PY_TIMER_WHEEL_SLOTS (1 << DBUS_PY_TIMER_WHEEL_BITS)
+#define DBUS_PY_TIMER_WHEEL_LEVELS 4
+
+typedef struct _DBusPyTimer DBusPyTimer;
+
+/* A timer, or the head of a circular list of timers. */
+struct _DBusPyTimer {
+    DBusPyTimer *prev;
+    DBusPyTimer *next;
+    dbus_uint64_t expires;
+    dbus_bool_t in_wheel;
+    void *data;
+};
+
+typedef struct {
+    dbus_uint64_t now;
+    unsigned long n_timers;
+    DBusPyTimer slots[DBUS_PY_TIMER_WHEEL_LEVELS][DBUS_PY_TIMER_WHEEL_SLOTS];
+} DBusPyTimerWheel;
+
+void dbus_py_timer_init(DBusPyTimer *timer, void *data);
+void dbus_py_timer_list_init(DBusPyTimer *head);
+dbus_bool_t dbus_py_timer_list_is_empty(const DBusPyTimer *head);
+
+void dbus_py_timer_wheel_init(DBusPyTimerWheel *wheel, dbus_uint64_t now);
+/* Schedule timer to expire at the given time, or on the next tick if that
+ * time has already passed. The timer must not already be scheduled. */
+void dbus_py_timer_wheel_add(DBusPyTimerWheel *wheel, DBusPyTimer *timer,
+                             dbus_uint64_t expires);
+/* Unschedule timer, or remove it from a list of expired timers. Does
+ * nothing if it is neither. */
+void dbus_py_timer_wheel_remove(DBusPyTimerWheel *wheel, DBusPyTimer *timer);
+/* Move the wheel's time forward, moving timers that expire on or before
+ * now to the end of the list headed by expired. */
+void dbus_py_timer_wheel_advance(DBusPyTimerWheel *wheel, dbus_uint64_t now,
+                                 DBusPyTimer *expired);
+/* If any timer is scheduled, set *when to a time no later than the
+ * earliest expiry, at which the wheel should next be advanced, and return
+ * TRUE. */
+dbus_bool_t dbus_py_timer_wheel_next_expiry(const DBusPyTimerWheel *wheel,
+                                            dbus_uint64_t *when);
+
+#endif
+
+/* vim:set ft=c cino< sw=4 sts=4 et: */
@@ -54,7 +54,7 @@ __all__ = [
 
            'ObjectPath', 'ByteArray', 'Signature', 'Byte', 'Boolean',
            'Int16', 'UInt16', 'Int32', 'UInt32', 'Int64', 'UInt64',
-           'Double', 'String', 'Array', 'Struct', 'Dictionary',
+           'Double', 'String', 'Array', 'Struct', 'Dictionary', 'VarDict',
 
            # from exceptions
            'DBusException',
@@ -95,7 +95,7 @@ from dbus.exceptions import (
     ValidationException)
 from _dbus_bindings import (
     Array, Boolean, Byte, ByteArray, Dictionary, Double, Int16, Int32, Int64,
-    ObjectPath, Signature, String, Struct, UInt16, UInt32, UInt64)
+    ObjectPath, Signature, String, Struct, UInt16, UInt32, UInt64, VarDict)
 
 if is_py2:
     from _dbus_bindings import UTF8String
@@ -30,6 +30,9 @@ from __future__ import generators
 __all__ = ('Bus', 'SystemBus', 'SessionBus', 'StarterBus')
 __docformat__ = 'reStructuredText'
 
+import os
+import socket
+
 from dbus.exceptions import DBusException
 from _dbus_bindings import (
     BUS_DAEMON_IFACE, BUS_DAEMON_NAME, BUS_DAEMON_PATH, BUS_SESSION,
@@ -55,8 +58,18 @@ class Bus(BusConnection):
 
     _shared_instances = {}
 
+    #: bus type -> the `dbus.bus.ConnectionRecipe` objects applied to the
+    #: shared instance
+    _recipes = {}
+
+    #: the process in which the shared instances were made
+    _pid = os.getpid()
+
+    #: shared instances inherited across a fork, still to be closed
+    _forked_instances = []
+
     def __new__(cls, bus_type=BusConnection.TYPE_SESSION, private=False,
-                mainloop=None):
+                mainloop=None, recipe=None):
         """Constructor, returning an existing instance where appropriate.
 
         The returned instance is actually always an instance of `SessionBus`,
@@ -76,12 +89,29 @@ class Bus(BusConnection):
                 The main loop to use. The default is to use the default
                 main loop if one has been set up, or raise an exception
                 if none has been.
+            `recipe` : dbus.bus.ConnectionRecipe
+                If not None, apply the recipe to the connection. For a
+                shared instance, the recipe is also applied to the new
+                shared instance made in a child process after a fork.
+                A recipe that has already been applied to the shared
+                instance is not applied again. (New in 1.2.1.)
         :Changed: in dbus-python 0.80:
             converted from a wrapper around a Connection to a Connection
             subclass.
         """
+        if Bus._pid != os.getpid():
+            # forked without os.register_at_fork telling us
+            _after_fork_in_child()
+        if Bus._forked_instances:
+            _close_forked_instances()
+
         if (not private and bus_type in cls._shared_instances):
-            return cls._shared_instances[bus_type]
+            bus = cls._shared_instances[bus_type]
+            recipes = cls._recipes.setdefault(bus_type, [])
+            if recipe is not None and recipe not in recipes:
+                recipe.apply(bus)
+                recipes.append(recipe)
+            return bus
 
         # this is a bit odd, but we create instances of the subtypes
         # so we can return the shared instances if someone tries to
@@ -101,8 +131,24 @@ class Bus(BusConnection):
 
         bus._bus_type = bus_type
 
+        recipes = []
         if not private:
+            recipes.extend(cls._recipes.get(bus_type, ()))
+        if recipe is not None and recipe not in recipes:
+            recipes.append(recipe)
+        try:
+            for r in recipes:
+                r.apply(bus)
+        except:
+            bus.close()
+            raise
+
+        if not private:
+            # the fork handler mustn't call into libdbus, so look up the
+            # socket now
+            bus._fork_fd = bus.get_unix_fd()
             cls._shared_instances[bus_type] = bus
+            cls._recipes[bus_type] = recipes
 
         return bus
 
@@ -110,6 +156,7 @@ class Bus(BusConnection):
         t = self._bus_type
         if self.__class__._shared_instances.get(t) is self:
             del self.__class__._shared_instances[t]
+            self.__class__._recipes.pop(t, None)
         super(Bus, self).close()
 
     def get_connection(self):
@@ -178,7 +225,7 @@ class Bus(BusConnection):
 # polymorphism
 class SystemBus(Bus):
     """The system-wide message bus."""
-    def __new__(cls, private=False, mainloop=None):
+    def __new__(cls, private=False, mainloop=None, recipe=None):
         """Return a connection to the system bus.
 
         :Parameters:
@@ -189,13 +236,16 @@ class SystemBus(Bus):
                 The main loop to use. The default is to use the default
                 main loop if one has been set up, or raise an exception
                 if none has been.
+            `recipe` : dbus.bus.ConnectionRecipe
+                As for `Bus`
         """
         return Bus.__new__(cls, Bus.TYPE_SYSTEM, mainloop=mainloop,
-                           private=private)
+                           private=private,
+                           recipe=recipe)
 
 class SessionBus(Bus):
     """The session (current login) message bus."""
-    def __new__(cls, private=False, mainloop=None):
+    def __new__(cls, private=False, mainloop=None, recipe=None):
         """Return a connection to the session bus.
 
         :Parameters:
@@ -206,15 +256,18 @@ class SessionBus(Bus):
                 The main loop to use. The default is to use the default
                 main loop if one has been set up, or raise an exception
                 if none has been.
+            `recipe` : dbus.bus.ConnectionRecipe
+                As for `Bus`
         """
         return Bus.__new__(cls, Bus.TYPE_SESSION, private=private,
-                           mainloop=mainloop)
+                           mainloop=mainloop,
+                           recipe=recipe)
 
 class StarterBus(Bus):
     """The bus that activated this process (only valid if
     this process was launched by DBus activation).
     """
-    def __new__(cls, private=False, mainloop=None):
+    def __new__(cls, private=False, mainloop=None, recipe=None):
         """Return a connection to the bus that activated this process.
 
         :Parameters:
@@ -225,6 +278,49 @@ class StarterBus(Bus):
                 The main loop to use. The default is to use the default
                 main loop if one has been set up, or raise an exception
                 if none has been.
+            `recipe` : dbus.bus.ConnectionRecipe
+                As for `Bus`
         """
         return Bus.__new__(cls, Bus.TYPE_STARTER, private=private,
-                           mainloop=mainloop)
+                           mainloop=mainloop,
+                           recipe=recipe)
+
+
+def _after_fork_in_child():
+    """Stop using the shared connections made before a fork, whose
+    sockets the child shares with its parent.
+
+    This doesn't call into libdbus, whose locks might have been held by
+    another of the parent's threads when it forked: the connections are
+    closed by the next call to `Bus` in the child.
+    """
+    Bus._pid = os.getpid()
+    instances = list(Bus._shared_instances.values())
+    Bus._shared_instances.clear()
+    if not instances:
+        return
+    Bus._forked_instances.extend(instances)
+
+    # Anything the child wrote to the shared socket would corrupt the
+    # parent's conversation with the bus daemon, so replace it with a
+    # socket whose other end is already closed. The parent's socket is
+    # unaffected. The child's next shared instance is a new connection,
+    # to which the recipes are applied again.
+    (ours, theirs) = socket.socketpair()
+    theirs.close()
+    try:
+        for bus in instances:
+            fd = getattr(bus, '_fork_fd', None)
+            if fd is not None:
+                os.dup2(ours.fileno(), fd)
+    finally:
+        ours.close()
+
+def _close_forked_instances():
+    while Bus._forked_instances:
+        bus = Bus._forked_instances.pop()
+        bus.set_exit_on_disconnect(False)
+        BusConnection.close(bus)
+
+if hasattr(os, 'register_at_fork'):
+    os.register_at_fork(after_in_child=_after_fork_in_child)
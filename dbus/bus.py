@@ -20,7 +20,7 @@
 # OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 # DEALINGS IN THE SOFTWARE.
 
-__all__ = ('BusConnection',)
+__all__ = ('BusConnection', 'ConnectionRecipe')
 __docformat__ = 'reStructuredText'
 
 import logging
@@ -37,8 +37,9 @@ from _dbus_bindings import (
     REQUEST_NAME_REPLY_PRIMARY_OWNER, validate_bus_name, validate_error_name,
     validate_interface_name, validate_member_name, validate_object_path)
 from dbus.connection import Connection
-from dbus.exceptions import DBusException
-from dbus.lowlevel import HANDLER_RESULT_NOT_YET_HANDLED
+from dbus.exceptions import DBusException, get_error_class
+from dbus.lowlevel import (
+    ErrorMessage, HANDLER_RESULT_NOT_YET_HANDLED, MethodCallMessage, Monitor)
 from dbus._compat import is_py2
 
 
@@ -52,13 +53,27 @@ messages"""
 
 _NAME_HAS_NO_OWNER = 'org.freedesktop.DBus.Error.NameHasNoOwner'
 
+_MONITORING_IFACE = 'org.freedesktop.DBus.Monitoring'
+
 _logger = logging.getLogger('dbus.bus')
 
 
+class _MatchBatch(object):
+    """Match rules to be added by a batch of AddMatch calls, and functions
+    to call once those calls have been sent.
+    """
+
+    __slots__ = ('rules', 'after')
+
+    def __init__(self):
+        self.rules = []
+        self.after = []
+
+
 class NameOwnerWatch(object):
     __slots__ = ('_match', '_pending_call')
 
-    def __init__(self, bus_conn, bus_name, callback):
+    def __init__(self, bus_conn, bus_name, callback, _batch=None):
         validate_bus_name(bus_name)
 
         def signal_cb(owned, old_owner, new_owner):
@@ -72,22 +87,35 @@ class NameOwnerWatch(object):
                 _logger.debug('GetNameOwner(%s) failed:', bus_name,
                               exc_info=(e.__class__, e, None))
 
-        self._match = bus_conn.add_signal_receiver(signal_cb,
-                                                   'NameOwnerChanged',
-                                                   BUS_DAEMON_IFACE,
-                                                   BUS_DAEMON_NAME,
-                                                   BUS_DAEMON_PATH,
-                                                   arg0=bus_name)
-        keywords = {}
-        if is_py2:
-            keywords['utf8_strings'] = True
-        self._pending_call = bus_conn.call_async(BUS_DAEMON_NAME,
-                                                 BUS_DAEMON_PATH,
-                                                 BUS_DAEMON_IFACE,
-                                                 'GetNameOwner',
-                                                 's', (bus_name,),
-                                                 callback, error_cb,
-                                                 **keywords)
+        self._match = bus_conn._add_signal_receiver(_batch, signal_cb,
+                                                    'NameOwnerChanged',
+                                                    BUS_DAEMON_IFACE,
+                                                    BUS_DAEMON_NAME,
+                                                    BUS_DAEMON_PATH,
+                                                    arg0=bus_name)
+        self._pending_call = None
+
+        def get_name_owner():
+            if self._match is None:
+                # already cancelled
+                return
+            keywords = {}
+            if is_py2:
+                keywords['utf8_strings'] = True
+            self._pending_call = bus_conn.call_async(BUS_DAEMON_NAME,
+                                                     BUS_DAEMON_PATH,
+                                                     BUS_DAEMON_IFACE,
+                                                     'GetNameOwner',
+                                                     's', (bus_name,),
+                                                     callback, error_cb,
+                                                     **keywords)
+
+        # ask for the owner only after asking for changes to it, so that
+        # none are missed
+        if _batch is None:
+            get_name_owner()
+        else:
+            _batch.after.append(get_name_owner)
 
     def cancel(self):
         if self._match is not None:
@@ -132,6 +160,15 @@ class BusConnection(Connection):
     def add_signal_receiver(self, handler_function, signal_name=None,
                             dbus_interface=None, bus_name=None,
                             path=None, **keywords):
+        return self._add_signal_receiver(None, handler_function,
+                                         signal_name, dbus_interface,
+                                         bus_name, path, **keywords)
+
+    def _add_signal_receiver(self, batch, handler_function, signal_name=None,
+                             dbus_interface=None, bus_name=None, path=None,
+                             **keywords):
+        # As for add_signal_receiver, but if batch is a _MatchBatch, the
+        # match rules are added to it instead of being added immediately
         named_service = keywords.pop('named_service', None)
         if named_service is not None:
             if bus_name is not None:
@@ -141,7 +178,7 @@ class BusConnection(Connection):
             from warnings import warn
             warn('Passing the named_service parameter to add_signal_receiver '
                  'by name is deprecated: please use positional parameters',
-                 DeprecationWarning, stacklevel=2)
+                 DeprecationWarning, stacklevel=3)
 
         match = super(BusConnection, self).add_signal_receiver(
                 handler_function, signal_name, dbus_interface, bus_name,
@@ -154,10 +191,16 @@ class BusConnection(Connection):
                         match.remove()
             else:
                 callback = match.set_sender_name_owner
-            watch = self.watch_name_owner(bus_name, callback)
+            if batch is None:
+                watch = self.watch_name_owner(bus_name, callback)
+            else:
+                watch = NameOwnerWatch(self, bus_name, callback, batch)
             self._signal_sender_matches[match] = watch
 
-        self.add_match_string(str(match))
+        if batch is None:
+            self.add_match_string(str(match))
+        else:
+            batch.rules.append(str(match))
 
         return match
 
@@ -443,3 +486,144 @@ class BusConnection(Connection):
         self.call_async(BUS_DAEMON_NAME, BUS_DAEMON_PATH,
                         BUS_DAEMON_IFACE, 'RemoveMatch', 's', (rule,),
                         None, None)
+
+    def become_monitor(self, match_rules=(), **kwargs):
+        """Turn this connection into a monitor, which receives a copy of
+        the messages on the bus that match any of the given rules, and
+        start capturing them.
+
+        A connection that has become a monitor can't send messages or own
+        names, so this should usually be a private connection.
+
+        :Parameters:
+            `match_rules` : sequence of str
+                Match rules selecting the messages to be monitored; if
+                empty, all messages are monitored. Filtering here, in the
+                bus daemon, is cheaper than by the keyword arguments.
+            `handler` : callable
+                Called with batches of captured records
+            `pcap` : file or int
+                A file to which captured messages are written in pcap
+                format
+        :Returns: the `dbus.lowlevel.Monitor` capturing the messages
+        :Raises `DBusException`: if the bus daemon refuses, for instance
+            because it does not support monitoring
+        :Since: 1.2.1
+
+        Other keyword arguments are passed to `dbus.lowlevel.Monitor`,
+        which describes the captured records.
+        """
+        # the monitor must be in place before the bus starts sending us
+        # messages, or they would reach the connection's other handlers
+        monitor = Monitor(self, **kwargs)
+        try:
+            self.call_blocking(BUS_DAEMON_NAME, BUS_DAEMON_PATH,
+                               _MONITORING_IFACE, 'BecomeMonitor', 'asu',
+                               (list(match_rules), 0))
+        except:
+            monitor.stop()
+            raise
+        return monitor
+
+
+class ConnectionRecipe(object):
+    """The bus names, match rules and signal receivers that a connection
+    needs, recorded so that they can be set up on a new connection with
+    one round trip to the bus daemon, rather than one for each.
+
+    A recipe can be passed to `dbus.SessionBus` and friends, which apply
+    it to the shared connection, and apply it again to the new shared
+    connection made in a child process after a fork.
+
+    :Since: 1.2.1
+    """
+
+    def __init__(self):
+        # (name, flags)
+        self._names = []
+        # match rules
+        self._rules = []
+        # (args, keywords) for add_signal_receiver
+        self._receivers = []
+
+    def request_name(self, name, flags=0):
+        """Request the given well-known name, as for
+        `BusConnection.request_name`.
+        """
+        validate_bus_name(name, allow_unique=False)
+        self._names.append((name, flags))
+
+    def add_match_string(self, rule):
+        """Add the given match rule, as for
+        `BusConnection.add_match_string`.
+        """
+        self._rules.append(rule)
+
+    def add_signal_receiver(self, handler_function, signal_name=None,
+                            dbus_interface=None, bus_name=None, path=None,
+                            **keywords):
+        """Add a signal receiver, as for
+        `BusConnection.add_signal_receiver`. The handler is called for
+        signals received on every connection the recipe is applied to.
+        """
+        self._receivers.append(((handler_function, signal_name,
+                                 dbus_interface, bus_name, path), keywords))
+
+    def apply(self, connection):
+        """Set up everything in the recipe on the given connection. All
+        the method calls to the bus daemon are sent before waiting for
+        any of their replies.
+
+        :Returns: a dict mapping each requested name to the reply to
+            RequestName, as returned by `BusConnection.request_name`
+        :Raises `DBusException`: if any call failed; the others are
+            still made
+        """
+        # the receivers' match rules are added along with ours
+        batch = _MatchBatch()
+        for (args, keywords) in self._receivers:
+            connection._add_signal_receiver(batch, *args, **keywords)
+
+        calls = []
+        for rule in self._rules + batch.rules:
+            calls.append((None, 'AddMatch', 's', (rule,)))
+        for (name, flags) in self._names:
+            calls.append((name, 'RequestName', 'su', (name, flags)))
+
+        pending = []
+        for (name, method, signature, args) in calls:
+            message = MethodCallMessage(BUS_DAEMON_NAME, BUS_DAEMON_PATH,
+                                        BUS_DAEMON_IFACE, method)
+            message.append(signature=signature, *args)
+            replies = []
+            pending.append((name, replies, connection.send_message_with_reply(
+                message, replies.append, require_main_loop=False)))
+        for func in batch.after:
+            func()
+
+        results = {}
+        error = None
+        for (name, replies, pending_call) in pending:
+            pending_call.block()
+            reply = replies[0]
+            if isinstance(reply, ErrorMessage):
+                if error is None:
+                    error_name = reply.get_error_name()
+                    error = get_error_class(error_name)(
+                        name=error_name, *reply.get_args_list())
+            elif name is not None:
+                results[name] = reply.get_args_list()[0]
+        if error is not None:
+            raise error
+        return results
+
+    def connect(self, address_or_type=BusConnection.TYPE_SESSION,
+                mainloop=None):
+        """Return a new private `BusConnection` with the recipe applied."""
+        bus = BusConnection(address_or_type, mainloop=mainloop)
+        try:
+            self.apply(bus)
+        except:
+            bus.close()
+            raise
+        return bus
@@ -0,0 +1,355 @@
+"""Generate Python client stubs from D-Bus introspection data.
+
+The generated module contains one class per interface, with a method for
+each D-Bus method and a ``connect_to_<Signal>`` method for each signal.
+Signatures are taken from the introspection data when the module is
+generated, so unlike `dbus.proxies.ProxyObject`, the stubs never need to
+introspect the remote object, look up attributes dynamically or guess
+signatures.
+
+Usage::
+
+    python -m dbus.codegen [-o OUTPUT] FILE
+    python -m dbus.codegen [-o OUTPUT] [--system] --dest NAME --path PATH
+
+:Since: 1.2.1
+"""
+
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use, copy,
+# modify, merge, publish, distribute, sublicense, and/or sell copies
+# of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+# WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+__all__ = ('Stub', 'generate', 'generate_from_service')
+__docformat__ = 'restructuredtext'
+
+import keyword
+import string
+import sys
+from xml.parsers.expat import ParserCreate
+
+from _dbus_bindings import (
+    INTROSPECTABLE_IFACE, validate_interface_name, validate_member_name)
+from dbus.exceptions import IntrospectionParserException
+
+
+class Stub(object):
+    """Base class for generated client stubs.
+
+    A stub calls methods of one interface on one remote object, like a
+    `dbus.Interface` wrapping a proxy.
+    """
+
+    __slots__ = ('_connection', '_bus_name', '_object_path')
+
+    #: The D-Bus interface implemented by the stub
+    INTERFACE = None
+
+    def __init__(self, connection, bus_name, object_path):
+        """Constructor.
+
+        :Parameters:
+            `connection` : dbus.connection.Connection
+                The connection on which to make calls
+            `bus_name` : str
+                The bus name of the remote object, or None on a
+                peer-to-peer connection
+            `object_path` : str
+                The object path of the remote object
+        """
+        self._connection = connection
+        self._bus_name = bus_name
+        self._object_path = object_path
+
+    bus_name = property(lambda self: self._bus_name, None, None,
+                        """The bus name of the remote object.""")
+    object_path = property(lambda self: self._object_path, None, None,
+                           """The object path of the remote object.""")
+
+    def _dbus_call(self, method, signature, args, keywords):
+        """Call a method, accepting the same keyword arguments as a call
+        via `dbus.proxies.ProxyObject`.
+        """
+        reply_handler = keywords.pop('reply_handler', None)
+        error_handler = keywords.pop('error_handler', None)
+        ignore_reply = keywords.pop('ignore_reply', False)
+
+        if ignore_reply or reply_handler is not None or error_handler is not None:
+            self._connection.call_async(self._bus_name, self._object_path,
+                                        self.INTERFACE, method, signature,
+                                        args, reply_handler, error_handler,
+                                        **keywords)
+            return None
+
+        return self._connection.call_blocking(self._bus_name,
+                                              self._object_path,
+                                              self.INTERFACE, method,
+                                              signature, args, **keywords)
+
+    def _dbus_connect(self, signal, handler, keywords):
+        return self._connection.add_signal_receiver(handler, signal,
+                                                    self.INTERFACE,
+                                                    self._bus_name,
+                                                    self._object_path,
+                                                    **keywords)
+
+
+class _Interface(object):
+    __slots__ = ('name', 'methods', 'signals')
+
+    def __init__(self, name):
+        self.name = name
+        # lists of (name, in args, out args) and (name, args), where args
+        # are lists of (name or None, type)
+        self.methods = []
+        self.signals = []
+
+
+class _Parser(object):
+    __slots__ = ('interfaces', 'iface', 'member', 'in_args', 'out_args')
+
+    def __init__(self):
+        self.interfaces = []
+        self.iface = None
+        self.member = None
+        self.in_args = None
+        self.out_args = None
+
+    def parse(self, data):
+        parser = ParserCreate('UTF-8', ' ')
+        parser.buffer_text = True
+        parser.StartElementHandler = self.StartElementHandler
+        parser.EndElementHandler = self.EndElementHandler
+        parser.Parse(data, True)
+        return self.interfaces
+
+    def StartElementHandler(self, name, attributes):
+        if self.iface is None:
+            if name == 'interface':
+                validate_interface_name(attributes['name'])
+                self.iface = _Interface(attributes['name'])
+        elif self.member is None:
+            if name in ('method', 'signal'):
+                validate_member_name(attributes['name'])
+                self.member = (name, attributes['name'])
+                self.in_args = []
+                self.out_args = []
+        elif name == 'arg':
+            arg = (attributes.get('name'), attributes['type'])
+            if self.member[0] == 'method':
+                default = 'in'
+            else:
+                default = 'out'
+            if attributes.get('direction', default) == 'in':
+                self.in_args.append(arg)
+            else:
+                self.out_args.append(arg)
+
+    def EndElementHandler(self, name):
+        if self.iface is None:
+            return
+        if self.member is None:
+            if name == 'interface':
+                self.interfaces.append(self.iface)
+                self.iface = None
+        elif name == self.member[0]:
+            if name == 'method':
+                self.iface.methods.append((self.member[1], self.in_args,
+                                           self.out_args))
+            else:
+                self.iface.signals.append((self.member[1], self.out_args))
+            self.member = None
+
+
+def _unique_name(name, taken, reserved=keyword.iskeyword):
+    # add underscores until the name is neither reserved nor taken, then
+    # take it
+    name = str(name)
+    while reserved(name) or name in taken:
+        name += '_'
+    taken.add(name)
+    return name
+
+
+def _class_name(interface, taken):
+    return _unique_name(''.join(part[:1].upper() + part[1:]
+                                for part in interface.replace('_', '.')
+                                                     .split('.')),
+                        taken)
+
+
+_IDENTIFIER_CHARS = frozenset(string.ascii_letters + string.digits + '_')
+
+def _arg_names(args):
+    # use the names from the introspection data if they're usable as
+    # Python parameter names
+    taken = set(('self', 'keywords', 'handler_function'))
+    names = []
+    for i, (name, type_) in enumerate(args):
+        if (not name or name[0] in string.digits or
+            not _IDENTIFIER_CHARS.issuperset(name)):
+            name = 'arg%d' % i
+        names.append(_unique_name(name, taken))
+    return names
+
+
+def _is_stub_name(name):
+    return keyword.iskeyword(name) or hasattr(Stub, name)
+
+
+def _python_name(name, taken):
+    # D-Bus member names are valid identifiers, but might be keywords or
+    # hide something the generated code relies on
+    return _unique_name(name, taken, _is_stub_name)
+
+
+def _describe(names, args):
+    return ', '.join('%s: %s' % (name, type_)
+                     for name, (_, type_) in zip(names, args))
+
+
+def _generate_interface(iface, out, class_names):
+    w = out.append
+    w('')
+    w('')
+    w('class %s(Stub):' % _class_name(iface.name, class_names))
+    w('    """Client stub for the D-Bus interface %s."""' % iface.name)
+    w('')
+    w('    __slots__ = ()')
+    w('')
+    w('    INTERFACE = %r' % str(iface.name))
+
+    taken = set()
+    for name, in_args, out_args in iface.methods:
+        py_name = _python_name(name, taken)
+        names = _arg_names(in_args)
+        signature = ''.join(type_ for _, type_ in in_args)
+        args = ''.join('%s, ' % n for n in names)
+        if len(names) == 1:
+            args_tuple = '(%s,)' % names[0]
+        else:
+            args_tuple = '(%s)' % ', '.join(names)
+        w('')
+        w('    def %s(self, %s**keywords):' % (py_name, args))
+        w('        """%s(%s) -> (%s)"""' % (name, _describe(names, in_args),
+                                            _describe(_arg_names(out_args),
+                                                      out_args)))
+        w('        if keywords:')
+        w('            return self._dbus_call(%r, %r, %s, keywords)'
+          % (str(name), str(signature), args_tuple))
+        w('        return self._connection.call_blocking(self._bus_name, '
+          'self._object_path,')
+        w('            %r, %r, %r, %s)'
+          % (str(iface.name), str(name), str(signature), args_tuple))
+
+    for name, args in iface.signals:
+        w('')
+        w('    def %s(self, handler_function, **keywords):'
+          % _python_name('connect_to_' + name, taken))
+        w('        """Call handler_function(%s) when the %s signal is'
+          % (_describe(_arg_names(args), args), name))
+        w('        emitted. Keyword arguments are as for')
+        w('        `dbus.connection.Connection.add_signal_receiver`."""')
+        w('        return self._dbus_connect(%r, handler_function, keywords)'
+          % str(name))
+
+
+def generate(data, source=None):
+    """Return the source code of a Python module containing client stubs
+    for the interfaces in some introspection XML.
+
+    :Parameters:
+        `data` : str
+            The introspection XML. Must be an 8-bit string of UTF-8.
+        `source` : str or None
+            Where the introspection XML came from, for a comment in the
+            generated module
+    """
+    try:
+        interfaces = _Parser().parse(data)
+    except Exception as e:
+        raise IntrospectionParserException('%s: %s' % (e.__class__, e))
+
+    out = ['# Generated by dbus.codegen%s. Do not edit.'
+           % (source and ' from %s' % source or ''),
+           '',
+           'from dbus.codegen import Stub']
+    class_names = set()
+    for iface in interfaces:
+        _generate_interface(iface, out, class_names)
+    out.append('')
+    return '\n'.join(out)
+
+
+def generate_from_service(connection, bus_name, object_path):
+    """Introspect a remote object and return the source code of a Python
+    module containing client stubs for its interfaces, as for `generate`.
+    """
+    data = connection.call_blocking(bus_name, object_path,
+                                    INTROSPECTABLE_IFACE, 'Introspect', '',
+                                    ())
+    if not isinstance(data, bytes):
+        data = data.encode('utf-8')
+    return generate(data, '%s %s' % (bus_name, object_path))
+
+
+def main(argv=None):
+    from optparse import OptionParser
+
+    parser = OptionParser(usage='%prog [options] [FILE]')
+    parser.add_option('-o', '--output', metavar='FILE',
+                      help='write the module to FILE instead of stdout')
+    parser.add_option('--system', action='store_true', default=False,
+                      help='introspect a service on the system bus '
+                           '(default: session bus)')
+    parser.add_option('--dest', metavar='NAME',
+                      help='introspect the service with this bus name')
+    parser.add_option('--path', metavar='PATH', default='/',
+                      help='introspect this object (default: /)')
+    options, args = parser.parse_args(argv)
+
+    if options.dest is not None:
+        if args:
+            parser.error('FILE cannot be used with --dest')
+        import dbus
+        if options.system:
+            bus = dbus.SystemBus()
+        else:
+            bus = dbus.SessionBus()
+        code = generate_from_service(bus, options.dest, options.path)
+    elif len(args) == 1:
+        f = open(args[0], 'rb')
+        try:
+            code = generate(f.read(), args[0])
+        finally:
+            f.close()
+    else:
+        parser.error('either FILE or --dest is required')
+
+    if options.output is None:
+        sys.stdout.write(code)
+    else:
+        f = open(options.output, 'w')
+        try:
+            f.write(code)
+        finally:
+            f.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -20,17 +20,18 @@
 # OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 # DEALINGS IN THE SOFTWARE.
 
-__all__ = ('Connection', 'SignalMatch')
+__all__ = ('CancellationScope', 'Connection', 'SignalMatch')
 __docformat__ = 'reStructuredText'
 
 import logging
 import threading
+import time
 import weakref
 
 from _dbus_bindings import (
     Connection as _Connection, LOCAL_IFACE, LOCAL_PATH, validate_bus_name,
     validate_interface_name, validate_member_name, validate_object_path)
-from dbus.exceptions import DBusException
+from dbus.exceptions import DBusException, get_error_class
 from dbus.lowlevel import (
     ErrorMessage, HANDLER_RESULT_NOT_YET_HANDLED, MethodCallMessage,
     MethodReturnMessage, SignalMessage)
@@ -50,6 +51,145 @@ def _noop(*args, **kwargs):
     pass
 
 
+_monotonic = getattr(time, 'monotonic', time.time)
+
+
+class CancellationScope(object):
+    """A group of asynchronous method calls which can be cancelled
+    together, and optionally share a deadline.
+
+    Pass the scope to `Connection.call_async`, `Connection.call_blocking`
+    or a proxy method call as the ``scope`` keyword argument. Cancelling
+    the scope cancels all of its calls that are still in progress, and
+    those of its child scopes: their reply and error handlers will never
+    be called, and replies that arrive late are not decoded.
+
+    :Since: 1.2.1
+    """
+
+    def __init__(self, timeout=None, parent=None):
+        """Constructor.
+
+        :Parameters:
+            `timeout` : float or None
+                If not None, calls in this scope must complete within this
+                many seconds from now; calls still pending at the deadline
+                fail with a timeout error, as if each had been made with
+                the remaining time as its own timeout.
+            `parent` : CancellationScope or None
+                If not None, this scope is cancelled whenever `parent` is,
+                and is subject to its deadline too.
+        """
+        self._lock = threading.Lock()
+        self._calls = {}
+        self._children = weakref.WeakKeyDictionary()
+        self._cancelled = False
+
+        if timeout is None:
+            self._deadline = None
+        else:
+            self._deadline = _monotonic() + timeout
+
+        if parent is not None:
+            if (parent._deadline is not None and
+                (self._deadline is None or parent._deadline < self._deadline)):
+                self._deadline = parent._deadline
+            parent._lock.acquire()
+            try:
+                parent._children[self] = None
+                self._cancelled = parent._cancelled
+            finally:
+                parent._lock.release()
+
+    @property
+    def cancelled(self):
+        """True if `cancel` has been called on this scope or a parent."""
+        return self._cancelled
+
+    def child(self, timeout=None):
+        """Return a new scope which is cancelled along with this one.
+
+        :Parameters:
+            `timeout` : float or None
+                As for the constructor. The child's deadline is never
+                later than this scope's.
+        """
+        return self.__class__(timeout, self)
+
+    def remaining(self):
+        """Return the number of seconds until the deadline (0 if it has
+        passed), or None if there is no deadline.
+        """
+        if self._deadline is None:
+            return None
+        return max(self._deadline - _monotonic(), 0.0)
+
+    def get_timeout(self, timeout=-1.0):
+        """Return the timeout in seconds to use for a call in this scope,
+        given the call's own timeout (negative for the default).
+        """
+        remaining = self.remaining()
+        if remaining is None:
+            return timeout
+        if timeout < 0 or remaining < timeout:
+            return remaining
+        return timeout
+
+    def cancel(self):
+        """Cancel all calls in progress in this scope and its children.
+        Calls subsequently made in the scope are not sent at all.
+        """
+        self._lock.acquire()
+        try:
+            self._cancelled = True
+            calls = list(self._calls.values())
+            self._calls.clear()
+            children = list(self._children.keys())
+        finally:
+            self._lock.release()
+
+        for pending in calls:
+            if pending is not None:
+                pending.cancel()
+        for child in children:
+            child.cancel()
+
+    def _reserve(self, token):
+        # Called before sending a call. Return False if we're cancelled.
+        self._lock.acquire()
+        try:
+            if self._cancelled:
+                return False
+            self._calls[token] = None
+            return True
+        finally:
+            self._lock.release()
+
+    def _attach(self, token, pending):
+        # Called with the PendingCall once the call has been sent; the reply
+        # might already have been handled, or the scope cancelled.
+        self._lock.acquire()
+        try:
+            if token in self._calls:
+                self._calls[token] = pending
+                return
+            cancel = self._cancelled
+        finally:
+            self._lock.release()
+
+        if cancel:
+            pending.cancel()
+
+    def _release(self, token):
+        # Called when a reply arrives. Return False if it should be ignored.
+        self._lock.acquire()
+        try:
+            self._calls.pop(token, None)
+            return not self._cancelled
+        finally:
+            self._lock.release()
+
+
 class SignalMatch(object):
     _slots = ['_sender_name_owner', '_member', '_interface', '_sender',
               '_path', '_handler', '_args_match', '_rule',
@@ -551,13 +691,26 @@ class Connection(_Connection):
     def call_async(self, bus_name, object_path, dbus_interface, method,
                    signature, args, reply_handler, error_handler,
                    timeout=-1.0, byte_arrays=False,
-                   require_main_loop=True, **kwargs):
+                   require_main_loop=True, scope=None, **kwargs):
         """Call the given method, asynchronously.
 
         If the reply_handler is None, successful replies will be ignored.
         If the error_handler is None, failures will be ignored. If both
         are None, the implementation may request that no reply is sent.
 
+        If `scope` is a `CancellationScope`, the call is subject to its
+        deadline and is cancelled along with it; if it has already been
+        cancelled, the call is not made and DBusException is raised, as
+        for `call_blocking`. (`scope` is new in 1.2.1.)
+
+        If the keyword argument `struct_columns` is true, arrays of structs
+        in the reply are decoded into columns, as for
+        `dbus.lowlevel.Message.get_args_list`. (New in 1.2.1.)
+
+        If the keyword argument `vardicts` is true, dicts of signature
+        ``a{sv}`` in the reply are decoded into `dbus.VarDict`.
+        (New in 1.2.1.)
+
         :Returns: The dbus.lowlevel.PendingCall.
         :Since: 0.81.0
         """
@@ -574,6 +727,10 @@ class Connection(_Connection):
             get_args_opts['utf8_strings'] = kwargs.get('utf8_strings', False)
         elif 'utf8_strings' in kwargs:
             raise TypeError("unexpected keyword argument 'utf8_strings'")
+        if kwargs.get('struct_columns', False):
+            get_args_opts['struct_columns'] = True
+        if kwargs.get('vardicts', False):
+            get_args_opts['vardicts'] = True
 
         message = MethodCallMessage(destination=bus_name,
                                     path=object_path,
@@ -589,6 +746,9 @@ class Connection(_Connection):
                           args, signature, e.__class__, e)
             raise
 
+        if scope is not None and scope.cancelled:
+            raise DBusException('Method call was cancelled')
+
         if reply_handler is None and error_handler is None:
             # we don't care what happens, so just send it
             self.send_message(message)
@@ -599,23 +759,50 @@ class Connection(_Connection):
         if error_handler is None:
             error_handler = _noop
 
+        if scope is not None:
+            timeout = scope.get_timeout(timeout)
+            token = object()
+            if not scope._reserve(token):
+                raise DBusException('Method call was cancelled')
+
         def msg_reply_handler(message):
+            if scope is not None and not scope._release(token):
+                # cancelled, so don't bother decoding the reply
+                return
             if isinstance(message, MethodReturnMessage):
                 reply_handler(*message.get_args_list(**get_args_opts))
             elif isinstance(message, ErrorMessage):
-                error_handler(DBusException(name=message.get_error_name(),
-                                            *message.get_args_list()))
+                name = message.get_error_name()
+                error_handler(get_error_class(name)(name=name,
+                                                    *message.get_args_list()))
             else:
                 error_handler(TypeError('Unexpected type for reply '
                                         'message: %r' % message))
-        return self.send_message_with_reply(message, msg_reply_handler,
+        try:
+            pending = self.send_message_with_reply(message, msg_reply_handler,
                                         timeout,
                                         require_main_loop=require_main_loop)
+        except:
+            if scope is not None:
+                scope._release(token)
+            raise
+
+        if scope is not None:
+            scope._attach(token, pending)
+        return pending
 
     def call_blocking(self, bus_name, object_path, dbus_interface, method,
                       signature, args, timeout=-1.0,
-                      byte_arrays=False, **kwargs):
+                      byte_arrays=False, scope=None, **kwargs):
         """Call the given method, synchronously.
+
+        If `scope` is a `CancellationScope`, the call is subject to its
+        deadline, and raises DBusException if it has already been
+        cancelled. (`scope` is new in 1.2.1.)
+
+        The keyword arguments `struct_columns` and `vardicts` are as for
+        `call_async`.
+
         :Since: 0.81.0
         """
         if object_path == LOCAL_PATH:
@@ -631,6 +818,10 @@ class Connection(_Connection):
             get_args_opts['utf8_strings'] = kwargs.get('utf8_strings', False)
         elif 'utf8_strings' in kwargs:
             raise TypeError("unexpected keyword argument 'utf8_strings'")
+        if kwargs.get('struct_columns', False):
+            get_args_opts['struct_columns'] = True
+        if kwargs.get('vardicts', False):
+            get_args_opts['vardicts'] = True
 
         message = MethodCallMessage(destination=bus_name,
                                     path=object_path,
@@ -646,6 +837,11 @@ class Connection(_Connection):
                           args, signature, e.__class__, e)
             raise
 
+        if scope is not None:
+            if scope.cancelled:
+                raise DBusException('Method call was cancelled')
+            timeout = scope.get_timeout(timeout)
+
         # make a blocking call
         reply_message = self.send_message_with_reply_and_block(
             message, timeout)
@@ -665,3 +861,66 @@ class Connection(_Connection):
         :Since: 0.83.0
         """
         self.__call_on_disconnection.append(callable)
+
+    def export_many(self, objects):
+        """Export many objects on this connection at once. This is much
+        faster than calling ``add_to_connection`` for each of them.
+
+        Either all of the objects are exported, or none are and an
+        exception is raised. This must not be called at the same time as
+        anything else that exports or unexports the same objects.
+
+        :Parameters:
+            `objects` : iterable of (str, object)
+                Pairs (object path, object), where each object is a
+                `dbus.service.Object` or `dbus.service.LightweightObject`
+        :Raises ValueError: if an object's class does not allow it to be
+            exported as requested
+        :Raises KeyError: if an object path is already in use
+        :Since: 1.2.1
+        """
+        objects = list(objects)
+        entries = []
+        seen = set()
+        for path, obj in objects:
+            if id(obj) in seen and not obj.SUPPORTS_MULTIPLE_OBJECT_PATHS:
+                raise ValueError('%r cannot be exported at more than one '
+                                 'object path' % obj)
+            seen.add(id(obj))
+            entries.append(obj._dbus_export_entry(self, path))
+
+        self._register_object_paths(entries)
+
+        for path, obj in objects:
+            obj._dbus_exported(self, path)
+
+    def unexport_many(self, objects):
+        """Make many objects inaccessible via this connection at once, as
+        if by calling ``remove_from_connection(connection)`` for each of
+        them. This is much faster than doing that.
+
+        Either all of the objects are unexported, or none are and an
+        exception is raised. This must not be called at the same time as
+        anything else that exports or unexports the same objects.
+
+        :Parameters:
+            `objects` : iterable of object
+                `dbus.service.Object` or `dbus.service.LightweightObject`
+                instances exported on this connection
+        :Raises LookupError: if an object is not exported on this
+            connection
+        :Since: 1.2.1
+        """
+        objects = list(objects)
+        paths = []
+        for obj in objects:
+            found = [location[1] for location in obj.locations
+                     if location[0] is self]
+            if not found:
+                raise LookupError('%r is not exported on %r' % (obj, self))
+            paths.extend(found)
+
+        self._unregister_object_paths(paths)
+
+        for obj in objects:
+            obj._dbus_unexported(self)
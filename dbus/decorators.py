@@ -41,7 +41,7 @@ def method(dbus_interface, in_signature=None, out_signature=None,
            sender_keyword=None, path_keyword=None, destination_keyword=None,
            message_keyword=None, connection_keyword=None,
            byte_arrays=False,
-           rel_path_keyword=None, **kwargs):
+           rel_path_keyword=None, include_traceback=None, **kwargs):
     """Factory for decorators used to mark methods of a `dbus.service.Object`
     to be exported on the D-Bus.
 
@@ -57,6 +57,19 @@ def method(dbus_interface, in_signature=None, out_signature=None,
         `out_signature` : str or None
             If not None, the signature of the return value in the usual
             D-Bus notation
+
+            With an `out_signature`, the method may also return a
+            generator: if the signature is a single array, the generator
+            yields its elements (``(key, value)`` pairs for a dict), which
+            are written into the reply one by one; if it has several
+            values, the generator yields each in turn. For any other
+            signature, such as a struct, the generator is the return
+            value, used as an iterable. The method may instead build and
+            return the `dbus.lowlevel.MethodReturnMessage` itself, for
+            instance with its ``open_array`` and ``append`` methods, using
+            the call from `message_keyword`.
+
+            :Since: 1.2.1 (generators and replies)
         `async_callbacks` : tuple containing (str,str), or None
             If None (default) the decorated method is expected to return
             values matching the `out_signature` as usual, or raise
@@ -151,6 +164,21 @@ def method(dbus_interface, in_signature=None, out_signature=None,
             consistent.
 
             :Since: 0.80.0
+
+        `include_traceback` : bool or None
+            If None (default), the ``INCLUDE_TRACEBACKS`` attribute of the
+            `dbus.service.Object` determines whether error replies caused by
+            exceptions from this method include a formatted traceback.
+            Otherwise, include a traceback if and only if this is true.
+            Use False for methods that are expected to fail frequently.
+
+            :Since: 1.2.1
+
+        `vardicts` : bool
+            If True, arguments of signature ``a{sv}`` are passed to the
+            decorated method as `dbus.VarDict` rather than `Dictionary`.
+
+            :Since: 1.2.1
     """
     validate_interface_name(dbus_interface)
 
@@ -198,6 +226,7 @@ def method(dbus_interface, in_signature=None, out_signature=None,
         func._dbus_destination_keyword = destination_keyword
         func._dbus_message_keyword = message_keyword
         func._dbus_connection_keyword = connection_keyword
+        func._dbus_include_traceback = include_traceback
         func._dbus_args = args
         func._dbus_get_args_options = dict(byte_arrays=byte_arrays)
         if is_py2:
@@ -205,6 +234,8 @@ def method(dbus_interface, in_signature=None, out_signature=None,
                 'utf8_strings', False)
         elif 'utf8_strings' in kwargs:
             raise TypeError("unexpected keyword argument 'utf8_strings'")
+        if kwargs.get('vardicts', False):
+            func._dbus_get_args_options['vardicts'] = True
         return func
 
     return decorator
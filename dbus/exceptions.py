@@ -25,10 +25,18 @@
 __all__ = ('DBusException', 'MissingErrorHandlerException',
            'MissingReplyHandlerException', 'ValidationException',
            'IntrospectionParserException', 'UnknownMethodException',
-           'NameExistsException')
+           'NameExistsException', 'LimitsExceededException',
+           'get_error_class', 'register_error_class')
+
+import weakref
 
 from dbus._compat import is_py3
 
+if is_py3:
+    import copyreg
+else:
+    import copy_reg as copyreg
+
 
 class DBusException(Exception):
 
@@ -90,6 +98,13 @@ class DBusException(Exception):
     def get_dbus_name(self):
         return self._dbus_error_name
 
+    def __reduce__(self):
+        if isinstance(type(self), _GeneratedErrorClass):
+            # made by get_error_class(), so it's found again by name
+            return (_make_generated_error, (self._dbus_error_name, self.args),
+                    self.__dict__)
+        return Exception.__reduce__(self)
+
 class MissingErrorHandlerException(DBusException):
 
     include_traceback = True
@@ -132,3 +147,97 @@ class NameExistsException(DBusException):
 
     def __init__(self, name):
         DBusException.__init__(self, "Bus name already exists: %s"%name)
+
+
+# D-Bus error name -> DBusException subclass registered for errors
+# received with that name
+_error_classes = {}
+
+# Subclasses created by get_error_class() for names with no registered
+# class. They are held weakly, so that a service replying with many
+# distinct error names can't make them pile up, but a name keeps the same
+# class for as long as anything (an exception raised with it, or code
+# that looked it up) refers to it. The most recently created are also
+# held in _recent_error_classes, which the C code looks in first.
+_generated_error_classes = weakref.WeakValueDictionary()
+_recent_error_classes = {}
+_MAX_RECENT_ERROR_CLASSES = 128
+
+
+class _GeneratedErrorClass(type):
+    """The metaclass of classes made by get_error_class(), which are
+    pickled by D-Bus error name, since they aren't module attributes.
+    """
+
+def _reduce_generated_error_class(cls):
+    return (get_error_class, (cls._dbus_error_name,))
+
+copyreg.pickle(_GeneratedErrorClass, _reduce_generated_error_class)
+
+def _make_generated_error(name, args):
+    return get_error_class(name)(*args)
+
+def register_error_class(cls):
+    """Use the given `DBusException` subclass for errors received with the
+    D-Bus error name in its ``_dbus_error_name`` attribute. This may be
+    used as a class decorator.
+
+    The class will be instantiated in the same way as `DBusException`,
+    with the error's arguments as positional parameters and the error name
+    as the keyword argument ``name``.
+
+    :Since: 1.2.1
+    """
+    name = getattr(cls, '_dbus_error_name', None)
+    if name is None:
+        raise ValueError('%r has no _dbus_error_name' % cls)
+    _error_classes[name] = cls
+    _recent_error_classes.pop(name, None)
+    _generated_error_classes.pop(name, None)
+    return cls
+
+def get_error_class(name):
+    """Return the `DBusException` subclass used for errors received with
+    the given D-Bus error name.
+
+    If no class was registered for that name with `register_error_class`,
+    a subclass is created. The same subclass is returned for that name as
+    long as it's in use, so errors raised with it can be caught with
+    ``except get_error_class(name)``, and it can be pickled.
+
+    :Since: 1.2.1
+    """
+    try:
+        return _error_classes[name]
+    except KeyError:
+        pass
+    try:
+        return _recent_error_classes[name]
+    except KeyError:
+        pass
+
+    cls = _generated_error_classes.get(name)
+    if cls is None:
+        cls = _GeneratedErrorClass(str(name.rsplit('.', 1)[-1]),
+                                   (DBusException,),
+                                   {'_dbus_error_name': name,
+                                    '__module__': __name__})
+        _generated_error_classes[name] = cls
+
+    if len(_recent_error_classes) >= _MAX_RECENT_ERROR_CLASSES:
+        # the C code holds a reference to this dict, so clear it in place
+        # rather than rebinding the name
+        _recent_error_classes.clear()
+    _recent_error_classes[name] = cls
+    return cls
+
+
+@register_error_class
+class LimitsExceededException(DBusException):
+    """Raised for calls rejected by a service because the caller has made
+    too many, as with `dbus.connection.Connection.set_sender_limits`.
+
+    :Since: 1.2.1
+    """
+
+    _dbus_error_name = 'org.freedesktop.DBus.Error.LimitsExceeded'
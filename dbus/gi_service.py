@@ -24,8 +24,53 @@
 
 __all__ = ['ExportedGObject']
 
-from gi.repository import GObject
+from gi.repository import GLib, GObject
+import dbus
 import dbus.service
+from dbus.exceptions import DBusException
+
+# GType name -> D-Bus signature for the GObject properties we can export
+_PROPERTY_SIGNATURES = {
+    'gboolean': 'b',
+    'guchar': 'y',
+    'gint': 'i',
+    'guint': 'u',
+    'glong': 'x',
+    'gulong': 't',
+    'gint64': 'x',
+    'guint64': 't',
+    'gfloat': 'd',
+    'gdouble': 'd',
+    'gchararray': 's',
+    'GStrv': 'as',
+}
+
+_PROPERTY_TYPES = {
+    'b': dbus.Boolean,
+    'y': dbus.Byte,
+    'i': dbus.Int32,
+    'u': dbus.UInt32,
+    'x': dbus.Int64,
+    't': dbus.UInt64,
+    'd': dbus.Double,
+    's': lambda value: dbus.String(value or ''),
+    'as': lambda value: dbus.Array(value or (), signature='s'),
+}
+
+# D-Bus signature -> class of the values of that type received in a
+# variant, for the scalar types above
+_PROPERTY_CLASSES = {
+    'b': dbus.Boolean,
+    'y': dbus.Byte,
+    'i': dbus.Int32,
+    'u': dbus.UInt32,
+    'x': dbus.Int64,
+    't': dbus.UInt64,
+    'd': dbus.Double,
+    's': dbus.String,
+}
+
+_ERROR_PREFIX = 'org.freedesktop.DBus.Error.'
 
 # The odd syntax used here is required so that the code is compatible with
 # both Python 2 and Python 3.  It essentially creates a new class called
@@ -43,8 +88,60 @@ class ExportedGObjectType(GObject.GObject.__class__, dbus.service.InterfaceType)
     """
     def __init__(cls, name, bases, dct):
         GObject.GObject.__class__.__init__(cls, name, bases, dct)
+        if 'DBUS_PROPERTIES' in dct:
+            cls._dbus_add_properties(dct['DBUS_PROPERTIES'])
+            if not hasattr(cls, '_dbus_emit_properties_changed'):
+                # the first class in the hierarchy to declare properties
+                # also implements org.freedesktop.DBus.Properties
+                dct = dict(dct)
+                for (attr, value) in _PROPERTIES_MEMBERS.items():
+                    if attr not in dct:
+                        dct[attr] = value
+                        setattr(cls, attr, value)
         dbus.service.InterfaceType.__init__(cls, name, bases, dct)
 
+    def _dbus_add_properties(cls, declared):
+        # interface -> {D-Bus name: (signature, access)}, for introspection
+        table = {}
+        for (interface, properties) in \
+                getattr(cls, '_dbus_property_table', {}).items():
+            table[interface] = dict(properties)
+        # (interface, D-Bus name) -> GObject property name
+        gobject_names = dict(getattr(cls, '_dbus_gobject_properties', {}))
+
+        for (interface, names) in declared.items():
+            properties = table.setdefault(interface, {})
+            for name in names:
+                pspec = cls.find_property(name)
+                if pspec is None:
+                    raise AttributeError('%s has no GObject property %r'
+                                         % (cls.__name__, name))
+                signature = _PROPERTY_SIGNATURES.get(pspec.value_type.name)
+                if signature is None:
+                    raise TypeError('GObject property %r has type %s, which '
+                                    'cannot be exported on D-Bus'
+                                    % (name, pspec.value_type.name))
+                if not pspec.flags & GObject.ParamFlags.WRITABLE:
+                    access = 'read'
+                elif not pspec.flags & GObject.ParamFlags.READABLE:
+                    access = 'write'
+                else:
+                    access = 'readwrite'
+
+                dbus_name = ''.join([part[:1].upper() + part[1:]
+                                     for part in pspec.name.split('-')])
+                properties[dbus_name] = (signature, access)
+                gobject_names[(interface, dbus_name)] = pspec.name
+
+        # GObject property name -> ((interface, D-Bus name), ...)
+        notify = {}
+        for (key, name) in gobject_names.items():
+            notify.setdefault(name, []).append(key)
+
+        cls._dbus_property_table = table
+        cls._dbus_gobject_properties = gobject_names
+        cls._dbus_property_notify = notify
+
 
 def ExportedGObject__init__(self, conn=None, object_path=None, **kwargs):
     """Initialize an exported GObject.
@@ -69,11 +166,149 @@ def ExportedGObject__init__(self, conn=None, object_path=None, **kwargs):
     if gobject_properties is not None:
         kwargs.update(gobject_properties)
     GObject.GObject.__init__(self, **kwargs)
+    self._dbus_pending_changes = None
+    if getattr(self, '_dbus_property_notify', None):
+        self.connect('notify', _notify_cb)
     dbus.service.Object.__init__(self, conn=conn,
                                  object_path=object_path,
                                  bus_name=bus_name)
 
-ExportedGObject__doc__ = 'A GObject which is exported on the D-Bus.'
+
+def _notify_cb(obj, pspec):
+    keys = obj._dbus_property_notify.get(pspec.name)
+    if not keys:
+        return
+    # emit one PropertiesChanged per interface for all the changes made
+    # during this main loop iteration
+    if obj._dbus_pending_changes is None:
+        obj._dbus_pending_changes = set()
+        GLib.idle_add(obj._dbus_emit_properties_changed)
+    obj._dbus_pending_changes.update(keys)
+
+
+def _lookup_property(obj, interface_name, property_name):
+    """Return (interface, signature, access, GObject property name) for
+    the given D-Bus property, or raise DBusException.
+    """
+    table = getattr(obj, '_dbus_property_table', {})
+    if interface_name:
+        interfaces = (interface_name,)
+    else:
+        interfaces = table.keys()
+    for interface in interfaces:
+        info = table.get(interface, {}).get(property_name)
+        if info is not None:
+            return ((interface,) + info +
+                    (obj._dbus_gobject_properties[(interface, property_name)],))
+    raise DBusException('No property "%s" on interface "%s"'
+                        % (property_name, interface_name),
+                        name=_ERROR_PREFIX + 'UnknownProperty')
+
+
+def _get_properties(obj, interface_name, names):
+    signatures = obj._dbus_property_table.get(interface_name, {})
+    changed = {}
+    invalidated = []
+    for name in names:
+        (signature, access) = signatures[name]
+        if access == 'write':
+            invalidated.append(name)
+        else:
+            gobject_name = obj._dbus_gobject_properties[(interface_name, name)]
+            changed[name] = _PROPERTY_TYPES[signature](
+                obj.get_property(gobject_name))
+    return (dbus.Dictionary(changed, signature='sv'),
+            dbus.Array(invalidated, signature='s'))
+
+
+@dbus.service.method(dbus.PROPERTIES_IFACE, in_signature='ss',
+                     out_signature='v')
+def Get(self, interface_name, property_name):
+    (interface, signature, access, gobject_name) = _lookup_property(
+        self, interface_name, property_name)
+    if access == 'write':
+        raise DBusException('Property "%s" is write-only' % property_name,
+                            name=_ERROR_PREFIX + 'InvalidArgs')
+    return _PROPERTY_TYPES[signature](self.get_property(gobject_name))
+
+
+@dbus.service.method(dbus.PROPERTIES_IFACE, in_signature='s',
+                     out_signature='a{sv}')
+def GetAll(self, interface_name):
+    names = getattr(self, '_dbus_property_table', {}).get(interface_name, ())
+    if not names:
+        return dbus.Dictionary({}, signature='sv')
+    return _get_properties(self, interface_name, names)[0]
+
+
+@dbus.service.method(dbus.PROPERTIES_IFACE, in_signature='ssv')
+def Set(self, interface_name, property_name, value):
+    (interface, signature, access, gobject_name) = _lookup_property(
+        self, interface_name, property_name)
+    if access == 'read':
+        raise DBusException('Property "%s" is read-only' % property_name,
+                            name=_ERROR_PREFIX + 'PropertyReadOnly')
+    if signature == 'as':
+        valid = (isinstance(value, dbus.Array) and value.signature == 's')
+    else:
+        valid = isinstance(value, _PROPERTY_CLASSES[signature])
+    if not valid:
+        raise DBusException('Property "%s" has type "%s"'
+                            % (property_name, signature),
+                            name=_ERROR_PREFIX + 'InvalidArgs')
+    try:
+        self.set_property(gobject_name, value)
+    except (TypeError, ValueError, OverflowError) as e:
+        raise DBusException(str(e), name=_ERROR_PREFIX + 'InvalidArgs')
+
+
+@dbus.service.signal(dbus.PROPERTIES_IFACE, signature='sa{sv}as')
+def PropertiesChanged(self, interface_name, changed_properties,
+                      invalidated_properties):
+    pass
+
+
+def ExportedGObject_dbus_emit_properties_changed(self):
+    pending = self._dbus_pending_changes
+    self._dbus_pending_changes = None
+
+    by_interface = {}
+    for (interface, name) in pending:
+        by_interface.setdefault(interface, []).append(name)
+    for (interface, names) in by_interface.items():
+        (changed, invalidated) = _get_properties(self, interface, names)
+        self.PropertiesChanged(interface, changed, invalidated)
+    return False
+
+
+# added to the first class in a hierarchy to have DBUS_PROPERTIES
+_PROPERTIES_MEMBERS = {
+    'Get': Get,
+    'GetAll': GetAll,
+    'Set': Set,
+    'PropertiesChanged': PropertiesChanged,
+    '_dbus_emit_properties_changed':
+        ExportedGObject_dbus_emit_properties_changed,
+}
+
+del Get, GetAll, Set, PropertiesChanged
+del ExportedGObject_dbus_emit_properties_changed
+
+
+ExportedGObject__doc__ = """A GObject which is exported on the D-Bus.
+
+    GObject properties can be made available as D-Bus properties, via
+    the standard ``org.freedesktop.DBus.Properties`` interface, by listing
+    them in the ``DBUS_PROPERTIES`` class attribute, a dict mapping D-Bus
+    interface names to sequences of GObject property names. The D-Bus
+    name of a property is its GObject name in CamelCase, so ``max-size``
+    becomes ``MaxSize``. Changes to the properties are announced by the
+    ``PropertiesChanged`` signal, emitted once per interface for all the
+    changes made during a main loop iteration. Only classes with
+    ``DBUS_PROPERTIES``, and their subclasses, implement that interface.
+
+    :Since: 1.2.1 (``DBUS_PROPERTIES``)
+    """
 
 ExportedGObject = ExportedGObjectType(
     'ExportedGObject',
@@ -22,7 +22,7 @@
 
 """Low-level interface to D-Bus."""
 
-__all__ = ('PendingCall', 'Message', 'MethodCallMessage',
+__all__ = ('PendingCall', 'Monitor', 'Message', 'MethodCallMessage',
            'MethodReturnMessage', 'ErrorMessage', 'SignalMessage',
            'HANDLER_RESULT_HANDLED', 'HANDLER_RESULT_NOT_YET_HANDLED',
            'MESSAGE_TYPE_INVALID', 'MESSAGE_TYPE_METHOD_CALL',
@@ -33,4 +33,5 @@ from _dbus_bindings import (
     ErrorMessage, HANDLER_RESULT_HANDLED, HANDLER_RESULT_NOT_YET_HANDLED,
     MESSAGE_TYPE_ERROR, MESSAGE_TYPE_INVALID, MESSAGE_TYPE_METHOD_CALL,
     MESSAGE_TYPE_METHOD_RETURN, MESSAGE_TYPE_SIGNAL, Message,
-    MethodCallMessage, MethodReturnMessage, PendingCall, SignalMessage)
+    MethodCallMessage, MethodReturnMessage, Monitor, PendingCall,
+    SignalMessage)
@@ -0,0 +1,293 @@
+"""A pool of connections for clients that make many method calls.
+
+:Since: 1.2.1
+"""
+
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use, copy,
+# modify, merge, publish, distribute, sublicense, and/or sell copies
+# of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+# WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+__all__ = ('ConnectionPool',)
+__docformat__ = 'restructuredtext'
+
+import threading
+
+from dbus.bus import BusConnection
+from dbus.exceptions import DBusException
+
+
+class _Shard(object):
+    """One connection in a `ConnectionPool`, with its counters.
+
+    The counters are protected by the pool's lock.
+    """
+
+    __slots__ = ('connection', 'calls', 'in_flight', 'errors')
+
+    def __init__(self, connection):
+        self.connection = connection
+        self.calls = 0
+        self.in_flight = 0
+        self.errors = 0
+
+
+class _InFlightCall(object):
+    """An asynchronous call counted in its shard's ``in_flight``, which
+    stops being counted when its reply or error arrives, or when the
+    `dbus.connection.CancellationScope` it was made in is cancelled,
+    whichever happens first.
+    """
+
+    __slots__ = ('_lock', '_shard', '_done')
+
+    def __init__(self, lock, shard):
+        self._lock = lock
+        self._shard = shard
+        self._done = False
+
+    def finish(self, error=False):
+        with self._lock:
+            if self._done:
+                return
+            self._done = True
+            self._shard.in_flight -= 1
+            if error:
+                self._shard.errors += 1
+
+    def cancel(self):
+        # called by the scope, as if this was a PendingCall
+        self.finish()
+
+
+class ConnectionPool(object):
+    """A number of private connections to the same bus or peer, over
+    which method calls are spread so that one busy client isn't limited
+    by the socket and lock of a single connection.
+
+    Each call is made on the shard chosen by its key: by default the
+    destination bus name, so that all the calls to one service are made
+    in order on one connection. Calls made on different connections may
+    be reordered with respect to each other. With ``shard_by='call'``,
+    calls without an explicit key go to each shard in turn instead.
+
+    Because each shard is a separate connection, calls to a bus come
+    from a different unique name depending on their shard, and services
+    that track their callers by unique name will see several clients.
+
+    :Since: 1.2.1
+    """
+
+    #: Choose the shard by the destination bus name (or explicit key)
+    SHARD_BY_DESTINATION = 'destination'
+    #: Choose the shard in turn for each call without an explicit key
+    SHARD_BY_CALL = 'call'
+
+    def __init__(self, address_or_type=BusConnection.TYPE_SESSION, size=4,
+                 mainloop=None, connection_class=BusConnection,
+                 shard_by=SHARD_BY_DESTINATION):
+        """Connect the pool's connections.
+
+        :Parameters:
+            `address_or_type` : str or int
+                The address or bus type to connect to, as for
+                `connection_class`
+            `size` : int
+                The number of connections
+            `mainloop` : dbus.mainloop.NativeMainLoop or None
+                The main loop to use for all the connections, or None to
+                use the default
+            `connection_class` : type
+                `dbus.bus.BusConnection` (the default) to connect to a
+                bus, `dbus.connection.Connection` for peer-to-peer
+                connections, or a subclass of either
+            `shard_by` : str
+                `SHARD_BY_DESTINATION` or `SHARD_BY_CALL`
+        """
+        if size < 1:
+            raise ValueError('A ConnectionPool needs at least one connection')
+        if shard_by not in (self.SHARD_BY_DESTINATION, self.SHARD_BY_CALL):
+            raise ValueError('Unknown shard_by value %r' % shard_by)
+
+        self._shard_by = shard_by
+        self._lock = threading.Lock()
+        self._next = 0
+        self._shards = []
+        try:
+            for i in range(size):
+                connection = connection_class(address_or_type,
+                                              mainloop=mainloop)
+                self._shards.append(_Shard(connection))
+        except Exception:
+            self.close()
+            raise
+
+    def __len__(self):
+        return len(self._shards)
+
+    @property
+    def connections(self):
+        """The pool's connections, as a list."""
+        return [shard.connection for shard in self._shards]
+
+    def _get_shard(self, key):
+        if key is None:
+            with self._lock:
+                shard = self._shards[self._next]
+                self._next = (self._next + 1) % len(self._shards)
+            return shard
+        return self._shards[hash(key) % len(self._shards)]
+
+    def _shard_for_call(self, bus_name, key):
+        if key is None and self._shard_by == self.SHARD_BY_DESTINATION:
+            key = bus_name
+        return self._get_shard(key)
+
+    def get_connection(self, key=None):
+        """Return the connection that calls with the given key are made
+        on, for instance to make a proxy object or add a signal receiver.
+        If `key` is None, return the next connection in turn.
+        """
+        return self._get_shard(key).connection
+
+    def call_async(self, bus_name, object_path, dbus_interface, method,
+                   signature, args, reply_handler, error_handler,
+                   timeout=-1.0, key=None, **kwargs):
+        """Call the given method asynchronously on one of the connections,
+        as for `dbus.connection.Connection.call_async`. A call made with
+        ``scope=`` stops counting as in flight if the scope is cancelled.
+
+        :Parameters:
+            `key` : hashable object
+                If not None, calls with an equal key are made in order on
+                the same connection; if None, the shard is chosen by
+                `bus_name` or in turn, depending on ``shard_by``
+        :Returns: The dbus.lowlevel.PendingCall.
+        """
+        shard = self._shard_for_call(bus_name, key)
+        scope = kwargs.get('scope')
+
+        if reply_handler is None and error_handler is None:
+            # no reply will be asked for, so it will never be in flight
+            with self._lock:
+                shard.calls += 1
+            return shard.connection.call_async(bus_name, object_path,
+                                               dbus_interface, method,
+                                               signature, args, None, None,
+                                               timeout, **kwargs)
+
+        if scope is not None and scope.cancelled:
+            raise DBusException('Method call was cancelled')
+
+        in_flight = _InFlightCall(self._lock, shard)
+        if scope is not None:
+            # the scope cancels in_flight along with the call itself, so
+            # that it is no longer counted
+            token = object()
+            scope._reserve(token)
+
+        def on_reply(*args):
+            if scope is not None:
+                scope._release(token)
+            in_flight.finish()
+            if reply_handler is not None:
+                reply_handler(*args)
+
+        def on_error(e):
+            if scope is not None:
+                scope._release(token)
+            in_flight.finish(error=True)
+            if error_handler is not None:
+                error_handler(e)
+
+        with self._lock:
+            shard.calls += 1
+            shard.in_flight += 1
+        try:
+            pending = shard.connection.call_async(bus_name, object_path,
+                                                  dbus_interface, method,
+                                                  signature, args, on_reply,
+                                                  on_error, timeout, **kwargs)
+        except Exception:
+            if scope is not None:
+                scope._release(token)
+            in_flight.finish(error=True)
+            raise
+        if scope is not None:
+            scope._attach(token, in_flight)
+        return pending
+
+    def call_blocking(self, bus_name, object_path, dbus_interface, method,
+                      signature, args, timeout=-1.0, key=None, **kwargs):
+        """Call the given method synchronously on one of the connections,
+        as for `dbus.connection.Connection.call_blocking`. The calls made
+        from different threads on different connections proceed in
+        parallel.
+
+        :Parameters:
+            `key` : hashable object
+                As for `call_async`
+        """
+        shard = self._shard_for_call(bus_name, key)
+        with self._lock:
+            shard.calls += 1
+            shard.in_flight += 1
+        try:
+            return shard.connection.call_blocking(bus_name, object_path,
+                                                  dbus_interface, method,
+                                                  signature, args, timeout,
+                                                  **kwargs)
+        except Exception:
+            with self._lock:
+                shard.errors += 1
+            raise
+        finally:
+            with self._lock:
+                shard.in_flight -= 1
+
+    def get_stats(self):
+        """Return a list with a dict for each connection in the pool,
+        containing:
+
+        ``unique_name``
+            the connection's unique name on the bus, or None for
+            peer-to-peer connections
+        ``calls``
+            the number of method calls made on it
+        ``in_flight``
+            the number of those calls still waiting for a reply
+        ``errors``
+            the number of those calls that failed
+        """
+        stats = []
+        with self._lock:
+            for shard in self._shards:
+                if isinstance(shard.connection, BusConnection):
+                    unique_name = shard.connection.get_unique_name()
+                else:
+                    unique_name = None
+                stats.append({'unique_name': unique_name,
+                              'calls': shard.calls,
+                              'in_flight': shard.in_flight,
+                              'errors': shard.errors})
+        return stats
+
+    def close(self):
+        """Close all the connections in the pool."""
+        for shard in self._shards:
+            shard.connection.close()
@@ -23,14 +23,16 @@
 # OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 # DEALINGS IN THE SOFTWARE.
 
-__all__ = ('BusName', 'Object', 'method', 'signal')
+__all__ = ('BusName', 'Object', 'LightweightObject', 'method', 'signal')
 __docformat__ = 'restructuredtext'
 
 import sys
 import logging
 import threading
 import traceback
+import weakref
 from collections import Sequence
+from inspect import isgenerator
 
 import _dbus_bindings
 from dbus import (
@@ -39,7 +41,7 @@ from dbus import (
 from dbus.decorators import method, signal
 from dbus.exceptions import (
     DBusException, NameExistsException, UnknownMethodException)
-from dbus.lowlevel import ErrorMessage, MethodReturnMessage, MethodCallMessage
+from dbus.lowlevel import MethodReturnMessage, MethodCallMessage
 from dbus.proxies import LOCAL_PATH
 from dbus._compat import is_py2
 
@@ -183,11 +185,17 @@ class BusName(object):
 
 
 def _method_lookup(self, method_name, dbus_interface):
-    """Walks the Python MRO of the given class to find the method to invoke.
+    """Walks the Python MRO of the given object's class to find the method to
+    invoke.
 
     Returns two methods, the one to call, and the one it inherits from which
     defines its D-Bus interface name, signature, and attributes.
     """
+    return _class_method_lookup(self.__class__, method_name, dbus_interface)
+
+
+def _class_method_lookup(klass, method_name, dbus_interface):
+    """As for `_method_lookup`, but for instances of the given class."""
     parent_method = None
     candidate_class = None
     successful = False
@@ -196,7 +204,7 @@ def _method_lookup(self, method_name, dbus_interface):
     # latter is much simpler
     if dbus_interface:
         # search through the class hierarchy in python MRO order
-        for cls in self.__class__.__mro__:
+        for cls in klass.__mro__:
             # if we haven't got a candidate class yet, and we find a class with a
             # suitably named member, save this as a candidate class
             if (not candidate_class and method_name in cls.__dict__):
@@ -229,7 +237,7 @@ def _method_lookup(self, method_name, dbus_interface):
 
     else:
         # simpler version of above
-        for cls in self.__class__.__mro__:
+        for cls in klass.__mro__:
             if (not candidate_class and method_name in cls.__dict__):
                 candidate_class = cls
 
@@ -248,10 +256,74 @@ def _method_lookup(self, method_name, dbus_interface):
             raise UnknownMethodException('%s is not a valid method' % method_name)
 
 
+def _is_streamed(signature):
+    """Return True if a generator returned by a method with this
+    out_signature yields its values one at a time: the elements of a
+    single array, or each of several return values. Otherwise (say for a
+    struct) the generator is the return value, used as an iterable.
+    """
+    if signature is None:
+        return False
+    types = list(Signature(signature))
+    return len(types) > 1 or (len(types) == 1 and types[0].startswith('a'))
+
+
+def _append_generated(reply, method_name, signature, generator):
+    """Append the values yielded by a method's generator to its reply,
+    without collecting them in a list first. The signature must be one
+    for which _is_streamed() is true.
+    """
+    types = list(Signature(signature))
+
+    if len(types) == 1 and types[0].startswith('a'):
+        # the generator yields the elements of the array
+        element = types[0][1:]
+        reply.open_array(element)
+        if element.startswith('{'):
+            entry = element[1:-1]
+            for key, value in generator:
+                reply.open_dict_entry()
+                reply.append(key, value, signature=entry)
+                reply.close()
+        else:
+            for value in generator:
+                reply.append(value, signature=element)
+        reply.close()
+        return
+
+    # the generator yields the return values in turn
+    types.reverse()
+    for value in generator:
+        if not types:
+            raise TypeError('%s yielded more values than its out_signature '
+                            '%s has' % (method_name, signature))
+        reply.append(value, signature=types.pop())
+    if types:
+        raise TypeError('%s yielded fewer values than its out_signature '
+                        '%s has' % (method_name, signature))
+
+
 def _method_reply_return(connection, message, method_name, signature, *retval):
+    if len(retval) == 1 and isinstance(retval[0], MethodReturnMessage):
+        # the method built its own reply
+        reply = retval[0]
+        if reply.get_reply_serial() != message.get_serial():
+            raise ValueError('%s returned a reply to a different method '
+                             'call' % method_name)
+        if (signature is not None and
+            reply.get_signature() != Signature(signature)):
+            raise TypeError('%s returned a reply with signature %r, not %r'
+                            % (method_name, reply.get_signature(), signature))
+        connection.send_message(reply)
+        return
+
     reply = MethodReturnMessage(message)
     try:
-        reply.append(signature=signature, *retval)
+        if (len(retval) == 1 and isgenerator(retval[0]) and
+            _is_streamed(signature)):
+            _append_generated(reply, method_name, signature, retval[0])
+        else:
+            reply.append(signature=signature, *retval)
     except Exception as e:
         logging.basicConfig()
         if signature is None:
@@ -268,32 +340,181 @@ def _method_reply_return(connection, message, method_name, signature, *retval):
     connection.send_message(reply)
 
 
-def _method_reply_error(connection, message, exception):
-    name = getattr(exception, '_dbus_error_name', None)
+# exception class -> D-Bus error name, for exceptions that don't specify one
+_error_names = weakref.WeakKeyDictionary()
+
 
+def _error_name_for(exception):
+    name = getattr(exception, '_dbus_error_name', None)
     if name is not None:
+        return name
+
+    cls = exception.__class__
+    try:
+        return _error_names[cls]
+    except KeyError:
         pass
-    elif getattr(exception, '__module__', '') in ('', '__main__'):
-        name = 'org.freedesktop.DBus.Python.%s' % exception.__class__.__name__
+
+    if getattr(cls, '__module__', '') in ('', '__main__'):
+        name = 'org.freedesktop.DBus.Python.%s' % cls.__name__
     else:
-        name = 'org.freedesktop.DBus.Python.%s.%s' % (exception.__module__, exception.__class__.__name__)
+        name = 'org.freedesktop.DBus.Python.%s.%s' % (cls.__module__,
+                                                      cls.__name__)
+    _error_names[cls] = name
+    return name
+
+
+def _method_reply_error(connection, message, exception,
+                        include_traceback=True):
+    if message.get_no_reply():
+        # nobody is listening, so don't bother formatting anything
+        return
+
+    name = _error_name_for(exception)
 
     et, ev, etb = sys.exc_info()
-    if isinstance(exception, DBusException) and not exception.include_traceback:
+    if isinstance(exception, DBusException) and (not include_traceback or
+                                                 not exception.include_traceback):
         # We don't actually want the traceback anyway
         contents = exception.get_dbus_message()
-    elif ev is exception:
+    elif include_traceback and ev is exception:
         # The exception was actually thrown, so we can get a traceback
         contents = ''.join(traceback.format_exception(et, ev, etb))
     else:
         # We don't have any traceback for it, e.g.
         #   async_err_cb(MyException('Failed to badger the mushroom'))
         # see also https://bugs.freedesktop.org/show_bug.cgi?id=12403
+        # or we have been asked not to send it
         contents = ''.join(traceback.format_exception_only(exception.__class__,
             exception))
-    reply = ErrorMessage(message, name, contents)
 
-    connection.send_message(reply)
+    connection._send_error_reply(message, name, contents)
+
+
+class _MethodInfo(object):
+    """Everything needed to dispatch calls to one exported method, taken
+    from the attributes set by the `dbus.service.method` decorator.
+
+    Not modified after construction.
+    """
+
+    __slots__ = ('function', 'get_args_options', 'out_signature',
+                 'out_count', 'async_callbacks', 'include_traceback',
+                 'message_keywords', 'rel_path_keyword',
+                 'connection_keyword')
+
+    def __init__(self, candidate_method, parent_method):
+        # the function to call, and the one whose decorator applies
+        self.function = candidate_method
+        self.get_args_options = parent_method._dbus_get_args_options
+
+        if parent_method._dbus_out_signature is not None:
+            self.out_signature = Signature(parent_method._dbus_out_signature)
+            self.out_count = len(tuple(self.out_signature))
+        else:
+            self.out_signature = None
+            self.out_count = None
+
+        self.async_callbacks = parent_method._dbus_async_callbacks
+        self.include_traceback = getattr(parent_method,
+                                         '_dbus_include_traceback', None)
+
+        # (keyword, function returning its value given the message)
+        message_keywords = []
+        for keyword, getter in (
+                (parent_method._dbus_sender_keyword,
+                 MethodCallMessage.get_sender),
+                (parent_method._dbus_path_keyword,
+                 MethodCallMessage.get_path),
+                (parent_method._dbus_destination_keyword,
+                 MethodCallMessage.get_destination),
+                (parent_method._dbus_message_keyword,
+                 lambda message: message)):
+            if keyword:
+                message_keywords.append((keyword, getter))
+        self.message_keywords = tuple(message_keywords)
+        self.rel_path_keyword = parent_method._dbus_rel_path_keyword
+        self.connection_keyword = parent_method._dbus_connection_keyword
+
+
+class _InterfaceDescriptor(object):
+    """The methods and introspection data of a class derived from
+    `Interface`, worked out once when the class is created.
+
+    Not modified after construction; `InterfaceType` replaces it with a
+    copy from `without_method` if an attribute of the class is set.
+    """
+
+    __slots__ = ('_methods', 'properties', 'introspection')
+
+    def __init__(self, cls, interface_table, property_table=None):
+        # (interface or None, method name) -> _MethodInfo
+        methods = {}
+        introspection = []
+
+        # interface -> {property name: (signature, access)}
+        if property_table is None:
+            property_table = {}
+        interfaces = list(interface_table)
+        for interface in property_table:
+            if interface not in interface_table:
+                interfaces.append(interface)
+
+        for interface in interfaces:
+            funcs = interface_table.get(interface, {})
+            introspection.append('  <interface name="%s">\n' % interface)
+
+            for (name, (signature, access)) in \
+                    property_table.get(interface, {}).items():
+                introspection.append(
+                    '    <property name="%s" type="%s" access="%s" />\n'
+                    % (name, signature, access))
+
+            for func in funcs.values():
+                if getattr(func, '_dbus_is_method', False):
+                    introspection.append(cls._reflect_on_method(func))
+                    name = func.__name__
+                    for key in ((interface, name), (None, name)):
+                        if key in methods:
+                            continue
+                        try:
+                            found = _class_method_lookup(cls, name, key[0])
+                        except UnknownMethodException:
+                            continue
+                        methods[key] = _MethodInfo(*found)
+                elif getattr(func, '_dbus_is_signal', False):
+                    introspection.append(cls._reflect_on_signal(func))
+
+            introspection.append('  </interface>\n')
+
+        self._methods = methods
+        self.properties = property_table
+        self.introspection = ''.join(introspection)
+
+    def without_method(self, name):
+        """Return a copy of this descriptor which doesn't know how to
+        dispatch calls to methods called name, or self if it already
+        doesn't.
+        """
+        methods = dict((key, info) for key, info in self._methods.items()
+                       if key[1] != name)
+        if len(methods) == len(self._methods):
+            return self
+        copy = object.__new__(self.__class__)
+        copy._methods = methods
+        copy.properties = self.properties
+        copy.introspection = self.introspection
+        return copy
+
+    def get_method(self, obj, interface, name):
+        """Return the _MethodInfo for a call to obj, or raise
+        UnknownMethodException.
+        """
+        try:
+            return self._methods[(interface or None, name)]
+        except KeyError:
+            # not known when the class was created - perhaps added later
+            return _MethodInfo(*_method_lookup(obj, name, interface))
 
 
 class InterfaceType(type):
@@ -303,6 +524,18 @@ class InterfaceType(type):
         # the per-class introspection/interface data
         class_table = getattr(cls, '_dbus_class_table', {})
         cls._dbus_class_table = class_table
+
+        # a subclass which only adds ordinary Python code can share its
+        # base class's tables and descriptor, which saves rebuilding them
+        # for every class in a deep hierarchy
+        base = cls._dbus_reusable_base(bases, dct)
+        if base is not None:
+            class_table[cls.__module__ + '.' + name] = \
+                class_table[base.__module__ + '.' + base.__name__]
+            super(InterfaceType, cls).__init__(name, bases, dct)
+            cls._dbus_descriptor = base._dbus_descriptor
+            return
+
         interface_table = class_table[cls.__module__ + '.' + name] = {}
 
         # merge all the name -> method tables for all the interfaces
@@ -322,6 +555,55 @@ class InterfaceType(type):
 
         super(InterfaceType, cls).__init__(name, bases, dct)
 
+        cls._dbus_descriptor = _InterfaceDescriptor(
+            cls, interface_table, getattr(cls, '_dbus_property_table', None))
+
+    def __setattr__(cls, name, value):
+        super(InterfaceType, cls).__setattr__(name, value)
+        if not name.startswith('_dbus_'):
+            cls._dbus_forget_method(name)
+
+    def __delattr__(cls, name):
+        super(InterfaceType, cls).__delattr__(name)
+        if not name.startswith('_dbus_'):
+            cls._dbus_forget_method(name)
+
+    def _dbus_forget_method(cls, name):
+        """Stop using the descriptors of this class and its subclasses to
+        dispatch calls to methods called name, since they might now be
+        handled by a different function. Such calls go back to walking
+        the MRO with `_method_lookup`.
+        """
+        pending = [cls]
+        while pending:
+            klass = pending.pop()
+            descriptor = klass.__dict__.get('_dbus_descriptor')
+            if descriptor is not None:
+                type.__setattr__(klass, '_dbus_descriptor',
+                                 descriptor.without_method(name))
+            pending.extend(type.__subclasses__(klass))
+
+    def _dbus_reusable_base(cls, bases, dct):
+        """Return the only base class if the class being created exports
+        exactly what it does, or None.
+        """
+        if len(bases) != 1 or '_dbus_property_table' in cls.__dict__:
+            return None
+        base = bases[0]
+        if '_dbus_descriptor' not in getattr(base, '__dict__', ()):
+            return None
+
+        for func in dct.values():
+            if getattr(func, '_dbus_interface', False):
+                return None
+        table = cls._dbus_class_table[base.__module__ + '.' + base.__name__]
+        for method_table in table.values():
+            for method_name in method_table:
+                # overriding an exported method changes the dispatch
+                if method_name in dct:
+                    return None
+        return base
+
     # methods are different to signals, so we have two functions... :)
     def _reflect_on_method(cls, func):
         args = func._dbus_args
@@ -373,7 +655,7 @@ class InterfaceType(type):
 
 # Define Interface as an instance of the metaclass InterfaceType, in a way
 # that is compatible across both Python 2 and Python 3.
-Interface = InterfaceType('Interface', (object,), {})
+Interface = InterfaceType('Interface', (object,), {'__slots__': ()})
 
 
 #: A unique object used as the value of Object._object_path and
@@ -423,6 +705,15 @@ class Object(Interface):
     #: have the same object path on all its connections.
     SUPPORTS_MULTIPLE_CONNECTIONS = False
 
+    #: If True, error replies caused by an exception raised from a method
+    #: include the formatted traceback. If False, they only contain the
+    #: exception's message, which is much cheaper to produce for methods that
+    #: fail often by design. Individual methods can override this with the
+    #: ``include_traceback`` argument to `dbus.service.method`.
+    #:
+    #: :Since: 1.2.1
+    INCLUDE_TRACEBACKS = True
+
     def __init__(self, conn=None, object_path=None, bus_name=None):
         """Constructor. Either conn or bus_name is required; object_path
         is also required.
@@ -553,39 +844,58 @@ class Object(Interface):
             object to be exported in the desired way.
         :Since: 0.82.0
         """
-        if path == LOCAL_PATH:
-            raise ValueError('Objects may not be exported on the reserved '
-                             'path %s' % LOCAL_PATH)
-
         self._locations_lock.acquire()
         try:
-            if (self._connection is not None and
-                self._connection is not connection and
-                not self.SUPPORTS_MULTIPLE_CONNECTIONS):
-                raise ValueError('%r is already exported on '
-                                 'connection %r' % (self, self._connection))
-
-            if (self._object_path is not None and
-                not self.SUPPORTS_MULTIPLE_OBJECT_PATHS and
-                self._object_path != path):
-                raise ValueError('%r is already exported at object '
-                                 'path %s' % (self, self._object_path))
-
+            self._dbus_export_entry(connection, path)
             connection._register_object_path(path, self._message_cb,
                                              self._unregister_cb,
                                              self._fallback)
+            self._dbus_exported(connection, path)
+        finally:
+            self._locations_lock.release()
 
-            if self._connection is None:
-                self._connection = connection
-            elif self._connection is not connection:
-                self._connection = _MANY
+    def _dbus_export_entry(self, connection, path):
+        # Raise ValueError if this object can't be exported at path on
+        # connection, or return the entry to register there with
+        # Connection._register_object_paths
+        if path == LOCAL_PATH:
+            raise ValueError('Objects may not be exported on the reserved '
+                             'path %s' % LOCAL_PATH)
+
+        if (self._connection is not None and
+            self._connection is not connection and
+            not self.SUPPORTS_MULTIPLE_CONNECTIONS):
+            raise ValueError('%r is already exported on '
+                             'connection %r' % (self, self._connection))
+
+        if (self._object_path is not None and
+            not self.SUPPORTS_MULTIPLE_OBJECT_PATHS and
+            self._object_path != path):
+            raise ValueError('%r is already exported at object '
+                             'path %s' % (self, self._object_path))
+
+        return (path, (self._unregister_cb, self._message_cb), self._fallback)
+
+    def _dbus_exported(self, connection, path):
+        # Record that this object has been exported at path on connection
+        if self._connection is None:
+            self._connection = connection
+        elif self._connection is not connection:
+            self._connection = _MANY
 
-            if self._object_path is None:
-                self._object_path = path
-            elif self._object_path != path:
-                self._object_path = _MANY
+        if self._object_path is None:
+            self._object_path = path
+        elif self._object_path != path:
+            self._object_path = _MANY
 
-            self._locations.append((connection, path, self._fallback))
+        self._locations.append((connection, path, self._fallback))
+
+    def _dbus_unexported(self, connection):
+        # Record that this object is no longer exported on connection
+        self._locations_lock.acquire()
+        try:
+            self._locations = [location for location in self._locations
+                               if location[0] is not connection]
         finally:
             self._locations_lock.release()
 
@@ -647,36 +957,34 @@ class Object(Interface):
         if not isinstance(message, MethodCallMessage):
             return
 
+        include_traceback = self.INCLUDE_TRACEBACKS
         try:
-            # lookup candidate method and parent method
+            # look up the method and how to call it
             method_name = message.get_member()
             interface_name = message.get_interface()
-            (candidate_method, parent_method) = _method_lookup(self, method_name, interface_name)
+            info = self._dbus_descriptor.get_method(self, interface_name,
+                                                    method_name)
+            if info.include_traceback is not None:
+                include_traceback = info.include_traceback
 
             # set up method call parameters
-            args = message.get_args_list(**parent_method._dbus_get_args_options)
+            args = message.get_args_list(**info.get_args_options)
             keywords = {}
-
-            if parent_method._dbus_out_signature is not None:
-                signature = Signature(parent_method._dbus_out_signature)
-            else:
-                signature = None
+            signature = info.out_signature
 
             # set up async callback functions
-            if parent_method._dbus_async_callbacks:
-                (return_callback, error_callback) = parent_method._dbus_async_callbacks
+            if info.async_callbacks:
+                (return_callback, error_callback) = info.async_callbacks
                 keywords[return_callback] = lambda *retval: _method_reply_return(connection, message, method_name, signature, *retval)
-                keywords[error_callback] = lambda exception: _method_reply_error(connection, message, exception)
+                keywords[error_callback] = lambda exception: _method_reply_error(connection, message, exception, include_traceback)
 
             # include the sender etc. if desired
-            if parent_method._dbus_sender_keyword:
-                keywords[parent_method._dbus_sender_keyword] = message.get_sender()
-            if parent_method._dbus_path_keyword:
-                keywords[parent_method._dbus_path_keyword] = message.get_path()
-            if parent_method._dbus_rel_path_keyword:
+            for (keyword, getter) in info.message_keywords:
+                keywords[keyword] = getter(message)
+            if info.rel_path_keyword:
                 path = message.get_path()
                 rel_path = path
-                for exp in self._locations:
+                for exp in self.locations:
                     # pathological case: if we're exported in two places,
                     # one of which is a subtree of the other, then pick the
                     # subtree by preference (i.e. minimize the length of
@@ -694,37 +1002,37 @@ class Object(Interface):
                             if len(suffix) < len(rel_path):
                                 rel_path = suffix
                 rel_path = ObjectPath(rel_path)
-                keywords[parent_method._dbus_rel_path_keyword] = rel_path
-
-            if parent_method._dbus_destination_keyword:
-                keywords[parent_method._dbus_destination_keyword] = message.get_destination()
-            if parent_method._dbus_message_keyword:
-                keywords[parent_method._dbus_message_keyword] = message
-            if parent_method._dbus_connection_keyword:
-                keywords[parent_method._dbus_connection_keyword] = connection
+                keywords[info.rel_path_keyword] = rel_path
+            if info.connection_keyword:
+                keywords[info.connection_keyword] = connection
 
             # call method
-            retval = candidate_method(self, *args, **keywords)
+            retval = info.function(self, *args, **keywords)
 
             # we're done - the method has got callback functions to reply with
-            if parent_method._dbus_async_callbacks:
+            if info.async_callbacks:
                 return
 
+            # a reply built by the method, or a generator of the return
+            # values, is handled by _method_reply_return
+            if (isinstance(retval, MethodReturnMessage) or
+                (isgenerator(retval) and _is_streamed(signature))):
+                retval = (retval,)
+
             # otherwise we send the return values in a reply. if we have a
             # signature, use it to turn the return value into a tuple as
             # appropriate
-            if signature is not None:
-                signature_tuple = tuple(signature)
+            elif signature is not None:
                 # if we have zero or one return values we want make a tuple
                 # for the _method_reply_return function, otherwise we need
                 # to check we're passing it a sequence
-                if len(signature_tuple) == 0:
+                if info.out_count == 0:
                     if retval == None:
                         retval = ()
                     else:
                         raise TypeError('%s has an empty output signature but did not return None' %
                             method_name)
-                elif len(signature_tuple) == 1:
+                elif info.out_count == 1:
                     retval = (retval,)
                 else:
                     if isinstance(retval, Sequence):
@@ -751,7 +1059,8 @@ class Object(Interface):
             _method_reply_return(connection, message, method_name, signature, *retval)
         except Exception as exception:
             # send error reply
-            _method_reply_error(connection, message, exception)
+            _method_reply_error(connection, message, exception,
+                                include_traceback)
 
     @method(INTROSPECTABLE_IFACE, in_signature='', out_signature='s',
             path_keyword='object_path', connection_keyword='connection')
@@ -762,17 +1071,7 @@ class Object(Interface):
         reflection_data = _dbus_bindings.DBUS_INTROSPECT_1_0_XML_DOCTYPE_DECL_NODE
         reflection_data += '<node name="%s">\n' % object_path
 
-        interfaces = self._dbus_class_table[self.__class__.__module__ + '.' + self.__class__.__name__]
-        for (name, funcs) in interfaces.items():
-            reflection_data += '  <interface name="%s">\n' % (name)
-
-            for func in funcs.values():
-                if getattr(func, '_dbus_is_method', False):
-                    reflection_data += self.__class__._reflect_on_method(func)
-                elif getattr(func, '_dbus_is_signal', False):
-                    reflection_data += self.__class__._reflect_on_signal(func)
-
-            reflection_data += '  </interface>\n'
+        reflection_data += self._dbus_descriptor.introspection
 
         for name in connection.list_exported_child_objects(object_path):
             reflection_data += '  <node name="%s"/>\n' % name
@@ -833,3 +1132,126 @@ class FallbackObject(Object):
             raise TypeError('If conn is given, object_path is required')
         else:
             self.add_to_connection(conn, object_path)
+
+
+class LightweightObject(Interface):
+    """A base class for exported objects that uses much less memory per
+    instance than `Object`, for applications exporting very many objects.
+
+    Methods and signals are declared as for `Object`. The differences are:
+
+    * instances have no ``__dict__``, so subclasses should list any
+      attributes they add in ``__slots__``
+    * an instance can be exported at only one object path on one
+      connection, and does not keep a `BusName` alive
+    * the connection records the instance itself as the handler for its
+      object path, and dispatches calls via a method shared by the class,
+      rather than holding callbacks bound to each instance
+    * there is no lock: `add_to_connection` and `remove_from_connection`
+      must not be called for the same instance from more than one thread
+      at a time
+
+    :Since: 1.2.1
+    """
+
+    __slots__ = ('_connection', '_object_path', '__weakref__')
+
+    SUPPORTS_MULTIPLE_OBJECT_PATHS = False
+    SUPPORTS_MULTIPLE_CONNECTIONS = False
+    INCLUDE_TRACEBACKS = True
+
+    _fallback = False
+
+    def __init__(self, conn=None, object_path=None):
+        """Constructor.
+
+        :Parameters:
+            `conn` : dbus.connection.Connection or None
+                The connection on which to export this object. If this is not
+                None, an `object_path` must also be provided.
+            `object_path` : str or None
+                A D-Bus object path at which to make this object available
+                immediately. If this is not None, a `conn` must also be
+                provided.
+        """
+        self._connection = None
+        self._object_path = None
+
+        if conn is None:
+            if object_path is not None:
+                raise TypeError('If object_path is given, conn is required')
+        elif object_path is None:
+            raise TypeError('If conn is given, object_path is required')
+        else:
+            self.add_to_connection(conn, object_path)
+
+    __dbus_object_path__ = Object.__dict__['__dbus_object_path__']
+    connection = Object.__dict__['connection']
+
+    @property
+    def locations(self):
+        """An iterable over tuples representing locations at which this
+        object is available, as for `Object.locations`.
+        """
+        if self._connection is None:
+            return iter(())
+        return iter(((self._connection, self._object_path, self._fallback),))
+
+    def add_to_connection(self, connection, path):
+        """Make this object accessible via the given D-Bus connection and
+        object path.
+
+        :Raises ValueError: if the object is already exported.
+        """
+        self._dbus_export_entry(connection, path)
+        connection._register_object(path, self, self._fallback)
+        self._dbus_exported(connection, path)
+
+    def _dbus_export_entry(self, connection, path):
+        if path == LOCAL_PATH:
+            raise ValueError('Objects may not be exported on the reserved '
+                             'path %s' % LOCAL_PATH)
+
+        if self._connection is not None:
+            raise ValueError('%r is already exported at object path %s on '
+                             'connection %r' % (self, self._object_path,
+                                                self._connection))
+
+        return (path, self, self._fallback)
+
+    def _dbus_exported(self, connection, path):
+        self._connection = connection
+        self._object_path = path
+
+    def _dbus_unexported(self, connection):
+        self._connection = None
+        self._object_path = None
+
+    def remove_from_connection(self, connection=None, path=None):
+        """Make this object inaccessible via the given D-Bus connection
+        and object path, as for `Object.remove_from_connection`.
+
+        :Raises LookupError:
+            if the object was not exported on the requested connection
+            or path, or (if both are None) was not exported at all.
+        """
+        if self._connection is None:
+            raise LookupError('%r is not exported' % self)
+        if ((connection is not None and connection is not self._connection)
+            or (path is not None and path != self._object_path)):
+            raise LookupError('%r is not exported at a location matching '
+                              '(%r,%r)' % (self, connection, path))
+
+        connection = self._connection
+        path = self._object_path
+        self._connection = None
+        self._object_path = None
+        try:
+            connection._unregister_object_path(path)
+        except LookupError:
+            pass
+
+    _dbus_message_cb = Object.__dict__['_message_cb']
+    Introspect = Object.__dict__['Introspect']
+    __repr__ = Object.__dict__['__repr__']
+    __str__ = __repr__
@@ -1,12 +1,12 @@
 __all__ = ['ObjectPath', 'ByteArray', 'Signature', 'Byte', 'Boolean',
            'Int16', 'UInt16', 'Int32', 'UInt32', 'Int64', 'UInt64',
-           'Double', 'String', 'Array', 'Struct', 'Dictionary',
-           'UnixFd']
+           'Double', 'String', 'Array', 'Struct', 'Dictionary', 'VarDict',
+           'UnixFd', 'register_struct_class']
 
 from _dbus_bindings import (
     Array, Boolean, Byte, ByteArray, Dictionary, Double, Int16, Int32, Int64,
     ObjectPath, Signature, String, Struct, UInt16, UInt32, UInt64,
-    UnixFd)
+    UnixFd, VarDict, register_struct_class)
 
 from dbus._compat import is_py2
 if is_py2:
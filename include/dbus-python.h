@@ -1,5 +1,6 @@
-/* C API for _dbus_bindings, used by _dbus_glib_bindings and any third-party
- * main loop integration which might happen in future.
+/* C API for _dbus_bindings, used by _dbus_glib_bindings, any third-party
+ * main loop integration which might happen in future, and extensions
+ * which marshal and dispatch messages in native code.
  *
  * This file is currently Python-version-independent - please keep it that way.
  *
@@ -44,8 +45,21 @@ typedef void (*_dbus_py_func_ptr)(void);
 typedef dbus_bool_t (*_dbus_py_conn_setup_func)(DBusConnection *, void *);
 typedef dbus_bool_t (*_dbus_py_srv_setup_func)(DBusServer *, void *);
 typedef void (*_dbus_py_free_func)(void *);
-
-#define DBUS_BINDINGS_API_COUNT 3
+/* Called with the GIL held, with the Connection and the message; may set
+ * a Python exception, in which case the result is ignored */
+typedef DBusHandlerResult (*_dbus_py_message_handler_func)(PyObject *,
+                                                           DBusMessage *,
+                                                           void *);
+
+/* Flags for DBusPyMessageIter_GetArgs, like the keyword arguments of
+ * Message.get_args_list */
+#define DBUS_PY_GET_ARGS_BYTE_ARRAYS        (1 << 0)
+/* ignored on Python 3 */
+#define DBUS_PY_GET_ARGS_UTF8_STRINGS       (1 << 1)
+#define DBUS_PY_GET_ARGS_STRUCT_COLUMNS     (1 << 2)
+#define DBUS_PY_GET_ARGS_VARDICTS           (1 << 3)
+
+#define DBUS_BINDINGS_API_COUNT 13
 
 #ifdef INSIDE_DBUS_PYTHON_BINDINGS
 
@@ -54,6 +68,20 @@ extern PyObject *DBusPyNativeMainLoop_New4(_dbus_py_conn_setup_func,
                                            _dbus_py_srv_setup_func,
                                            _dbus_py_free_func,
                                            void *);
+extern DBusMessage *DBusPyMessage_BorrowDBusMessage(PyObject *);
+extern PyObject *DBusPyMessage_ConsumeDBusMessage(DBusMessage *);
+extern int DBusPyMessageIter_AppendArgs(DBusMessageIter *, const char *,
+                                        PyObject *);
+extern PyObject *DBusPyMessageIter_GetArgs(DBusMessageIter *, int);
+extern PyObject *DBusPyNativeMessageHandler_New(
+    _dbus_py_message_handler_func, _dbus_py_free_func, void *);
+extern int DBusPyConnection_RegisterObjectPath(PyObject *, const char *,
+                                               PyObject *, int);
+extern int DBusPyConnection_UnregisterObjectPath(PyObject *, const char *);
+extern int DBusPyConnection_AddMessageFilter(PyObject *, PyObject *);
+extern int DBusPyConnection_RemoveMessageFilter(PyObject *, PyObject *);
+extern int DBusPyConnection_SendMessage(PyObject *, DBusMessage *,
+                                        dbus_uint32_t *);
 
 #else
 
@@ -66,6 +94,54 @@ static _dbus_py_func_ptr *dbus_bindings_API;
     ((PyObject *(*)(_dbus_py_conn_setup_func, _dbus_py_srv_setup_func, \
                     _dbus_py_free_func, void *))dbus_bindings_API[2])
 
+/* Return a borrowed reference to the DBusMessage underlying a
+ * dbus.lowlevel.Message, or NULL with an exception set; the Message keeps
+ * the same DBusMessage from then on, so the pointer stays valid for as
+ * long as the Message does */
+#define DBusPyMessage_BorrowDBusMessage \
+    (*(DBusMessage *(*)(PyObject *))dbus_bindings_API[3])
+/* Wrap a DBusMessage in a new dbus.lowlevel.Message of the appropriate
+ * subclass, stealing the caller's reference to it even on failure */
+#define DBusPyMessage_ConsumeDBusMessage \
+    (*(PyObject *(*)(DBusMessage *))dbus_bindings_API[4])
+/* Append the items of a sequence to an iterator, one for each complete type
+ * in the signature; return 0, or -1 with an exception set, after which the
+ * message must be discarded since some items might have been appended */
+#define DBusPyMessageIter_AppendArgs \
+    (*(int (*)(DBusMessageIter *, const char *, PyObject *)) \
+        dbus_bindings_API[5])
+/* Return a new list of the values from the iterator to the end of its
+ * container or message, as for Message.get_args_list; flags are
+ * DBUS_PY_GET_ARGS_... */
+#define DBusPyMessageIter_GetArgs \
+    (*(PyObject *(*)(DBusMessageIter *, int))dbus_bindings_API[6])
+/* Return a new handler object which calls the function, for the functions
+ * below or Connection methods which take a callable handler. Messages
+ * are given to it without being wrapped in a dbus.lowlevel.Message */
+#define DBusPyNativeMessageHandler_New \
+    ((PyObject *(*)(_dbus_py_message_handler_func, _dbus_py_free_func, \
+                    void *))dbus_bindings_API[7])
+/* As Connection._register_object_path(path, on_message, fallback=...) */
+#define DBusPyConnection_RegisterObjectPath \
+    (*(int (*)(PyObject *, const char *, PyObject *, int)) \
+        dbus_bindings_API[8])
+/* As Connection._unregister_object_path(path) */
+#define DBusPyConnection_UnregisterObjectPath \
+    (*(int (*)(PyObject *, const char *))dbus_bindings_API[9])
+/* As Connection.add_message_filter(filter) */
+#define DBusPyConnection_AddMessageFilter \
+    (*(int (*)(PyObject *, PyObject *))dbus_bindings_API[10])
+/* As Connection.remove_message_filter(filter) */
+#define DBusPyConnection_RemoveMessageFilter \
+    (*(int (*)(PyObject *, PyObject *))dbus_bindings_API[11])
+/* As Connection.send_message(msg), putting the serial in the last
+ * argument if it's not NULL; return 0, or -1 with an exception set.
+ * Native handlers should send their replies with this, so that the
+ * connection's sender limits know the call is finished */
+#define DBusPyConnection_SendMessage \
+    (*(int (*)(PyObject *, DBusMessage *, dbus_uint32_t *)) \
+        dbus_bindings_API[12])
+
 static int
 import_dbus_bindings(const char *this_module_name)
 {
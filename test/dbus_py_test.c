@@ -111,9 +111,201 @@ UnusableMainLoop (PyObject *always_null UNUSED, PyObject *args, PyObject *kwargs
     return mainloop;
 }
 
+static PyObject *
+new_message_with_args(PyObject *always_null UNUSED, PyObject *args)
+{
+    const char *signature;
+    PyObject *items;
+    DBusMessage *msg;
+    DBusMessageIter iter;
+
+    if (!PyArg_ParseTuple(args, "sO:new_message_with_args", &signature,
+                          &items)) {
+        return NULL;
+    }
+    msg = dbus_message_new_method_call(NULL, "/", "com.example", "Test");
+    if (!msg) return PyErr_NoMemory();
+    dbus_message_iter_init_append(msg, &iter);
+    if (DBusPyMessageIter_AppendArgs(&iter, signature, items) < 0) {
+        dbus_message_unref(msg);
+        return NULL;
+    }
+    return DBusPyMessage_ConsumeDBusMessage(msg);
+}
+
+static PyObject *
+get_args(PyObject *always_null UNUSED, PyObject *args, PyObject *kwargs)
+{
+    PyObject *message;
+    DBusMessage *msg;
+    DBusMessageIter iter;
+    int byte_arrays = 0, struct_columns = 0, vardicts = 0;
+    int flags = 0;
+    static char *argnames[] = {"message", "byte_arrays", "struct_columns",
+                               "vardicts", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|iii:get_args",
+                                     argnames, &message, &byte_arrays,
+                                     &struct_columns, &vardicts)) {
+        return NULL;
+    }
+    msg = DBusPyMessage_BorrowDBusMessage(message);
+    if (!msg) return NULL;
+    if (byte_arrays) flags |= DBUS_PY_GET_ARGS_BYTE_ARRAYS;
+    if (struct_columns) flags |= DBUS_PY_GET_ARGS_STRUCT_COLUMNS;
+    if (vardicts) flags |= DBUS_PY_GET_ARGS_VARDICTS;
+    if (!dbus_message_iter_init(msg, &iter)) return PyList_New(0);
+    return DBusPyMessageIter_GetArgs(&iter, flags);
+}
+
+/* Reply to method calls with their own arguments, without going through
+ * dbus.lowlevel.Message */
+static DBusHandlerResult
+dbus_py_test_echo(PyObject *conn, DBusMessage *msg, void *data UNUSED)
+{
+    DBusMessage *reply;
+    DBusMessageIter iter;
+    PyObject *list;
+    const char *signature = dbus_message_get_signature(msg);
+    int status = -1;
+
+    if (dbus_message_get_type(msg) != DBUS_MESSAGE_TYPE_METHOD_CALL)
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+    reply = dbus_message_new_method_return(msg);
+    if (!reply) return DBUS_HANDLER_RESULT_NEED_MEMORY;
+
+    list = PyList_New(0);
+    if (list && dbus_message_iter_init(msg, &iter)) {
+        Py_CLEAR(list);
+        list = DBusPyMessageIter_GetArgs(&iter, 0);
+    }
+    if (list) {
+        dbus_message_iter_init_append(reply, &iter);
+        status = DBusPyMessageIter_AppendArgs(&iter, signature, list);
+        Py_CLEAR(list);
+    }
+    if (status == 0)
+        status = DBusPyConnection_SendMessage(conn, reply, NULL);
+    dbus_message_unref(reply);
+    return (status == 0 ? DBUS_HANDLER_RESULT_HANDLED
+                        : DBUS_HANDLER_RESULT_NOT_YET_HANDLED);
+}
+
+static PyObject *
+EchoHandler(PyObject *always_null UNUSED, PyObject *args UNUSED)
+{
+    return DBusPyNativeMessageHandler_New(dbus_py_test_echo, NULL, NULL);
+}
+
+/* Append each message, wrapped in a dbus.lowlevel.Message, to a list */
+static DBusHandlerResult
+dbus_py_test_record(PyObject *conn UNUSED, DBusMessage *msg, void *data)
+{
+    PyObject *message;
+
+    dbus_message_ref(msg);
+    message = DBusPyMessage_ConsumeDBusMessage(msg);
+    if (message) {
+        PyList_Append((PyObject *)data, message);
+        Py_CLEAR(message);
+    }
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static void
+dbus_py_test_decref(void *data)
+{
+    Py_DECREF((PyObject *)data);
+}
+
+static PyObject *
+RecordingHandler(PyObject *always_null UNUSED, PyObject *list)
+{
+    PyObject *handler;
+
+    if (!PyList_Check(list)) {
+        PyErr_SetString(PyExc_TypeError, "RecordingHandler needs a list");
+        return NULL;
+    }
+    Py_INCREF(list);
+    handler = DBusPyNativeMessageHandler_New(dbus_py_test_record,
+                                             dbus_py_test_decref, list);
+    if (!handler) Py_CLEAR(list);
+    return handler;
+}
+
+static PyObject *
+register_object_path(PyObject *always_null UNUSED, PyObject *args)
+{
+    PyObject *conn, *handler;
+    const char *path;
+    int fallback = 0;
+
+    if (!PyArg_ParseTuple(args, "OsO|i:register_object_path", &conn, &path,
+                          &handler, &fallback)) {
+        return NULL;
+    }
+    if (DBusPyConnection_RegisterObjectPath(conn, path, handler,
+                                            fallback) < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+unregister_object_path(PyObject *always_null UNUSED, PyObject *args)
+{
+    PyObject *conn;
+    const char *path;
+
+    if (!PyArg_ParseTuple(args, "Os:unregister_object_path", &conn, &path))
+        return NULL;
+    if (DBusPyConnection_UnregisterObjectPath(conn, path) < 0) return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+add_message_filter(PyObject *always_null UNUSED, PyObject *args)
+{
+    PyObject *conn, *handler;
+
+    if (!PyArg_ParseTuple(args, "OO:add_message_filter", &conn, &handler))
+        return NULL;
+    if (DBusPyConnection_AddMessageFilter(conn, handler) < 0) return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+remove_message_filter(PyObject *always_null UNUSED, PyObject *args)
+{
+    PyObject *conn, *handler;
+
+    if (!PyArg_ParseTuple(args, "OO:remove_message_filter", &conn, &handler))
+        return NULL;
+    if (DBusPyConnection_RemoveMessageFilter(conn, handler) < 0) return NULL;
+    Py_RETURN_NONE;
+}
+
 static PyMethodDef module_functions[] = {
     {"UnusableMainLoop", (PyCFunction)UnusableMainLoop,
      METH_VARARGS|METH_KEYWORDS, "Return a main loop that fails to attach"},
+    {"new_message_with_args", new_message_with_args, METH_VARARGS,
+     "Return a method call with the arguments appended from C"},
+    {"get_args", (PyCFunction)get_args, METH_VARARGS|METH_KEYWORDS,
+     "Return a message's arguments, decoded from C"},
+    {"EchoHandler", EchoHandler, METH_NOARGS,
+     "Return a native handler which replies with the call's arguments"},
+    {"RecordingHandler", RecordingHandler, METH_O,
+     "Return a native handler which appends each message to a list"},
+    {"register_object_path", register_object_path, METH_VARARGS,
+     "Register a handler for an object path from C"},
+    {"unregister_object_path", unregister_object_path, METH_VARARGS,
+     "Unregister an object path from C"},
+    {"add_message_filter", add_message_filter, METH_VARARGS,
+     "Add a message filter from C"},
+    {"remove_message_filter", remove_message_filter, METH_VARARGS,
+     "Remove a message filter from C"},
     {NULL, NULL, 0, NULL}
 };
 
@@ -89,6 +89,41 @@ class TestDBusBindings(unittest.TestCase):
         remote_gobject.Introspect(dbus_interface=dbus.INTROSPECTABLE_IFACE)
         print("method call, ", end='')
         self.assertEqual(iface.Echo('123'), '123')
+        print("properties, ", end='')
+        props = dbus.Interface(remote_gobject, dbus.PROPERTIES_IFACE)
+        self.assertEqual(props.GetAll(IFACE), {'Count': 0, 'Label': 'test'})
+
+        # each method call's changes are announced by one signal
+        loop = gobject.MainLoop()
+        changes = []
+        def changed(interface, changed_properties, invalidated_properties):
+            changes.append((interface, changed_properties))
+            loop.quit()
+        match = remote_gobject.connect_to_signal(
+            'PropertiesChanged', changed, dbus_interface=dbus.PROPERTIES_IFACE)
+
+        props.Set(IFACE, 'Count', dbus.UInt32(5))
+        loop.run()
+        count = props.Get(IFACE, 'Count')
+        self.assertEqual(count, 5)
+        self.assertTrue(isinstance(count, dbus.UInt32))
+        for (name, value, error) in (
+                ('Label', 'changed', 'PropertyReadOnly'),
+                ('Count', dbus.Int32(6), 'InvalidArgs'),
+                ('Count', 'six', 'InvalidArgs')):
+            try:
+                props.Set(IFACE, name, value)
+            except dbus.DBusException as e:
+                self.assertEqual(e.get_dbus_name(),
+                                 'org.freedesktop.DBus.Error.' + error)
+            else:
+                self.fail('Set should have failed')
+
+        iface.IncrementCount(dbus.UInt32(3))
+        loop.run()
+        match.remove()
+        self.assertEqual(changes, [(IFACE, {'Count': 5}),
+                                   (IFACE, {'Count': 8})])
         print("... OK")
 
     def testWeakRefs(self):
@@ -100,6 +135,71 @@ class TestDBusBindings(unittest.TestCase):
         del bus
         self.assertTrue(ref() is None)
 
+    def testFork(self):
+        from dbus.bus import ConnectionRecipe
+
+        fork_name = 'org.freedesktop.DBus.TestSuiteForkName'
+        recipe = ConnectionRecipe()
+        recipe.request_name(fork_name)
+        recipe.add_match_string("type='signal',interface='%s'" % IFACE)
+        bus = dbus.SessionBus(recipe=recipe)
+        self.assertTrue(bus is self.bus)
+        parent_name = bus.get_unique_name()
+        self.assertEqual(bus.get_name_owner(fork_name), parent_name)
+        # passing the same recipe again doesn't apply it again
+        self.assertTrue(dbus.SessionBus(recipe=recipe) is bus)
+        self.assertEqual(
+            dbus.SessionBus._recipes[dbus.BUS_SESSION].count(recipe), 1)
+
+        (r, w) = os.pipe()
+        pid = os.fork()
+        if pid == 0:
+            try:
+                os.close(r)
+                # the shared connection was replaced, and the new one
+                # queued for the name behind the parent
+                child_bus = dbus.SessionBus()
+                child_name = child_bus.get_unique_name()
+                owners = child_bus.call_blocking(
+                    dbus.BUS_DAEMON_NAME, dbus.BUS_DAEMON_PATH,
+                    dbus.BUS_DAEMON_IFACE, 'ListQueuedOwners', 's',
+                    (fork_name,))
+                if (child_bus is not bus and
+                    not bus.get_is_connected() and
+                    owners == [parent_name, child_name]):
+                    os.write(w, b'ok')
+            finally:
+                os._exit(0)
+
+        os.close(w)
+        result = os.read(r, 100)
+        os.close(r)
+        os.waitpid(pid, 0)
+        self.assertEqual(result, b'ok')
+
+        # the parent's connection is unaffected
+        self.assertTrue(dbus.SessionBus() is bus)
+        self.assertEqual(bus.get_name_owner(fork_name), parent_name)
+        self.assertEqual(self.iface.Echo('fork'), 'fork')
+        bus.release_name(fork_name)
+
+    def testRecipeSignalReceiver(self):
+        from dbus.bus import ConnectionRecipe
+
+        loop = gobject.MainLoop()
+        received = []
+        def handler(value):
+            received.append(value)
+            loop.quit()
+        recipe = ConnectionRecipe()
+        recipe.add_signal_receiver(handler, 'SignalOneString', IFACE, NAME,
+                                   OBJECT)
+        private = recipe.connect()
+        self.iface.EmitSignal('SignalOneString', 0)
+        loop.run()
+        self.assertEqual(len(received), 1)
+        private.close()
+
     def testInterfaceKeyword(self):
         #test dbus_interface parameter
         print(self.remote_object.Echo("dbus_interface on Proxy test Passed", 
@@ -189,6 +289,385 @@ class TestDBusBindings(unittest.TestCase):
         print("Delta: %f" % (b - a))
         self.assertTrue(True)
 
+    def testBenchmarkDirectEncoding(self):
+        print("\n********* Benchmark direct encoding ************")
+        from dbus.lowlevel import MethodCallMessage
+
+        def make_call():
+            return MethodCallMessage(NAME, OBJECT, IFACE, 'Echo')
+
+        for send_val in test_types_vals:
+            for signature in (None, 'v'):
+                kwargs = {}
+                if signature is not None:
+                    kwargs['signature'] = signature
+                iterated = make_call()
+                iterated.append(send_val, **kwargs)
+                direct = make_call()
+                direct.append(send_val, direct=True, **kwargs)
+                self.assertEqual(direct.marshal(), iterated.marshal())
+
+        n = 50000
+        send_val = [('item %d' % i, i, i * 0.5, {'n': i}) for i in range(n)]
+        for direct in (False, True):
+            message = make_call()
+            a = time.time()
+            message.append(send_val, signature='a(sida{sv})', direct=direct)
+            b = time.time()
+            print("Appending %d structs (direct=%r): %f" % (n, direct, b - a))
+            if direct:
+                self.assertEqual(message.marshal(), iterated)
+            iterated = message.marshal()
+
+        reply = self.bus.send_message_with_reply_and_block(message)
+        self.assertEqual(reply.get_args_list()[0][n - 1],
+                         ('item %d' % (n - 1), n - 1, (n - 1) * 0.5,
+                          {'n': n - 1}))
+
+    def testBenchmarkDirectDecoding(self):
+        print("\n********* Benchmark direct decoding ************")
+        from dbus.lowlevel import MethodCallMessage
+
+        def echo(value, signature=None):
+            message = MethodCallMessage(NAME, OBJECT, IFACE, 'Echo')
+            if signature is None:
+                message.append(value)
+            else:
+                message.append(value, signature=signature)
+            return self.bus.send_message_with_reply_and_block(message)
+
+        for send_val in test_types_vals:
+            reply = echo(send_val)
+            self.assertEqual(reply.get_args_list(direct=True),
+                             reply.get_args_list())
+
+        n = 20000
+        for (send_val, signature) in (
+                (dict(('key %d' % i, {'n': i, 's': 'x', 'a': [i, i + 1]})
+                      for i in range(n)), 'a{sa{sv}}'),
+                ([('item %d' % i, [(i, i + 1)] * 4) for i in range(n)],
+                 'a(sa(ii))')):
+            reply = echo(send_val, signature)
+            results = []
+            for direct in (False, True):
+                a = time.time()
+                results.append(reply.get_args_list(direct=direct))
+                b = time.time()
+                print("Decoding %d x %s (direct=%r): %f"
+                      % (n, signature, direct, b - a))
+            self.assertEqual(results[1], results[0])
+
+    def testBenchmarkAppendStrings(self):
+        print("\n********* Benchmark appending 100000 strings ************")
+        from dbus.lowlevel import MethodCallMessage
+
+        n = 100000
+        non_ascii = b' caf\xc3\xa9 \xe2\x98\x83'.decode('utf-8')
+        for (kind, send_val) in (
+                ('ASCII', ['org.freedesktop.Example%d' % i for i in range(n)]),
+                ('non-ASCII', ['%d' % i + non_ascii for i in range(n)])):
+            for direct in (False, True):
+                message = MethodCallMessage(NAME, OBJECT, IFACE, 'Echo')
+                a = time.time()
+                message.append(send_val, signature='as', direct=direct)
+                b = time.time()
+                print("Appending %d %s strings (direct=%r): %f"
+                      % (n, kind, direct, b - a))
+            reply = self.bus.send_message_with_reply_and_block(message)
+            self.assertEqual(reply.get_args_list()[0], send_val)
+
+    def testBenchmarkPendingCalls(self):
+        print("\n********* Benchmark 10000 pending calls ************")
+        loop = gobject.MainLoop()
+        n = 10000
+        replies = []
+        errors = []
+        def done():
+            if len(replies) + len(errors) >= n:
+                loop.quit()
+        def replied(value):
+            replies.append(value)
+            done()
+        def failed(e):
+            errors.append(e)
+            done()
+        a = time.time()
+        for i in range(n):
+            self.iface.Echo(i, reply_handler=replied, error_handler=failed,
+                            timeout=60.0)
+        b = time.time()
+        loop.run()
+        c = time.time()
+        print("Sending: %f" % (b - a))
+        print("Delta: %f" % (c - a))
+        self.assertEqual(errors, [])
+        self.assertEqual(sorted(replies), list(range(n)))
+
+    def testBenchmarkLightweightObjects(self):
+        print("\n********* Benchmark 20000 exported objects ************")
+        service_bus = dbus.SessionBus(private=True)
+        class Heavy(dbus.service.Object):
+            @dbus.service.method(IFACE, in_signature='', out_signature='s')
+            def WhoAmI(self):
+                return self.__dbus_object_path__
+        class Light(dbus.service.LightweightObject):
+            __slots__ = ()
+            @dbus.service.method(IFACE, in_signature='', out_signature='s')
+            def WhoAmI(self):
+                return self.__dbus_object_path__
+
+        try:
+            import tracemalloc
+        except ImportError:
+            tracemalloc = None
+        n = 20000
+        for cls in (Heavy, Light):
+            if tracemalloc is not None:
+                tracemalloc.start()
+            a = time.time()
+            objs = [cls(service_bus, '/%s/%d' % (cls.__name__, i))
+                    for i in range(n)]
+            b = time.time()
+            print("%s: exporting: %f" % (cls.__name__, b - a))
+            if tracemalloc is not None:
+                print("%s: %d bytes per object" % (
+                    cls.__name__, tracemalloc.get_traced_memory()[0] // n))
+                tracemalloc.stop()
+            del objs[1:]
+
+        self.assertFalse(hasattr(objs[0], '__dict__'))
+        loop = gobject.MainLoop()
+        results = []
+        def done(result):
+            results.append(result)
+            loop.quit()
+        proxy = self.bus.get_object(service_bus.get_unique_name(), '/Light/0',
+                                    introspect=False)
+        proxy.WhoAmI(dbus_interface=IFACE, reply_handler=done,
+                     error_handler=done)
+        loop.run()
+        self.assertEqual(results, ['/Light/0'])
+
+        objs[0].remove_from_connection()
+        self.assertRaises(LookupError, objs[0].remove_from_connection)
+        service_bus.close()
+
+    def testNativeHandlers(self):
+        import dbus_py_test
+
+        service_bus = dbus.SessionBus(private=True)
+        echo = dbus_py_test.EchoHandler()
+        recorded = []
+        recorder = dbus_py_test.RecordingHandler(recorded)
+        dbus_py_test.register_object_path(service_bus, '/Native', echo)
+        dbus_py_test.add_message_filter(service_bus, recorder)
+        self.assertRaises(KeyError, dbus_py_test.register_object_path,
+                          service_bus, '/Native', echo)
+
+        loop = gobject.MainLoop()
+        results = []
+        def done(*args):
+            results.append(args)
+            loop.quit()
+        proxy = self.bus.get_object(service_bus.get_unique_name(), '/Native',
+                                    introspect=False)
+        proxy.Echo('hello', [1, 2], dbus_interface=IFACE,
+                   signature='sai', reply_handler=done, error_handler=done)
+        loop.run()
+        self.assertEqual(results, [('hello', [1, 2])])
+        self.assertEqual([m.get_member() for m in recorded
+                          if m.get_path() == '/Native'], ['Echo'])
+        self.assertTrue(isinstance(recorded[-1], dbus.lowlevel.Message))
+
+        # the native handler's replies finish the calls, so more calls
+        # than max_concurrent can be made one after another
+        service_bus.set_sender_limits(max_concurrent=1)
+        del results[:]
+        for i in range(3):
+            proxy.Echo(i, dbus_interface=IFACE, signature='i',
+                       reply_handler=done, error_handler=done)
+            loop.run()
+        self.assertEqual(results, [(0,), (1,), (2,)])
+        self.assertEqual(
+            service_bus.get_sender_stats()[self.bus.get_unique_name()],
+            (3, 0, 0))
+        # a large limit doesn't cost memory up front
+        service_bus.set_sender_limits(max_concurrent=2**31 - 1)
+        del results[:]
+        proxy.Echo(3, dbus_interface=IFACE, signature='i',
+                   reply_handler=done, error_handler=done)
+        loop.run()
+        self.assertEqual(results, [(3,)])
+
+        dbus_py_test.remove_message_filter(service_bus, recorder)
+        self.assertRaises(ValueError, dbus_py_test.remove_message_filter,
+                          service_bus, recorder)
+        dbus_py_test.unregister_object_path(service_bus, '/Native')
+        self.assertRaises(KeyError, dbus_py_test.unregister_object_path,
+                          service_bus, '/Native')
+
+        del results[:]
+        proxy.Echo('hello', dbus_interface=IFACE, reply_handler=done,
+                   error_handler=done)
+        loop.run()
+        self.assertTrue(isinstance(results[0][0], dbus.DBusException))
+        service_bus.close()
+
+    def testBenchmarkMethodCalls(self):
+        print("\n********* Benchmark per-call overhead ************")
+        from dbus.lowlevel import MethodCallMessage
+
+        message = MethodCallMessage(NAME, OBJECT, IFACE, 'Echo')
+        message.append(42, signature='i')
+        reply = self.bus.send_message_with_reply_and_block(message,
+                                                           timeout_s=60.0)
+        self.assertEqual(reply.get_args_list(byte_arrays=True), [42])
+
+        unsent = MethodCallMessage(NAME, OBJECT, IFACE, 'Echo')
+        n = 100000
+        for (label, call) in (
+                ('set_no_reply', lambda: unsent.set_no_reply(False)),
+                ('has_member', lambda: unsent.has_member('Echo')),
+                ('get_args_list', lambda: reply.get_args_list()),
+                ('get_args_list(byte_arrays=True)',
+                 lambda: reply.get_args_list(byte_arrays=True)),
+                ('append(signature=...)',
+                 lambda: MethodCallMessage(NAME, OBJECT, IFACE,
+                                           'Echo').append(42, signature='i'))):
+            a = time.time()
+            for i in range(n):
+                call()
+            b = time.time()
+            print("%s: %f us per call" % (label, (b - a) * 1e6 / n))
+
+        n = 2000
+        a = time.time()
+        for i in range(n):
+            self.bus.send_message_with_reply_and_block(message,
+                                                       timeout_s=60.0)
+        b = time.time()
+        print("send_message_with_reply_and_block: %f us per call"
+              % ((b - a) * 1e6 / n))
+
+    def testExportMany(self):
+        print("\n********* Benchmark exporting 20000 objects at once *******")
+        service_bus = dbus.SessionBus(private=True)
+        class Exported(dbus.service.Object):
+            @dbus.service.method(IFACE, in_signature='', out_signature='s')
+            def WhoAmI(self):
+                return self.__dbus_object_path__
+
+        n = 20000
+        objs = [Exported() for i in range(n)]
+        a = time.time()
+        service_bus.export_many(('/Many/%d' % i, obj)
+                                for i, obj in enumerate(objs))
+        b = time.time()
+        print("Exporting: %f" % (b - a))
+        self.assertEqual(len(service_bus.list_exported_child_objects('/Many')),
+                         n)
+        self.assertEqual(objs[1].__dbus_object_path__, '/Many/1')
+        loop = gobject.MainLoop()
+        results = []
+        def done(result):
+            results.append(result)
+            loop.quit()
+        self.bus.call_async(service_bus.get_unique_name(), '/Many/1', IFACE,
+                            'WhoAmI', '', (), done, done)
+        loop.run()
+        self.assertEqual(results, ['/Many/1'])
+
+        # nothing is exported if anything fails
+        extra = Exported()
+        self.assertRaises(KeyError, service_bus.export_many,
+                          [('/Many/extra', extra), ('/Many/0', Exported())])
+        self.assertEqual(list(extra.locations), [])
+        self.assertRaises(LookupError, service_bus.unexport_many,
+                          [objs[0], extra])
+
+        a = time.time()
+        service_bus.unexport_many(objs)
+        b = time.time()
+        print("Unexporting: %f" % (b - a))
+        self.assertEqual(service_bus.list_exported_child_objects('/Many'), [])
+        self.assertEqual(list(objs[0].locations), [])
+        service_bus.close()
+
+    def testConnectionPool(self):
+        print("\n********* Benchmark connection pool ************")
+        import threading
+        from dbus.pool import ConnectionPool
+
+        n_threads = 4
+        n = 2000
+        for size in (1, n_threads):
+            pool = ConnectionPool(size=size,
+                                  shard_by=ConnectionPool.SHARD_BY_CALL)
+            def worker():
+                for i in range(n // n_threads):
+                    pool.call_blocking(NAME, OBJECT, IFACE, 'Echo', 's',
+                                       ('x',))
+            threads = [threading.Thread(target=worker)
+                       for i in range(n_threads)]
+            a = time.time()
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+            b = time.time()
+            print("%d calls from %d threads on %d connections: %f"
+                  % (n, n_threads, size, b - a))
+            stats = pool.get_stats()
+            self.assertEqual(len(stats), size)
+            self.assertEqual(sum([s['calls'] for s in stats]), n)
+            self.assertEqual(sum([s['in_flight'] for s in stats]), 0)
+            self.assertEqual(len(set([s['unique_name'] for s in stats])), size)
+            pool.close()
+
+        # calls with the same key stay in order on the same connection
+        pool = ConnectionPool(size=3, shard_by=ConnectionPool.SHARD_BY_CALL)
+        loop = gobject.MainLoop()
+        replies = []
+        errors = []
+        def reply(value):
+            replies.append(value)
+            if len(replies) + len(errors) == 101:
+                loop.quit()
+        def error(e):
+            errors.append(e)
+            if len(replies) + len(errors) == 101:
+                loop.quit()
+        for i in range(100):
+            pool.call_async(NAME, OBJECT, IFACE, 'Echo', 'i', (i,), reply,
+                            error, key='ordered')
+        pool.call_async(NAME, OBJECT, IFACE, 'NoSuchMethod', '', (), reply,
+                        error, key='other')
+        loop.run()
+        self.assertEqual(replies, list(range(100)))
+        self.assertEqual(len(errors), 1)
+        stats = pool.get_stats()
+        calls = dict([(s['unique_name'], s['calls']) for s in stats])
+        self.assertEqual(sum(calls.values()), 101)
+        self.assertTrue(
+            calls[pool.get_connection('ordered').get_unique_name()] >= 100)
+        self.assertEqual(sum([s['errors'] for s in stats]), 1)
+        self.assertEqual(sum([s['in_flight'] for s in stats]), 0)
+
+        # cancelled calls are no longer in flight
+        from dbus.connection import CancellationScope
+        scope = CancellationScope()
+        pool.call_async(NAME, OBJECT, IFACE, 'AsyncWait500ms', '', (),
+                        reply, error, scope=scope)
+        self.assertEqual(sum([s['in_flight'] for s in pool.get_stats()]), 1)
+        scope.cancel()
+        stats = pool.get_stats()
+        self.assertEqual(sum([s['in_flight'] for s in stats]), 0)
+        self.assertEqual(sum([s['calls'] for s in stats]), 102)
+        self.assertEqual(sum([s['errors'] for s in stats]), 1)
+        self.assertRaises(dbus.DBusException, pool.call_async, NAME, OBJECT,
+                          IFACE, 'Echo', 'i', (1,), reply, error, scope=scope)
+        pool.close()
+
     def testAsyncCalls(self):
         #test sending python types and getting them back async
         print("\n********* Testing Async Calls ***********")
@@ -437,6 +916,31 @@ class TestDBusBindings(unittest.TestCase):
         self.assertTrue(not isinstance(ret, dbus.Struct), repr(ret))
         self.assertEqual(ret, ('abc', 123))
 
+    def testGeneratedReturn(self):
+        self.assertEqual(self.iface.GenerateArray(3),
+                         [(0, '0'), (1, '1'), (2, '2')])
+        self.assertEqual(self.iface.GenerateArray(0), [])
+        self.assertEqual(self.iface.GenerateDict(2), {0: '0', 1: '1'})
+        self.assertEqual(self.iface.GenerateReturnValues(), ('abc', 123))
+        self.assertEqual(self.iface.GenerateStruct(), (1, 2))
+        try:
+            self.iface.GenerateWrongArray()
+        except dbus.DBusException as e:
+            self.assertTrue(e.get_dbus_name().endswith('.TypeError'),
+                            e.get_dbus_name())
+        else:
+            self.fail('GenerateWrongArray should have raised')
+
+    def testBuiltReply(self):
+        self.assertEqual(self.iface.BuildReply(3), [0, 1, 2])
+        try:
+            self.iface.BuildWrongReply()
+        except dbus.DBusException as e:
+            self.assertTrue(e.get_dbus_name().endswith('.TypeError'),
+                            e.get_dbus_name())
+        else:
+            self.fail('BuildWrongReply should have raised')
+
     def testListExportedChildObjects(self):
         self.assertTrue(self.iface.TestListExportedChildObjects())
 
@@ -511,6 +1015,111 @@ class TestDBusBindings(unittest.TestCase):
         # fd.o #12096
         dbus.Bus(private=True).close()
 
+    def testForward(self):
+        gateway = dbus.SessionBus(private=True)
+        def forwarder(conn, msg):
+            if (isinstance(msg, dbus.lowlevel.MethodCallMessage)
+                and msg.get_path() == '/Gateway'):
+                conn.forward(msg, destination=NAME, path=OBJECT, origin=conn)
+                return dbus.lowlevel.HANDLER_RESULT_HANDLED
+            return dbus.lowlevel.HANDLER_RESULT_NOT_YET_HANDLED
+        gateway.add_message_filter(forwarder)
+
+        loop = gobject.MainLoop()
+        replies = []
+        errors = []
+        def done():
+            if len(replies) + len(errors) >= 2:
+                loop.quit()
+        def replied(*args):
+            replies.append(args)
+            done()
+        def failed(e):
+            errors.append(e.get_dbus_name())
+            done()
+        proxy = self.bus.get_object(gateway.get_unique_name(), '/Gateway',
+                                    introspect=False)
+        proxy.Echo('forwarded', dbus_interface=IFACE,
+                   reply_handler=replied, error_handler=failed)
+        proxy.AsyncRaise(dbus_interface=IFACE,
+                         reply_handler=replied, error_handler=failed)
+        loop.run()
+        gateway.close()
+        self.assertEqual(replies, [('forwarded',)])
+        self.assertEqual(errors, ['org.freedesktop.bugzilla.bug12403'])
+
+    def testSenderLimits(self):
+        service_bus = dbus.SessionBus(private=True)
+        class Limited(dbus.service.Object):
+            @dbus.service.method(IFACE, in_signature='', out_signature='')
+            def Ping(self):
+                pass
+        Limited(service_bus, '/Limited')
+        # two calls at once, then one every 1000 seconds
+        service_bus.set_sender_limits(rate=0.001, burst=2)
+
+        loop = gobject.MainLoop()
+        results = []
+        def done(result):
+            results.append(result)
+            if len(results) == 3:
+                loop.quit()
+        proxy = self.bus.get_object(service_bus.get_unique_name(), '/Limited',
+                                    introspect=False)
+        for i in range(3):
+            proxy.Ping(dbus_interface=IFACE,
+                       reply_handler=lambda: done(None),
+                       error_handler=lambda e: done(e.__class__))
+        loop.run()
+
+        self.assertEqual(results,
+                         [None, None, dbus.exceptions.LimitsExceededException])
+        self.assertEqual(
+            service_bus.get_sender_stats()[self.bus.get_unique_name()],
+            (2, 1, 0))
+        service_bus.close()
+
+    def testMonitor(self):
+        import struct
+        import tempfile
+        monitor_bus = dbus.SessionBus(private=True)
+        loop = gobject.MainLoop()
+        records = []
+        def handler(batch):
+            records.extend(batch)
+            loop.quit()
+        pcap = tempfile.TemporaryFile()
+        monitor = monitor_bus.become_monitor(
+                ["type='signal',interface='%s'" % IFACE], handler=handler,
+                pcap=pcap, members=['Captured'])
+
+        # the burst ends with a filtered-out message, which must still
+        # deliver the batch
+        serials = [self.bus.send_message(
+                        dbus.lowlevel.SignalMessage('/Monitored', IFACE,
+                                                    member))
+                   for member in ('Captured', 'Ignored')]
+        loop.run()
+        monitor.stop()
+        monitor_bus.close()
+
+        self.assertEqual(len(records), 1)
+        self.assertEqual(records[0][1:],
+                         (dbus.lowlevel.MESSAGE_TYPE_SIGNAL,
+                          serials[0], 0, self.bus.get_unique_name(), None,
+                          '/Monitored', IFACE, 'Captured', None, ''))
+        self.assertEqual(monitor.captured, 1)
+        # at least the Ignored signal; the bus daemon's own signals to
+        # monitor_bus are counted too
+        self.assertTrue(monitor.filtered_out >= 1)
+
+        pcap.seek(0)
+        data = pcap.read()
+        self.assertEqual(struct.unpack('=IHH', data[:8]), (0xa1b2c3d4, 2, 4))
+        self.assertEqual(struct.unpack('=I', data[20:24]), (231,))
+        length = struct.unpack('=I', data[32:36])[0]
+        self.assertEqual(len(data), 40 + length)
+
     def testTimeoutAsyncClient(self):
         loop = gobject.MainLoop()
         passes = []
@@ -563,6 +1172,16 @@ class TestDBusBindings(unittest.TestCase):
         else:
             raise AssertionError('Wanted an exception')
 
+        try:
+            self.iface.RaiseValueErrorNoTraceback()
+        except Exception as e:
+            self.assertTrue(isinstance(e, dbus.DBusException), e.__class__)
+            self.assertTrue(e.get_dbus_name().endswith('.ValueError'),
+                            e.get_dbus_name())
+            self.assertEqual(e.get_dbus_message(), 'ValueError: Wrong!\n')
+        else:
+            raise AssertionError('Wanted an exception')
+
         try:
             self.iface.RaiseDBusExceptionNoTraceback()
         except Exception as e:
@@ -587,6 +1206,31 @@ class TestDBusBindings(unittest.TestCase):
         else:
             raise AssertionError('Wanted an exception')
 
+    def testErrorArgs(self):
+        try:
+            self.bus.call_blocking(NAME, OBJECT, IFACE, 'RaiseMultipleArgs',
+                                   '', ())
+        except dbus.DBusException as e:
+            self.assertEqual(e.get_dbus_name(),
+                             'com.example.Errors.MultipleArgs')
+            self.assertEqual(e.args, ('Several things', 42,
+                                      ['went', 'wrong']))
+        else:
+            raise AssertionError('Wanted an exception')
+
+    def testCancelledScope(self):
+        from dbus.connection import CancellationScope
+        scope = CancellationScope()
+        scope.cancel()
+        replies = []
+        self.assertRaises(dbus.DBusException, self.bus.call_async,
+                          NAME, OBJECT, IFACE, 'Echo', 's', ('foo',),
+                          replies.append, replies.append, scope=scope)
+        self.assertRaises(dbus.DBusException, self.bus.call_blocking,
+                          NAME, OBJECT, IFACE, 'Echo', 's', ('foo',),
+                          scope=scope)
+        self.assertEqual(replies, [])
+
 """ Remove this for now
 class TestDBusPythonToGLibBindings(unittest.TestCase):
     def setUp(self):
@@ -35,6 +35,7 @@ import dbus
 if not dbus.__file__.startswith(pydir):
     raise Exception("DBus modules are not being picked up from the package")
 
+import dbus.lowlevel
 import dbus.service
 import dbus.glib
 import random
@@ -64,6 +65,12 @@ class RemovableObject(dbus.service.Object):
         return True
 
 class TestGObject(ExportedGObject):
+    DBUS_PROPERTIES = {IFACE: ('count', 'label')}
+
+    count = GObject.Property(type=GObject.TYPE_UINT, default=0)
+    label = GObject.Property(type=str, default='test',
+                             flags=GObject.ParamFlags.READABLE)
+
     def __init__(self, bus_name, object_path=OBJECT + '/GObject'):
         super(TestGObject, self).__init__(bus_name, object_path)
 
@@ -71,6 +78,11 @@ class TestGObject(ExportedGObject):
     def Echo(self, arg):
         return arg
 
+    @dbus.service.method(IFACE, in_signature='u', out_signature='')
+    def IncrementCount(self, times):
+        for i in range(times):
+            self.props.count += 1
+
 class TestInterface(dbus.service.Interface):
     @dbus.service.method(IFACE, in_signature='', out_signature='b')
     def CheckInheritance(self):
@@ -300,6 +312,47 @@ class TestObject(dbus.service.Object, TestInterface):
         # https://bugs.freedesktop.org/show_bug.cgi?id=10174
         return dbus.String('abc'), dbus.Int32(123)
 
+    @dbus.service.method(IFACE, in_signature='u', out_signature='a(us)')
+    def GenerateArray(self, n):
+        for i in range(n):
+            yield i, str(i)
+
+    @dbus.service.method(IFACE, in_signature='u', out_signature='a{us}')
+    def GenerateDict(self, n):
+        for i in range(n):
+            yield i, str(i)
+
+    @dbus.service.method(IFACE, in_signature='', out_signature='su')
+    def GenerateReturnValues(self):
+        yield 'abc'
+        yield 123
+
+    @dbus.service.method(IFACE, in_signature='', out_signature='(ii)')
+    def GenerateStruct(self):
+        yield 1
+        yield 2
+
+    @dbus.service.method(IFACE, in_signature='', out_signature='ai')
+    def GenerateWrongArray(self):
+        yield 'abc'
+
+    @dbus.service.method(IFACE, in_signature='u', out_signature='au',
+                         message_keyword='message')
+    def BuildReply(self, n, message):
+        reply = dbus.lowlevel.MethodReturnMessage(message)
+        reply.open_array('u')
+        for i in range(n):
+            reply.append_basic('u', i)
+        reply.close()
+        return reply
+
+    @dbus.service.method(IFACE, in_signature='', out_signature='s',
+                         message_keyword='message')
+    def BuildWrongReply(self, message):
+        reply = dbus.lowlevel.MethodReturnMessage(message)
+        reply.append_basic('u', 1)
+        return reply
+
     @dbus.service.method(IFACE, in_signature='', out_signature='')
     def BlockFor500ms(self):
         sleep(0.5)
@@ -316,6 +369,11 @@ class TestObject(dbus.service.Object, TestInterface):
     def RaiseValueError(self):
         raise ValueError('Wrong!')
 
+    @dbus.service.method(IFACE, in_signature='', out_signature='',
+                         include_traceback=False)
+    def RaiseValueErrorNoTraceback(self):
+        raise ValueError('Wrong!')
+
     @dbus.service.method(IFACE, in_signature='', out_signature='')
     def RaiseDBusExceptionNoTraceback(self):
         class ServerError(dbus.DBusException):
@@ -342,6 +400,15 @@ class TestObject(dbus.service.Object, TestInterface):
 
         raise_cb(Fdo12403Error())
 
+    @dbus.service.method(IFACE, in_signature='', out_signature='',
+                         async_callbacks=('return_cb', 'raise_cb'),
+                         connection_keyword='conn', message_keyword='message')
+    def RaiseMultipleArgs(self, return_cb, raise_cb, conn, message):
+        error = dbus.lowlevel.ErrorMessage(message,
+                'com.example.Errors.MultipleArgs', 'Several things')
+        error.append(42, ['went', 'wrong'], signature='ias')
+        conn.send_message(error)
+
 
 def main():
     global session_bus
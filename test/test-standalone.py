@@ -89,6 +89,52 @@ class TestTypes(unittest.TestCase):
         self.assertEqual(x.variant_level, 42)
         self.assertEqual(x, ('a','b','c'))
 
+    def test_VarDict(self):
+        x = types.VarDict({'a': 1, 'b': 'x'}, signatures={'a': 'q'})
+        self.assertEqual(len(x), 2)
+        self.assertEqual(x['a'], 1)
+        self.assertTrue('b' in x)
+        self.assertFalse('c' in x)
+        self.assertEqual(x.get('c', 42), 42)
+        self.assertEqual(sorted(x), ['a', 'b'])
+        self.assertEqual(sorted(x.items()), [('a', 1), ('b', 'x')])
+        self.assertRaises(KeyError, lambda: x['c'])
+        def set_item():
+            x['c'] = 1
+        self.assertRaises(TypeError, set_item)
+        self.assertEqual(x.variant_level, 0)
+        self.assertEqual(x.signature, 'sv')
+        self.assertEqual(x.value_signature('a'), 'q')
+        self.assertEqual(x.value_signature('b'), 's')
+
+        self.assertEqual(x, {'a': 1, 'b': 'x'})
+        self.assertEqual({'a': 1, 'b': 'x'}, x)
+        self.assertNotEqual(x, {'a': 1})
+        y = types.VarDict([('b', 'x'), ('a', 1)], variant_level=2)
+        self.assertEqual(x, y)
+        self.assertEqual(hash(x), hash(y))
+        self.assertEqual(y.variant_level, 2)
+        self.assertEqual(repr(types.VarDict({'a': 1})),
+                         'dbus.VarDict(%r)' % {'a': 1})
+
+        # signatures are copied from another VarDict
+        self.assertEqual(types.VarDict(x).value_signature('a'), 'q')
+        self.assertRaises(TypeError, types.VarDict, {1: 2})
+        self.assertRaises(ValueError, types.VarDict, {'a': 1},
+                          signatures={'a': 'qq'})
+        self.assertRaises(ValueError, types.VarDict, variant_level=-1)
+
+        # copies keep the signatures and variant level
+        import copy, pickle
+        z = types.VarDict(x, variant_level=1)
+        for w in (copy.copy(z), copy.deepcopy(z),
+                  pickle.loads(pickle.dumps(z, 2))):
+            self.assertEqual(type(w), types.VarDict)
+            self.assertEqual(w, z)
+            self.assertEqual(w.value_signature('a'), 'q')
+            self.assertEqual(w.variant_level, 1)
+        self.assertEqual(type(x.keys()), list)
+
     def test_Byte(self):
         self.assertEqual(types.Byte(b'x', variant_level=2),
                           types.Byte(ord('x')))
@@ -253,6 +299,250 @@ class TestMessageMarshalling(unittest.TestCase):
         s.append([], signature='ay')
         aeq(s.get_args_list(), [[]])
 
+    def test_append_columns(self):
+        import array
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+
+        names = ['a', 'bb', 'ccc']
+        ints = [1, -2, 3]
+        doubles = [0.5, 1.5, 2.5]
+        uints = [7, 8, 9]
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append(list(zip(names, ints, doubles, uints)), signature='a(sidu)')
+        expected = s.get_args_list()
+
+        for columns in ([names, ints, doubles, uints],
+                        (tuple(names), array.array(str('i'), ints),
+                         array.array(str('d'), doubles),
+                         array.array(str('B'), uints)),
+                        [names, array.array(str('l'), ints),
+                         array.array(str('f'), doubles),
+                         array.array(str('L'), uints)]):
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            s.append(1, signature='i')
+            s.append_columns('a(sidu)', columns)
+            aeq(s.get_signature(), 'ia(sidu)')
+            aeq(s.get_args_list()[1:], expected)
+
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append_columns('a(yb(as)v)', [b'\x01\x02', [0, 5],
+                                        [(['x'],), ([],)], [1, 'z']])
+        aeq(s.get_args_list(), [[(1, False, (['x'],), 1),
+                                 (2, True, ([],), 'z')]])
+
+        for (signature, columns, exception) in (
+                ('a(si)', [['a'], [1, 2]], ValueError),
+                ('a(si)', [['a']], TypeError),
+                ('a(si)', [['a'], [1], [2]], TypeError),
+                ('as', [['a']], ValueError),
+                ('a(y)', [array.array(str('i'), [256])], ValueError),
+                ('a(u)', [array.array(str('i'), [-1])], OverflowError)):
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            self.assertRaises(exception, s.append_columns, signature,
+                              columns)
+
+    def test_get_struct_columns(self):
+        import array
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+
+        names = ['a', 'bb', 'ccc']
+        ints = [1, -2, 3]
+        doubles = [0.5, 1.5, 2.5]
+        flags = [True, False, True]
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append_columns('a(sidbnqyu)', [names, ints, doubles, flags,
+                                         [-4, 5, 6], [7, 8, 9], b'xyz',
+                                         [0, 1, 4294967295]])
+        s.append(1, signature='i')
+        s.append([], signature='a(ix)')
+        s.append([(1, {'k': [(2, 'v')]})], signature='a(ia{sa(is)})')
+        args = s.get_args_list(struct_columns=True)
+        aeq(len(args), 4)
+
+        columns = args[0]
+        aeq(len(columns), 8)
+        aeq(columns[0], names)
+        for (column, typecode, values) in (
+                (columns[1], 'i', ints),
+                (columns[2], 'd', doubles),
+                (columns[3], 'B', [1, 0, 1]),
+                (columns[4], 'h', [-4, 5, 6]),
+                (columns[5], 'H', [7, 8, 9]),
+                (columns[6], 'B', [120, 121, 122]),
+                (columns[7], 'I', [0, 1, 4294967295])):
+            self.assertTrue(isinstance(column, array.array))
+            aeq(column.typecode, typecode)
+            aeq(column.tolist(), values)
+
+        aeq(args[1], 1)
+        aeq(len(args[2]), 2)
+        aeq(len(args[2][0]), 0)
+        aeq(len(args[2][1]), 0)
+        # nested arrays of structs are columns too
+        aeq(args[3][0].tolist(), [1])
+        aeq(args[3][1], [{'k': (array.array(str('i'), [2]), ['v'])}])
+
+        # without the option, nothing changes
+        aeq(s.get_args_list()[0][1], ('bb', -2, 1.5, False, 5, 8,
+                                      ord('y'), 1))
+
+        # a leading array field doesn't hide the fields after it
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append([([1, 2], 3), ([], 4)], signature='a(aiy)')
+        columns = s.get_args_list(struct_columns=True)[0]
+        aeq(len(columns), 2)
+        aeq(columns[0], [[1, 2], []])
+        aeq(columns[1].tolist(), [3, 4])
+
+    def test_append_direct(self):
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage, MethodCallMessage
+
+        for (args, signature) in (
+                ((True, 7, 3, -70000, 70000, make_long(-2**40), 2.5),
+                 'bnqiuxd'),
+                ((b'abc', [], [], {}), 'ayaxa(yx)a{sv}'),
+                (([(1, (2, 'x'))], types.ObjectPath('/a'), 'a{s(i)}'),
+                 'a(y(ts))og'),
+                (({'a': types.String('b', variant_level=3),
+                   'c': types.ByteArray(b'de'),
+                   'f': types.Struct((1, 'g'), variant_level=1)},
+                  types.ByteArray(b'h')),
+                 'a{sv}av')):
+            for make_message in (
+                    lambda: SignalMessage('/', 'foo.bar', 'baz'),
+                    lambda: MethodCallMessage('org.example', '/', None, 'M')):
+                iterated = make_message()
+                direct = make_message()
+                for message in (iterated, direct):
+                    message.set_destination(':1.23')
+                iterated.append(*args, signature=signature)
+                direct.append(direct=True, signature=signature, *args)
+                aeq(direct.marshal(), iterated.marshal())
+                aeq(direct.get_serial(), 0)
+                aeq(direct.get_destination(), ':1.23')
+                # later appends fall back to the message iterator
+                iterated.append(1, signature='q')
+                direct.append(1, signature='q', direct=True)
+                aeq(direct.marshal(), iterated.marshal())
+
+        # the header is kept as it was
+        m = MethodCallMessage('org.example', '/', None, 'M')
+        m.set_interface('org.example.I')
+        m.set_no_reply(True)
+        m.set_auto_start(False)
+        m.set_sender(':1.5')
+        m.append(1, 'x', signature='is', direct=True)
+        aeq(m.get_interface(), 'org.example.I')
+        aeq(m.get_no_reply(), True)
+        aeq(m.get_auto_start(), False)
+        aeq(m.get_sender(), ':1.5')
+        aeq(m.get_args_list(), [1, 'x'])
+
+        # on failure, the message is unchanged
+        too_deep = 1
+        for i in range(40):
+            too_deep = [too_deep]
+        for (args, signature, exception) in (
+                ((1,), 'ii', TypeError),
+                ((1, 2), 'i', TypeError),
+                (('a/b',), 'o', ValueError),
+                ((256,), 'y', ValueError),
+                (((1,),), '(ii)', TypeError),
+                ((too_deep,), 'v', ValueError)):
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            self.assertRaises(exception, s.append, direct=True,
+                              signature=signature, *args)
+            aeq(s.get_signature(), '')
+        # the message iterator checks variant signatures too
+        self.assertRaises(ValueError, SignalMessage('/', 'a.b', 'c').append,
+                          too_deep, signature='v')
+
+    def test_open_containers(self):
+        import array
+        aeq = self.assertEqual
+        from _dbus_bindings import SignalMessage
+        from dbus.exceptions import DBusException
+
+        appended = SignalMessage('/', 'foo.bar', 'baz')
+        appended.append('x', [(0, '0'), (1, '1')],
+                        {'k': types.Array([1, 2, 3], signature='i',
+                                          variant_level=1)},
+                        types.ByteArray(b'abc'), [],
+                        signature='sa(is)a{sv}aya(ii)')
+
+        built = SignalMessage('/', 'foo.bar', 'baz')
+        built.append_basic('s', 'x')
+        built.open_array('(is)')
+        for i in range(2):
+            built.open_struct()
+            built.append_basic('i', i)
+            built.append(str(i), signature='s')
+            built.close()
+        built.close()
+        built.open_array('{sv}')
+        built.open_dict_entry()
+        built.append_basic('s', 'k')
+        built.open_variant('ai')
+        built.append_fixed_array('i', array.array(str('i'), [1, 2, 3]))
+        built.close()
+        built.close()
+        built.close()
+        built.append_fixed_array('y', b'abc')
+        built.open_array('(ii)')
+        built.close()
+        aeq(built.get_signature(), 'sa(is)a{sv}aya(ii)')
+        aeq(built.marshal(), appended.marshal())
+
+        # mistakes leave the container open and the message usable
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(ValueError, s.close)
+        s.open_array('(ii)')
+        self.assertRaises(DBusException, s.marshal)
+        self.assertRaises(DBusException, s.get_args_list)
+        self.assertRaises(TypeError, s.append_basic, 'i', 1)
+        self.assertRaises(TypeError, s.append, (1, 'a'), signature='(is)')
+        self.assertRaises(TypeError, s.open_dict_entry)
+        s.open_struct()
+        self.assertRaises(TypeError, s.open_struct)
+        s.append_basic('i', 1)
+        self.assertRaises(TypeError, s.close)
+        s.append(2, signature='i')
+        self.assertRaises(TypeError, s.append_basic, 'i', 3)
+        s.close()
+        s.append((3, 4), signature='(ii)')
+        s.close()
+        self.assertRaises(ValueError, s.close)
+        aeq(s.get_args_list(), [[(1, 2), (3, 4)]])
+
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.open_struct()
+        self.assertRaises(TypeError, s.close)
+        s.append_fixed_array('d', [0.5])
+        s.close()
+        aeq(s.get_args_list(), [([0.5],)])
+
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        self.assertRaises(ValueError, s.open_array, '')
+        self.assertRaises(ValueError, s.open_array, 'ii')
+        self.assertRaises(ValueError, s.open_variant, '{sv}')
+        self.assertRaises(ValueError, s.append_basic, 'as', [])
+        self.assertRaises(ValueError, s.append_fixed_array, 's', [])
+        self.assertRaises(ValueError, s.append_fixed_array, 'i', b'abc')
+        # the buffer's items must be of the D-Bus type
+        self.assertRaises(ValueError, s.append_fixed_array, 'i', b'abcd')
+        if not is_py2:
+            # (Python 2's array.array is used as a sequence instead)
+            self.assertRaises(ValueError, s.append_fixed_array, 'd',
+                              array.array(str('l'), [1]))
+            self.assertRaises(ValueError, s.append_fixed_array, 'u',
+                              array.array(str('i'), [1]))
+        for i in range(64):
+            s.open_variant('v')
+        self.assertRaises(ValueError, s.open_variant, 'v')
+
     def test_append_Byte(self):
         aeq = self.assertEqual
         from _dbus_bindings import SignalMessage
@@ -342,6 +632,128 @@ class TestMessageMarshalling(unittest.TestCase):
         aeq(gs(types.Array([types.Int32(1)])), 'ai')
         aeq(gs(types.Array([types.Int32(1)], signature='u')), 'au')
 
+    def test_get_args_direct(self):
+        import random
+        from collections import namedtuple
+        from _dbus_bindings import SignalMessage
+
+        rand = random.Random(94)
+        basic = 'ybnqiuxtdsog'
+
+        def random_basic(t):
+            if t == 'y':
+                return rand.randint(0, 255)
+            elif t == 'b':
+                return rand.choice((True, False))
+            elif t in 'nqiuxt':
+                bits = {'n': 16, 'q': 16, 'i': 32, 'u': 32, 'x': 64,
+                        't': 64}[t]
+                if t in 'nix':
+                    return make_long(rand.randint(-2**(bits - 1),
+                                                  2**(bits - 1) - 1))
+                return make_long(rand.randint(0, 2**bits - 1))
+            elif t == 'd':
+                return rand.uniform(-1e6, 1e6)
+            elif t == 's':
+                return ''.join(rand.choice('ab\xe9\u20ac ')
+                               for i in range(rand.randint(0, 5)))
+            elif t == 'o':
+                return rand.choice(('/', '/a', '/a/b_c'))
+            else:
+                return rand.choice(('', 'i', 'a{sv}'))
+
+        def random_type(depth):
+            n = rand.randint(0, 9 if depth < 3 else 0)
+            if n <= 4:
+                t = rand.choice(basic)
+                return (t, lambda: random_basic(t))
+            elif n == 5:
+                (sig, make) = random_type(depth + 1)
+                return ('a' + sig,
+                        lambda: [make() for i in range(rand.randint(0, 3))])
+            elif n == 6:
+                k = rand.choice(basic)
+                (sig, make) = random_type(depth + 1)
+                return ('a{%s%s}' % (k, sig),
+                        lambda: dict((random_basic(k), make())
+                                     for i in range(rand.randint(0, 3))))
+            elif n <= 8:
+                fields = [random_type(depth + 1)
+                          for i in range(rand.randint(1, 3))]
+                return ('(%s)' % ''.join(sig for (sig, make) in fields),
+                        lambda: tuple(make() for (sig, make) in fields))
+            else:
+                return ('v', lambda: random_variant(depth + 1))
+
+        def random_variant(depth):
+            # decode the contents to get values of the right D-Bus type
+            (sig, make) = random_type(depth)
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            s.append(make(), signature=sig)
+            value = s.get_args_list()[0]
+            if rand.randint(0, 3) == 0:
+                if isinstance(value, (types.Array, types.Dictionary)):
+                    value = type(value)(value, signature=value.signature,
+                                        variant_level=2)
+                else:
+                    value = type(value)(value, variant_level=2)
+            return value
+
+        def check_same(a, b):
+            self.assertEqual(type(a), type(b))
+            self.assertEqual(getattr(a, 'variant_level', None),
+                             getattr(b, 'variant_level', None))
+            self.assertEqual(getattr(a, 'signature', None),
+                             getattr(b, 'signature', None))
+            if isinstance(a, dict):
+                self.assertEqual(len(a), len(b))
+                b_keys = dict((k, k) for k in b)
+                for k in a:
+                    check_same(k, b_keys[k])
+                    check_same(a[k], b[k])
+            elif isinstance(a, (list, tuple)):
+                self.assertEqual(len(a), len(b))
+                for (x, y) in zip(a, b):
+                    check_same(x, y)
+            else:
+                self.assertEqual(a, b)
+
+        option_sets = [{}, {'byte_arrays': True}, {'struct_columns': True},
+                       {'byte_arrays': True, 'struct_columns': True}]
+        if is_py2:
+            option_sets.append({'utf8_strings': True})
+
+        for i in range(300):
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            for j in range(rand.randint(0, 4)):
+                (sig, make) = random_type(0)
+                s.append(make(), signature=sig)
+            for options in option_sets:
+                check_same(s.get_args_list(**options),
+                           s.get_args_list(direct=True, **options))
+
+        Pair = namedtuple('Pair', 'name value')
+        types.register_struct_class('(su)', Pair)
+        try:
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            s.append([('a', 1)], Pair('b', 2), signature='a(su)v')
+            check_same(s.get_args_list(), s.get_args_list(direct=True))
+            self.assertEqual(type(s.get_args_list(direct=True)[1]), Pair)
+
+            # a class for a struct whose first field is a struct
+            Nested = namedtuple('Nested', 'pair count')
+            types.register_struct_class('((su)u)', Nested)
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            s.append(Nested(Pair('c', 3), 4), signature='((su)u)')
+            for direct in (False, True):
+                nested = s.get_args_list(direct=direct)[0]
+                self.assertEqual(type(nested), Nested)
+                self.assertEqual(type(nested.pair), Pair)
+                self.assertEqual(nested, (('c', 3), 4))
+        finally:
+            types.register_struct_class('(su)', None)
+            types.register_struct_class('((su)u)', None)
+
     def test_get_args_options(self):
         aeq = self.assertEqual
         s = _dbus_bindings.SignalMessage('/', 'foo.bar', 'baz')
@@ -395,6 +807,44 @@ class TestMessageMarshalling(unittest.TestCase):
         aeq(variant.variant_level, 1)
         aeq(variant, 'var')
 
+    def test_get_vardicts(self):
+        aeq = self.assertEqual
+        vardict = types.VarDict({'a': 1, 'b': ['x'],
+                                 'c': types.String('y', variant_level=2)},
+                                signatures={'a': 'q'})
+        dictionary = types.Dictionary({'a': types.UInt16(1), 'b': ['x'],
+                                       'c': types.String('y',
+                                                         variant_level=2)},
+                                      signature='sv')
+        for direct in (False, True):
+            s = _dbus_bindings.SignalMessage('/', 'foo.bar', 'baz')
+            s.append(vardict, {'d': vardict}, signature='a{sv}a{sv}',
+                     direct=direct)
+            t = _dbus_bindings.SignalMessage('/', 'foo.bar', 'baz')
+            t.append(dictionary, {'d': dictionary}, signature='a{sv}a{sv}')
+            aeq(s.get_args_list(), t.get_args_list())
+            aeq(s.get_args_list()[0].__class__, types.Dictionary)
+
+            for direct_get in (False, True):
+                first, second = s.get_args_list(vardicts=True,
+                                                direct=direct_get)
+                aeq(first.__class__, types.VarDict)
+                aeq(first, dictionary)
+                aeq(first['a'].__class__, types.UInt16)
+                aeq(first['a'].variant_level, 1)
+                aeq(first['c'].variant_level, 2)
+                aeq(first.value_signature('a'), 'q')
+                aeq(first.value_signature('b'), 'as')
+                aeq(first.value_signature('c'), 's')
+                aeq(second['d'].__class__, types.VarDict)
+                aeq(second['d'].variant_level, 1)
+
+                # the signatures it came with are used to send it again
+                u = _dbus_bindings.SignalMessage('/', 'foo.bar', 'baz')
+                u.append(first, second, direct=direct_get)
+                aeq(u.get_signature(), 'a{sv}a{sv}')
+                aeq(u.get_args_list(), t.get_args_list())
+
     def test_object_path_attr(self):
         from _dbus_bindings import SignalMessage
         class MyObject(object):
@@ -423,6 +873,76 @@ class TestMessageMarshalling(unittest.TestCase):
             raise AssertionError('Appending too many things in a struct '
                                  'should fail')
 
+    def test_struct_classes(self):
+        from collections import namedtuple
+        from _dbus_bindings import SignalMessage
+
+        Pair = namedtuple('Pair', 'name value')
+        class Entry(object):
+            __slots__ = ('name', 'count', 'props')
+            def __init__(self, name, count, props):
+                self.name = name
+                self.count = count
+                self.props = props
+
+        types.register_struct_class('(su)', Pair)
+        types.register_struct_class('(sta{sv})', Entry)
+        try:
+            self.assertRaises(ValueError, types.register_struct_class,
+                              '(s)', Entry)
+            self.assertRaises(ValueError, types.register_struct_class,
+                              'as', Pair)
+
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            s.append([Entry('a', 1, {'x': Pair('y', 2)})], (1, 2))
+            self.assertEqual(s.get_signature(), 'a(sta{sv})(ii)')
+            entries, other = s.get_args_list()
+            self.assertEqual(type(entries[0]), Entry)
+            self.assertEqual(entries[0].name, 'a')
+            self.assertEqual(entries[0].count, 1)
+            self.assertEqual(type(entries[0].count), types.UInt64)
+            self.assertEqual(type(entries[0].props['x']), Pair)
+            self.assertEqual(entries[0].props['x'], ('y', 2))
+            self.assertEqual(type(other), types.Struct)
+
+            # same first field, different signature
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            s.append(('a', 'b'), signature='(ss)')
+            self.assertEqual(type(s.get_args_list()[0]), types.Struct)
+
+            # registering a class again moves it to the new signature
+            types.register_struct_class('(iu)', Pair)
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            s.append(('a', 1), (2, 3), signature='(su)(iu)')
+            self.assertEqual([type(x) for x in s.get_args_list()],
+                             [types.Struct, Pair])
+            types.register_struct_class('(iu)', None)
+
+            s = SignalMessage('/', 'foo.bar', 'baz')
+            entry = Entry('b', 2, {})
+            del entry.props
+            self.assertRaises(AttributeError, s.append, entry,
+                              signature='(sta{sv})')
+        finally:
+            types.register_struct_class('(su)', None)
+            types.register_struct_class('(sta{sv})', None)
+
+        s = SignalMessage('/', 'foo.bar', 'baz')
+        s.append(Pair('a', 1), signature='(su)')
+        self.assertEqual(type(s.get_args_list()[0]), types.Struct)
+
+    def test_struct_class_dataclass_init_false(self):
+        try:
+            import dataclasses
+        except ImportError:
+            return
+
+        Pair = dataclasses.make_dataclass('Pair', [
+            ('name', str),
+            ('value', int, dataclasses.field(init=False, default=0))])
+        self.assertRaises(TypeError, types.register_struct_class, '(su)',
+                          Pair)
+
     def test_utf8(self):
         from _dbus_bindings import SignalMessage
         if is_py3:
@@ -459,6 +979,21 @@ class TestMessageMarshalling(unittest.TestCase):
             s = SignalMessage('/', 'foo.bar', 'baz')
             s.append(good, signature='s')
             s.append(good.encode('utf-8'), signature='s')
+            self.assertEqual(s.get_args_list(), [good, good])
+            self.assertEqual(s.get_args_list(direct=True), [good, good])
+        # ASCII is decoded a word at a time, so try non-ASCII characters
+        # at various offsets
+        for i in range(20):
+            for c in (uni(0xe9), uni(0x20ac), uni(0x0001f600)):
+                good = 'x' * i + c + 'y' * (i % 3)
+                s = SignalMessage('/', 'foo.bar', 'baz')
+                s.append(good, 'x' * i, signature='ss')
+                self.assertEqual(s.get_args_list(), [good, 'x' * i])
+        for direct in (False, True):
+            for bad in ('a\0b', b'a\0b'):
+                s = SignalMessage('/', 'foo.bar', 'baz')
+                self.assertRaises((TypeError, ValueError), s.append, bad,
+                                  signature='s', direct=direct)
         for noncharacter in [
                 uni(0xFDD0),
                 utf8(0xef, 0xb7, 0x90),
@@ -509,6 +1044,336 @@ class TestMatching(unittest.TestCase):
         self._message.append('/', signature='o')
         self.assertFalse(self._match.maybe_handle_message(self._message))
 
+class TestErrorClasses(unittest.TestCase):
+    def test_get_error_class(self):
+        from dbus.exceptions import get_error_class
+        cls = get_error_class('com.example.Errors.Mushroom')
+        self.assertTrue(issubclass(cls, dbus.DBusException))
+        self.assertTrue(get_error_class('com.example.Errors.Mushroom') is cls)
+        e = cls('Badger', name='com.example.Errors.Mushroom')
+        self.assertEqual(e.get_dbus_name(), 'com.example.Errors.Mushroom')
+        self.assertEqual(e.get_dbus_message(), 'Badger')
+
+    def test_register_error_class(self):
+        from dbus.exceptions import get_error_class, register_error_class
+        @register_error_class
+        class Snake(dbus.DBusException):
+            _dbus_error_name = 'com.example.Errors.Snake'
+        self.assertTrue(get_error_class('com.example.Errors.Snake') is Snake)
+        self.assertRaises(ValueError, register_error_class, dbus.DBusException)
+
+    def test_error_class_cache_bounded(self):
+        import gc
+        from dbus import exceptions
+        first = exceptions.get_error_class('com.example.Errors.Badger')
+        exceptions.get_error_class('com.example.Errors.Unused')
+        for i in range(exceptions._MAX_RECENT_ERROR_CLASSES * 3):
+            exceptions.get_error_class('com.example.Errors.E%d' % i)
+        gc.collect()
+        self.assertTrue(len(exceptions._recent_error_classes) <=
+                        exceptions._MAX_RECENT_ERROR_CLASSES)
+        self.assertTrue(len(exceptions._generated_error_classes) <=
+                        exceptions._MAX_RECENT_ERROR_CLASSES + 1)
+        self.assertTrue('com.example.Errors.Unused' not in
+                        exceptions._generated_error_classes)
+        # a class that's still referred to keeps its identity
+        self.assertTrue(exceptions.get_error_class(
+            'com.example.Errors.Badger') is first)
+
+    def test_pickle_error_class(self):
+        import pickle
+        from dbus.exceptions import get_error_class
+        cls = get_error_class('com.example.Errors.Pickled')
+        e = pickle.loads(pickle.dumps(cls('Badger', 42)))
+        self.assertTrue(type(e) is cls)
+        self.assertEqual(e.args, ('Badger', 42))
+        self.assertEqual(e.get_dbus_name(), 'com.example.Errors.Pickled')
+        if is_py3:
+            self.assertTrue(pickle.loads(pickle.dumps(cls)) is cls)
+
+class TestCancellationScope(unittest.TestCase):
+    def test_timeout(self):
+        from dbus.connection import CancellationScope
+        scope = CancellationScope()
+        self.assertEqual(scope.remaining(), None)
+        self.assertEqual(scope.get_timeout(), -1.0)
+        self.assertEqual(scope.get_timeout(2.5), 2.5)
+
+        scope = CancellationScope(timeout=10.0)
+        self.assertTrue(0.0 < scope.remaining() <= 10.0)
+        self.assertTrue(0.0 < scope.get_timeout() <= 10.0)
+        self.assertEqual(scope.get_timeout(2.5), 2.5)
+        self.assertTrue(scope.child(60.0).remaining() <= 10.0)
+        self.assertTrue(scope.child(1.0).remaining() <= 1.0)
+
+        self.assertEqual(CancellationScope(timeout=-1.0).remaining(), 0.0)
+
+    def test_cancel(self):
+        from dbus.connection import CancellationScope
+        class FakePendingCall(object):
+            cancelled = False
+            def cancel(self):
+                self.cancelled = True
+
+        scope = CancellationScope()
+        child = scope.child()
+        finished, pending, late = FakePendingCall(), FakePendingCall(), FakePendingCall()
+        for token, call in ((1, finished), (2, pending)):
+            self.assertTrue(child._reserve(token))
+            child._attach(token, call)
+        self.assertTrue(child._release(1))
+        self.assertTrue(scope._reserve(3))
+
+        scope.cancel()
+        self.assertTrue(scope.cancelled)
+        self.assertTrue(child.cancelled)
+        self.assertFalse(finished.cancelled)
+        self.assertTrue(pending.cancelled)
+        # a reply that was already on its way is ignored
+        self.assertFalse(child._release(2))
+        # a call that was sent while we were cancelling is cancelled
+        scope._attach(3, late)
+        self.assertTrue(late.cancelled)
+        self.assertFalse(scope._reserve(4))
+        self.assertTrue(CancellationScope(parent=scope).cancelled)
+
+class TestInterfaceDescriptor(unittest.TestCase):
+
+    def test_descriptor(self):
+        import dbus.service
+        from dbus.exceptions import UnknownMethodException
+
+        class Base(dbus.service.Object):
+            @dbus.service.method('com.example.Base', in_signature='s',
+                                 out_signature='as', sender_keyword='sender')
+            def Frob(self, name, sender=None):
+                return [name]
+
+            @dbus.service.signal('com.example.Base', signature='s')
+            def Frobbed(self, name):
+                pass
+
+        class Derived(Base):
+            def Frob(self, name, sender=None):
+                return [name, name]
+
+        obj = Derived()
+        for interface in ('com.example.Base', None):
+            info = Derived._dbus_descriptor.get_method(obj, interface, 'Frob')
+            self.assertTrue(info.function is Derived.__dict__['Frob'])
+            self.assertEqual(info.out_signature, 'as')
+            self.assertEqual(info.out_count, 1)
+            self.assertEqual([k for (k, getter) in info.message_keywords],
+                             ['sender'])
+        self.assertRaises(UnknownMethodException,
+                          Derived._dbus_descriptor.get_method, obj,
+                          'com.example.Other', 'Frob')
+        self.assertRaises(UnknownMethodException,
+                          Derived._dbus_descriptor.get_method, obj, None,
+                          'Frobbed')
+
+        xml = Derived._dbus_descriptor.introspection
+        self.assertTrue('<interface name="com.example.Base">' in xml)
+        self.assertTrue('<method name="Frob">' in xml)
+        self.assertTrue('<signal name="Frobbed">' in xml)
+        self.assertTrue('<method name="Introspect">' in xml)
+
+    def test_shared_descriptor(self):
+        import dbus.service
+
+        class Base(dbus.service.Object):
+            @dbus.service.method('com.example.Base')
+            def Frob(self):
+                pass
+
+        class Helper(Base):
+            def helper(self):
+                pass
+
+        class Override(Base):
+            def Frob(self):
+                pass
+
+        class Properties(Base):
+            _dbus_property_table = {'com.example.Base': {'Size': ('u', 'read')},
+                                    'com.example.Props': {'On': ('b', 'readwrite')}}
+
+        # nothing changed, so the base class's work is reused
+        self.assertTrue(Helper._dbus_descriptor is Base._dbus_descriptor)
+        self.assertFalse(Override._dbus_descriptor is Base._dbus_descriptor)
+        self.assertTrue(Override._dbus_descriptor.get_method(
+            Override(), None, 'Frob').function is Override.__dict__['Frob'])
+
+        xml = Properties._dbus_descriptor.introspection
+        self.assertTrue('<interface name="com.example.Base">\n'
+                        '    <property name="Size" type="u" access="read" />'
+                        in xml)
+        self.assertTrue('<interface name="com.example.Props">\n'
+                        '    <property name="On" type="b" '
+                        'access="readwrite" />' in xml)
+        self.assertFalse('<property' in Base._dbus_descriptor.introspection)
+
+    def test_replaced_method(self):
+        import dbus.service
+
+        class Base(dbus.service.Object):
+            @dbus.service.method('com.example.Base')
+            def Frob(self):
+                return 'base'
+
+        class Helper(Base):
+            pass
+
+        def frob(self):
+            return 'override'
+
+        @dbus.service.method('com.example.Base')
+        def Frob(self):
+            return 'patched'
+
+        obj = Helper()
+        self.assertTrue(Helper._dbus_descriptor.get_method(
+            obj, None, 'Frob').function is Base.__dict__['Frob'])
+        # overriding the method after the class was created
+        Helper.Frob = frob
+        self.assertTrue(Helper._dbus_descriptor.get_method(
+            obj, None, 'Frob').function is frob)
+        self.assertTrue(Base._dbus_descriptor.get_method(
+            Base(), None, 'Frob').function is Base.__dict__['Frob'])
+        # replacing it on the base class is seen by subclasses
+        del Helper.Frob
+        Base.Frob = Frob
+        for cls in (Base, Helper):
+            self.assertTrue(cls._dbus_descriptor.get_method(
+                cls(), None, 'Frob').function is Frob)
+
+class TestCodegen(unittest.TestCase):
+    xml = b"""<node>
+      <interface name="com.example.Frob">
+        <method name="Frobnicate">
+          <arg name="count" type="i" direction="in"/>
+          <arg name="class" type="s" direction="in"/>
+          <arg name="result" type="as" direction="out"/>
+        </method>
+        <signal name="Changed">
+          <arg name="what" type="s"/>
+        </signal>
+      </interface>
+    </node>"""
+
+    def test_generate(self):
+        from dbus.codegen import Stub, generate
+        calls = []
+        class FakeConn(object):
+            def call_blocking(self, *args, **kwargs):
+                calls.append(('blocking', args, kwargs))
+            def call_async(self, *args, **kwargs):
+                calls.append(('async', args, kwargs))
+            def add_signal_receiver(self, *args, **kwargs):
+                calls.append(('signal', args, kwargs))
+
+        namespace = {}
+        exec(compile(generate(self.xml), '<generated>', 'exec'), namespace)
+        cls = namespace['ComExampleFrob']
+        self.assertTrue(issubclass(cls, Stub))
+        self.assertEqual(cls.INTERFACE, 'com.example.Frob')
+
+        stub = cls(FakeConn(), 'com.example.Frobber', '/Frob')
+        stub.Frobnicate(1, 'x')
+        stub.Frobnicate(2, 'y', timeout=5)
+        stub.Frobnicate(3, 'z', reply_handler=None, ignore_reply=True)
+        stub.connect_to_Changed(None, sender_keyword='sender')
+        self.assertEqual(calls, [
+            ('blocking', ('com.example.Frobber', '/Frob', 'com.example.Frob',
+                          'Frobnicate', 'is', (1, 'x')), {}),
+            ('blocking', ('com.example.Frobber', '/Frob', 'com.example.Frob',
+                          'Frobnicate', 'is', (2, 'y')), {'timeout': 5}),
+            ('async', ('com.example.Frobber', '/Frob', 'com.example.Frob',
+                       'Frobnicate', 'is', (3, 'z'), None, None), {}),
+            ('signal', (None, 'Changed', 'com.example.Frob',
+                        'com.example.Frobber', '/Frob'),
+             {'sender_keyword': 'sender'}),
+            ])
+
+    def test_generate_mangled_names(self):
+        from dbus.codegen import generate
+        xml = b"""
+        <node>
+          <interface name="com.example.Awkward">
+            <method name="import"/>
+            <method name="_dbus_call"/>
+            <method name="connect_to_lambda"/>
+            <signal name="lambda"/>
+          </interface>
+        </node>"""
+        calls = []
+        class FakeConn(object):
+            def call_blocking(self, *args, **kwargs):
+                calls.append(args[3])
+
+        namespace = {}
+        exec(compile(generate(xml), '<generated>', 'exec'), namespace)
+        cls = namespace['ComExampleAwkward']
+        stub = cls(FakeConn(), 'com.example.Awkward', '/')
+        stub.import_()
+        stub._dbus_call_()
+        stub.connect_to_lambda()
+        self.assertEqual(calls, ['import', '_dbus_call', 'connect_to_lambda'])
+        self.assertTrue(hasattr(cls, 'connect_to_lambda_'))
+
+    def test_generate_unique_names(self):
+        from dbus.codegen import generate
+        xml = b"""
+        <node>
+          <interface name="a.Foo_Bar">
+            <method name="M">
+              <arg name="arg1" type="i"/>
+              <arg type="s"/>
+              <arg name="class" type="u"/>
+            </method>
+          </interface>
+          <interface name="a.Foo.Bar"/>
+        </node>"""
+        calls = []
+        class FakeConn(object):
+            def call_blocking(self, *args, **kwargs):
+                calls.append(args[3:])
+
+        namespace = {}
+        exec(compile(generate(xml), '<generated>', 'exec'), namespace)
+        self.assertEqual(namespace['AFooBar'].INTERFACE, 'a.Foo_Bar')
+        self.assertEqual(namespace['AFooBar_'].INTERFACE, 'a.Foo.Bar')
+        stub = namespace['AFooBar'](FakeConn(), 'a.Foo', '/')
+        stub.M(1, 'x', class_=2)
+        self.assertEqual(calls, [('M', 'isu', (1, 'x', 2))])
+
+class TestCAPI(unittest.TestCase):
+
+    def test_marshalling(self):
+        import dbus_py_test
+
+        msg = dbus_py_test.new_message_with_args('sa{sv}ay',
+                                                 ['x', {'n': 1}, b'ab'])
+        self.assertTrue(isinstance(msg, lowlevel.MethodCallMessage))
+        self.assertEqual(msg.get_signature(), 'sa{sv}ay')
+        self.assertEqual(msg.get_args_list(), ['x', {'n': 1}, [97, 98]])
+        self.assertEqual(dbus_py_test.get_args(msg), msg.get_args_list())
+        args = dbus_py_test.get_args(msg, byte_arrays=True, vardicts=True)
+        self.assertEqual(args, msg.get_args_list(byte_arrays=True,
+                                                 vardicts=True))
+        self.assertTrue(isinstance(args[1], dbus.VarDict))
+        self.assertTrue(isinstance(args[2], dbus.ByteArray))
+
+        empty = dbus_py_test.new_message_with_args('', ())
+        self.assertEqual(dbus_py_test.get_args(empty), [])
+        self.assertRaises(ValueError, dbus_py_test.new_message_with_args,
+                          'a', [[1]])
+        self.assertRaises(TypeError, dbus_py_test.new_message_with_args,
+                          'ii', [1])
+        self.assertRaises(TypeError, dbus_py_test.new_message_with_args,
+                          'ai', [['x']])
+        self.assertRaises(TypeError, dbus_py_test.get_args, 'not a message')
+
 if __name__ == '__main__':
     # Python 2.6 doesn't accept a `verbosity` keyword.
     kwargs = {}